@@ -65,6 +65,7 @@ target_sources(hikogui INTERFACE FILE_SET hikogui_include_files TYPE HEADERS BAS
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/codec/base_n.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/codec/BON8.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/codec/datum.hpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/codec/deflate.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/codec/gzip.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/codec/huffman.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/codec/indent.hpp
@@ -86,6 +87,7 @@ target_sources(hikogui INTERFACE FILE_SET hikogui_include_files TYPE HEADERS BAS
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/color/sRGB.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/concurrency/atomic.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/concurrency/callback_flags.hpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/concurrency/futex.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/concurrency/global_state.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/concurrency/concurrency.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/concurrency/notifier.hpp
@@ -93,6 +95,7 @@ target_sources(hikogui INTERFACE FILE_SET hikogui_include_files TYPE HEADERS BAS
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/concurrency/subsystem.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/concurrency/thread.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/concurrency/thread_intf.hpp
+    $<$<PLATFORM_ID:Linux>:${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/concurrency/thread_posix_impl.hpp>
     $<$<PLATFORM_ID:Windows>:${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/concurrency/thread_win32_impl.hpp>
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/concurrency/unfair_mutex.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/concurrency/unfair_mutex_intf.hpp
@@ -108,17 +111,21 @@ target_sources(hikogui INTERFACE FILE_SET hikogui_include_files TYPE HEADERS BAS
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/console/print_intf.hpp
     $<$<PLATFORM_ID:Windows>:${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/console/print_win32_impl.hpp>
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/byte_string.hpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/fifo_slot.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/function_fifo.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/functional.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/gap_buffer.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/hash_map.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/lean_vector.hpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/lru_cache.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/module.hpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/mpmc_fifo.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/packed_int_array.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/polymorphic_optional.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/secure_vector.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/small_map.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/small_vector.hpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/spsc_fifo.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/stable_set.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/stack.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/tree.hpp
@@ -127,6 +134,7 @@ target_sources(hikogui INTERFACE FILE_SET hikogui_include_files TYPE HEADERS BAS
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/void_span.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/wfree_fifo.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/wfree_unordered_map.hpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/work_stealing_deque.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/coroutine/awaitable.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/coroutine/generator.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/coroutine/module.hpp
@@ -155,6 +163,7 @@ target_sources(hikogui INTERFACE FILE_SET hikogui_include_files TYPE HEADERS BAS
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/font/font_book.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/font/font_char_map.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/font/font_family_id.hpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/font/font_index.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/font/font_metrics.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/font/font_variant.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/font/font_weight.hpp
@@ -165,6 +174,7 @@ target_sources(hikogui INTERFACE FILE_SET hikogui_include_files TYPE HEADERS BAS
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/font/font.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/font/font_font.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/font/font_style.hpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/font/otype_GPOS.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/font/otype_cmap.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/font/otype_glyf.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/font/otype_head.hpp
@@ -177,6 +187,7 @@ target_sources(hikogui INTERFACE FILE_SET hikogui_include_files TYPE HEADERS BAS
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/font/otype_os2.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/font/otype_sfnt.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/font/otype_utilities.hpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/font/shape_run_cache.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/font/true_type_font.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/formula/formula.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/formula/formula_add_node.hpp
@@ -346,17 +357,22 @@ target_sources(hikogui INTERFACE FILE_SET hikogui_include_files TYPE HEADERS BAS
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/l10n/po_parser.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/l10n/txt.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/l10n/translation.hpp
+    $<$<PLATFORM_ID:Linux>:${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/dispatch/awaitable_io.hpp>
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/dispatch/awaitable_timer.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/dispatch/awaitable_timer_intf.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/dispatch/awaitable_timer_impl.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/dispatch/function_timer.hpp
+    $<$<PLATFORM_ID:Linux>:${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/dispatch/io_ring_linux_impl.hpp>
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/dispatch/loop.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/dispatch/loop_intf.hpp
+    $<$<PLATFORM_ID:Linux>:${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/dispatch/loop_linux_impl.hpp>
     $<$<PLATFORM_ID:Windows>:${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/dispatch/loop_win32_impl.hpp>
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/dispatch/dispatch.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/dispatch/socket_event.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/dispatch/socket_event_intf.hpp
+    $<$<PLATFORM_ID:Linux>:${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/dispatch/socket_event_linux_impl.hpp>
     $<$<PLATFORM_ID:Windows>:${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/dispatch/socket_event_win32_impl.hpp>
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/dispatch/thread_pool.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/layout/box_constraints.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/layout/box_shape.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/layout/grid_layout.hpp
@@ -458,12 +474,14 @@ target_sources(hikogui INTERFACE FILE_SET hikogui_include_files TYPE HEADERS BAS
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/skeleton/skeleton_string_node.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/skeleton/skeleton_top_node.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/skeleton/skeleton_while_node.hpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/telemetry/binary_log.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/telemetry/counters.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/telemetry/delayed_format.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/telemetry/format_check.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/telemetry/log.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/telemetry/telemetry.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/telemetry/trace.hpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/telemetry/trace_recorder.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/text/module.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/text/semantic_text_style.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/text/text_cursor.hpp
@@ -519,6 +537,7 @@ target_sources(hikogui INTERFACE FILE_SET hikogui_include_files TYPE HEADERS BAS
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/utility/endian.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/utility/enum_metadata.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/utility/exception_intf.hpp
+    $<$<PLATFORM_ID:Linux>:${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/utility/exception_posix_impl.hpp>
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/utility/exception_win32_impl.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/utility/exception.hpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/utility/fixed_string.hpp
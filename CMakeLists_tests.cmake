@@ -22,9 +22,13 @@ target_sources(hikogui_tests PRIVATE
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/codec/base_n_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/codec/BON8_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/codec/datum_tests.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/codec/deflate_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/codec/gzip_tests.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/codec/huffman_tests.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/codec/inflate_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/codec/jsonpath_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/codec/JSON_tests.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/codec/png_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/codec/SHA2_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/color/color_space_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/concurrency/unfair_mutex_tests.cpp
@@ -32,14 +36,25 @@ target_sources(hikogui_tests PRIVATE
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/concurrency/rcu_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/gap_buffer_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/lean_vector_tests.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/lru_cache_tests.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/mpmc_fifo_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/packed_int_array_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/polymorphic_optional_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/small_map_tests.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/spsc_fifo_tests.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/stable_set_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/tree_tests.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/wfree_unordered_map_tests.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/container/work_stealing_deque_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/coroutine/generator_tests.cpp
+    $<$<PLATFORM_ID:Linux>:${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/dispatch/awaitable_io_tests.cpp>
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/dispatch/loop_tests.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/dispatch/thread_pool_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/file/file_view_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/font/font_char_map_tests.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/font/font_index_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/font/font_weight_tests.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/font/otype_GPOS_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/formula/formula_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/geometry/matrix3_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/geometry/point2_tests.cpp
@@ -83,8 +98,11 @@ target_sources(hikogui_tests PRIVATE
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/settings/user_settings_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/SIMD/simd_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/skeleton/skeleton_tests.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/telemetry/binary_log_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/telemetry/counters_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/telemetry/format_check_tests.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/telemetry/trace_recorder_tests.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/text/text_shaper_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/unicode/grapheme_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/unicode/gstring_tests.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/hikogui/unicode/markup_tests.cpp
@@ -89,6 +89,7 @@ public:
                 hi_log_fatal("Could not start the os_settings subsystem.");
             }
 
+            font_book::global().use_index(font_index_file());
             register_font_file(URL{"resource:elusiveicons-webfont.ttf"});
             register_font_file(URL{"resource:hikogui_icons.ttf"});
             register_font_directories(font_dirs());
@@ -10,6 +10,7 @@
 #include "../GFX/GFX.hpp"
 #include "../telemetry/telemetry.hpp"
 #include "../macros.hpp"
+#include <atomic>
 
 namespace hi { inline namespace v1 {
 class gui_window;
@@ -29,7 +30,11 @@ public:
 
     virtual ~widget_intf() = default;
 
-    widget_intf(widget_intf *parent) noexcept : id(narrow_cast<uint32_t>(++global_counter<"widget::id">)), parent(parent) {}
+    widget_intf(widget_intf *parent) noexcept :
+        id(_last_id.fetch_add(1, std::memory_order::relaxed) + 1), parent(parent)
+    {
+        ++global_counter<"widget::id">;
+    }
 
     /** Set the window for this tree of widgets.
      *
@@ -197,6 +202,11 @@ public:
     {
         scroll_to_show(layout().rectangle());
     }
+
+private:
+    /** The last widget id that was handed out.
+     */
+    inline static std::atomic<uint32_t> _last_id = 0;
 };
 
 inline widget_intf *get_if(widget_intf *start, widget_id id, bool include_invisible) noexcept
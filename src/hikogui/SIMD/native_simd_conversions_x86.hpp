@@ -4,12 +4,14 @@
 
 #pragma once
 
+#include "native_f16x8_sse2.hpp"
 #include "native_f32x4_sse.hpp"
 #include "native_f64x4_avx.hpp"
 #include "native_i32x4_sse2.hpp"
 #include "native_i64x4_avx2.hpp"
 #include "native_u32x4_sse2.hpp"
 #include "native_simd_utility.hpp"
+#include "float16_sse4_1.hpp"
 #include "../macros.hpp"
 
 namespace hi { inline namespace v1 {
@@ -20,6 +22,14 @@ namespace hi { inline namespace v1 {
 [[nodiscard]] inline native_simd<int32_t, 4>::native_simd(native_simd<uint32_t, 4> const& a) noexcept : v(a.v) {}
 [[nodiscard]] inline native_simd<uint32_t, 4>::native_simd(native_simd<int32_t, 4> const& a) noexcept : v(a.v) {}
 #endif
+#ifdef HI_HAS_SSE4_1
+[[nodiscard]] inline native_simd<float16, 8>::native_simd(
+    native_simd<float, 4> const& a,
+    native_simd<float, 4> const& b) noexcept :
+    v(_mm_unpacklo_epi64(_mm_cvtps_ph_sse4_1(a.v), _mm_cvtps_ph_sse4_1(b.v)))
+{
+}
+#endif
 #ifdef HI_HAS_AVX
 [[nodiscard]] inline native_simd<float, 4>::native_simd(native_simd<double, 4> const& a) noexcept : v(_mm256_cvtpd_ps(a.v)) {}
 [[nodiscard]] inline native_simd<double, 4>::native_simd(native_simd<float, 4> const& a) noexcept : v(_mm256_cvtps_pd(a.v)) {}
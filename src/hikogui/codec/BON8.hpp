@@ -57,7 +57,7 @@ constexpr auto BON8_code_eot = uint8_t{0xff};
  * @param last Pointer one beyond the end of the message.
  * @return The decoded message.
  */
-[[nodiscard]] datum decode_BON8(cbyteptr& ptr, cbyteptr last);
+[[nodiscard]] datum decode_BON8(cbyteptr& ptr, cbyteptr last, datum_arena *arena);
 
 [[nodiscard]] bstring encode_BON8(datum const& value);
 
@@ -524,12 +524,12 @@ void inline BON8_encoder::add(datum const& value)
     }
 }
 
-[[nodiscard]] inline datum decode_BON8_array(cbyteptr& ptr, cbyteptr last)
+[[nodiscard]] inline datum decode_BON8_array(cbyteptr& ptr, cbyteptr last, datum_arena *arena)
 {
     hi_assert_not_null(ptr);
     hi_assert_not_null(last);
 
-    auto r = datum::make_vector();
+    auto r = datum::make_vector(arena);
     auto& vector = get<datum::vector_type>(r);
 
     while (ptr != last) {
@@ -538,29 +538,29 @@ void inline BON8_encoder::add(datum const& value)
             return r;
 
         } else {
-            vector.push_back(decode_BON8(ptr, last));
+            vector.push_back(decode_BON8(ptr, last, arena));
         }
     }
     throw parse_error("Incomplete array at end of buffer");
 }
 
-[[nodiscard]] inline datum decode_BON8_array(cbyteptr& ptr, cbyteptr last, std::size_t count)
+[[nodiscard]] inline datum decode_BON8_array(cbyteptr& ptr, cbyteptr last, std::size_t count, datum_arena *arena)
 {
-    auto r = datum::make_vector();
+    auto r = datum::make_vector(arena);
     auto& vector = get<datum::vector_type>(r);
 
     while (count--) {
-        vector.push_back(decode_BON8(ptr, last));
+        vector.push_back(decode_BON8(ptr, last, arena));
     }
     return r;
 }
 
-[[nodiscard]] inline datum decode_BON8_object(cbyteptr& ptr, cbyteptr last)
+[[nodiscard]] inline datum decode_BON8_object(cbyteptr& ptr, cbyteptr last, datum_arena *arena)
 {
     hi_assert_not_null(ptr);
     hi_assert_not_null(last);
 
-    auto r = datum::make_map();
+    auto r = datum::make_map(arena);
     auto& map = get<datum::map_type>(r);
 
     while (ptr != last) {
@@ -569,26 +569,26 @@ void inline BON8_encoder::add(datum const& value)
             return r;
 
         } else {
-            auto key = decode_BON8(ptr, last);
+            auto key = decode_BON8(ptr, last, arena);
             hi_check(holds_alternative<std::string>(key), "Key in object is not a string");
 
-            auto value = decode_BON8(ptr, last);
+            auto value = decode_BON8(ptr, last, arena);
             map.emplace(std::move(key), std::move(value));
         }
     }
     throw parse_error("Incomplete object at end of buffer");
 }
 
-[[nodiscard]] inline datum decode_BON8_object(cbyteptr& ptr, cbyteptr last, std::size_t count)
+[[nodiscard]] inline datum decode_BON8_object(cbyteptr& ptr, cbyteptr last, std::size_t count, datum_arena *arena)
 {
-    auto r = datum::make_map();
+    auto r = datum::make_map(arena);
     auto& map = get<datum::map_type>(r);
 
     while (count--) {
-        auto key = decode_BON8(ptr, last);
+        auto key = decode_BON8(ptr, last, arena);
         hi_check(holds_alternative<std::string>(key), "Key in object is not a string");
 
-        auto value = decode_BON8(ptr, last);
+        auto value = decode_BON8(ptr, last, arena);
         map.emplace(std::move(key), std::move(value));
     }
     return r;
@@ -661,7 +661,7 @@ void inline BON8_encoder::add(datum const& value)
     }
 }
 
-[[nodiscard]] inline datum decode_BON8(cbyteptr& ptr, cbyteptr last)
+[[nodiscard]] inline datum decode_BON8(cbyteptr& ptr, cbyteptr last, datum_arena *arena)
 {
     hi_assert_not_null(ptr);
     hi_assert_not_null(last);
@@ -674,7 +674,7 @@ void inline BON8_encoder::add(datum const& value)
         if (c == BON8_code_eot) {
             // End of string found, return the current string.
             ++ptr;
-            return datum{str};
+            return datum::make_string(arena, str);
 
         } else if (c <= 0x7f) {
             // ASCII character.
@@ -692,7 +692,7 @@ void inline BON8_encoder::add(datum const& value)
 
             } else if (not str.empty()) {
                 // Multibyte integer found, but first return the current string.
-                return datum{str};
+                return datum::make_string(arena, str);
 
             } else {
                 // Multibyte integer, the first code-unit includes part of the integer.
@@ -701,7 +701,7 @@ void inline BON8_encoder::add(datum const& value)
 
         } else if (not str.empty()) {
             // This must be a non-string type, but first return the current string.
-            return datum{str};
+            return datum::make_string(arena, str);
 
         } else {
             // This is one of the non-string types.
@@ -728,29 +728,29 @@ void inline BON8_encoder::add(datum const& value)
             case BON8_code_binary64:
                 return decode_BON8_float(ptr, last, 8);
             case BON8_code_array_count0:
-                return datum::make_vector();
+                return datum::make_vector(arena);
             case BON8_code_array_count1:
-                return decode_BON8_array(ptr, last, 1);
+                return decode_BON8_array(ptr, last, 1, arena);
             case BON8_code_array_count2:
-                return decode_BON8_array(ptr, last, 2);
+                return decode_BON8_array(ptr, last, 2, arena);
             case BON8_code_array_count3:
-                return decode_BON8_array(ptr, last, 3);
+                return decode_BON8_array(ptr, last, 3, arena);
             case BON8_code_array_count4:
-                return decode_BON8_array(ptr, last, 4);
+                return decode_BON8_array(ptr, last, 4, arena);
             case BON8_code_array:
-                return decode_BON8_array(ptr, last);
+                return decode_BON8_array(ptr, last, arena);
             case BON8_code_object_count0:
-                return datum::make_map();
+                return datum::make_map(arena);
             case BON8_code_object_count1:
-                return decode_BON8_object(ptr, last, 1);
+                return decode_BON8_object(ptr, last, 1, arena);
             case BON8_code_object_count2:
-                return decode_BON8_object(ptr, last, 2);
+                return decode_BON8_object(ptr, last, 2, arena);
             case BON8_code_object_count3:
-                return decode_BON8_object(ptr, last, 3);
+                return decode_BON8_object(ptr, last, 3, arena);
             case BON8_code_object_count4:
-                return decode_BON8_object(ptr, last, 4);
+                return decode_BON8_object(ptr, last, 4, arena);
             case BON8_code_object:
-                return decode_BON8_object(ptr, last);
+                return decode_BON8_object(ptr, last, arena);
             case BON8_code_eoc:
                 throw parse_error("Unexpected end-of-container");
             case BON8_code_eot:
@@ -782,7 +782,7 @@ hi_export [[nodiscard]] inline datum decode_BON8(std::span<const std::byte> buff
 {
     auto *ptr = buffer.data();
     auto *last = ptr + buffer.size();
-    return detail::decode_BON8(ptr, last);
+    return detail::decode_BON8(ptr, last, nullptr);
 }
 
 /** Decode BON8 message from buffer.
@@ -793,7 +793,7 @@ hi_export [[nodiscard]] inline datum decode_BON8(bstring const& buffer)
 {
     auto *ptr = buffer.data();
     auto *last = ptr + buffer.size();
-    return detail::decode_BON8(ptr, last);
+    return detail::decode_BON8(ptr, last, nullptr);
 }
 
 /** Decode BON8 message from buffer.
@@ -804,7 +804,25 @@ hi_export [[nodiscard]] inline datum decode_BON8(bstring_view buffer)
 {
     auto *ptr = buffer.data();
     auto *last = ptr + buffer.size();
-    return detail::decode_BON8(ptr, last);
+    return detail::decode_BON8(ptr, last, nullptr);
+}
+
+/** Decode BON8 message from buffer into an arena.
+ *
+ * The string, array and object nodes of the result are allocated in the arena,
+ * which must outlive the result. Values moved out of the result are copied to the heap.
+ *
+ * @param buffer A buffer to a BON8 encoded message.
+ * @param arena The arena to allocate the result in.
+ * @return The decoded message.
+ */
+hi_export [[nodiscard]] inline datum decode_BON8(bstring_view buffer, datum_arena& arena)
+{
+    auto *ptr = buffer.data();
+    auto *last = ptr + buffer.size();
+    auto r = detail::decode_BON8(ptr, last, &arena);
+    arena.seal(r);
+    return r;
 }
 
 /** Encode a value to a BON8 message.
@@ -80,3 +80,23 @@ TEST(BON8, decode_negative_integers)
         datum{std::numeric_limits<int64_t>::min()},
         decode_BON8(to_bstring(0x8d, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00)));
 }
+
+TEST(BON8, decode_into_arena)
+{
+    auto value = datum::make_map();
+    value["name"] = "A string longer than the small string buffer";
+    value["items"] = datum::make_vector(1, 2.5, "three", true, nullptr, 6, 7);
+    hilet message = encode_BON8(value);
+
+    auto copy = datum{};
+    {
+        auto arena = datum_arena{};
+        hilet decoded = decode_BON8(message, arena);
+        ASSERT_EQ(decoded, value);
+
+        copy = decoded;
+    }
+
+    // The copy was allocated on the heap and outlives the arena.
+    ASSERT_EQ(copy, value);
+}
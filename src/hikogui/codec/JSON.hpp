@@ -15,6 +15,16 @@
 #include <string_view>
 #include <vector>
 #include <optional>
+#include <array>
+#include <algorithm>
+#include <format>
+#include <bit>
+#if defined(HI_HAS_SSE2)
+#include <emmintrin.h>
+#endif
+#if defined(HI_HAS_AVX2)
+#include <immintrin.h>
+#endif
 
 hi_export_module(hikogui.codec.JSON);
 
@@ -176,6 +186,8 @@ template<std::input_iterator It, std::sentinel_for<It> ItEnd>
     }
 }
 
+[[nodiscard]] inline datum json_read_datum(std::string_view text, std::string_view path, datum_arena *arena = nullptr);
+
 } // namespace detail
 
 hi_export template<std::input_iterator It, std::sentinel_for<It> ItEnd>
@@ -209,6 +221,12 @@ hi_export template<std::input_iterator It, std::sentinel_for<It> ItEnd>
  */
 hi_export [[nodiscard]] constexpr datum parse_JSON(std::string_view text, std::string_view path = std::string_view{"<none>"})
 {
+    if (not std::is_constant_evaluated()) {
+        // Contiguous text is scanned directly by the json_reader, which skips
+        // white-space and string bodies in bulk.
+        return detail::json_read_datum(text, path);
+    }
+
     return parse_JSON(text.cbegin(), text.cend(), path);
 }
 
@@ -239,6 +257,588 @@ hi_export [[nodiscard]] inline datum parse_JSON(std::filesystem::path const& pat
     return parse_JSON(as_string_view(file_view(path)), path.string());
 }
 
+/** Parse a JSON string into an arena.
+ *
+ * The string, array and object nodes of the result are allocated in the arena,
+ * which must outlive the result. Values moved out of the result are copied to the heap.
+ *
+ * @param text The text to parse.
+ * @param arena The arena to allocate the result in.
+ * @return A datum representing the parsed object.
+ */
+hi_export [[nodiscard]] inline datum
+parse_JSON(std::string_view text, datum_arena& arena, std::string_view path = std::string_view{"<none>"})
+{
+    return detail::json_read_datum(text, path, &arena);
+}
+
+/** Parse a JSON file into an arena.
+ *
+ * @param path A path pointing to the file to parse.
+ * @param arena The arena to allocate the result in.
+ * @return A datum representing the parsed object.
+ */
+hi_export [[nodiscard]] inline datum parse_JSON(std::filesystem::path const& path, datum_arena& arena)
+{
+    return parse_JSON(as_string_view(file_view(path)), arena, path.string());
+}
+
+namespace detail {
+
+/** Find the first character that is not a space, tab, line-feed or carriage-return.
+ *
+ * @return Pointer to the first non-blank character, or @a last.
+ */
+[[nodiscard]] inline char const *json_find_non_blank(char const *first, char const *last) noexcept
+{
+#if defined(HI_HAS_AVX2)
+    while (last - first >= 32) {
+        hilet chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(first));
+        auto blank = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' '));
+        blank = _mm256_or_si256(blank, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n')));
+        blank = _mm256_or_si256(blank, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r')));
+        blank = _mm256_or_si256(blank, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\t')));
+        if (hilet mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(blank))) {
+            return first + std::countr_zero(mask);
+        }
+        first += 32;
+    }
+#endif
+#if defined(HI_HAS_SSE2)
+    while (last - first >= 16) {
+        hilet chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(first));
+        auto blank = _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' '));
+        blank = _mm_or_si128(blank, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')));
+        blank = _mm_or_si128(blank, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')));
+        blank = _mm_or_si128(blank, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t')));
+        if (hilet mask = ~static_cast<uint32_t>(_mm_movemask_epi8(blank)) & 0xffff) {
+            return first + std::countr_zero(mask);
+        }
+        first += 16;
+    }
+#endif
+    while (first != last and (*first == ' ' or *first == '\n' or *first == '\r' or *first == '\t')) {
+        ++first;
+    }
+    return first;
+}
+
+/** Find the first double-quote or backslash.
+ *
+ * @return Pointer to the first '"' or '\\' character, or @a last.
+ */
+[[nodiscard]] inline char const *json_find_quote_or_backslash(char const *first, char const *last) noexcept
+{
+#if defined(HI_HAS_AVX2)
+    while (last - first >= 32) {
+        hilet chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(first));
+        hilet quote = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"'));
+        hilet backslash = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\'));
+        if (hilet mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(quote, backslash)))) {
+            return first + std::countr_zero(mask);
+        }
+        first += 32;
+    }
+#endif
+#if defined(HI_HAS_SSE2)
+    while (last - first >= 16) {
+        hilet chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(first));
+        hilet quote = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'));
+        hilet backslash = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'));
+        if (hilet mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(quote, backslash)))) {
+            return first + std::countr_zero(mask);
+        }
+        first += 16;
+    }
+#endif
+    while (first != last and *first != '"' and *first != '\\') {
+        ++first;
+    }
+    return first;
+}
+
+} // namespace detail
+
+/** A pull-style JSON reader.
+ *
+ * Unlike `parse_JSON()` this reader does not build a `datum` tree; the caller pulls
+ * events one at a time and may skip over values it is not interested in. No memory is
+ * allocated while reading.
+ *
+ * Keys and strings are returned as views into the source text, which must outlive the
+ * reader. Like `parse_JSON()` escape sequences in strings are kept verbatim, so a
+ * string never needs to be copied.
+ *
+ * The same JSON dialect as `parse_JSON()` is accepted, including line comments
+ * starting with `//` and trailing commas in arrays and objects.
+ *
+ * ```
+ * auto reader = json_reader{text};
+ * while (reader.next() != json_reader::event_type::end) {
+ *     if (reader.event() == json_reader::event_type::key and reader.text() == "theme") {
+ *         ...
+ *     }
+ * }
+ * ```
+ */
+hi_export class json_reader {
+public:
+    enum class event_type : uint8_t {
+        /** The root value has been completely read.
+         */
+        end,
+        begin_object,
+        end_object,
+        begin_array,
+        end_array,
+
+        /** A key of an object, the next event is the value of this key.
+         */
+        key,
+        string,
+        integer,
+        real,
+        boolean,
+        null
+    };
+
+    /** The maximum nesting depth of arrays and objects.
+     */
+    constexpr static std::size_t max_depth = 256;
+
+    /** Create a reader.
+     *
+     * @param text The JSON text, must outlive the reader.
+     * @param path The filename used for error messages.
+     */
+    constexpr json_reader(std::string_view text, std::string_view path = std::string_view{"<none>"}) noexcept :
+        _text(text), _path(path)
+    {
+    }
+
+    /** The event returned by the last call to `next()`.
+     */
+    [[nodiscard]] constexpr event_type event() const noexcept
+    {
+        return _event;
+    }
+
+    /** The number of arrays and objects that enclose the current position.
+     */
+    [[nodiscard]] constexpr std::size_t depth() const noexcept
+    {
+        return _depth;
+    }
+
+    /** The text of the current key, string, number or literal.
+     *
+     * For keys and strings the quotes are not included.
+     *
+     * @return A view into the source text.
+     */
+    [[nodiscard]] constexpr std::string_view text() const noexcept
+    {
+        return _value;
+    }
+
+    /** The value of the current integer event.
+     */
+    [[nodiscard]] long long integer() const
+    {
+        hi_axiom(_event == event_type::integer);
+        return from_string<long long>(_value);
+    }
+
+    /** The value of the current integer or real event.
+     */
+    [[nodiscard]] double real() const
+    {
+        hi_axiom(_event == event_type::integer or _event == event_type::real);
+        return from_string<double>(_value);
+    }
+
+    /** The value of the current boolean event.
+     */
+    [[nodiscard]] constexpr bool boolean() const noexcept
+    {
+        hi_axiom(_event == event_type::boolean);
+        return _value == "true";
+    }
+
+    /** The location of the current event, for use in error messages.
+     */
+    [[nodiscard]] constexpr std::string location() const noexcept
+    {
+        hilet prefix = _text.substr(0, _token_offset);
+        hilet line_nr = std::count(prefix.begin(), prefix.end(), '\n');
+        hilet line_start = prefix.rfind('\n');
+        hilet column_nr = line_start == prefix.npos ? prefix.size() : prefix.size() - line_start - 1;
+        return std::format("{}:{}:{}", _path, line_nr + 1, column_nr + 1);
+    }
+
+    /** Read the next event.
+     *
+     * @return The event that was read, `event_type::end` after the root value.
+     * @throw parse_error When the text is not valid JSON.
+     */
+    constexpr event_type next()
+    {
+        while (true) {
+            skip_white_space();
+            _token_offset = _offset;
+
+            if (_state == state_type::done) {
+                if (_offset != _text.size()) {
+                    throw parse_error(std::format("{}: Unexpected text after JSON root object", location()));
+                }
+                return _event = event_type::end;
+
+            } else if (_offset == _text.size()) {
+                if (_depth == 0) {
+                    throw parse_error(std::format("{}: No tokens found", location()));
+                } else {
+                    throw parse_error(std::format("{}: Unexpected end of text", location()));
+                }
+            }
+
+            hilet c = _text[_offset];
+            switch (_state) {
+            case state_type::comma_or_end:
+                if (c == ',') {
+                    ++_offset;
+                    _state = in_object() ? state_type::key_or_end : state_type::array_value_or_end;
+                    continue;
+
+                } else if (c == (in_object() ? '}' : ']')) {
+                    return end_container();
+
+                } else {
+                    throw parse_error(std::format("{}: Expecting ',', found '{}'.", location(), c));
+                }
+
+            case state_type::key_or_end:
+                if (c == '}') {
+                    return end_container();
+
+                } else if (c == '"') {
+                    parse_string();
+
+                    skip_white_space();
+                    if (_offset == _text.size() or _text[_offset] != ':') {
+                        _token_offset = _offset;
+                        throw parse_error(std::format("{}: Expecting ':'.", location()));
+                    }
+                    ++_offset;
+
+                    _state = state_type::value;
+                    return _event = event_type::key;
+
+                } else {
+                    throw parse_error(
+                        std::format("{}: Unexpected character '{}', expected a key or close-brace.", location(), c));
+                }
+
+            case state_type::array_value_or_end:
+                if (c == ']') {
+                    return end_container();
+                }
+                return parse_value(c);
+
+            case state_type::value:
+                return parse_value(c);
+
+            default:
+                hi_no_default();
+            }
+        }
+    }
+
+    /** Skip over the value of the current event.
+     *
+     * - After `begin_object` or `begin_array` the reader skips to the matching end event.
+     * - After `key` the reader skips over the value of the key.
+     * - After any other event this function does nothing.
+     *
+     * @throw parse_error When the text is not valid JSON.
+     */
+    constexpr void skip()
+    {
+        if (_event == event_type::key) {
+            next();
+        }
+
+        if (_event == event_type::begin_object or _event == event_type::begin_array) {
+            hilet depth = _depth - 1;
+            while (_depth != depth) {
+                next();
+            }
+        }
+    }
+
+private:
+    enum class state_type : uint8_t { value, array_value_or_end, key_or_end, comma_or_end, done };
+
+    std::string_view _text;
+    std::string_view _path;
+    std::size_t _offset = 0;
+    std::size_t _token_offset = 0;
+    std::string_view _value = {};
+    event_type _event = event_type::end;
+    state_type _state = state_type::value;
+    std::size_t _depth = 0;
+
+    /** For each nesting level, true if it is an object, false if it is an array.
+     */
+    std::array<uint64_t, max_depth / 64> _is_object = {};
+
+    [[nodiscard]] constexpr bool in_object() const noexcept
+    {
+        hi_axiom(_depth != 0);
+        hilet i = _depth - 1;
+        return to_bool((_is_object[i / 64] >> (i % 64)) & 1);
+    }
+
+    [[nodiscard]] constexpr static bool is_identifier_char(char c) noexcept
+    {
+        return (c >= 'a' and c <= 'z') or (c >= 'A' and c <= 'Z') or (c >= '0' and c <= '9') or c == '_';
+    }
+
+    constexpr void skip_white_space() noexcept
+    {
+        while (_offset != _text.size()) {
+            hilet c = _text[_offset];
+            if (c == ' ' or c == '\n' or c == '\r' or c == '\t') {
+                ++_offset;
+                if (not std::is_constant_evaluated()) {
+                    // Indentation comes in long runs of blanks.
+                    hilet first = _text.data() + _offset;
+                    _offset += detail::json_find_non_blank(first, _text.data() + _text.size()) - first;
+                }
+
+            } else if (c == '\f' or c == '\v') {
+                ++_offset;
+
+            } else if (c == '/' and _offset + 1 != _text.size() and _text[_offset + 1] == '/') {
+                hilet line_end = _text.find('\n', _offset + 2);
+                _offset = line_end == _text.npos ? _text.size() : line_end + 1;
+
+            } else {
+                return;
+            }
+        }
+    }
+
+    constexpr void value_done() noexcept
+    {
+        _state = _depth == 0 ? state_type::done : state_type::comma_or_end;
+    }
+
+    constexpr event_type begin_container(bool is_object)
+    {
+        if (_depth == max_depth) {
+            throw parse_error(std::format("{}: JSON nesting too deep.", location()));
+        }
+
+        _value = _text.substr(_offset++, 1);
+        if (is_object) {
+            _is_object[_depth / 64] |= uint64_t{1} << (_depth % 64);
+        } else {
+            _is_object[_depth / 64] &= ~(uint64_t{1} << (_depth % 64));
+        }
+        ++_depth;
+        if (is_object) {
+            _state = state_type::key_or_end;
+            return _event = event_type::begin_object;
+        } else {
+            _state = state_type::array_value_or_end;
+            return _event = event_type::begin_array;
+        }
+    }
+
+    constexpr event_type end_container() noexcept
+    {
+        hilet is_object = in_object();
+        _value = _text.substr(_offset++, 1);
+        --_depth;
+        value_done();
+        return _event = is_object ? event_type::end_object : event_type::end_array;
+    }
+
+    constexpr void parse_string()
+    {
+        hi_axiom(_text[_offset] == '"');
+
+        hilet first = ++_offset;
+        while (true) {
+            hilet i = find_quote_or_backslash();
+            if (i == _text.npos or (_text[i] == '\\' and i + 1 == _text.size())) {
+                throw parse_error(std::format("{}: Incomplete string.", location()));
+
+            } else if (_text[i] == '\\') {
+                // Skip over the escaped character, which may be a quote.
+                _offset = i + 2;
+
+            } else {
+                _value = _text.substr(first, i - first);
+                _offset = i + 1;
+                return;
+            }
+        }
+    }
+
+    [[nodiscard]] constexpr std::size_t find_quote_or_backslash() const noexcept
+    {
+        if (not std::is_constant_evaluated()) {
+            hilet first = _text.data() + _offset;
+            hilet last = _text.data() + _text.size();
+            hilet it = detail::json_find_quote_or_backslash(first, last);
+            return it == last ? _text.npos : narrow_cast<std::size_t>(it - _text.data());
+        }
+        return _text.find_first_of("\"\\", _offset);
+    }
+
+    constexpr event_type parse_number()
+    {
+        hilet first = _offset;
+
+        auto skip_digits = [&] {
+            hilet digits_first = _offset;
+            while (_offset != _text.size() and _text[_offset] >= '0' and _text[_offset] <= '9') {
+                ++_offset;
+            }
+            return _offset != digits_first;
+        };
+
+        if (_text[_offset] == '-') {
+            ++_offset;
+        }
+        if (not skip_digits()) {
+            throw parse_error(
+                std::format("{}: Unexpected character after '-', expected integer or floating point literal.", location()));
+        }
+
+        auto is_real = false;
+        if (_offset != _text.size() and _text[_offset] == '.') {
+            ++_offset;
+            is_real = true;
+            skip_digits();
+        }
+
+        if (_offset != _text.size() and (_text[_offset] == 'e' or _text[_offset] == 'E')) {
+            ++_offset;
+            is_real = true;
+            if (_offset != _text.size() and (_text[_offset] == '+' or _text[_offset] == '-')) {
+                ++_offset;
+            }
+            if (not skip_digits()) {
+                throw parse_error(std::format("{}: Incomplete exponent.", location()));
+            }
+        }
+
+        _value = _text.substr(first, _offset - first);
+        value_done();
+        return _event = is_real ? event_type::real : event_type::integer;
+    }
+
+    constexpr event_type parse_value(char c)
+    {
+        if (c == '{') {
+            return begin_container(true);
+
+        } else if (c == '[') {
+            return begin_container(false);
+
+        } else if (c == '"') {
+            parse_string();
+            value_done();
+            return _event = event_type::string;
+
+        } else if (c == '-' or (c >= '0' and c <= '9')) {
+            return parse_number();
+
+        } else if (is_identifier_char(c)) {
+            hilet first = _offset;
+            while (_offset != _text.size() and is_identifier_char(_text[_offset])) {
+                ++_offset;
+            }
+            _value = _text.substr(first, _offset - first);
+
+            if (_value == "true" or _value == "false") {
+                value_done();
+                return _event = event_type::boolean;
+            } else if (_value == "null") {
+                value_done();
+                return _event = event_type::null;
+            } else {
+                throw parse_error(std::format("{}: Expecting a JSON value, found '{}'.", location(), _value));
+            }
+
+        } else {
+            throw parse_error(std::format("{}: Expecting a JSON value, found '{}'.", location(), c));
+        }
+    }
+};
+
+namespace detail {
+
+[[nodiscard]] inline datum json_read_value(json_reader& reader, datum_arena *arena)
+{
+    using enum json_reader::event_type;
+
+    switch (reader.event()) {
+    case begin_object:
+        {
+            auto r = datum::make_map(arena);
+            auto& map = get<datum::map_type>(r);
+            while (reader.next() == key) {
+                auto name = datum::make_string(arena, reader.text());
+                reader.next();
+                map[std::move(name)] = json_read_value(reader, arena);
+            }
+            return r;
+        }
+
+    case begin_array:
+        {
+            auto r = datum::make_vector(arena);
+            auto& vector = get<datum::vector_type>(r);
+            while (reader.next() != end_array) {
+                vector.push_back(json_read_value(reader, arena));
+            }
+            return r;
+        }
+
+    case string:
+        return datum::make_string(arena, reader.text());
+    case integer:
+        return datum{reader.integer()};
+    case real:
+        return datum{reader.real()};
+    case boolean:
+        return datum{reader.boolean()};
+    case null:
+        return datum{nullptr};
+    default:
+        hi_no_default();
+    }
+}
+
+[[nodiscard]] inline datum json_read_datum(std::string_view text, std::string_view path, datum_arena *arena)
+{
+    auto reader = json_reader{text, path};
+    reader.next();
+    auto r = json_read_value(reader, arena);
+
+    // Checks that there is no text after the root value.
+    reader.next();
+    if (arena != nullptr) {
+        arena->seal(r);
+    }
+    return r;
+}
+
+} // namespace detail
+
 hi_export constexpr void format_JSON_impl(datum const& value, std::string& result, hi::indent indent = {})
 {
     if (holds_alternative<nullptr_t>(value)) {
@@ -108,3 +108,204 @@ TEST(JSON, ParseTwoItemObject)
     ASSERT_EQ(parse_JSON("{\"foo\": {\"bar\": 42, \"baz\": 43}}"), expected);
     ASSERT_EQ(parse_JSON("{\"foo\": {\"bar\": 42, \"baz\": 43,}}"), expected);
 }
+
+TEST(JSON, ReaderEvents)
+{
+    using enum json_reader::event_type;
+
+    auto text = std::string_view{"{\"foo\": [42, -1.5, \"bar\", true, null], \"baz\": {}}"};
+    auto reader = json_reader{text};
+
+    ASSERT_EQ(reader.next(), begin_object);
+    ASSERT_EQ(reader.next(), key);
+    ASSERT_EQ(reader.text(), "foo");
+    ASSERT_EQ(reader.next(), begin_array);
+    ASSERT_EQ(reader.depth(), 2);
+    ASSERT_EQ(reader.next(), integer);
+    ASSERT_EQ(reader.integer(), 42);
+    ASSERT_EQ(reader.next(), real);
+    ASSERT_EQ(reader.real(), -1.5);
+    ASSERT_EQ(reader.next(), string);
+    ASSERT_EQ(reader.text(), "bar");
+    ASSERT_EQ(reader.next(), boolean);
+    ASSERT_TRUE(reader.boolean());
+    ASSERT_EQ(reader.next(), null);
+    ASSERT_EQ(reader.next(), end_array);
+    ASSERT_EQ(reader.next(), key);
+    ASSERT_EQ(reader.text(), "baz");
+    ASSERT_EQ(reader.next(), begin_object);
+    ASSERT_EQ(reader.next(), end_object);
+    ASSERT_EQ(reader.next(), end_object);
+    ASSERT_EQ(reader.depth(), 0);
+    ASSERT_EQ(reader.next(), end);
+}
+
+TEST(JSON, ReaderStringsAreViews)
+{
+    auto text = std::string_view{"[\"plain\", \"esc\\\"aped\"]"};
+    auto reader = json_reader{text};
+
+    ASSERT_EQ(reader.next(), json_reader::event_type::begin_array);
+    ASSERT_EQ(reader.next(), json_reader::event_type::string);
+    ASSERT_EQ(reader.text(), "plain");
+    ASSERT_EQ(reader.text().data(), text.data() + 2);
+
+    // Escape sequences are kept verbatim, the same as parse_JSON().
+    ASSERT_EQ(reader.next(), json_reader::event_type::string);
+    ASSERT_EQ(reader.text(), "esc\\\"aped");
+    hilet tree = parse_JSON(text);
+    ASSERT_EQ(static_cast<std::string>(tree[1]), reader.text());
+}
+
+TEST(JSON, ReaderSkip)
+{
+    auto text = std::string_view{"{\"a\": {\"x\": [1, [2, 3], {\"y\": 4}]}, \"b\": [5, 6], \"c\": 7}"};
+    auto reader = json_reader{text};
+
+    auto c = 0ll;
+    ASSERT_EQ(reader.next(), json_reader::event_type::begin_object);
+    while (reader.next() == json_reader::event_type::key) {
+        if (reader.text() == "c") {
+            ASSERT_EQ(reader.next(), json_reader::event_type::integer);
+            c = reader.integer();
+        } else {
+            reader.skip();
+        }
+    }
+    ASSERT_EQ(reader.event(), json_reader::event_type::end_object);
+    ASSERT_EQ(c, 7);
+    ASSERT_EQ(reader.next(), json_reader::event_type::end);
+}
+
+TEST(JSON, ReaderDialect)
+{
+    using enum json_reader::event_type;
+
+    // Line comments and trailing commas, the same as parse_JSON().
+    auto reader = json_reader{"// comment\n{\"foo\": [42,], // comment\n}"};
+    ASSERT_EQ(reader.next(), begin_object);
+    ASSERT_EQ(reader.next(), key);
+    ASSERT_EQ(reader.next(), begin_array);
+    ASSERT_EQ(reader.next(), integer);
+    ASSERT_EQ(reader.next(), end_array);
+    ASSERT_EQ(reader.next(), end_object);
+    ASSERT_EQ(reader.next(), end);
+}
+
+TEST(JSON, ReaderErrors)
+{
+    auto read_all = [](std::string_view text) {
+        auto reader = json_reader{text};
+        while (reader.next() != json_reader::event_type::end) {}
+    };
+
+    ASSERT_THROW(read_all(""), parse_error);
+    ASSERT_THROW(read_all("{"), parse_error);
+    ASSERT_THROW(read_all("{\"foo\" 42}"), parse_error);
+    ASSERT_THROW(read_all("{\"foo\": 42 \"bar\": 43}"), parse_error);
+    ASSERT_THROW(read_all("[42 43]"), parse_error);
+    ASSERT_THROW(read_all("[42}"), parse_error);
+    ASSERT_THROW(read_all("[\"foo]"), parse_error);
+    ASSERT_THROW(read_all("[nil]"), parse_error);
+    ASSERT_THROW(read_all("[-]"), parse_error);
+    ASSERT_THROW(read_all("{} {}"), parse_error);
+    ASSERT_NO_THROW(read_all("42"));
+}
+
+TEST(JSON, FindNonBlank)
+{
+    for (auto size = 0_uz; size != 80; ++size) {
+        for (auto position = 0_uz; position <= size; ++position) {
+            auto text = std::string(size, ' ');
+            for (auto i = 0_uz; i != size; ++i) {
+                text[i] = " \t\r\n"[i % 4];
+            }
+            if (position != size) {
+                text[position] = '\f';
+            }
+
+            hilet first = text.data();
+            hilet last = text.data() + text.size();
+            ASSERT_EQ(detail::json_find_non_blank(first, last), first + position);
+        }
+    }
+}
+
+TEST(JSON, FindQuoteOrBackslash)
+{
+    for (auto size = 0_uz; size != 80; ++size) {
+        for (auto position = 0_uz; position <= size; ++position) {
+            for (hilet c : {'"', '\\'}) {
+                auto text = std::string(size, 'x');
+                if (position != size) {
+                    text[position] = c;
+                }
+                // A second match later in the text must not be found first.
+                if (position + 1 < size) {
+                    text.back() = '"';
+                }
+
+                hilet first = text.data();
+                hilet last = text.data() + text.size();
+                ASSERT_EQ(detail::json_find_quote_or_backslash(first, last), first + position);
+            }
+        }
+    }
+}
+
+TEST(JSON, ParseLongStringsAndIndentation)
+{
+    hilet long_string = std::string(100, 'a') + "\\\"" + std::string(40, 'b') + "\\\\";
+
+    auto text = std::string{"{\n"};
+    text += std::string(40, ' ') + "\"foo\":\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\"" + long_string + "\",\r\n";
+    text += std::string(70, ' ') + "// A comment\n";
+    text += std::string(70, ' ') + "\"bar\": [" + std::string(33, '\n') + "1, \"" + long_string + "\"]\n";
+    text += "}";
+
+    auto expected = datum::make_map();
+    expected["foo"] = long_string;
+    expected["bar"] = datum::make_vector(1, long_string);
+    ASSERT_EQ(parse_JSON(text), expected);
+}
+
+TEST(JSON, ParseIntoArena)
+{
+    hilet text = std::string{"{\"foo\": [42, -1.5, \"bar\", true, null], \"baz\": {\"qux\": \"quux\"}}"};
+    hilet expected = parse_JSON(text);
+
+    auto arena = datum_arena{};
+    auto value = parse_JSON(text, arena);
+    ASSERT_EQ(value, expected);
+
+    // Mixing heap and arena allocated values in the same tree.
+    value["baz"]["corge"] = datum::make_vector(1, 2, 3);
+    value["foo"].push_back("grault");
+    value["foo"][0] = datum::make_map("garply", 1);
+    ASSERT_EQ(size(value["foo"]), 6);
+    ASSERT_EQ(value["baz"]["corge"][2], 3);
+}
+
+TEST(JSON, MoveOutOfArena)
+{
+    hilet text = std::string{"{\"foo\": [\"A string longer than the small string buffer\", [1, 2]], \"bar\": {\"baz\": \"qux\"}}"};
+
+    auto string_value = datum{};
+    auto vector_value = datum{};
+    auto map_value = datum{};
+    {
+        auto arena = datum_arena{};
+        auto value = parse_JSON(text, arena);
+
+        string_value = std::move(value["foo"][0]);
+        auto tmp = std::move(value["foo"][1]);
+        vector_value = std::move(tmp);
+        map_value = std::move(value["bar"]);
+        value["foo"][0] = "replaced";
+    }
+
+    // The values were copied to the heap when they were moved out of the arena.
+    ASSERT_EQ(string_value, datum{"A string longer than the small string buffer"});
+    ASSERT_EQ(vector_value, datum::make_vector(1, 2));
+    ASSERT_EQ(map_value, datum::make_map("baz", "qux"));
+}
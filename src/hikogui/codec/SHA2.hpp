@@ -9,9 +9,17 @@
 #include "../macros.hpp"
 #include <bit>
 #include <array>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <type_traits>
 #include <cstdint>
 #include <span>
 
+#if defined(HI_HAS_SHA) or defined(HI_HAS_AVX2)
+#include <immintrin.h>
+#endif
+
 hi_export_module(hikogui.codec.SHA2);
 
 hi_warning_push();
@@ -21,6 +29,158 @@ hi_warning_ignore_msvc(26429);
 
 namespace hi { inline namespace v1 {
 
+hi_export template<typename Hash>
+[[nodiscard]] std::vector<bstring> SHA2_parallel(std::span<bstring_view const> messages);
+
+namespace detail {
+
+#if defined(HI_HAS_AVX2)
+/** Operations on SHA-2 words in the lanes of a vector register.
+ *
+ * Each lane is working on a different message.
+ */
+template<typename T>
+struct SHA2_lanes;
+
+template<>
+struct SHA2_lanes<uint32_t> {
+    using vector_type = __m256i;
+    constexpr static std::size_t size = 8;
+
+    [[nodiscard]] static vector_type broadcast(uint32_t x) noexcept
+    {
+        return _mm256_set1_epi32(static_cast<int>(x));
+    }
+
+    [[nodiscard]] static vector_type load(uint32_t const *ptr) noexcept
+    {
+        return _mm256_load_si256(reinterpret_cast<__m256i const *>(ptr));
+    }
+
+    static void store(uint32_t *ptr, vector_type x) noexcept
+    {
+        _mm256_store_si256(reinterpret_cast<__m256i *>(ptr), x);
+    }
+
+    [[nodiscard]] static vector_type add(vector_type x, vector_type y) noexcept
+    {
+        return _mm256_add_epi32(x, y);
+    }
+
+    template<int N>
+    [[nodiscard]] static vector_type rotr(vector_type x) noexcept
+    {
+        return _mm256_or_si256(_mm256_srli_epi32(x, N), _mm256_slli_epi32(x, 32 - N));
+    }
+
+    template<int N>
+    [[nodiscard]] static vector_type shr(vector_type x) noexcept
+    {
+        return _mm256_srli_epi32(x, N);
+    }
+
+    [[nodiscard]] static vector_type Maj(vector_type x, vector_type y, vector_type z) noexcept
+    {
+        return _mm256_or_si256(_mm256_and_si256(x, y), _mm256_and_si256(z, _mm256_or_si256(x, y)));
+    }
+
+    [[nodiscard]] static vector_type Ch(vector_type x, vector_type y, vector_type z) noexcept
+    {
+        return _mm256_xor_si256(_mm256_and_si256(x, y), _mm256_andnot_si256(x, z));
+    }
+
+    [[nodiscard]] static vector_type S0(vector_type x) noexcept
+    {
+        return _mm256_xor_si256(_mm256_xor_si256(rotr<2>(x), rotr<13>(x)), rotr<22>(x));
+    }
+
+    [[nodiscard]] static vector_type S1(vector_type x) noexcept
+    {
+        return _mm256_xor_si256(_mm256_xor_si256(rotr<6>(x), rotr<11>(x)), rotr<25>(x));
+    }
+
+    [[nodiscard]] static vector_type s0(vector_type x) noexcept
+    {
+        return _mm256_xor_si256(_mm256_xor_si256(rotr<7>(x), rotr<18>(x)), shr<3>(x));
+    }
+
+    [[nodiscard]] static vector_type s1(vector_type x) noexcept
+    {
+        return _mm256_xor_si256(_mm256_xor_si256(rotr<17>(x), rotr<19>(x)), shr<10>(x));
+    }
+};
+
+template<>
+struct SHA2_lanes<uint64_t> {
+    using vector_type = __m256i;
+    constexpr static std::size_t size = 4;
+
+    [[nodiscard]] static vector_type broadcast(uint64_t x) noexcept
+    {
+        return _mm256_set1_epi64x(static_cast<long long>(x));
+    }
+
+    [[nodiscard]] static vector_type load(uint64_t const *ptr) noexcept
+    {
+        return _mm256_load_si256(reinterpret_cast<__m256i const *>(ptr));
+    }
+
+    static void store(uint64_t *ptr, vector_type x) noexcept
+    {
+        _mm256_store_si256(reinterpret_cast<__m256i *>(ptr), x);
+    }
+
+    [[nodiscard]] static vector_type add(vector_type x, vector_type y) noexcept
+    {
+        return _mm256_add_epi64(x, y);
+    }
+
+    template<int N>
+    [[nodiscard]] static vector_type rotr(vector_type x) noexcept
+    {
+        return _mm256_or_si256(_mm256_srli_epi64(x, N), _mm256_slli_epi64(x, 64 - N));
+    }
+
+    template<int N>
+    [[nodiscard]] static vector_type shr(vector_type x) noexcept
+    {
+        return _mm256_srli_epi64(x, N);
+    }
+
+    [[nodiscard]] static vector_type Maj(vector_type x, vector_type y, vector_type z) noexcept
+    {
+        return _mm256_or_si256(_mm256_and_si256(x, y), _mm256_and_si256(z, _mm256_or_si256(x, y)));
+    }
+
+    [[nodiscard]] static vector_type Ch(vector_type x, vector_type y, vector_type z) noexcept
+    {
+        return _mm256_xor_si256(_mm256_and_si256(x, y), _mm256_andnot_si256(x, z));
+    }
+
+    [[nodiscard]] static vector_type S0(vector_type x) noexcept
+    {
+        return _mm256_xor_si256(_mm256_xor_si256(rotr<28>(x), rotr<34>(x)), rotr<39>(x));
+    }
+
+    [[nodiscard]] static vector_type S1(vector_type x) noexcept
+    {
+        return _mm256_xor_si256(_mm256_xor_si256(rotr<14>(x), rotr<18>(x)), rotr<41>(x));
+    }
+
+    [[nodiscard]] static vector_type s0(vector_type x) noexcept
+    {
+        return _mm256_xor_si256(_mm256_xor_si256(rotr<1>(x), rotr<8>(x)), shr<7>(x));
+    }
+
+    [[nodiscard]] static vector_type s1(vector_type x) noexcept
+    {
+        return _mm256_xor_si256(_mm256_xor_si256(rotr<19>(x), rotr<61>(x)), shr<6>(x));
+    }
+};
+#endif
+
+} // namespace detail
+
 hi_export template<typename T, std::size_t Bits>
 class SHA2 {
     static_assert(Bits % 8 == 0);
@@ -103,20 +263,10 @@ class SHA2 {
 
         constexpr static std::size_t size = sizeof(v);
 
-        constexpr void set_byte(std::size_t i, std::byte value) noexcept
-        {
-            hilet word_nr = i / sizeof(T);
-            hilet byte_nr = i % sizeof(T);
-            auto& word = v[word_nr];
-
-            hilet valueT = static_cast<T>(static_cast<uint8_t>(value));
-            word |= valueT << (sizeof(T) - 1 - byte_nr) * 8;
-        }
-
         constexpr block_type(std::byte const *ptr) noexcept : v()
         {
-            for (std::size_t i = 0; i != size; ++i) {
-                set_byte(i, *(ptr++));
+            for (std::size_t i = 0; i != v.size(); ++i) {
+                v[i] = load_be<T>(ptr + i * sizeof(T));
             }
         }
 
@@ -141,36 +291,36 @@ class SHA2 {
 
     std::size_t size;
 
+    constexpr static std::array<uint32_t, 64> K32 = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+    constexpr static std::array<uint64_t, 80> K64 = {
+        0x428a2f98d728ae22, 0x7137449123ef65cd, 0xb5c0fbcfec4d3b2f, 0xe9b5dba58189dbbc, 0x3956c25bf348b538,
+        0x59f111f1b605d019, 0x923f82a4af194f9b, 0xab1c5ed5da6d8118, 0xd807aa98a3030242, 0x12835b0145706fbe,
+        0x243185be4ee4b28c, 0x550c7dc3d5ffb4e2, 0x72be5d74f27b896f, 0x80deb1fe3b1696b1, 0x9bdc06a725c71235,
+        0xc19bf174cf692694, 0xe49b69c19ef14ad2, 0xefbe4786384f25e3, 0x0fc19dc68b8cd5b5, 0x240ca1cc77ac9c65,
+        0x2de92c6f592b0275, 0x4a7484aa6ea6e483, 0x5cb0a9dcbd41fbd4, 0x76f988da831153b5, 0x983e5152ee66dfab,
+        0xa831c66d2db43210, 0xb00327c898fb213f, 0xbf597fc7beef0ee4, 0xc6e00bf33da88fc2, 0xd5a79147930aa725,
+        0x06ca6351e003826f, 0x142929670a0e6e70, 0x27b70a8546d22ffc, 0x2e1b21385c26c926, 0x4d2c6dfc5ac42aed,
+        0x53380d139d95b3df, 0x650a73548baf63de, 0x766a0abb3c77b2a8, 0x81c2c92e47edaee6, 0x92722c851482353b,
+        0xa2bfe8a14cf10364, 0xa81a664bbc423001, 0xc24b8b70d0f89791, 0xc76c51a30654be30, 0xd192e819d6ef5218,
+        0xd69906245565a910, 0xf40e35855771202a, 0x106aa07032bbd1b8, 0x19a4c116b8d2d0c8, 0x1e376c085141ab53,
+        0x2748774cdf8eeb99, 0x34b0bcb5e19b48a8, 0x391c0cb3c5c95a63, 0x4ed8aa4ae3418acb, 0x5b9cca4f7763e373,
+        0x682e6ff3d6b2b8a3, 0x748f82ee5defb2fc, 0x78a5636f43172f60, 0x84c87814a1f0ab72, 0x8cc702081a6439ec,
+        0x90befffa23631e28, 0xa4506cebde82bde9, 0xbef9a3f7b2c67915, 0xc67178f2e372532b, 0xca273eceea26619c,
+        0xd186b8c721c0c207, 0xeada7dd6cde0eb1e, 0xf57d4f7fee6ed178, 0x06f067aa72176fba, 0x0a637dc5a2c898a6,
+        0x113f9804bef90dae, 0x1b710b35131c471b, 0x28db77f523047d84, 0x32caab7b40c72493, 0x3c9ebe0a15c9bebc,
+        0x431d67c49c100d4c, 0x4cc5d4becb3e42b6, 0x597f299cfc657e2a, 0x5fcb6fab3ad6faec, 0x6c44198c4a475817};
+
     [[nodiscard]] constexpr static T K(std::size_t i) noexcept
     {
-        constexpr std::array<uint32_t, 64> K32 = {
-            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
-            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
-            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
-            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
-            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
-            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
-            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
-            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
-
-        constexpr std::array<uint64_t, 80> K64 = {
-            0x428a2f98d728ae22, 0x7137449123ef65cd, 0xb5c0fbcfec4d3b2f, 0xe9b5dba58189dbbc, 0x3956c25bf348b538,
-            0x59f111f1b605d019, 0x923f82a4af194f9b, 0xab1c5ed5da6d8118, 0xd807aa98a3030242, 0x12835b0145706fbe,
-            0x243185be4ee4b28c, 0x550c7dc3d5ffb4e2, 0x72be5d74f27b896f, 0x80deb1fe3b1696b1, 0x9bdc06a725c71235,
-            0xc19bf174cf692694, 0xe49b69c19ef14ad2, 0xefbe4786384f25e3, 0x0fc19dc68b8cd5b5, 0x240ca1cc77ac9c65,
-            0x2de92c6f592b0275, 0x4a7484aa6ea6e483, 0x5cb0a9dcbd41fbd4, 0x76f988da831153b5, 0x983e5152ee66dfab,
-            0xa831c66d2db43210, 0xb00327c898fb213f, 0xbf597fc7beef0ee4, 0xc6e00bf33da88fc2, 0xd5a79147930aa725,
-            0x06ca6351e003826f, 0x142929670a0e6e70, 0x27b70a8546d22ffc, 0x2e1b21385c26c926, 0x4d2c6dfc5ac42aed,
-            0x53380d139d95b3df, 0x650a73548baf63de, 0x766a0abb3c77b2a8, 0x81c2c92e47edaee6, 0x92722c851482353b,
-            0xa2bfe8a14cf10364, 0xa81a664bbc423001, 0xc24b8b70d0f89791, 0xc76c51a30654be30, 0xd192e819d6ef5218,
-            0xd69906245565a910, 0xf40e35855771202a, 0x106aa07032bbd1b8, 0x19a4c116b8d2d0c8, 0x1e376c085141ab53,
-            0x2748774cdf8eeb99, 0x34b0bcb5e19b48a8, 0x391c0cb3c5c95a63, 0x4ed8aa4ae3418acb, 0x5b9cca4f7763e373,
-            0x682e6ff3d6b2b8a3, 0x748f82ee5defb2fc, 0x78a5636f43172f60, 0x84c87814a1f0ab72, 0x8cc702081a6439ec,
-            0x90befffa23631e28, 0xa4506cebde82bde9, 0xbef9a3f7b2c67915, 0xc67178f2e372532b, 0xca273eceea26619c,
-            0xd186b8c721c0c207, 0xeada7dd6cde0eb1e, 0xf57d4f7fee6ed178, 0x06f067aa72176fba, 0x0a637dc5a2c898a6,
-            0x113f9804bef90dae, 0x1b710b35131c471b, 0x28db77f523047d84, 0x32caab7b40c72493, 0x3c9ebe0a15c9bebc,
-            0x431d67c49c100d4c, 0x4cc5d4becb3e42b6, 0x597f299cfc657e2a, 0x5fcb6fab3ad6faec, 0x6c44198c4a475817};
-
         if constexpr (std::is_same_v<T, uint32_t>) {
             return K32[i];
         } else {
@@ -262,6 +412,234 @@ class SHA2 {
         state += tmp;
     }
 
+#if defined(HI_HAS_SHA)
+    /** Compress whole blocks using the x86 SHA extensions.
+     *
+     * The state is kept in registers between blocks.
+     */
+    void add_blocks_SHA_NI(cbyteptr ptr, std::size_t nr_blocks) noexcept
+        requires(std::is_same_v<T, uint32_t>)
+    {
+#if defined(HI_HAS_AVX)
+        // The SHA instructions only have a legacy SSE encoding; avoid the AVX-SSE transition penalty.
+        _mm256_zeroupper();
+#endif
+
+        hilet byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+
+        // The SHA instructions work on the state split into {a, b, e, f} and {c, d, g, h}.
+        auto abef = _mm_setr_epi32(
+            static_cast<int>(state.f), static_cast<int>(state.e), static_cast<int>(state.b), static_cast<int>(state.a));
+        auto cdgh = _mm_setr_epi32(
+            static_cast<int>(state.h), static_cast<int>(state.g), static_cast<int>(state.d), static_cast<int>(state.c));
+
+        for (; nr_blocks != 0; --nr_blocks, ptr += block_type::size) {
+            hilet abef_save = abef;
+            hilet cdgh_save = cdgh;
+
+            // Each iteration does four rounds, W holds the last sixteen words of the message schedule.
+            __m128i W[4];
+            for (std::size_t i = 0; i != 16; ++i) {
+                auto& w = W[i % 4];
+                if (i < 4) {
+                    w = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(ptr + i * 16)), byte_swap);
+                } else {
+                    hilet w7 = _mm_alignr_epi8(W[(i - 1) % 4], W[(i - 2) % 4], 4);
+                    w = _mm_sha256msg2_epu32(_mm_add_epi32(_mm_sha256msg1_epu32(w, W[(i - 3) % 4]), w7), W[(i - 1) % 4]);
+                }
+
+                hilet wk = _mm_add_epi32(w, _mm_loadu_si128(reinterpret_cast<__m128i const *>(K32.data() + i * 4)));
+                cdgh = _mm_sha256rnds2_epu32(cdgh, abef, wk);
+                abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(wk, 0x0e));
+            }
+
+            abef = _mm_add_epi32(abef, abef_save);
+            cdgh = _mm_add_epi32(cdgh, cdgh_save);
+        }
+
+        state.a = static_cast<uint32_t>(_mm_extract_epi32(abef, 3));
+        state.b = static_cast<uint32_t>(_mm_extract_epi32(abef, 2));
+        state.e = static_cast<uint32_t>(_mm_extract_epi32(abef, 1));
+        state.f = static_cast<uint32_t>(_mm_extract_epi32(abef, 0));
+        state.c = static_cast<uint32_t>(_mm_extract_epi32(cdgh, 3));
+        state.d = static_cast<uint32_t>(_mm_extract_epi32(cdgh, 2));
+        state.g = static_cast<uint32_t>(_mm_extract_epi32(cdgh, 1));
+        state.h = static_cast<uint32_t>(_mm_extract_epi32(cdgh, 0));
+    }
+#endif
+
+    constexpr void add_blocks(cbyteptr ptr, std::size_t nr_blocks) noexcept
+    {
+#if defined(HI_HAS_SHA)
+        if constexpr (std::is_same_v<T, uint32_t>) {
+            if (not std::is_constant_evaluated()) {
+                return add_blocks_SHA_NI(ptr, nr_blocks);
+            }
+        }
+#endif
+
+        for (; nr_blocks != 0; --nr_blocks, ptr += block_type::size) {
+            add(block_type{ptr});
+        }
+    }
+
+#if defined(HI_HAS_AVX2)
+    /** Hash several messages at the same time, one message per lane of a vector register.
+     *
+     * When a message is finished the lane continues with the next message, so that
+     * messages of different lengths keep all the lanes busy.
+     *
+     * @param initial The initial state of the hash.
+     * @param messages The messages to hash.
+     * @param[out] digests The hash of each message.
+     */
+    static void add_lanes(state_type const& initial, std::span<bstring_view const> messages, std::span<bstring> digests)
+    {
+        using lanes_type = detail::SHA2_lanes<T>;
+        using vector_type = typename lanes_type::vector_type;
+        constexpr auto nr_lanes = lanes_type::size;
+
+        hi_axiom(messages.size() == digests.size());
+
+        struct lane_type {
+            std::size_t message_nr = 0;
+            cbyteptr ptr = nullptr;
+            std::size_t nr_blocks = 0;
+            std::size_t nr_tail_blocks = 0;
+            std::size_t tail_block_nr = 0;
+
+            /** The last partial block of the message followed by the padding.
+             */
+            std::array<std::byte, 2 * block_type::size> tail = {};
+
+            [[nodiscard]] cbyteptr next_block() noexcept
+            {
+                hi_axiom(nr_blocks != 0);
+                --nr_blocks;
+                if (nr_blocks >= nr_tail_blocks) {
+                    return std::exchange(ptr, ptr + block_type::size);
+                } else {
+                    return tail.data() + (tail_block_nr++) * block_type::size;
+                }
+            }
+        };
+
+        // The state and the message block of each lane, transposed so that each word can be loaded in a vector.
+        alignas(sizeof(vector_type)) std::array<std::array<T, nr_lanes>, 8> state_words;
+        alignas(sizeof(vector_type)) std::array<std::array<T, nr_lanes>, 16> block_words = {};
+
+        auto lanes = std::array<lane_type, nr_lanes>{};
+        auto next_message_nr = 0_uz;
+        auto nr_active = 0_uz;
+
+        auto start_lane = [&](std::size_t lane_nr) {
+            auto& lane = lanes[lane_nr];
+            if (next_message_nr == messages.size()) {
+                return;
+            }
+
+            hilet message = messages[next_message_nr];
+            hilet nr_full_blocks = message.size() / block_type::size;
+            hilet tail_size = message.size() % block_type::size;
+
+            lane.message_nr = next_message_nr++;
+            lane.ptr = message.data();
+            lane.nr_tail_blocks = tail_size + 1 + pad_length_of_length <= block_type::size ? 1 : 2;
+            lane.nr_blocks = nr_full_blocks + lane.nr_tail_blocks;
+            lane.tail_block_nr = 0;
+
+            lane.tail.fill(std::byte{0x00});
+            std::copy_n(message.data() + nr_full_blocks * block_type::size, tail_size, lane.tail.begin());
+            lane.tail[tail_size] = std::byte{0x80};
+
+            std::size_t nr_of_bits = message.size() * 8;
+            auto length_it = lane.tail.begin() + lane.nr_tail_blocks * block_type::size;
+            for (std::size_t i = 0; i != sizeof(nr_of_bits); ++i) {
+                *(--length_it) = static_cast<std::byte>(nr_of_bits >> i * 8);
+            }
+
+            for (std::size_t i = 0; i != 8; ++i) {
+                state_words[i][lane_nr] = initial.get_word(i);
+            }
+            ++nr_active;
+        };
+
+        for (std::size_t lane_nr = 0; lane_nr != nr_lanes; ++lane_nr) {
+            start_lane(lane_nr);
+        }
+
+        while (nr_active != 0) {
+            for (std::size_t lane_nr = 0; lane_nr != nr_lanes; ++lane_nr) {
+                auto& lane = lanes[lane_nr];
+                if (lane.nr_blocks != 0) {
+                    hilet ptr = lane.next_block();
+                    for (std::size_t i = 0; i != 16; ++i) {
+                        block_words[i][lane_nr] = load_be<T>(ptr + i * sizeof(T));
+                    }
+                }
+            }
+
+            vector_type s[8];
+            for (std::size_t i = 0; i != 8; ++i) {
+                s[i] = lanes_type::load(state_words[i].data());
+            }
+
+            vector_type W[16];
+            for (std::size_t i = 0; i != 16; ++i) {
+                W[i] = lanes_type::load(block_words[i].data());
+            }
+
+            auto [a, b, c, d, e, f, g, h] = s;
+            for (std::size_t i = 0; i != nr_rounds; ++i) {
+                if (i >= 16) {
+                    W[i % 16] = lanes_type::add(
+                        lanes_type::add(lanes_type::s1(W[(i - 2) % 16]), W[(i - 7) % 16]),
+                        lanes_type::add(lanes_type::s0(W[(i - 15) % 16]), W[i % 16]));
+                }
+
+                hilet T1 = lanes_type::add(
+                    lanes_type::add(h, lanes_type::S1(e)),
+                    lanes_type::add(lanes_type::Ch(e, f, g), lanes_type::add(lanes_type::broadcast(K(i)), W[i % 16])));
+                hilet T2 = lanes_type::add(lanes_type::S0(a), lanes_type::Maj(a, b, c));
+
+                h = g;
+                g = f;
+                f = e;
+                e = lanes_type::add(d, T1);
+                d = c;
+                c = b;
+                b = a;
+                a = lanes_type::add(T1, T2);
+            }
+
+            vector_type const r[8] = {a, b, c, d, e, f, g, h};
+            for (std::size_t i = 0; i != 8; ++i) {
+                lanes_type::store(state_words[i].data(), lanes_type::add(s[i], r[i]));
+            }
+
+            for (std::size_t lane_nr = 0; lane_nr != nr_lanes; ++lane_nr) {
+                auto& lane = lanes[lane_nr];
+                if (lane.nr_blocks == 0 and lane.nr_tail_blocks != 0) {
+                    hilet lane_state = state_type{
+                        state_words[0][lane_nr],
+                        state_words[1][lane_nr],
+                        state_words[2][lane_nr],
+                        state_words[3][lane_nr],
+                        state_words[4][lane_nr],
+                        state_words[5][lane_nr],
+                        state_words[6][lane_nr],
+                        state_words[7][lane_nr]};
+                    digests[lane.message_nr] = lane_state.template get_bytes<Bits / 8>();
+
+                    lane.nr_tail_blocks = 0;
+                    --nr_active;
+                    start_lane(lane_nr);
+                }
+            }
+        }
+    }
+#endif
+
     constexpr void add_to_overflow(cbyteptr& ptr, std::byte const *last) noexcept
     {
         hi_axiom_not_null(ptr);
@@ -286,7 +664,7 @@ class SHA2 {
             while (overflow_it != overflow.end()) {
                 *(overflow_it++) = std::byte{0x00};
             }
-            add(block_type{overflow.data()});
+            add_blocks(overflow.data(), 1);
             overflow_it = overflow.begin();
         }
 
@@ -301,10 +679,12 @@ class SHA2 {
             *(overflow_it++) = i < sizeof(nr_of_bits) ? static_cast<std::byte>(nr_of_bits >> i * 8) : std::byte{0x00};
         }
 
-        auto b = block_type{overflow.data()};
-        add(b);
+        add_blocks(overflow.data(), 1);
     }
 
+    template<typename Hash>
+    friend std::vector<bstring> SHA2_parallel(std::span<bstring_view const> messages);
+
 public:
     constexpr SHA2(T a, T b, T c, T d, T e, T f, T g, T h) noexcept :
         state(a, b, c, d, e, f, g, h), overflow(), overflow_it(overflow.begin()), size(0)
@@ -319,7 +699,7 @@ public:
             add_to_overflow(ptr, last);
 
             if (overflow_it == overflow.end()) {
-                add(block_type{overflow.data()});
+                add_blocks(overflow.data(), 1);
                 overflow_it = overflow.begin();
 
             } else {
@@ -330,10 +710,9 @@ public:
             }
         }
 
-        while (ptr + block_type::size <= last) {
-            add(block_type{ptr});
-            ptr += block_type::size;
-        }
+        hilet nr_blocks = narrow_cast<std::size_t>(last - ptr) / block_type::size;
+        add_blocks(ptr, nr_blocks);
+        ptr += nr_blocks * block_type::size;
 
         add_to_overflow(ptr, last);
 
@@ -464,6 +843,32 @@ public:
     }
 };
 
+/** Hash several independent messages.
+ *
+ * With AVX2 the messages are hashed at the same time in the lanes of a vector
+ * register; eight messages for SHA-224/256 and four messages for the SHA-512 family.
+ *
+ * @tparam Hash The hash algorithm: SHA224, SHA256, SHA384, SHA512, SHA512_224 or SHA512_256.
+ * @param messages The messages to hash.
+ * @return The hash of each message, in the same order as @a messages.
+ */
+hi_export template<typename Hash>
+[[nodiscard]] std::vector<bstring> SHA2_parallel(std::span<bstring_view const> messages)
+{
+#if defined(HI_HAS_AVX2)
+    auto r = std::vector<bstring>(messages.size());
+    Hash::add_lanes(Hash{}.state, messages, r);
+    return r;
+#else
+    auto r = std::vector<bstring>{};
+    r.reserve(messages.size());
+    for (hilet message : messages) {
+        r.push_back(Hash{}.add(message).get_bytes());
+    }
+    return r;
+#endif
+}
+
 }} // namespace hi::v1
 
 hi_warning_pop();
@@ -162,3 +162,46 @@ TEST(SHA2, NESSIE512Set1)
         "DE0FF244877EA60A4CB0432CE577C31B"
         "EB009C5C2C49AA2E4EADB217AD8CC09B");
 }
+
+template<typename T>
+void test_sha2_parallel(std::size_t nr_messages)
+{
+    // Message lengths cross the block and padding boundaries, so that lanes finish at different times.
+    auto messages = std::vector<bstring>{};
+    for (auto i = 0_uz; i != nr_messages; ++i) {
+        hilet size = (i * 37) % 300;
+        auto message = bstring{};
+        for (auto j = 0_uz; j != size; ++j) {
+            message += static_cast<std::byte>(i + j * 7);
+        }
+        messages.push_back(std::move(message));
+    }
+
+    hilet views = std::vector<bstring_view>(messages.begin(), messages.end());
+    hilet digests = SHA2_parallel<T>(views);
+    ASSERT_EQ(digests.size(), nr_messages);
+
+    for (auto i = 0_uz; i != nr_messages; ++i) {
+        auto hash = T();
+        hash.add(messages[i]);
+        ASSERT_EQ(digests[i], hash.get_bytes()) << "message " << i;
+    }
+}
+
+TEST(SHA2, Parallel)
+{
+    for (auto nr_messages : {0_uz, 1_uz, 3_uz, 8_uz, 9_uz, 100_uz}) {
+        test_sha2_parallel<SHA224>(nr_messages);
+        test_sha2_parallel<SHA256>(nr_messages);
+        test_sha2_parallel<SHA384>(nr_messages);
+        test_sha2_parallel<SHA512>(nr_messages);
+        test_sha2_parallel<SHA512_224>(nr_messages);
+        test_sha2_parallel<SHA512_256>(nr_messages);
+    }
+
+    hilet abc = to_bstring("abc");
+    hilet views = std::vector<bstring_view>{abc, bstring_view{}};
+    hilet digests = SHA2_parallel<SHA256>(views);
+    ASSERT_CASEEQ(base16::encode(digests[0]), "BA7816BF8F01CFEA414140DE5DAE2223B00361A396177A9CB410FF61F20015AD");
+    ASSERT_CASEEQ(base16::encode(digests[1]), "E3B0C44298FC1C149AFBF4C8996FB92427AE41E4649B934CA495991B7852B855");
+}
@@ -4,6 +4,7 @@
 #include "base_n.hpp" // export
 #include "BON8.hpp" // export
 #include "datum.hpp" // export
+#include "deflate.hpp" // export
 #include "gzip.hpp" // export
 #include "huffman.hpp" // export
 #include "indent.hpp" // export
@@ -18,6 +18,8 @@
 #include <limits>
 #include <vector>
 #include <map>
+#include <memory>
+#include <memory_resource>
 
 hi_warning_push();
 // C26476: Expression/symbol '...' uses a naked union '...' with multiple type pointers: Use variant instead (type.7.).
@@ -200,6 +202,59 @@ class is_datum_type<bstring> : public std::true_type {};
 hi_export template<typename T>
 constexpr bool is_datum_type_v = is_datum_type<T>::value;
 
+hi_export class datum;
+
+/** Memory for the nodes of datum trees which are released in one step.
+ *
+ * The string, vector and map objects of datums created in an arena, for example by
+ * `parse_JSON()` or `decode_BON8()`, are allocated from a monotonic region. Destroying
+ * those datums does not return that memory; the region is released when the arena is
+ * destroyed.
+ *
+ * The characters of the strings and the items of the vectors and maps are still
+ * allocated on the heap.
+ *
+ * The arena must outlive the tree created in it. A value that is copied or moved out
+ * of a finished tree is copied to the heap and is independent of the arena.
+ */
+hi_export class datum_arena {
+public:
+    constexpr static std::size_t default_block_size = 65536;
+
+    ~datum_arena() = default;
+    datum_arena(datum_arena const&) = delete;
+    datum_arena(datum_arena&&) = delete;
+    datum_arena& operator=(datum_arena const&) = delete;
+    datum_arena& operator=(datum_arena&&) = delete;
+
+    /** Create an arena.
+     *
+     * @param block_size The size of the first block of memory, following blocks grow geometrically.
+     */
+    explicit datum_arena(std::size_t block_size = default_block_size) : _resource(block_size) {}
+
+    /** Construct an object in the arena.
+     */
+    template<typename T, typename... Args>
+    [[nodiscard]] T *make(Args&&...args)
+    {
+        return std::construct_at(static_cast<T *>(_resource.allocate(sizeof(T), alignof(T))), std::forward<Args>(args)...);
+    }
+
+    /** Finish a tree that was built in this arena.
+     *
+     * After this call the values inside the tree are copied to the heap when they are
+     * moved out of it, so that they can outlive the arena. The root keeps referring to
+     * the arena.
+     *
+     * @param root The root of the tree.
+     */
+    void seal(datum& root) noexcept;
+
+private:
+    std::pmr::monotonic_buffer_resource _resource;
+};
+
 /** A dynamic data type.
  *
  * This class holds data of different types, useful as the data-type used for variables
@@ -251,9 +306,17 @@ public:
         }
     }
 
-    constexpr datum(datum&& other) noexcept : _tag(other._tag), _value(other._value)
+    constexpr datum(datum&& other) noexcept : _tag(other._tag), _owner(other._owner), _value(other._value)
     {
+        if (_owner == node_owner::sealed_arena) [[unlikely]] {
+            // The node belongs to a finished tree in an arena, which may be destroyed before this datum.
+            _owner = node_owner::heap;
+            copy_pointer(other);
+            return;
+        }
+
         other._tag = tag_type::monostate;
+        other._owner = node_owner::heap;
         other._value._long_long = 0;
     }
 
@@ -309,6 +372,64 @@ public:
         return datum{std::move(r)};
     }
 
+    /** Create a string in an arena.
+     *
+     * Call `datum_arena::seal()` on the root of the tree when it is finished.
+     *
+     * @param arena The arena to allocate the string in, or nullptr to allocate on the heap.
+     * @param value The value of the string.
+     */
+    [[nodiscard]] static datum make_string(datum_arena *arena, std::string_view value)
+    {
+        if (arena == nullptr) {
+            return datum{value};
+        }
+
+        auto r = datum{};
+        r._tag = tag_type::string;
+        r._owner = node_owner::arena;
+        r._value = arena->make<std::string>(value);
+        return r;
+    }
+
+    /** Create an empty vector in an arena.
+     *
+     * Call `datum_arena::seal()` on the root of the tree when it is finished.
+     *
+     * @param arena The arena to allocate the vector in, or nullptr to allocate on the heap.
+     */
+    [[nodiscard]] static datum make_vector(datum_arena *arena)
+    {
+        if (arena == nullptr) {
+            return datum{vector_type{}};
+        }
+
+        auto r = datum{};
+        r._tag = tag_type::vector;
+        r._owner = node_owner::arena;
+        r._value = arena->make<vector_type>();
+        return r;
+    }
+
+    /** Create an empty map in an arena.
+     *
+     * Call `datum_arena::seal()` on the root of the tree when it is finished.
+     *
+     * @param arena The arena to allocate the map in, or nullptr to allocate on the heap.
+     */
+    [[nodiscard]] static datum make_map(datum_arena *arena)
+    {
+        if (arena == nullptr) {
+            return datum{map_type{}};
+        }
+
+        auto r = datum{};
+        r._tag = tag_type::map;
+        r._owner = node_owner::arena;
+        r._value = arena->make<map_type>();
+        return r;
+    }
+
     [[nodiscard]] static datum make_break() noexcept
     {
         return datum{break_type{}};
@@ -334,7 +455,17 @@ public:
 
     constexpr datum& operator=(datum&& other) noexcept
     {
+        if (other._owner == node_owner::sealed_arena) [[unlikely]] {
+            return *this = std::as_const(other);
+
+        } else if (_owner == node_owner::sealed_arena) [[unlikely]] {
+            // Release the node here, instead of handing it to `other` which may outlive the arena.
+            delete_pointer();
+            _tag = tag_type::monostate;
+        }
+
         std::swap(_tag, other._tag);
+        std::swap(_owner, other._owner);
         std::swap(_value, other._value);
         return *this;
     }
@@ -1912,7 +2043,27 @@ private:
         bstring = -5
     };
 
+    /** The owner of the memory of the string, vector or map.
+     */
+    enum class node_owner : uint8_t {
+        /** Allocated on the heap and owned by the datum.
+         */
+        heap,
+
+        /** Allocated in a `datum_arena` while the tree is being built.
+         */
+        arena,
+
+        /** Allocated in a `datum_arena` as part of a finished tree.
+         *
+         * Moving the datum makes a copy on the heap.
+         */
+        sealed_arena
+    };
+
     tag_type _tag = tag_type::monostate;
+    node_owner _owner = node_owner::heap;
+
     union value_type {
         double _double;
         long long _long_long;
@@ -1968,21 +2119,32 @@ private:
         }
     }
 
+    template<typename T>
+    void delete_node(T *ptr) noexcept
+    {
+        if (_owner != node_owner::heap) {
+            // The memory is owned by the arena, only the children need to be released.
+            std::destroy_at(ptr);
+        } else {
+            delete ptr;
+        }
+    }
+
     hi_no_inline void _delete_pointer() noexcept
     {
         hi_axiom(is_pointer());
         switch (_tag) {
         case tag_type::string:
-            delete _value._string;
+            delete_node(_value._string);
             return;
         case tag_type::vector:
-            delete _value._vector;
+            delete_node(_value._vector);
             return;
         case tag_type::map:
-            delete _value._map;
+            delete_node(_value._map);
             return;
         case tag_type::bstring:
-            delete _value._bstring;
+            delete_node(_value._bstring);
             return;
         default:
             hi_no_default();
@@ -1993,9 +2155,35 @@ private:
     {
         if (is_pointer()) {
             _delete_pointer();
+            _owner = node_owner::heap;
         }
     }
 
+    void seal_children() noexcept
+    {
+        hilet seal_child = [](datum& child) {
+            if (child._owner == node_owner::arena) {
+                child._owner = node_owner::sealed_arena;
+            }
+            child.seal_children();
+        };
+
+        if (auto vector = get_if<vector_type>(*this)) {
+            for (auto& item : *vector) {
+                seal_child(item);
+            }
+
+        } else if (auto map = get_if<map_type>(*this)) {
+            for (auto& item : *map) {
+                // The owner is not part of the ordering of the keys.
+                seal_child(const_cast<datum&>(item.first));
+                seal_child(item.second);
+            }
+        }
+    }
+
+    friend class datum_arena;
+
     void find_wildcard(jsonpath::const_iterator it, jsonpath::const_iterator it_end, std::vector<datum *>& r) noexcept
     {
         if (auto vector = get_if<datum::vector_type>(*this)) {
@@ -2370,6 +2558,11 @@ private:
     }
 };
 
+inline void datum_arena::seal(datum& root) noexcept
+{
+    root.seal_children();
+}
+
 }} // namespace hi::v1
 
 hi_export template<>
@@ -0,0 +1,512 @@
+// Copyright Take Vos 2023.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "../utility/utility.hpp"
+#include "../container/module.hpp"
+#include "../macros.hpp"
+#include "huffman.hpp"
+#include "inflate.hpp"
+#include <span>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+hi_export_module(hikogui.codec.deflate);
+
+namespace hi { inline namespace v1 {
+
+/** The trade-off between speed and compression ratio of the deflate algorithm.
+ */
+hi_export enum class deflate_level : uint8_t {
+    /** Store the data without compression.
+     */
+    stored,
+
+    /** Greedy matching against the last occurrence of each 3-byte sequence,
+     * encoded with the fixed huffman code.
+     */
+    fast,
+
+    /** Lazy matching over hash chains, encoded with huffman codes optimized for each block.
+     */
+    best
+};
+
+namespace detail {
+
+/** A bit-writer for a deflate bit-stream.
+ *
+ * Bits are ordered LSB first and are collected in a 64-bit integer before
+ * being appended to the output.
+ */
+class deflate_bit_writer {
+public:
+    /** Write bits to the stream.
+     *
+     * @param value The bits to write, the first bit of the stream in the LSB.
+     * @param nr_bits The number of bits to write, at most 32.
+     */
+    void put_bits(std::size_t value, std::size_t nr_bits) noexcept
+    {
+        hi_axiom(nr_bits <= 32);
+        hi_axiom(nr_bits == 32 or value < (1_uz << nr_bits));
+
+        _bits |= uint64_t{value} << _nr_bits;
+        _nr_bits += nr_bits;
+
+        if (_nr_bits >= 32) {
+            for (auto i = 0; i != 4; ++i) {
+                _bytes.push_back(static_cast<std::byte>(_bits));
+                _bits >>= 8;
+            }
+            _nr_bits -= 32;
+        }
+    }
+
+    /** Write a huffman code to the stream.
+     *
+     * @param code The code with the first bit in the MSB, as returned by `huffman_canonical_codes()`.
+     * @param length The length of the code.
+     */
+    void put_code(std::size_t code, std::size_t length) noexcept
+    {
+        auto reversed = 0_uz;
+        for (auto i = 0_uz; i != length; ++i) {
+            reversed = (reversed << 1) | (code & 1);
+            code >>= 1;
+        }
+        put_bits(reversed, length);
+    }
+
+    /** Pad the stream with zero bits to the next byte boundary.
+     */
+    void align_to_byte() noexcept
+    {
+        while (_nr_bits > 0) {
+            _bytes.push_back(static_cast<std::byte>(_bits));
+            _bits >>= 8;
+            _nr_bits -= std::min(_nr_bits, 8_uz);
+        }
+        _bits = 0;
+    }
+
+    /** Append bytes to the stream.
+     *
+     * @pre The stream must be aligned to a byte boundary.
+     */
+    void put_bytes(std::span<std::byte const> bytes) noexcept
+    {
+        hi_axiom(_nr_bits == 0);
+        _bytes.append(bytes.data(), bytes.size());
+    }
+
+    /** Take the bytes that have been written.
+     *
+     * @pre The stream must be aligned to a byte boundary.
+     */
+    [[nodiscard]] bstring take() noexcept
+    {
+        hi_axiom(_nr_bits == 0);
+        return std::move(_bytes);
+    }
+
+private:
+    bstring _bytes = {};
+    uint64_t _bits = 0;
+    std::size_t _nr_bits = 0;
+};
+
+/** A literal or a back reference found by the LZ77 matcher.
+ */
+struct deflate_token {
+    /** The length of the back reference, or zero for a literal.
+     */
+    uint16_t length;
+
+    /** The distance of the back reference, or the value of the literal.
+     */
+    uint16_t distance;
+};
+
+[[nodiscard]] constexpr std::size_t deflate_length_symbol(std::size_t length) noexcept
+{
+    hi_axiom(length >= 3 and length <= 258);
+    hilet it = std::upper_bound(deflate_length_base.begin(), deflate_length_base.end(), length);
+    return 257 + std::distance(deflate_length_base.begin(), it) - 1;
+}
+
+[[nodiscard]] constexpr std::size_t deflate_distance_symbol(std::size_t distance) noexcept
+{
+    hi_axiom(distance >= 1 and distance <= 32768);
+    hilet it = std::upper_bound(deflate_distance_base.begin(), deflate_distance_base.end(), distance);
+    return std::distance(deflate_distance_base.begin(), it) - 1;
+}
+
+/** Find repeated sequences using chains of earlier positions with the same 3-byte hash.
+ */
+class deflate_matcher {
+public:
+    constexpr static std::size_t window_size = 0x8000;
+    constexpr static std::size_t min_match = 3;
+    constexpr static std::size_t max_match = 258;
+
+    deflate_matcher(std::span<std::byte const> bytes, std::size_t max_chain) :
+        _bytes(bytes), _max_chain(max_chain), _head(hash_size, 0), _prev(window_size, 0)
+    {
+    }
+
+    /** Add the sequence at a position to the hash chains.
+     */
+    void insert(std::size_t position) noexcept
+    {
+        if (position + min_match <= _bytes.size()) {
+            auto& head = _head[hash(position)];
+            _prev[position % window_size] = head;
+            head = narrow_cast<uint32_t>(position + 1);
+        }
+    }
+
+    /** Find the longest earlier sequence that matches the bytes at a position.
+     *
+     * @return The length and distance of the match, the length is zero when no match was found.
+     */
+    [[nodiscard]] std::pair<std::size_t, std::size_t> find(std::size_t position) const noexcept
+    {
+        if (position + min_match > _bytes.size()) {
+            return {0, 0};
+        }
+
+        hilet max_length = std::min(max_match, _bytes.size() - position);
+        hilet min_position = position > window_size ? position - window_size : 0_uz;
+
+        auto best_length = min_match - 1;
+        auto best_distance = 0_uz;
+
+        auto candidate_plus_one = _head[hash(position)];
+        for (auto chain = 0_uz; chain != _max_chain and candidate_plus_one > min_position; ++chain) {
+            hilet candidate = candidate_plus_one - 1_uz;
+            if (candidate >= position) {
+                break;
+            }
+
+            // Check the byte that would make the match longer than the best match first.
+            if (_bytes[candidate + best_length] == _bytes[position + best_length]) {
+                auto length = 0_uz;
+                while (length != max_length and _bytes[candidate + length] == _bytes[position + length]) {
+                    ++length;
+                }
+
+                if (length > best_length) {
+                    best_length = length;
+                    best_distance = position - candidate;
+                    if (length == max_length) {
+                        break;
+                    }
+                }
+            }
+
+            candidate_plus_one = _prev[candidate % window_size];
+        }
+
+        // Short matches far away cost more bits than the literals they replace.
+        if (best_length < min_match or (best_length == min_match and best_distance > 4096)) {
+            return {0, 0};
+        }
+        return {best_length, best_distance};
+    }
+
+private:
+    constexpr static std::size_t hash_bits = 15;
+    constexpr static std::size_t hash_size = 1_uz << hash_bits;
+
+    std::span<std::byte const> _bytes;
+    std::size_t _max_chain;
+
+    /** The last position + 1 with a given hash, or zero.
+     */
+    std::vector<uint32_t> _head;
+
+    /** The previous position + 1 with the same hash as the position, or zero.
+     */
+    std::vector<uint32_t> _prev;
+
+    [[nodiscard]] std::size_t hash(std::size_t position) const noexcept
+    {
+        hilet a = std::to_integer<uint32_t>(_bytes[position]);
+        hilet b = std::to_integer<uint32_t>(_bytes[position + 1]);
+        hilet c = std::to_integer<uint32_t>(_bytes[position + 2]);
+        return (((a << 16) | (b << 8) | c) * 2654435761U) >> (32 - hash_bits);
+    }
+};
+
+/** Write data as stored blocks to the stream.
+ *
+ * @param writer The stream to write to.
+ * @param bytes The data to store, split into multiple blocks when larger than 64 kByte.
+ * @param final This is the last data of the stream.
+ */
+inline void deflate_stored_block(deflate_bit_writer& writer, std::span<std::byte const> bytes, bool final) noexcept
+{
+    auto offset = 0_uz;
+    do {
+        hilet length = std::min(bytes.size() - offset, 0xffff_uz);
+        hilet last = offset + length == bytes.size();
+
+        writer.put_bits(final and last, 1);
+        writer.put_bits(0, 2);
+        writer.align_to_byte();
+        writer.put_bits(length, 16);
+        writer.put_bits(length ^ 0xffff, 16);
+        writer.put_bytes(bytes.subspan(offset, length));
+        offset += length;
+    } while (offset != bytes.size());
+}
+
+/** Write a block of tokens to the stream.
+ *
+ * The block is written as a stored, fixed or dynamic block, whichever is smallest.
+ *
+ * @param writer The stream to write to.
+ * @param bytes The uncompressed data of the block, used for stored blocks.
+ * @param tokens The literals and back references of the block.
+ * @param allow_dynamic Allow the use of a dynamic block.
+ * @param final This is the last block of the stream.
+ */
+inline void deflate_block(
+    deflate_bit_writer& writer,
+    std::span<std::byte const> bytes,
+    std::vector<deflate_token> const& tokens,
+    bool allow_dynamic,
+    bool final)
+{
+    auto literal_frequencies = std::array<std::size_t, 286>{};
+    auto distance_frequencies = std::array<std::size_t, 30>{};
+    auto extra_bits = 0_uz;
+    for (hilet token : tokens) {
+        if (token.length == 0) {
+            ++literal_frequencies[token.distance];
+        } else {
+            hilet length_symbol = deflate_length_symbol(token.length);
+            hilet distance_symbol = deflate_distance_symbol(token.distance);
+            ++literal_frequencies[length_symbol];
+            ++distance_frequencies[distance_symbol];
+            extra_bits += deflate_length_extra[length_symbol - 257] + deflate_distance_extra[distance_symbol];
+        }
+    }
+    literal_frequencies[256] = 1;
+
+    hilet data_size = [&](std::vector<uint8_t> const& literal_lengths, std::vector<uint8_t> const& distance_lengths) {
+        auto r = extra_bits;
+        for (auto i = 0_uz; i != literal_frequencies.size(); ++i) {
+            r += literal_frequencies[i] * literal_lengths[i];
+        }
+        for (auto i = 0_uz; i != distance_frequencies.size(); ++i) {
+            r += distance_frequencies[i] * distance_lengths[i];
+        }
+        return r;
+    };
+
+    // Sizes in bits, including the 3 bit block header.
+    hilet fixed_literal_lengths = deflate_fixed_literal_lengths();
+    hilet fixed_distance_lengths = deflate_fixed_distance_lengths();
+    hilet fixed_size = 3 + data_size(fixed_literal_lengths, fixed_distance_lengths);
+    hilet stored_size = (bytes.size() / 0xffff + 1) * (3 + 7 + 32) + bytes.size() * 8;
+
+    auto literal_lengths = fixed_literal_lengths;
+    auto distance_lengths = fixed_distance_lengths;
+
+    // The code lengths of the dynamic block header, run-length encoded with symbols 16, 17 and 18.
+    auto code_length_symbols = std::vector<std::pair<uint8_t, uint8_t>>{};
+    auto code_length_lengths = std::vector<uint8_t>{};
+    auto nr_literal_lengths = 0_uz;
+    auto nr_distance_lengths = 0_uz;
+    auto nr_code_length_lengths = 0_uz;
+    auto dynamic_size = std::numeric_limits<std::size_t>::max();
+
+    if (allow_dynamic) {
+        literal_lengths = huffman_code_lengths(literal_frequencies, 15);
+        distance_lengths = huffman_code_lengths(distance_frequencies, 15);
+
+        nr_literal_lengths = 286;
+        while (literal_lengths[nr_literal_lengths - 1] == 0) {
+            --nr_literal_lengths;
+        }
+        nr_distance_lengths = 30;
+        while (nr_distance_lengths > 1 and distance_lengths[nr_distance_lengths - 1] == 0) {
+            --nr_distance_lengths;
+        }
+
+        auto lengths = std::vector<uint8_t>{};
+        lengths.insert(lengths.end(), literal_lengths.begin(), literal_lengths.begin() + nr_literal_lengths);
+        lengths.insert(lengths.end(), distance_lengths.begin(), distance_lengths.begin() + nr_distance_lengths);
+
+        auto code_length_frequencies = std::array<std::size_t, 19>{};
+        for (auto i = 0_uz; i != lengths.size();) {
+            hilet length = lengths[i];
+            auto run = 1_uz;
+            while (i + run != lengths.size() and lengths[i + run] == length) {
+                ++run;
+            }
+
+            auto symbol = length;
+            auto extra = uint8_t{0};
+            if (length == 0 and run >= 11) {
+                run = std::min(run, 138_uz);
+                symbol = 18;
+                extra = narrow_cast<uint8_t>(run - 11);
+            } else if (length == 0 and run >= 3) {
+                symbol = 17;
+                extra = narrow_cast<uint8_t>(run - 3);
+            } else if (length != 0 and run >= 3 and i != 0 and lengths[i - 1] == length) {
+                run = std::min(run, 6_uz);
+                symbol = 16;
+                extra = narrow_cast<uint8_t>(run - 3);
+            } else {
+                run = 1;
+            }
+
+            code_length_symbols.emplace_back(symbol, extra);
+            ++code_length_frequencies[symbol];
+            i += run;
+        }
+
+        code_length_lengths = huffman_code_lengths(code_length_frequencies, 7);
+
+        nr_code_length_lengths = 19;
+        while (nr_code_length_lengths > 4 and
+               code_length_lengths[deflate_code_length_order[nr_code_length_lengths - 1]] == 0) {
+            --nr_code_length_lengths;
+        }
+
+        dynamic_size = 3 + 5 + 5 + 4 + nr_code_length_lengths * 3 + data_size(literal_lengths, distance_lengths);
+        for (hilet& [symbol, extra] : code_length_symbols) {
+            hi_axiom(extra < 128);
+            dynamic_size += code_length_lengths[symbol];
+            dynamic_size += symbol == 16 ? 2 : symbol == 17 ? 3 : symbol == 18 ? 7 : 0;
+        }
+    }
+
+    if (stored_size <= fixed_size and stored_size <= dynamic_size) {
+        return deflate_stored_block(writer, bytes, final);
+    }
+
+    writer.put_bits(final, 1);
+    if (fixed_size <= dynamic_size) {
+        writer.put_bits(1, 2);
+        literal_lengths = fixed_literal_lengths;
+        distance_lengths = fixed_distance_lengths;
+
+    } else {
+        writer.put_bits(2, 2);
+        writer.put_bits(nr_literal_lengths - 257, 5);
+        writer.put_bits(nr_distance_lengths - 1, 5);
+        writer.put_bits(nr_code_length_lengths - 4, 4);
+        for (auto i = 0_uz; i != nr_code_length_lengths; ++i) {
+            writer.put_bits(code_length_lengths[deflate_code_length_order[i]], 3);
+        }
+
+        hilet code_length_codes = huffman_canonical_codes(code_length_lengths.data(), code_length_lengths.size());
+        for (hilet& [symbol, extra] : code_length_symbols) {
+            writer.put_code(code_length_codes[symbol], code_length_lengths[symbol]);
+            if (symbol == 16) {
+                writer.put_bits(extra, 2);
+            } else if (symbol == 17) {
+                writer.put_bits(extra, 3);
+            } else if (symbol == 18) {
+                writer.put_bits(extra, 7);
+            }
+        }
+    }
+
+    hilet literal_codes = huffman_canonical_codes(literal_lengths.data(), literal_lengths.size());
+    hilet distance_codes = huffman_canonical_codes(distance_lengths.data(), distance_lengths.size());
+
+    for (hilet token : tokens) {
+        if (token.length == 0) {
+            writer.put_code(literal_codes[token.distance], literal_lengths[token.distance]);
+
+        } else {
+            hilet length_symbol = deflate_length_symbol(token.length);
+            writer.put_code(literal_codes[length_symbol], literal_lengths[length_symbol]);
+            writer.put_bits(
+                token.length - deflate_length_base[length_symbol - 257], deflate_length_extra[length_symbol - 257]);
+
+            hilet distance_symbol = deflate_distance_symbol(token.distance);
+            writer.put_code(distance_codes[distance_symbol], distance_lengths[distance_symbol]);
+            writer.put_bits(token.distance - deflate_distance_base[distance_symbol], deflate_distance_extra[distance_symbol]);
+        }
+    }
+    writer.put_code(literal_codes[256], literal_lengths[256]);
+}
+
+} // namespace detail
+
+/** Compress data using the deflate algorithm.
+ *
+ * @param bytes The data to compress.
+ * @param level The trade-off between speed and compression ratio.
+ * @return The compressed data, which can be decompressed with `inflate()`.
+ */
+hi_export [[nodiscard]] inline bstring deflate(std::span<std::byte const> bytes, deflate_level level = deflate_level::best)
+{
+    // The number of tokens in a block, after which the block is written.
+    constexpr auto max_block_tokens = 0x4000_uz;
+
+    auto writer = detail::deflate_bit_writer{};
+
+    if (level == deflate_level::stored) {
+        detail::deflate_stored_block(writer, bytes, true);
+        writer.align_to_byte();
+        return writer.take();
+    }
+
+    hilet lazy = level == deflate_level::best;
+    auto matcher = detail::deflate_matcher{bytes, lazy ? 128_uz : 1_uz};
+
+    auto tokens = std::vector<detail::deflate_token>{};
+    tokens.reserve(max_block_tokens);
+
+    auto block_start = 0_uz;
+    auto i = 0_uz;
+    while (i != bytes.size()) {
+        auto [length, distance] = matcher.find(i);
+        matcher.insert(i);
+
+        // Lazy matching: emit a literal when the next position has a longer match.
+        if (lazy and length != 0 and length < 32 and i + 1 != bytes.size()) {
+            hilet [next_length, next_distance] = matcher.find(i + 1);
+            if (next_length > length) {
+                length = 0;
+            }
+        }
+
+        if (length != 0) {
+            tokens.push_back(detail::deflate_token{narrow_cast<uint16_t>(length), narrow_cast<uint16_t>(distance)});
+            for (auto j = i + 1; j != i + length; ++j) {
+                matcher.insert(j);
+            }
+            i += length;
+
+        } else {
+            tokens.push_back(detail::deflate_token{uint16_t{0}, std::to_integer<uint16_t>(bytes[i])});
+            ++i;
+        }
+
+        if (tokens.size() == max_block_tokens and i != bytes.size()) {
+            detail::deflate_block(writer, bytes.subspan(block_start, i - block_start), tokens, lazy, false);
+            block_start = i;
+            tokens.clear();
+        }
+    }
+
+    detail::deflate_block(writer, bytes.subspan(block_start), tokens, lazy, true);
+    writer.align_to_byte();
+    return writer.take();
+}
+
+}} // namespace hi::v1
@@ -0,0 +1,106 @@
+// Copyright Take Vos 2023.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "deflate.hpp"
+#include "inflate.hpp"
+#include "gzip.hpp"
+#include "zlib.hpp"
+#include "../file/file.hpp"
+#include "../path/path.hpp"
+#include "../utility/utility.hpp"
+#include "../macros.hpp"
+#include <gtest/gtest.h>
+#include <iostream>
+
+using namespace std;
+using namespace hi;
+
+namespace {
+
+void deflate_round_trip(std::string_view name, deflate_level level)
+{
+    hilet original = file_view{library_source_dir() / "tests" / "data" / name};
+    hilet original_bytes = as_span<std::byte const>(original);
+
+    hilet compressed = deflate(original_bytes, level);
+    if (level != deflate_level::stored) {
+        ASSERT_LE(compressed.size(), original_bytes.size() + 5);
+    }
+
+    auto offset = 0_uz;
+    hilet decompressed = inflate(compressed, offset);
+    ASSERT_EQ(offset, compressed.size());
+    ASSERT_EQ(decompressed.size(), original_bytes.size());
+    ASSERT_TRUE(std::equal(decompressed.begin(), decompressed.end(), original_bytes.begin()));
+}
+
+} // namespace
+
+TEST(Deflate, RoundTripStored)
+{
+    for (auto i = 1; i <= 8; ++i) {
+        deflate_round_trip(std::format("gzip_test{}.bin", i), deflate_level::stored);
+    }
+}
+
+TEST(Deflate, RoundTripFast)
+{
+    for (auto i = 1; i <= 8; ++i) {
+        deflate_round_trip(std::format("gzip_test{}.bin", i), deflate_level::fast);
+    }
+}
+
+TEST(Deflate, RoundTripBest)
+{
+    for (auto i = 1; i <= 8; ++i) {
+        deflate_round_trip(std::format("gzip_test{}.bin", i), deflate_level::best);
+    }
+}
+
+TEST(Deflate, BestIsSmaller)
+{
+    hilet original = file_view{library_source_dir() / "tests" / "data" / "gzip_test4.bin"};
+    hilet original_bytes = as_span<std::byte const>(original);
+
+    hilet fast = deflate(original_bytes, deflate_level::fast);
+    hilet best = deflate(original_bytes, deflate_level::best);
+    ASSERT_LT(best.size(), fast.size());
+    ASSERT_LT(fast.size(), original_bytes.size());
+}
+
+TEST(Deflate, LongRepeat)
+{
+    // Runs of a single byte are encoded as overlapping matches with distance 1.
+    auto original = bstring(100'000, std::byte{'a'});
+    original[50'000] = std::byte{'b'};
+
+    hilet compressed = deflate(original);
+    ASSERT_LT(compressed.size(), 1'000);
+
+    auto offset = 0_uz;
+    hilet decompressed = inflate(compressed, offset);
+    ASSERT_TRUE(decompressed == original);
+}
+
+TEST(Deflate, ZlibRoundTrip)
+{
+    hilet original = file_view{library_source_dir() / "tests" / "data" / "gzip_test7.bin"};
+    hilet original_bytes = as_span<std::byte const>(original);
+
+    hilet compressed = zlib_compress(original_bytes);
+    hilet decompressed = zlib_decompress(compressed, 0x0100'0000);
+    ASSERT_EQ(decompressed.size(), original_bytes.size());
+    ASSERT_TRUE(std::equal(decompressed.begin(), decompressed.end(), original_bytes.begin()));
+}
+
+TEST(Deflate, GzipRoundTrip)
+{
+    hilet original = file_view{library_source_dir() / "tests" / "data" / "gzip_test8.bin"};
+    hilet original_bytes = as_span<std::byte const>(original);
+
+    hilet compressed = gzip_compress(original_bytes, deflate_level::fast);
+    hilet decompressed = gzip_decompress(compressed, 0x0100'0000);
+    ASSERT_EQ(decompressed.size(), original_bytes.size());
+    ASSERT_TRUE(std::equal(decompressed.begin(), decompressed.end(), original_bytes.begin()));
+}
@@ -9,14 +9,39 @@
 #include "../parser/parser.hpp"
 #include "../macros.hpp"
 #include "inflate.hpp"
+#include "deflate.hpp"
 #include <cstddef>
 #include <filesystem>
+#include <array>
 
 hi_export_module(hikogui.codec.gzip);
 
 namespace hi { inline namespace v1 {
 namespace detail {
 
+/** Calculate the CRC-32 checksum as used by gzip.
+ */
+[[nodiscard]] inline uint32_t crc32(std::span<std::byte const> bytes) noexcept
+{
+    constexpr auto table = [] {
+        auto r = std::array<uint32_t, 256>{};
+        for (auto i = uint32_t{0}; i != 256; ++i) {
+            auto c = i;
+            for (auto k = 0; k != 8; ++k) {
+                c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+            }
+            r[i] = c;
+        }
+        return r;
+    }();
+
+    auto r = uint32_t{0xffffffff};
+    for (hilet c : bytes) {
+        r = table[(r ^ std::to_integer<uint32_t>(c)) & 0xff] ^ (r >> 8);
+    }
+    return r ^ 0xffffffff;
+}
+
 struct gzip_member_header {
     uint8_t ID1;
     uint8_t ID2;
@@ -99,4 +124,36 @@ hi_export [[nodiscard]] inline bstring gzip_decompress(std::filesystem::path con
     return gzip_decompress(as_span<std::byte const>(file_view{path}), max_size);
 }
 
+/** Compress data into the gzip format.
+ *
+ * The data is compressed as a single member without a file name or modification time.
+ *
+ * @param bytes The data to compress.
+ * @param level The trade-off between speed and compression ratio.
+ * @return The gzip stream, including the header, the CRC-32 checksum and the size.
+ */
+hi_export [[nodiscard]] inline bstring gzip_compress(std::span<std::byte const> bytes, deflate_level level = deflate_level::best)
+{
+    auto r = bstring{};
+    r.push_back(std::byte{31}); // ID1
+    r.push_back(std::byte{139}); // ID2
+    r.push_back(std::byte{8}); // CM: deflate
+    r.push_back(std::byte{0}); // FLG
+    r.append(4, std::byte{0}); // MTIME: not available
+    r.push_back(level == deflate_level::best ? std::byte{2} : std::byte{4}); // XFL: slowest or fastest algorithm
+    r.push_back(std::byte{255}); // OS: unknown
+
+    r.append(deflate(bytes, level));
+
+    hilet CRC32 = detail::crc32(bytes);
+    hilet ISIZE = narrow_cast<uint32_t>(bytes.size() & 0xffffffff);
+    for (auto i = 0; i != 4; ++i) {
+        r.push_back(static_cast<std::byte>(CRC32 >> (i * 8)));
+    }
+    for (auto i = 0; i != 4; ++i) {
+        r.push_back(static_cast<std::byte>(ISIZE >> (i * 8)));
+    }
+    return r;
+}
+
 }} // namespace hi::inline v1
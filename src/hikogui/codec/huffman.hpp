@@ -9,11 +9,142 @@
 #include <span>
 #include <vector>
 #include <algorithm>
+#include <array>
+#include <utility>
+#include <limits>
+#include <functional>
 
 hi_export_module(hikogui.codec.huffman);
 
 namespace hi { inline namespace v1 {
 
+/** Assign canonical-huffman codes to symbols based on the length of their code.
+ *
+ * Shorter codes get lower code values, and codes of the same length are
+ * assigned in symbol order, as described in RFC 1951 section 3.2.2.
+ *
+ * @param lengths The length of the code for each symbol, zero when unused.
+ * @param nr_symbols The number of symbols.
+ * @return The code for each symbol, with the first bit in the MSB of the code.
+ * @throw parse_error When the lengths are over-subscribed.
+ */
+hi_export [[nodiscard]] inline std::vector<uint16_t> huffman_canonical_codes(uint8_t const *lengths, std::size_t nr_symbols)
+{
+    hi_assert_not_null(lengths);
+
+    constexpr auto max_length = 15_uz;
+
+    auto length_count = std::array<std::size_t, max_length + 1>{};
+    for (auto symbol = 0_uz; symbol != nr_symbols; ++symbol) {
+        hi_check(lengths[symbol] <= max_length, "Huffman code length too long");
+        ++length_count[lengths[symbol]];
+    }
+    length_count[0] = 0;
+
+    auto next_code = std::array<std::size_t, max_length + 1>{};
+    auto code = 0_uz;
+    for (auto length = 1_uz; length <= max_length; ++length) {
+        code = (code + length_count[length - 1]) << 1;
+        next_code[length] = code;
+    }
+
+    auto r = std::vector<uint16_t>(nr_symbols, 0);
+    for (auto symbol = 0_uz; symbol != nr_symbols; ++symbol) {
+        if (hilet length = lengths[symbol]) {
+            hi_check(next_code[length] < (1_uz << length), "Over-subscribed huffman code lengths");
+            r[symbol] = narrow_cast<uint16_t>(next_code[length]++);
+        }
+    }
+    return r;
+}
+
+/** Calculate length-limited huffman code lengths from symbol frequencies.
+ *
+ * When the optimal code is longer than @a max_length the frequencies are
+ * flattened until the code fits. If fewer than two symbols are used, the
+ * code is completed with extra symbols, so that every code is at least
+ * one bit long and the resulting code is always complete.
+ *
+ * @param frequencies The number of times each symbol is used.
+ * @param max_length The maximum length of a code.
+ * @return The length of the code for each symbol, zero when unused.
+ */
+hi_export [[nodiscard]] inline std::vector<uint8_t>
+huffman_code_lengths(std::span<std::size_t const> frequencies, std::size_t max_length)
+{
+    hi_axiom(frequencies.size() >= 2);
+    hi_axiom(max_length >= 1 and (1_uz << max_length) >= frequencies.size());
+
+    auto weights = std::vector<std::size_t>(frequencies.begin(), frequencies.end());
+
+    auto nr_used = std::count_if(weights.begin(), weights.end(), [](hilet weight) {
+        return weight != 0;
+    });
+    for (auto symbol = 0_uz; nr_used < 2; ++symbol) {
+        if (weights[symbol] == 0) {
+            weights[symbol] = 1;
+            ++nr_used;
+        }
+    }
+
+    auto r = std::vector<uint8_t>(weights.size(), 0);
+    while (true) {
+        // Leaves are nodes [0, weights.size()), internal nodes are appended after.
+        auto parents = std::vector<std::size_t>(weights.size(), 0);
+        auto queue = std::vector<std::pair<std::size_t, std::size_t>>{};
+        for (auto symbol = 0_uz; symbol != weights.size(); ++symbol) {
+            if (weights[symbol] != 0) {
+                queue.emplace_back(weights[symbol], symbol);
+            }
+        }
+
+        constexpr auto cmp = std::greater<std::pair<std::size_t, std::size_t>>{};
+        std::make_heap(queue.begin(), queue.end(), cmp);
+        while (queue.size() > 1) {
+            std::pop_heap(queue.begin(), queue.end(), cmp);
+            hilet a = queue.back();
+            queue.pop_back();
+            std::pop_heap(queue.begin(), queue.end(), cmp);
+            hilet b = queue.back();
+            queue.pop_back();
+
+            hilet node = parents.size();
+            parents.push_back(0);
+            parents[a.second] = node;
+            parents[b.second] = node;
+            queue.emplace_back(a.first + b.first, node);
+            std::push_heap(queue.begin(), queue.end(), cmp);
+        }
+
+        // Internal nodes are created after their children, so walk backward from the root.
+        auto depths = std::vector<std::size_t>(parents.size(), 0);
+        for (auto node = parents.size() - 1; node-- != 0;) {
+            if (node >= weights.size() or weights[node] != 0) {
+                depths[node] = depths[parents[node]] + 1;
+            }
+        }
+
+        auto fits = true;
+        for (auto symbol = 0_uz; symbol != weights.size(); ++symbol) {
+            if (weights[symbol] != 0) {
+                fits &= depths[symbol] <= max_length;
+                r[symbol] = narrow_cast<uint8_t>(std::min(depths[symbol], max_length));
+            }
+        }
+
+        if (fits) {
+            return r;
+        }
+
+        // Flatten the distribution, while keeping used symbols in use.
+        for (auto& weight : weights) {
+            if (weight != 0) {
+                weight = (weight >> 1) | 1;
+            }
+        }
+    }
+}
+
 hi_export template<typename T>
 class huffman_tree {
     static_assert(std::is_integral_v<T> && std::is_signed_v<T>);
@@ -124,50 +255,174 @@ public:
         hi_assert_not_null(lengths);
         hi_axiom(nr_symbols < std::numeric_limits<T>::min());
 
-        struct symbol_length_t {
-            T symbol;
-            uint8_t length;
+        hilet codes = huffman_canonical_codes(lengths, nr_symbols);
+
+        auto r = huffman_tree{};
+        for (auto symbol = 0_uz; symbol != nr_symbols; ++symbol) {
+            if (hilet length = lengths[symbol]) {
+                r.add(narrow_cast<int>(symbol), codes[symbol], length);
+            }
+        }
+
+        return r;
+    }
+
+    [[nodiscard]] static huffman_tree from_lengths(std::vector<uint8_t> const& lengths)
+    {
+        return from_lengths(lengths.data(), lengths.size());
+    }
+};
+
+/** A table-driven canonical-huffman decoder.
+ *
+ * The table is indexed by the next `root_bits` bits of a LSB-first bit-stream.
+ * Codes that are longer than `root_bits` are resolved through a second-level
+ * sub-table, which is indexed by the remaining bits of the code.
+ *
+ * Compared to `huffman_tree`, which walks the tree one bit at a time, this
+ * decodes a full symbol with one or two table lookups.
+ */
+hi_export class huffman_table {
+public:
+    /** The maximum length of a code in bits.
+     */
+    constexpr static std::size_t max_code_length = 15;
 
-            symbol_length_t(T symbol, uint8_t length) : symbol(symbol), length(length) {}
-        };
+    constexpr huffman_table() noexcept = default;
 
-        std::vector<symbol_length_t> symbol_lengths;
-        symbol_lengths.reserve(nr_symbols);
+    /** Decode a symbol from the front of a bit-buffer.
+     *
+     * @param bits The next bits of the stream; the LSB is the next bit. At
+     *             least `max_code_length` bits must be in the buffer, bits
+     *             beyond the end of the stream should be zero.
+     * @return The symbol and the length in bits of the code.
+     * @throw parse_error on invalid code-bit sequence.
+     */
+    [[nodiscard]] std::pair<std::size_t, std::size_t> decode(uint64_t bits) const
+    {
+        hi_axiom(not _table.empty());
 
-        for (T symbol = T{0}; symbol != narrow_cast<T>(nr_symbols); ++symbol) {
-            symbol_lengths.emplace_back(symbol, lengths[symbol]);
+        auto entry = _table[bits & _root_mask];
+        if (entry.kind == entry_kind::sub_table) {
+            hilet sub_bits = (bits >> _root_bits) & ((uint64_t{1} << entry.length) - 1);
+            entry = _table[entry.value + sub_bits];
         }
 
-        // Sort the table based on the length of the code, followed by symbol
-        std::sort(symbol_lengths.begin(), symbol_lengths.end(), [](hilet& a, hilet& b) {
-            if (a.length == b.length) {
-                return a.symbol < b.symbol;
-            } else {
-                return a.length < b.length;
-            }
-        });
+        if (entry.kind != entry_kind::symbol) {
+            throw parse_error("Code not in huffman table.");
+        }
+        return {entry.value, entry.length};
+    }
 
-        auto r = huffman_tree{};
+    /** Build a canonical-huffman table from a set of lengths.
+     *
+     * @param lengths The length of the code for each symbol, zero when unused.
+     * @param nr_symbols The number of symbols.
+     * @param root_bits The number of bits used to index the first level table.
+     */
+    [[nodiscard]] static huffman_table from_lengths(uint8_t const *lengths, std::size_t nr_symbols, std::size_t root_bits = 9)
+    {
+        hi_assert_not_null(lengths);
+        hi_axiom(nr_symbols <= std::numeric_limits<uint16_t>::max());
+        hi_axiom(root_bits >= 1 and root_bits <= max_code_length);
 
-        int code = 0;
-        int prev_length = 0;
-        for (auto&& entry : symbol_lengths) {
-            if (entry.length != 0) {
-                code <<= (entry.length - prev_length);
+        auto codes = std::vector<std::size_t>(nr_symbols, 0);
+        hilet canonical_codes = huffman_canonical_codes(lengths, nr_symbols);
+        for (auto symbol = 0_uz; symbol != nr_symbols; ++symbol) {
+            codes[symbol] = reverse_bits(canonical_codes[symbol], lengths[symbol]);
+        }
 
-                r.add(entry.symbol, code, entry.length);
-                ++code;
+        auto r = huffman_table{};
+        r._root_bits = root_bits;
+        r._root_mask = (uint64_t{1} << root_bits) - 1;
+        r._table.resize(1_uz << root_bits);
+
+        // Determine the size of each sub-table from the longest code sharing a root prefix.
+        auto sub_table_bits = std::vector<uint8_t>(1_uz << root_bits, 0);
+        for (auto symbol = 0_uz; symbol != nr_symbols; ++symbol) {
+            hilet length = lengths[symbol];
+            if (length > root_bits) {
+                auto& bits = sub_table_bits[codes[symbol] & r._root_mask];
+                bits = std::max(bits, narrow_cast<uint8_t>(length - root_bits));
             }
+        }
 
-            prev_length = entry.length;
+        for (auto prefix = 0_uz; prefix != sub_table_bits.size(); ++prefix) {
+            if (hilet bits = sub_table_bits[prefix]) {
+                r._table[prefix] = entry_type{narrow_cast<uint16_t>(r._table.size()), bits, entry_kind::sub_table};
+                r._table.resize(r._table.size() + (1_uz << bits));
+            }
+        }
+
+        // Fill in the symbols, replicating each entry for every value of the unused high bits.
+        for (auto symbol = 0_uz; symbol != nr_symbols; ++symbol) {
+            hilet length = lengths[symbol];
+            if (length == 0) {
+                continue;
+            }
+
+            hilet entry = entry_type{narrow_cast<uint16_t>(symbol), length, entry_kind::symbol};
+            if (length <= root_bits) {
+                for (auto i = codes[symbol]; i < (1_uz << root_bits); i += 1_uz << length) {
+                    r._table[i] = entry;
+                }
+
+            } else {
+                hilet& link = r._table[codes[symbol] & r._root_mask];
+                hilet sub_code = codes[symbol] >> root_bits;
+                hilet sub_length = length - root_bits;
+                for (auto i = sub_code; i < (1_uz << link.length); i += 1_uz << sub_length) {
+                    r._table[link.value + i] = entry;
+                }
+            }
         }
 
         return r;
     }
 
-    [[nodiscard]] static huffman_tree from_lengths(std::vector<uint8_t> const& lengths)
+    [[nodiscard]] static huffman_table from_lengths(std::vector<uint8_t> const& lengths, std::size_t root_bits = 9)
     {
-        return from_lengths(lengths.data(), lengths.size());
+        return from_lengths(lengths.data(), lengths.size(), root_bits);
+    }
+
+private:
+    enum class entry_kind : uint8_t {
+        /** Unused entry, the code is not in the table.
+         */
+        invalid,
+
+        /** The value is the symbol, the length is the length of the code.
+         */
+        symbol,
+
+        /** The value is the index of a sub-table, the length is the number of
+         * bits used to index the sub-table.
+         */
+        sub_table
+    };
+
+    struct entry_type {
+        uint16_t value = 0;
+        uint8_t length = 0;
+        entry_kind kind = entry_kind::invalid;
+    };
+
+    std::vector<entry_type> _table = {};
+    std::size_t _root_bits = 0;
+    uint64_t _root_mask = 0;
+
+    /** Reverse the order of the bits of a code.
+     *
+     * Huffman codes are packed MSB first in a LSB-first bit-stream.
+     */
+    [[nodiscard]] constexpr static std::size_t reverse_bits(std::size_t code, std::size_t length) noexcept
+    {
+        auto r = 0_uz;
+        for (auto i = 0_uz; i != length; ++i) {
+            r = (r << 1) | (code & 1);
+            code >>= 1;
+        }
+        return r;
     }
 };
 
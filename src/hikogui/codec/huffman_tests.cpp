@@ -0,0 +1,112 @@
+// Copyright Take Vos 2023.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "huffman.hpp"
+#include "../utility/utility.hpp"
+#include "../macros.hpp"
+#include <gtest/gtest.h>
+#include <array>
+#include <vector>
+
+using namespace std;
+using namespace hi;
+
+namespace {
+
+/** Create canonical codes for a set of lengths.
+ */
+[[nodiscard]] std::vector<std::size_t> canonical_codes(std::vector<uint8_t> const& lengths)
+{
+    auto r = std::vector<std::size_t>(lengths.size(), 0);
+
+    auto code = 0_uz;
+    for (auto length = 1_uz; length <= 15; ++length) {
+        for (auto symbol = 0_uz; symbol != lengths.size(); ++symbol) {
+            if (lengths[symbol] == length) {
+                r[symbol] = code++;
+            }
+        }
+        code <<= 1;
+    }
+    return r;
+}
+
+/** Pack a code MSB first into a LSB-first bit-stream.
+ */
+[[nodiscard]] uint64_t pack_code(std::size_t code, std::size_t length)
+{
+    auto r = uint64_t{0};
+    for (auto i = 0_uz; i != length; ++i) {
+        r |= uint64_t{(code >> (length - i - 1)) & 1} << i;
+    }
+    return r;
+}
+
+void check_table_against_tree(std::vector<uint8_t> const& lengths, std::size_t root_bits)
+{
+    hilet table = huffman_table::from_lengths(lengths, root_bits);
+    hilet tree = huffman_tree<int16_t>::from_lengths(lengths);
+    hilet codes = canonical_codes(lengths);
+
+    for (auto symbol = 0_uz; symbol != lengths.size(); ++symbol) {
+        if (lengths[symbol] == 0) {
+            continue;
+        }
+
+        hilet bits = pack_code(codes[symbol], lengths[symbol]);
+
+        hilet [table_symbol, table_length] = table.decode(bits);
+        ASSERT_EQ(table_symbol, symbol);
+        ASSERT_EQ(table_length, lengths[symbol]);
+
+        auto bytes = std::array<std::byte, 8>{};
+        for (auto i = 0_uz; i != bytes.size(); ++i) {
+            bytes[i] = static_cast<std::byte>(bits >> (i * 8));
+        }
+        auto bit_offset = 0_uz;
+        ASSERT_EQ(tree.get_symbol(bytes, bit_offset), symbol);
+        ASSERT_EQ(bit_offset, lengths[symbol]);
+    }
+}
+
+} // namespace
+
+TEST(Huffman, TableFixedLiterals)
+{
+    auto lengths = std::vector<uint8_t>{};
+    lengths.insert(lengths.end(), 144, 8);
+    lengths.insert(lengths.end(), 112, 9);
+    lengths.insert(lengths.end(), 24, 7);
+    lengths.insert(lengths.end(), 8, 8);
+
+    check_table_against_tree(lengths, 9);
+    check_table_against_tree(lengths, 7);
+}
+
+TEST(Huffman, TableLongCodes)
+{
+    // Code lengths 1 to 15, with the last length used twice to complete the code.
+    auto lengths = std::vector<uint8_t>{};
+    for (uint8_t length = 1; length <= 15; ++length) {
+        lengths.push_back(length);
+    }
+    lengths.push_back(15);
+    // Unused symbol.
+    lengths.push_back(0);
+
+    check_table_against_tree(lengths, 9);
+    check_table_against_tree(lengths, 4);
+}
+
+TEST(Huffman, TableInvalidCode)
+{
+    // A single code of length 1, as allowed for deflate distance codes.
+    hilet table = huffman_table::from_lengths(std::vector<uint8_t>{0, 1}, 9);
+
+    hilet [symbol, length] = table.decode(0b0);
+    ASSERT_EQ(symbol, 1);
+    ASSERT_EQ(length, 1);
+
+    ASSERT_THROW((void)table.decode(0b1), parse_error);
+}
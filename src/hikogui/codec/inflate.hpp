@@ -10,213 +10,255 @@
 #include "../macros.hpp"
 #include "huffman.hpp"
 #include <span>
+#include <array>
+#include <vector>
+#include <format>
+#include <optional>
+#include <limits>
+#include <utility>
+#include <cstring>
 
 hi_export_module(hikogui.codec.inflate);
 
 namespace hi { inline namespace v1 {
 namespace detail {
 
-inline void inflate_copy_block(std::span<std::byte const> bytes, std::size_t& bit_offset, std::size_t max_size, bstring& r)
-{
-    auto offset = (bit_offset + 7) / 8;
+/** A bit-reader for a deflate bit-stream.
+ *
+ * Bits are ordered LSB first and are buffered in a 64-bit integer, so that
+ * after a single refill at least 56 bits can be consumed without touching
+ * the byte span again.
+ */
+class inflate_bit_reader {
+public:
+    /** Start reading a byte span.
+     *
+     * @param bytes The byte span to read.
+     * @param bit_offset The offset in bits from the start of the span.
+     */
+    inflate_bit_reader(std::span<std::byte const> bytes, std::size_t bit_offset) noexcept :
+        _bytes(bytes), _offset(bit_offset / 8)
+    {
+        if (hilet nr_bits = bit_offset % 8) {
+            hi_axiom(_offset < _bytes.size());
+            refill();
+            _bits >>= nr_bits;
+            _nr_bits -= nr_bits;
+        }
+    }
 
-    auto LEN = **make_placement_ptr<little_uint16_buf_t>(bytes, offset);
-    [[maybe_unused]] auto NLEN = **make_placement_ptr<little_uint16_buf_t>(bytes, offset);
+    /** The byte span being read.
+     */
+    [[nodiscard]] std::span<std::byte const> bytes() const noexcept
+    {
+        return _bytes;
+    }
 
-    hi_check((offset + LEN) <= bytes.size(), "input buffer overrun");
-    hi_check((r.size() + LEN) <= max_size, "output buffer overrun");
-    r.append(&bytes[offset], LEN);
+    /** The offset of the next unread byte.
+     *
+     * @pre The reader must be aligned to a byte boundary.
+     */
+    [[nodiscard]] std::size_t byte_offset() const noexcept
+    {
+        hi_axiom(_nr_bits % 8 == 0);
+        return _offset - _nr_bits / 8;
+    }
 
-    bit_offset = offset * 8;
-}
+    /** The offset of the next unread bit.
+     */
+    [[nodiscard]] std::size_t bit_offset() const noexcept
+    {
+        return _offset * 8 - _nr_bits;
+    }
 
-[[nodiscard]] inline std::size_t
-inflate_decode_length(std::span<std::byte const> bytes, std::size_t& bit_offset, std::size_t symbol)
-{
-    switch (symbol) {
-    case 257:
-        return 3;
-    case 258:
-        return 4;
-    case 259:
-        return 5;
-    case 260:
-        return 6;
-    case 261:
-        return 7;
-    case 262:
-        return 8;
-    case 263:
-        return 9;
-    case 264:
-        return 10;
-    case 265:
-        return get_bits(bytes, bit_offset, 1) + 11;
-    case 266:
-        return get_bits(bytes, bit_offset, 1) + 13;
-    case 267:
-        return get_bits(bytes, bit_offset, 1) + 15;
-    case 268:
-        return get_bits(bytes, bit_offset, 1) + 17;
-    case 269:
-        return get_bits(bytes, bit_offset, 2) + 19;
-    case 270:
-        return get_bits(bytes, bit_offset, 2) + 23;
-    case 271:
-        return get_bits(bytes, bit_offset, 2) + 27;
-    case 272:
-        return get_bits(bytes, bit_offset, 2) + 31;
-    case 273:
-        return get_bits(bytes, bit_offset, 3) + 35;
-    case 274:
-        return get_bits(bytes, bit_offset, 3) + 43;
-    case 275:
-        return get_bits(bytes, bit_offset, 3) + 51;
-    case 276:
-        return get_bits(bytes, bit_offset, 3) + 59;
-    case 277:
-        return get_bits(bytes, bit_offset, 4) + 67;
-    case 278:
-        return get_bits(bytes, bit_offset, 4) + 83;
-    case 279:
-        return get_bits(bytes, bit_offset, 4) + 99;
-    case 280:
-        return get_bits(bytes, bit_offset, 4) + 115;
-    case 281:
-        return get_bits(bytes, bit_offset, 5) + 131;
-    case 282:
-        return get_bits(bytes, bit_offset, 5) + 163;
-    case 283:
-        return get_bits(bytes, bit_offset, 5) + 195;
-    case 284:
-        return get_bits(bytes, bit_offset, 5) + 227;
-    case 285:
-        return 258;
-    default:
-        throw parse_error(std::format("Literal/Length symbol out of range {}", symbol));
+    /** Check if a read failed because it went beyond the end of the byte span.
+     *
+     * This makes it possible to distinguish truncated input from invalid input.
+     */
+    [[nodiscard]] bool overrun() const noexcept
+    {
+        return _overrun;
     }
-}
 
-[[nodiscard]] inline std::size_t
-inflate_decode_distance(std::span<std::byte const> bytes, std::size_t& bit_offset, std::size_t symbol)
-{
-    switch (symbol) {
-    case 0:
-        return 1;
-    case 1:
-        return 2;
-    case 2:
-        return 3;
-    case 3:
-        return 4;
-    case 4:
-        return get_bits(bytes, bit_offset, 1) + 5;
-    case 5:
-        return get_bits(bytes, bit_offset, 1) + 7;
-    case 6:
-        return get_bits(bytes, bit_offset, 2) + 9;
-    case 7:
-        return get_bits(bytes, bit_offset, 2) + 13;
-    case 8:
-        return get_bits(bytes, bit_offset, 3) + 17;
-    case 9:
-        return get_bits(bytes, bit_offset, 3) + 25;
-    case 10:
-        return get_bits(bytes, bit_offset, 4) + 33;
-    case 11:
-        return get_bits(bytes, bit_offset, 4) + 49;
-    case 12:
-        return get_bits(bytes, bit_offset, 5) + 65;
-    case 13:
-        return get_bits(bytes, bit_offset, 5) + 97;
-    case 14:
-        return get_bits(bytes, bit_offset, 6) + 129;
-    case 15:
-        return get_bits(bytes, bit_offset, 6) + 193;
-    case 16:
-        return get_bits(bytes, bit_offset, 7) + 257;
-    case 17:
-        return get_bits(bytes, bit_offset, 7) + 385;
-    case 18:
-        return get_bits(bytes, bit_offset, 8) + 513;
-    case 19:
-        return get_bits(bytes, bit_offset, 8) + 769;
-    case 20:
-        return get_bits(bytes, bit_offset, 9) + 1025;
-    case 21:
-        return get_bits(bytes, bit_offset, 9) + 1537;
-    case 22:
-        return get_bits(bytes, bit_offset, 10) + 2049;
-    case 23:
-        return get_bits(bytes, bit_offset, 10) + 3073;
-    case 24:
-        return get_bits(bytes, bit_offset, 11) + 4097;
-    case 25:
-        return get_bits(bytes, bit_offset, 11) + 6145;
-    case 26:
-        return get_bits(bytes, bit_offset, 12) + 8193;
-    case 27:
-        return get_bits(bytes, bit_offset, 12) + 12289;
-    case 28:
-        return get_bits(bytes, bit_offset, 13) + 16385;
-    case 29:
-        return get_bits(bytes, bit_offset, 13) + 24577;
-    default:
-        throw parse_error(std::format("Distance symbol out of range {}", symbol));
+    /** Continue reading at a byte offset, discarding the buffered bits.
+     */
+    void seek(std::size_t offset) noexcept
+    {
+        _offset = offset;
+        _bits = 0;
+        _nr_bits = 0;
     }
-}
 
-inline void inflate_block(
-    std::span<std::byte const> bytes,
-    std::size_t& bit_offset,
-    std::size_t max_size,
-    huffman_tree<int16_t> const& literal_tree,
-    huffman_tree<int16_t> const& distance_tree,
-    bstring& r)
-{
-    while (true) {
-        // Test only every get_symbol, the trailer is at least 32 bits (Checksum)
-        // - 15 bits maximum huffman code.
-        // -  5 bits extra length.
-        // -  7 bits rounding up to byte.
-        hi_check(((bit_offset + 27) >> 3) <= bytes.size(), "Input buffer overrun");
+    /** Fill the bit-buffer with at least 56 bits, if available.
+     */
+    void refill() noexcept
+    {
+        if (_offset + sizeof(uint64_t) <= _bytes.size()) {
+            // Load 8 bytes, but only consume the whole bytes that fit in the buffer.
+            // The extra bits that are loaded are the same bits that will be loaded again on the next refill.
+            _bits |= load_le<uint64_t>(_bytes.data() + _offset) << _nr_bits;
+            _offset += (63 - _nr_bits) >> 3;
+            _nr_bits |= 56;
 
-        hilet literal_symbol = literal_tree.get_symbol(bytes, bit_offset);
+        } else {
+            while (_nr_bits <= 56 and _offset < _bytes.size()) {
+                _bits |= uint64_t{std::to_integer<uint8_t>(_bytes[_offset++])} << _nr_bits;
+                _nr_bits += 8;
+            }
+        }
+    }
 
-        if (literal_symbol <= 255) {
-            hi_check(r.size() < max_size, "Output buffer overrun");
-            r.push_back(static_cast<std::byte>(literal_symbol));
+    /** The bit-buffer, the LSB is the next bit in the stream.
+     */
+    [[nodiscard]] uint64_t peek() const noexcept
+    {
+        return _bits;
+    }
 
-        } else if (literal_symbol == 256) {
-            // End-of-block.
-            return;
+    /** Consume bits from the bit-buffer.
+     *
+     * @throw parse_error When reading beyond the end of the byte span.
+     */
+    void skip(std::size_t nr_bits)
+    {
+        if (nr_bits > _nr_bits) {
+            _overrun = true;
+            throw parse_error("Input buffer overrun");
+        }
+        _bits >>= nr_bits;
+        _nr_bits -= nr_bits;
+    }
 
-        } else {
-            hilet length = inflate_decode_length(bytes, bit_offset, literal_symbol);
-            hi_check(r.size() + length <= max_size, "Output buffer overrun");
-
-            // Test only every get_symbol, the trailer is at least 32 bits (Checksum)
-            // - 15 bits maximum huffman code.
-            // -  7 bits rounding up to byte.
-            hi_check(((bit_offset + 22) >> 3) <= bytes.size(), "Input buffer overrun");
-            hilet distance_symbol = distance_tree.get_symbol(bytes, bit_offset);
-
-            // Test only every inflate_decode_distance, the trailer is at least 32 bits (Checksum)
-            // - 13 bits extra length.
-            // -  7 bits rounding up to byte.
-            hi_check(((bit_offset + 20) >> 3) <= bytes.size(), "Input buffer overrun");
-            hilet distance = inflate_decode_distance(bytes, bit_offset, distance_symbol);
-
-            hi_check(distance <= r.size(), "Distance beyond start of decompressed data");
-            auto src_i = r.size() - distance;
-            for (auto i = 0; i != length; ++i) {
-                r.push_back(r[src_i++]);
+    /** Skip to the next byte boundary.
+     */
+    void align_to_byte() noexcept
+    {
+        hilet nr_bits = _nr_bits % 8;
+        _bits >>= nr_bits;
+        _nr_bits -= nr_bits;
+    }
+
+    /** Read a number of bits from the stream.
+     *
+     * @param nr_bits Number of bits to read, at most 32.
+     * @return The bits, with the first bit of the stream in the LSB.
+     * @throw parse_error When reading beyond the end of the byte span.
+     */
+    [[nodiscard]] std::size_t get_bits(std::size_t nr_bits)
+    {
+        hi_axiom(nr_bits <= 32);
+
+        if (_nr_bits < nr_bits) {
+            refill();
+        }
+
+        hilet r = narrow_cast<std::size_t>(_bits & ((uint64_t{1} << nr_bits) - 1));
+        skip(nr_bits);
+        return r;
+    }
+
+    /** Read a single bit from the stream.
+     *
+     * @throw parse_error When reading beyond the end of the byte span.
+     */
+    [[nodiscard]] bool get_bit()
+    {
+        return get_bits(1) != 0;
+    }
+
+    /** Decode a huffman encoded symbol from the stream.
+     *
+     * @throw parse_error When reading beyond the end of the byte span, or on an invalid code.
+     */
+    [[nodiscard]] std::size_t get_symbol(huffman_table const& table)
+    {
+        if (_nr_bits < huffman_table::max_code_length) {
+            refill();
+        }
+
+        if (_nr_bits < huffman_table::max_code_length) {
+            // Near the end of the byte span the zero padding may turn a truncated code into an invalid code.
+            try {
+                hilet [symbol, length] = table.decode(_bits);
+                skip(length);
+                return symbol;
+            } catch (parse_error const&) {
+                _overrun = true;
+                throw;
             }
         }
+
+        hilet [symbol, length] = table.decode(_bits);
+        skip(length);
+        return symbol;
     }
+
+private:
+    std::span<std::byte const> _bytes;
+
+    /** Offset of the next byte to load into the bit-buffer.
+     */
+    std::size_t _offset;
+
+    /** The bit-buffer, bits above `_nr_bits` are either zero or the same as the next bits in the stream.
+     */
+    uint64_t _bits = 0;
+
+    /** The number of valid bits in the bit-buffer.
+     */
+    std::size_t _nr_bits = 0;
+
+    bool _overrun = false;
+};
+
+/** The first length of each length symbol 257 to 285.
+ */
+constexpr auto deflate_length_base = std::array<uint16_t, 29>{
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+
+/** The number of extra bits of each length symbol 257 to 285.
+ */
+constexpr auto deflate_length_extra =
+    std::array<uint8_t, 29>{0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+/** The first distance of each distance symbol 0 to 29.
+ */
+constexpr auto deflate_distance_base = std::array<uint16_t, 30>{1,    2,    3,    4,    5,    7,     9,     13,    17,   25,
+                                                                33,   49,   65,   97,   129,  193,   257,   385,   513,  769,
+                                                                1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+
+/** The number of extra bits of each distance symbol 0 to 29.
+ */
+constexpr auto deflate_distance_extra = std::array<uint8_t, 30>{0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                                                6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+/** The order in which the lengths of the code-length symbols are stored in a dynamic block header.
+ */
+constexpr auto deflate_code_length_order = std::array<uint8_t, 19>{16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+[[nodiscard]] inline std::size_t inflate_decode_length(inflate_bit_reader& reader, std::size_t symbol)
+{
+    if (symbol < 257 or symbol > 285) {
+        throw parse_error(std::format("Literal/Length symbol out of range {}", symbol));
+    }
+
+    hilet i = symbol - 257;
+    return deflate_length_base[i] + reader.get_bits(deflate_length_extra[i]);
 }
 
-inline huffman_tree<int16_t> deflate_fixed_literal_tree = []() {
+[[nodiscard]] inline std::size_t inflate_decode_distance(inflate_bit_reader& reader, std::size_t symbol)
+{
+    if (symbol > 29) {
+        throw parse_error(std::format("Distance symbol out of range {}", symbol));
+    }
+
+    return deflate_distance_base[symbol] + reader.get_bits(deflate_distance_extra[symbol]);
+}
+
+/** The code lengths of the literal/length symbols of a fixed block.
+ */
+[[nodiscard]] inline std::vector<uint8_t> deflate_fixed_literal_lengths() noexcept
+{
     std::vector<uint8_t> lengths;
 
     for (int i = 0; i <= 143; ++i) {
@@ -232,62 +274,45 @@ inline huffman_tree<int16_t> deflate_fixed_literal_tree = []() {
         lengths.push_back(8);
     }
 
-    return huffman_tree<int16_t>::from_lengths(lengths);
-}();
-
-inline huffman_tree<int16_t> deflate_fixed_distance_tree = []() {
-    std::vector<uint8_t> lengths;
-
-    for (int i = 0; i <= 31; ++i) {
-        lengths.push_back(5);
-    }
-
-    return huffman_tree<int16_t>::from_lengths(lengths);
-}();
+    return lengths;
+}
 
-inline void inflate_fixed_block(std::span<std::byte const> bytes, std::size_t& bit_offset, std::size_t max_size, bstring& r)
+/** The code lengths of the distance symbols of a fixed block.
+ */
+[[nodiscard]] inline std::vector<uint8_t> deflate_fixed_distance_lengths() noexcept
 {
-    inflate_block(bytes, bit_offset, max_size, deflate_fixed_literal_tree, deflate_fixed_distance_tree, r);
+    return std::vector<uint8_t>(32, 5);
 }
 
-[[nodiscard]] inline huffman_tree<int16_t>
-inflate_code_lengths(std::span<std::byte const> bytes, std::size_t& bit_offset, std::size_t nr_symbols)
-{
-    // The symbols are in different order in the table.
-    constexpr auto symbols = std::array<int16_t, 19>{16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+inline huffman_table deflate_fixed_literal_table = huffman_table::from_lengths(deflate_fixed_literal_lengths(), 9);
 
-    hi_check(((bit_offset + (3 * static_cast<std::size_t>(nr_symbols)) + 7) >> 3) <= bytes.size(), "Input buffer overrun");
+inline huffman_table deflate_fixed_distance_table = huffman_table::from_lengths(deflate_fixed_distance_lengths(), 5);
 
-    auto lengths = std::vector<uint8_t>(symbols.size(), 0);
+[[nodiscard]] inline huffman_table inflate_code_lengths(inflate_bit_reader& reader, std::size_t nr_symbols)
+{
+    // The symbols are in different order in the table.
+    auto lengths = std::vector<uint8_t>(deflate_code_length_order.size(), 0);
     for (auto i = 0_uz; i != nr_symbols; ++i) {
-        hilet symbol = symbols[i];
-        lengths[symbol] = narrow_cast<uint8_t>(get_bits(bytes, bit_offset, 3));
+        hilet symbol = deflate_code_length_order[i];
+        lengths[symbol] = narrow_cast<uint8_t>(reader.get_bits(3));
     }
-    return huffman_tree<int16_t>::from_lengths(std::move(lengths));
+    return huffman_table::from_lengths(lengths, 7);
 }
 
-inline std::vector<uint8_t> inflate_lengths(
-    std::span<std::byte const> bytes,
-    std::size_t& bit_offset,
-    std::size_t nr_symbols,
-    huffman_tree<int16_t> const& code_length_tree)
+inline std::vector<uint8_t>
+inflate_lengths(inflate_bit_reader& reader, std::size_t nr_symbols, huffman_table const& code_length_table)
 {
     auto r = std::vector<uint8_t>{};
     r.reserve(nr_symbols);
 
     auto prev_length = 0_uz;
     while (r.size() < nr_symbols) {
-        // Test only every get_symbol, the trailer is at least 32 bits (Checksum)
-        // -  7 bits maximum huffman code.
-        // -  7 bits extra length.
-        // -  7 bits rounding up to byte.
-        hi_check(((bit_offset + 21) >> 3) <= bytes.size(), "Input buffer overrun");
-        hilet symbol = code_length_tree.get_symbol(bytes, bit_offset);
+        hilet symbol = reader.get_symbol(code_length_table);
 
         switch (symbol) {
         case 16:
             {
-                auto copy_length = get_bits(bytes, bit_offset, 2) + 3;
+                auto copy_length = reader.get_bits(2) + 3;
                 while (copy_length--) {
                     r.push_back(static_cast<uint8_t>(prev_length));
                 }
@@ -295,7 +320,7 @@ inline std::vector<uint8_t> inflate_lengths(
             break;
         case 17:
             {
-                auto copy_length = get_bits(bytes, bit_offset, 3) + 3;
+                auto copy_length = reader.get_bits(3) + 3;
                 while (copy_length--) {
                     r.push_back(0);
                 }
@@ -303,7 +328,7 @@ inline std::vector<uint8_t> inflate_lengths(
             break;
         case 18:
             {
-                auto copy_length = get_bits(bytes, bit_offset, 7) + 11;
+                auto copy_length = reader.get_bits(7) + 11;
                 while (copy_length--) {
                     r.push_back(0);
                 }
@@ -317,34 +342,375 @@ inline std::vector<uint8_t> inflate_lengths(
     return r;
 }
 
-inline void inflate_dynamic_block(std::span<std::byte const> bytes, std::size_t& bit_offset, std::size_t max_size, bstring& r)
+/** Read the huffman tables of a dynamic block.
+ *
+ * @return The literal/length table and the distance table.
+ */
+[[nodiscard]] inline std::pair<huffman_table, huffman_table> inflate_dynamic_tables(inflate_bit_reader& reader)
 {
-    // Test all lengths, the trailer is at least 32 bits (Checksum)
-    // - 14 bits lengths
-    // -  7 bits rounding up to byte.
-    hi_check(((bit_offset + 21) >> 3) <= bytes.size(), "Input buffer overrun");
-    hilet HLIT = get_bits(bytes, bit_offset, 5);
-    hilet HDIST = get_bits(bytes, bit_offset, 5);
-    hilet HCLEN = get_bits(bytes, bit_offset, 4);
+    hilet HLIT = reader.get_bits(5);
+    hilet HDIST = reader.get_bits(5);
+    hilet HCLEN = reader.get_bits(4);
 
-    hilet code_length_tree = inflate_code_lengths(bytes, bit_offset, HCLEN + 4);
+    hilet code_length_table = inflate_code_lengths(reader, HCLEN + 4);
 
-    hilet lengths = inflate_lengths(bytes, bit_offset, HLIT + HDIST + 258, code_length_tree);
+    hilet lengths = inflate_lengths(reader, HLIT + HDIST + 258, code_length_table);
     hi_check(lengths[256] != 0, "The end-of-block symbol must be in the table");
 
     hilet lengths_ptr = lengths.data();
     hi_assert_not_null(lengths_ptr);
-    hilet literal_tree = huffman_tree<int16_t>::from_lengths(lengths_ptr, HLIT + 257);
-    hilet distance_tree = huffman_tree<int16_t>::from_lengths(&lengths_ptr[HLIT + 257], HDIST + 1);
-
-    inflate_block(bytes, bit_offset, max_size, literal_tree, distance_tree, r);
+    return {
+        huffman_table::from_lengths(lengths_ptr, HLIT + 257, 10),
+        huffman_table::from_lengths(&lengths_ptr[HLIT + 257], HDIST + 1, 8)};
 }
 
 } // namespace detail
 
+/** Resumable decompression of data using the deflate algorithm.
+ *
+ * Compressed data is passed in chunks, and decompressed data is written
+ * into output windows supplied by the caller. Back references are resolved
+ * against a 32 kByte history of earlier output, so that memory use does not
+ * depend on the size of the compressed or decompressed data.
+ *
+ * Example:
+ * ```
+ * auto stream = inflate_stream{};
+ * auto window = std::array<std::byte, 0x1'0000>{};
+ * auto input = std::span<std::byte const>{};
+ * while (not stream.finished()) {
+ *     if (input.empty()) {
+ *         input = read_next_chunk();
+ *     }
+ *     hilet size = stream.decompress(input, window);
+ *     write(std::span{window}.first(size));
+ * }
+ * ```
+ */
+hi_export class inflate_stream {
+public:
+    /** The maximum distance of a back reference in a deflate stream.
+     */
+    constexpr static std::size_t history_capacity = 0x8000;
+
+    inflate_stream() : _history(history_capacity) {}
+
+    /** The final block of the deflate stream has been decompressed.
+     */
+    [[nodiscard]] bool finished() const noexcept
+    {
+        return _state == state_type::finished;
+    }
+
+    /** Decompress a chunk of compressed data.
+     *
+     * This function returns when the output window is full, the deflate stream
+     * is finished, or all input has been consumed. The bits of a symbol that
+     * straddle the end of @a input are kept by the stream, so the next call
+     * can simply pass the next chunk of compressed data.
+     *
+     * When the stream is finished @a input starts at the first byte after
+     * the deflate stream, for example at the zlib or gzip trailer.
+     *
+     * @param[in,out] input The compressed data. On return advanced beyond the consumed bytes.
+     * @param output The output window to write the decompressed data into.
+     * @return The number of bytes written into @a output.
+     * @throw parse_error On invalid compressed data.
+     */
+    [[nodiscard]] std::size_t decompress(std::span<std::byte const>& input, std::span<std::byte> output)
+    {
+        auto out_pos = 0_uz;
+
+        if (not _carry.empty()) {
+            // Complete the block header or symbol that straddled the end of the previous chunk.
+            hilet old_size = _carry.size();
+            hilet top_up = std::min(input.size(), carry_capacity - old_size);
+            _carry.append(input.data(), top_up);
+            input = input.subspan(top_up);
+
+            auto reader = detail::inflate_bit_reader{_carry, _bit_offset};
+            if (decode(reader, output, out_pos, old_size * 8)) {
+                // Still not enough input, keep all of it in the carry buffer.
+                hi_axiom(input.empty());
+                hilet pos = reader.bit_offset();
+                _carry.erase(0, pos / 8);
+                _bit_offset = pos % 8;
+                update_history(output.first(out_pos));
+                return out_pos;
+            }
+
+            // Give back the bytes that were taken from the input but not consumed.
+            hilet pos = reader.bit_offset();
+            hilet keep = std::max(pos / 8, old_size);
+            hilet give_back = _carry.size() - keep;
+            input = std::span{input.data() - give_back, input.size() + give_back};
+            _carry.erase(keep);
+            _carry.erase(0, pos / 8);
+            _bit_offset = pos % 8;
+
+            if (not _carry.empty()) {
+                // The output window is full.
+                update_history(output.first(out_pos));
+                return out_pos;
+            }
+        }
+
+        auto reader = detail::inflate_bit_reader{input, _bit_offset};
+        hilet need_input = decode(reader, output, out_pos, std::numeric_limits<std::size_t>::max());
+
+        hilet pos = reader.bit_offset();
+        if (need_input) {
+            // Keep the start of the incomplete block header or symbol until more input is available.
+            hi_axiom(input.size() - pos / 8 < carry_capacity);
+            _carry.assign(input.data() + pos / 8, input.size() - pos / 8);
+            input = input.subspan(input.size());
+        } else {
+            input = input.subspan(pos / 8);
+        }
+        _bit_offset = pos % 8;
+
+        update_history(output.first(out_pos));
+        return out_pos;
+    }
+
+private:
+    enum class state_type : uint8_t { block_header, stored_block, huffman_block, finished };
+
+    /** The size of the carry buffer.
+     *
+     * Must be large enough to hold the largest dynamic block header of about 570 bytes.
+     */
+    constexpr static std::size_t carry_capacity = 0x400;
+
+    state_type _state = state_type::block_header;
+
+    /** The current block is the last block of the stream.
+     */
+    bool _final_block = false;
+
+    /** The number of bytes left to copy from a stored block.
+     */
+    std::size_t _stored_length = 0;
+
+    huffman_table const *_literal_table = nullptr;
+    huffman_table const *_distance_table = nullptr;
+    huffman_table _dynamic_literal_table = {};
+    huffman_table _dynamic_distance_table = {};
+
+    /** A literal that did not fit in the output window.
+     */
+    std::optional<std::byte> _pending_literal = {};
+
+    /** The part of a back reference that did not fit in the output window.
+     */
+    std::size_t _copy_length = 0;
+    std::size_t _copy_distance = 0;
+
+    /** Input bytes holding the start of a block header or symbol that straddled the end of a chunk.
+     */
+    bstring _carry = {};
+
+    /** The number of bits already consumed from the first byte of the carry buffer or the input.
+     */
+    std::size_t _bit_offset = 0;
+
+    /** Ring buffer with the last 32 kByte of output.
+     */
+    std::vector<std::byte> _history;
+    std::size_t _history_end = 0;
+    std::size_t _history_size = 0;
+
+    [[nodiscard]] std::byte history_at(std::size_t distance) const noexcept
+    {
+        hi_axiom(distance >= 1 and distance <= _history_size);
+        return _history[(_history_end - distance) % history_capacity];
+    }
+
+    void update_history(std::span<std::byte const> bytes) noexcept
+    {
+        if (bytes.size() >= history_capacity) {
+            std::memcpy(_history.data(), bytes.data() + bytes.size() - history_capacity, history_capacity);
+            _history_end = 0;
+            _history_size = history_capacity;
+            return;
+        }
+
+        hilet first = std::min(bytes.size(), history_capacity - _history_end);
+        std::memcpy(_history.data() + _history_end, bytes.data(), first);
+        std::memcpy(_history.data(), bytes.data() + first, bytes.size() - first);
+        _history_end = (_history_end + bytes.size()) % history_capacity;
+        _history_size = std::min(_history_size + bytes.size(), history_capacity);
+    }
+
+    /** Write a pending literal and back reference into the output window.
+     *
+     * @return true when everything was written, false when the output window is full.
+     */
+    [[nodiscard]] bool flush(std::span<std::byte> output, std::size_t& out_pos) noexcept
+    {
+        if (_pending_literal) {
+            if (out_pos == output.size()) {
+                return false;
+            }
+            output[out_pos++] = *_pending_literal;
+            _pending_literal = std::nullopt;
+        }
+
+        hilet length = std::min(_copy_length, output.size() - out_pos);
+        hilet end_pos = out_pos + length;
+        _copy_length -= length;
+
+        // The start of the back reference may be in the output of earlier calls.
+        for (; out_pos != end_pos and _copy_distance > out_pos; ++out_pos) {
+            output[out_pos] = history_at(_copy_distance - out_pos);
+        }
+
+        // The source and destination may overlap, so copy byte-by-byte.
+        for (; out_pos != end_pos; ++out_pos) {
+            output[out_pos] = output[out_pos - _copy_distance];
+        }
+
+        return _copy_length == 0;
+    }
+
+    void decode_block_header(detail::inflate_bit_reader& reader)
+    {
+        hilet BFINAL = reader.get_bit();
+        hilet BTYPE = reader.get_bits(2);
+
+        switch (BTYPE) {
+        case 0:
+            {
+                reader.align_to_byte();
+                hilet LEN = reader.get_bits(16);
+                hilet NLEN = reader.get_bits(16);
+                hi_check((LEN ^ NLEN) == 0xffff, "Stored block length does not match its complement");
+
+                _stored_length = LEN;
+                _state = state_type::stored_block;
+            }
+            break;
+        case 1:
+            _literal_table = &detail::deflate_fixed_literal_table;
+            _distance_table = &detail::deflate_fixed_distance_table;
+            _state = state_type::huffman_block;
+            break;
+        case 2:
+            {
+                auto [literal_table, distance_table] = detail::inflate_dynamic_tables(reader);
+                _dynamic_literal_table = std::move(literal_table);
+                _dynamic_distance_table = std::move(distance_table);
+                _literal_table = &_dynamic_literal_table;
+                _distance_table = &_dynamic_distance_table;
+                _state = state_type::huffman_block;
+            }
+            break;
+        default:
+            throw parse_error("Reserved block type");
+        }
+
+        _final_block = BFINAL;
+    }
+
+    void decode_stored_block(detail::inflate_bit_reader& reader, std::span<std::byte> output, std::size_t& out_pos) noexcept
+    {
+        reader.align_to_byte();
+        hilet bytes = reader.bytes();
+        hilet offset = reader.byte_offset();
+
+        hilet length = std::min({_stored_length, bytes.size() - offset, output.size() - out_pos});
+        std::memcpy(output.data() + out_pos, bytes.data() + offset, length);
+        reader.seek(offset + length);
+        out_pos += length;
+        _stored_length -= length;
+    }
+
+    void decode_symbol(detail::inflate_bit_reader& reader, std::span<std::byte> output, std::size_t& out_pos)
+    {
+        hilet literal_symbol = reader.get_symbol(*_literal_table);
+
+        if (literal_symbol <= 255) {
+            if (out_pos != output.size()) {
+                output[out_pos++] = static_cast<std::byte>(literal_symbol);
+            } else {
+                _pending_literal = static_cast<std::byte>(literal_symbol);
+            }
+
+        } else if (literal_symbol == 256) {
+            // End-of-block.
+            _state = state_type::block_header;
+
+        } else {
+            hilet length = detail::inflate_decode_length(reader, literal_symbol);
+            hilet distance_symbol = reader.get_symbol(*_distance_table);
+            hilet distance = detail::inflate_decode_distance(reader, distance_symbol);
+            hi_check(distance <= _history_size + out_pos, "Distance beyond start of decompressed data");
+
+            _copy_length = length;
+            _copy_distance = distance;
+        }
+    }
+
+    /** Decode from the reader.
+     *
+     * Decoding stops when the output window is full, the stream is finished,
+     * the reader passed @a stop_bit_offset, or when more input is needed.
+     *
+     * @return true when more input is needed, the reader is then positioned at
+     *         the start of the incomplete block header or symbol.
+     */
+    [[nodiscard]] bool decode(
+        detail::inflate_bit_reader& reader,
+        std::span<std::byte> output,
+        std::size_t& out_pos,
+        std::size_t stop_bit_offset)
+    {
+        while (true) {
+            if (not flush(output, out_pos)) {
+                return false;
+            }
+
+            if (_state == state_type::block_header and _final_block) {
+                reader.align_to_byte();
+                _state = state_type::finished;
+            }
+
+            if (_state == state_type::finished or reader.bit_offset() >= stop_bit_offset) {
+                return false;
+            }
+
+            if (_state == state_type::stored_block) {
+                decode_stored_block(reader, output, out_pos);
+                if (_stored_length != 0) {
+                    // Either the output window is full, or all input has been consumed.
+                    return out_pos != output.size();
+                }
+                _state = state_type::block_header;
+                continue;
+            }
+
+            // Block headers and symbols are decoded as a whole, so that decoding
+            // can restart from the saved reader when more input becomes available.
+            auto saved_reader = reader;
+            try {
+                if (_state == state_type::block_header) {
+                    decode_block_header(reader);
+                } else {
+                    decode_symbol(reader, output, out_pos);
+                }
+
+            } catch (parse_error const&) {
+                if (not reader.overrun()) {
+                    throw;
+                }
+                reader = saved_reader;
+                return true;
+            }
+        }
+    }
+};
+
 /** Inflate compressed data using the deflate algorithm
- * `bytes` should include at least 32 bit of trailer, for the overflow check which
- * will slightly overrun the actual compressed data for performance reasons.
  *
  * - gzip has a CRC32+ISIZE trailer.
  *   Since gzip has no end-of-segment indicator, we need to include the trailer
@@ -353,41 +719,39 @@ inline void inflate_dynamic_block(std::span<std::byte const> bytes, std::size_t&
  *   Since zlib has no end-of-segment indicator, we need to include the trailer
  *   in the byte array passed to inflate anyway.
  * - png IDAT chunks include the full zlib-format, including the 32 bit check value.
+ *
+ * @param bytes The compressed data.
+ * @param[in,out] offset The byte offset of the start of the compressed data,
+ *                       set to the byte offset after the compressed data on return.
+ * @param max_size The maximum size of the decompressed data.
+ * @return The decompressed data.
+ * @throw parse_error On invalid compressed data, or when exceeding @a max_size.
  */
 hi_export [[nodiscard]] inline bstring
 inflate(std::span<std::byte const> bytes, std::size_t& offset, std::size_t max_size = 0x0100'0000)
 {
-    std::size_t bit_offset = offset * 8;
+    auto stream = inflate_stream{};
+    auto input = bytes.subspan(offset);
 
     auto r = bstring{};
+    auto size = 0_uz;
+    while (true) {
+        if (size == r.size()) {
+            r.resize(std::min(max_size, std::max({r.size() * 2, input.size() * 2, 0x1000_uz})));
+        }
 
-    auto BFINAL = false;
-    do {
-        // Test all lengths, the trailer is at least 32 bits (Checksum)
-        // - 3 bits header
-        // - 7 bits rounding up to byte.
-        hi_check(((bit_offset + 10) >> 3) <= bytes.size(), "Input buffer overrun");
-
-        BFINAL = get_bit(bytes, bit_offset);
-        hilet BTYPE = get_bits(bytes, bit_offset, 2);
+        hilet window = std::span{r}.subspan(size);
+        size += stream.decompress(input, window);
 
-        switch (BTYPE) {
-        case 0:
-            detail::inflate_copy_block(bytes, bit_offset, max_size, r);
+        if (stream.finished()) {
             break;
-        case 1:
-            detail::inflate_fixed_block(bytes, bit_offset, max_size, r);
-            break;
-        case 2:
-            detail::inflate_dynamic_block(bytes, bit_offset, max_size, r);
-            break;
-        default:
-            throw parse_error("Reserved block type");
         }
+        hi_check(not window.empty(), "Output buffer overrun");
+        hi_check(size == r.size(), "Input buffer overrun");
+    }
 
-    } while (!BFINAL);
-
-    offset = (bit_offset + 7) / 8;
+    r.resize(size);
+    offset = bytes.size() - input.size();
     return r;
 }
 
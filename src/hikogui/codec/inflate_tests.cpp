@@ -0,0 +1,93 @@
+// Copyright Take Vos 2023.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "inflate.hpp"
+#include "../file/file.hpp"
+#include "../path/path.hpp"
+#include "../utility/utility.hpp"
+#include "../macros.hpp"
+#include <gtest/gtest.h>
+#include <iostream>
+
+using namespace std;
+using namespace hi;
+
+namespace {
+
+/** Get the deflate stream from a gzip file with a FNAME field.
+ */
+[[nodiscard]] std::span<std::byte const> gzip_deflate_data(file_view const& view)
+{
+    auto bytes = as_span<std::byte const>(view);
+
+    // Skip the fixed header and the zero terminated file name.
+    auto offset = 10_uz;
+    while (bytes[offset++] != std::byte{0}) {}
+    return bytes.subspan(offset);
+}
+
+void stream_decompress(std::string_view name, std::size_t chunk_size, std::size_t window_size)
+{
+    hilet compressed = file_view{library_source_dir() / "tests" / "data" / std::format("{}.bin.gz", name)};
+    hilet original = file_view{library_source_dir() / "tests" / "data" / std::format("{}.bin", name)};
+    hilet original_bytes = as_bstring_view(original);
+
+    auto data = gzip_deflate_data(compressed);
+
+    auto stream = inflate_stream{};
+    auto window = bstring(window_size, std::byte{0});
+    auto decompressed = bstring{};
+    auto input = std::span<std::byte const>{};
+    while (not stream.finished()) {
+        if (input.empty()) {
+            ASSERT_FALSE(data.empty());
+            hilet size = std::min(chunk_size, data.size());
+            input = data.first(size);
+            data = data.subspan(size);
+        }
+
+        hilet size = stream.decompress(input, window);
+        decompressed.append(window.data(), size);
+    }
+
+    ASSERT_TRUE(decompressed == original_bytes);
+
+    // Only the CRC32 and ISIZE trailer should be left.
+    ASSERT_EQ(input.size() + data.size(), 8);
+}
+
+} // namespace
+
+TEST(Inflate, StreamCpHTML)
+{
+    stream_decompress("gzip_test4", 7, 100);
+}
+
+TEST(Inflate, StreamGrammarLSPSingleByte)
+{
+    stream_decompress("gzip_test6", 1, 1);
+}
+
+TEST(Inflate, StreamXargs1LargeWindow)
+{
+    stream_decompress("gzip_test8", 1000, 0x1'0000);
+}
+
+TEST(Inflate, Truncated)
+{
+    hilet compressed = file_view{library_source_dir() / "tests" / "data" / "gzip_test4.bin.gz"};
+    hilet data = gzip_deflate_data(compressed);
+
+    auto offset = 0_uz;
+    ASSERT_THROW((void)inflate(data.first(data.size() / 2), offset), parse_error);
+}
+
+TEST(Inflate, MaximumSize)
+{
+    hilet compressed = file_view{library_source_dir() / "tests" / "data" / "gzip_test4.bin.gz"};
+    hilet data = gzip_deflate_data(compressed);
+
+    auto offset = 0_uz;
+    ASSERT_THROW((void)inflate(data, offset, 1000), parse_error);
+}
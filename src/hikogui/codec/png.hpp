@@ -10,19 +10,405 @@
 #include "../geometry/module.hpp"
 #include "../container/module.hpp"
 #include "../parser/parser.hpp"
+#include "../dispatch/dispatch.hpp"
 #include "../macros.hpp"
 #include "zlib.hpp"
 #include <span>
 #include <vector>
 #include <cstddef>
 #include <cstdint>
-#include <numeric>
 #include <filesystem>
 #include <memory>
+#include <atomic>
+#include <array>
+#include <cstring>
+#include <algorithm>
+#if defined(HI_HAS_SSE2)
+#include <emmintrin.h>
+#endif
+#if defined(HI_HAS_SSSE3)
+#include <tmmintrin.h>
+#endif
+#if defined(HI_HAS_AVX2)
+#include <immintrin.h>
+#endif
 
 hi_export_module(hikogui.codec.png);
 
 namespace hi { inline namespace v1 {
+namespace detail {
+
+[[nodiscard]] constexpr uint8_t png_paeth_predictor(uint8_t _a, uint8_t _b, uint8_t _c) noexcept
+{
+    hilet a = static_cast<int>(_a);
+    hilet b = static_cast<int>(_b);
+    hilet c = static_cast<int>(_c);
+
+    hilet p = a + b - c;
+    hilet pa = std::abs(p - a);
+    hilet pb = std::abs(p - b);
+    hilet pc = std::abs(p - c);
+
+    if (pa <= pb && pa <= pc) {
+        return narrow_cast<uint8_t>(a);
+    } else if (pb <= pc) {
+        return narrow_cast<uint8_t>(b);
+    } else {
+        return narrow_cast<uint8_t>(c);
+    }
+}
+
+#if defined(HI_HAS_SSE2)
+/** Load a single pixel into the low bytes of a register.
+ */
+template<std::size_t BytesPerPixel>
+[[nodiscard]] hi_force_inline __m128i png_load_pixel(uint8_t const *ptr) noexcept
+{
+    // The samples are combined in integer registers, a memcpy() through a zero
+    // initialized variable would cause a store-forwarding stall on every pixel.
+    if constexpr (BytesPerPixel == 3) {
+        auto lo = uint16_t{};
+        std::memcpy(&lo, ptr, 2);
+        return _mm_cvtsi32_si128(static_cast<int32_t>(lo | (uint32_t{ptr[2]} << 16)));
+    } else if constexpr (BytesPerPixel == 4) {
+        auto tmp = uint32_t{};
+        std::memcpy(&tmp, ptr, 4);
+        return _mm_cvtsi32_si128(static_cast<int32_t>(tmp));
+    } else if constexpr (BytesPerPixel == 6) {
+        auto lo = uint32_t{};
+        auto hi = uint16_t{};
+        std::memcpy(&lo, ptr, 4);
+        std::memcpy(&hi, ptr + 4, 2);
+        return _mm_cvtsi64_si128(static_cast<int64_t>(lo | (uint64_t{hi} << 32)));
+    } else if constexpr (BytesPerPixel == 8) {
+        return _mm_loadl_epi64(reinterpret_cast<__m128i const *>(ptr));
+    } else {
+        hi_static_no_default();
+    }
+}
+
+/** Store the low bytes of a register as a single pixel.
+ */
+template<std::size_t BytesPerPixel>
+hi_force_inline void png_store_pixel(uint8_t *ptr, __m128i pixel) noexcept
+{
+    static_assert(BytesPerPixel >= 3 and BytesPerPixel <= 8);
+
+    hilet tmp = _mm_cvtsi128_si64(pixel);
+    std::memcpy(ptr, &tmp, BytesPerPixel);
+}
+
+/** Broadcast the last pixel of a 16 byte chunk to all the pixels in the register.
+ */
+template<std::size_t BytesPerPixel>
+[[nodiscard]] hi_force_inline __m128i png_broadcast_last_pixel(__m128i chunk) noexcept
+{
+    if constexpr (BytesPerPixel == 1) {
+        hilet tmp = _mm_shufflehi_epi16(_mm_unpackhi_epi8(chunk, chunk), 0b11'11'11'11);
+        return _mm_shuffle_epi32(tmp, 0b11'11'11'11);
+    } else if constexpr (BytesPerPixel == 2) {
+        return _mm_shuffle_epi32(_mm_shufflehi_epi16(chunk, 0b11'11'11'11), 0b11'11'11'11);
+    } else if constexpr (BytesPerPixel == 4) {
+        return _mm_shuffle_epi32(chunk, 0b11'11'11'11);
+    } else if constexpr (BytesPerPixel == 8) {
+        return _mm_unpackhi_epi64(chunk, chunk);
+    } else {
+        hi_static_no_default();
+    }
+}
+
+/** Un-filter the sub-filter 16 bytes at a time.
+ *
+ * The pixels inside a chunk are summed using a prefix-sum of shifted copies of
+ * the chunk, the last pixel of the previous chunk is added to every pixel.
+ *
+ * @return The number of bytes that were un-filtered.
+ */
+template<std::size_t BytesPerPixel>
+[[nodiscard]] inline std::size_t png_unfilter_line_sub_sse2(uint8_t *line, std::size_t size) noexcept
+{
+    auto carry = _mm_setzero_si128();
+    auto i = 0_uz;
+    for (; i + 16 <= size; i += 16) {
+        auto chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(line + i));
+        if constexpr (BytesPerPixel <= 1) {
+            chunk = _mm_add_epi8(chunk, _mm_slli_si128(chunk, 1));
+        }
+        if constexpr (BytesPerPixel <= 2) {
+            chunk = _mm_add_epi8(chunk, _mm_slli_si128(chunk, 2));
+        }
+        if constexpr (BytesPerPixel <= 4) {
+            chunk = _mm_add_epi8(chunk, _mm_slli_si128(chunk, 4));
+        }
+        chunk = _mm_add_epi8(chunk, _mm_slli_si128(chunk, 8));
+        chunk = _mm_add_epi8(chunk, carry);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(line + i), chunk);
+
+        carry = png_broadcast_last_pixel<BytesPerPixel>(chunk);
+    }
+    return i;
+}
+
+/** Un-filter the average-filter one pixel at a time.
+ *
+ * @return The number of bytes that were un-filtered.
+ */
+template<std::size_t BytesPerPixel>
+[[nodiscard]] inline std::size_t png_unfilter_line_average_sse2(uint8_t *line, uint8_t const *prev_line, std::size_t size) noexcept
+{
+    hilet ones = _mm_set1_epi8(1);
+
+    auto left = _mm_setzero_si128();
+    auto i = 0_uz;
+    for (; i + BytesPerPixel <= size; i += BytesPerPixel) {
+        hilet up = png_load_pixel<BytesPerPixel>(prev_line + i);
+        hilet pixel = png_load_pixel<BytesPerPixel>(line + i);
+
+        // _mm_avg_epu8() rounds up, the filter requires the average to be rounded down.
+        hilet average = _mm_sub_epi8(_mm_avg_epu8(left, up), _mm_and_si128(_mm_xor_si128(left, up), ones));
+
+        left = _mm_add_epi8(pixel, average);
+        png_store_pixel<BytesPerPixel>(line + i, left);
+    }
+    return i;
+}
+
+[[nodiscard]] hi_force_inline __m128i png_abs_epi16(__m128i x) noexcept
+{
+#if defined(HI_HAS_SSSE3)
+    return _mm_abs_epi16(x);
+#else
+    return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+#endif
+}
+
+[[nodiscard]] hi_force_inline __m128i png_select(__m128i mask, __m128i a, __m128i b) noexcept
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/** Un-filter the paeth-filter one pixel at a time.
+ *
+ * The predictor is calculated for all samples of the pixel in parallel as 16 bit integers.
+ *
+ * @return The number of bytes that were un-filtered.
+ */
+template<std::size_t BytesPerPixel>
+[[nodiscard]] inline std::size_t png_unfilter_line_paeth_sse2(uint8_t *line, uint8_t const *prev_line, std::size_t size) noexcept
+{
+    hilet zero = _mm_setzero_si128();
+
+    auto left = zero;
+    auto left_up = zero;
+    auto i = 0_uz;
+    for (; i + BytesPerPixel <= size; i += BytesPerPixel) {
+        hilet up = _mm_unpacklo_epi8(png_load_pixel<BytesPerPixel>(prev_line + i), zero);
+        hilet pixel = png_load_pixel<BytesPerPixel>(line + i);
+
+        // p = left + up - left_up
+        // pa = |p - left| = |up - left_up|
+        // pb = |p - up| = |left - left_up|
+        // pc = |p - left_up| = |up - left_up + left - left_up|
+        auto pa = _mm_sub_epi16(up, left_up);
+        auto pb = _mm_sub_epi16(left, left_up);
+        auto pc = _mm_add_epi16(pa, pb);
+        pa = png_abs_epi16(pa);
+        pb = png_abs_epi16(pb);
+        pc = png_abs_epi16(pc);
+
+        // Select in the same order of preference as the scalar predictor.
+        hilet smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+        auto predictor = png_select(_mm_cmpeq_epi16(pc, smallest), left_up, up);
+        predictor = png_select(_mm_cmpeq_epi16(pb, smallest), up, predictor);
+        predictor = png_select(_mm_cmpeq_epi16(pa, smallest), left, predictor);
+
+        hilet result = _mm_add_epi8(pixel, _mm_packus_epi16(predictor, predictor));
+        png_store_pixel<BytesPerPixel>(line + i, result);
+
+        left = _mm_unpacklo_epi8(result, zero);
+        left_up = up;
+    }
+    return i;
+}
+#endif
+
+#if defined(HI_HAS_SSSE3)
+/** Un-filter the sub-filter 12 bytes at a time, for pixels that are 3 or 6 bytes.
+ *
+ * @return The number of bytes that were un-filtered.
+ */
+template<std::size_t BytesPerPixel>
+[[nodiscard]] inline std::size_t png_unfilter_line_sub_ssse3(uint8_t *line, std::size_t size) noexcept
+{
+    static_assert(BytesPerPixel == 3 or BytesPerPixel == 6);
+
+    hilet broadcast_last_pixel = BytesPerPixel == 3 ? _mm_setr_epi8(9, 10, 11, 9, 10, 11, 9, 10, 11, 9, 10, 11, 9, 10, 11, 9) :
+                                                      _mm_setr_epi8(6, 7, 8, 9, 10, 11, 6, 7, 8, 9, 10, 11, 6, 7, 8, 9);
+
+    auto carry = _mm_setzero_si128();
+    auto i = 0_uz;
+    // A full 16 bytes is loaded, but only the first 12 bytes are stored.
+    for (; i + 16 <= size; i += 12) {
+        auto chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(line + i));
+        if constexpr (BytesPerPixel == 3) {
+            chunk = _mm_add_epi8(chunk, _mm_slli_si128(chunk, 3));
+        }
+        chunk = _mm_add_epi8(chunk, _mm_slli_si128(chunk, 6));
+        chunk = _mm_add_epi8(chunk, carry);
+
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(line + i), chunk);
+        hilet tail = _mm_cvtsi128_si32(_mm_srli_si128(chunk, 8));
+        std::memcpy(line + i + 8, &tail, 4);
+
+        carry = _mm_shuffle_epi8(chunk, broadcast_last_pixel);
+    }
+    return i;
+}
+#endif
+
+/** Un-filter a line that was filtered with the sub-filter.
+ *
+ * @param line The filtered bytes of a line, without the filter-type byte.
+ * @param bytes_per_pixel The number of bytes of a pixel, at least 1.
+ */
+inline void png_unfilter_line_sub(std::span<uint8_t> line, std::size_t bytes_per_pixel) noexcept
+{
+    auto i = 0_uz;
+#if defined(HI_HAS_SSE2)
+    switch (bytes_per_pixel) {
+    case 1:
+        i = png_unfilter_line_sub_sse2<1>(line.data(), line.size());
+        break;
+    case 2:
+        i = png_unfilter_line_sub_sse2<2>(line.data(), line.size());
+        break;
+    case 4:
+        i = png_unfilter_line_sub_sse2<4>(line.data(), line.size());
+        break;
+    case 8:
+        i = png_unfilter_line_sub_sse2<8>(line.data(), line.size());
+        break;
+#if defined(HI_HAS_SSSE3)
+    case 3:
+        i = png_unfilter_line_sub_ssse3<3>(line.data(), line.size());
+        break;
+    case 6:
+        i = png_unfilter_line_sub_ssse3<6>(line.data(), line.size());
+        break;
+#endif
+    default:;
+    }
+#endif
+
+    for (i = std::max(i, bytes_per_pixel); i < line.size(); ++i) {
+        line[i] += line[i - bytes_per_pixel];
+    }
+}
+
+/** Un-filter a line that was filtered with the up-filter.
+ *
+ * @param line The filtered bytes of a line, without the filter-type byte.
+ * @param prev_line The un-filtered bytes of the previous line, or zeros for the first line.
+ */
+inline void png_unfilter_line_up(std::span<uint8_t> line, std::span<uint8_t const> prev_line) noexcept
+{
+    hi_axiom(prev_line.size() >= line.size());
+
+    auto i = 0_uz;
+#if defined(HI_HAS_AVX2)
+    for (; i + 32 <= line.size(); i += 32) {
+        hilet up = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(prev_line.data() + i));
+        hilet pixels = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(line.data() + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(line.data() + i), _mm256_add_epi8(pixels, up));
+    }
+#endif
+#if defined(HI_HAS_SSE2)
+    for (; i + 16 <= line.size(); i += 16) {
+        hilet up = _mm_loadu_si128(reinterpret_cast<__m128i const *>(prev_line.data() + i));
+        hilet pixels = _mm_loadu_si128(reinterpret_cast<__m128i const *>(line.data() + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(line.data() + i), _mm_add_epi8(pixels, up));
+    }
+#endif
+
+    for (; i != line.size(); ++i) {
+        line[i] += prev_line[i];
+    }
+}
+
+/** Un-filter a line that was filtered with the average-filter.
+ *
+ * @param line The filtered bytes of a line, without the filter-type byte.
+ * @param prev_line The un-filtered bytes of the previous line, or zeros for the first line.
+ * @param bytes_per_pixel The number of bytes of a pixel, at least 1.
+ */
+inline void png_unfilter_line_average(std::span<uint8_t> line, std::span<uint8_t const> prev_line, std::size_t bytes_per_pixel) noexcept
+{
+    hi_axiom(prev_line.size() >= line.size());
+
+    auto i = 0_uz;
+#if defined(HI_HAS_SSE2)
+    // With fewer than 3 bytes per pixel the dependency between pixels dominates.
+    switch (bytes_per_pixel) {
+    case 3:
+        i = png_unfilter_line_average_sse2<3>(line.data(), prev_line.data(), line.size());
+        break;
+    case 4:
+        i = png_unfilter_line_average_sse2<4>(line.data(), prev_line.data(), line.size());
+        break;
+    case 6:
+        i = png_unfilter_line_average_sse2<6>(line.data(), prev_line.data(), line.size());
+        break;
+    case 8:
+        i = png_unfilter_line_average_sse2<8>(line.data(), prev_line.data(), line.size());
+        break;
+    default:;
+    }
+#endif
+
+    for (; i != line.size(); ++i) {
+        hilet left = i >= bytes_per_pixel ? line[i - bytes_per_pixel] : uint8_t{0};
+        line[i] += narrow_cast<uint8_t>((left + prev_line[i]) / 2);
+    }
+}
+
+/** Un-filter a line that was filtered with the paeth-filter.
+ *
+ * @param line The filtered bytes of a line, without the filter-type byte.
+ * @param prev_line The un-filtered bytes of the previous line, or zeros for the first line.
+ * @param bytes_per_pixel The number of bytes of a pixel, at least 1.
+ */
+inline void png_unfilter_line_paeth(std::span<uint8_t> line, std::span<uint8_t const> prev_line, std::size_t bytes_per_pixel) noexcept
+{
+    hi_axiom(prev_line.size() >= line.size());
+
+    auto i = 0_uz;
+#if defined(HI_HAS_SSE2)
+    switch (bytes_per_pixel) {
+    case 3:
+        i = png_unfilter_line_paeth_sse2<3>(line.data(), prev_line.data(), line.size());
+        break;
+    case 4:
+        i = png_unfilter_line_paeth_sse2<4>(line.data(), prev_line.data(), line.size());
+        break;
+    case 6:
+        i = png_unfilter_line_paeth_sse2<6>(line.data(), prev_line.data(), line.size());
+        break;
+    case 8:
+        i = png_unfilter_line_paeth_sse2<8>(line.data(), prev_line.data(), line.size());
+        break;
+    default:;
+    }
+#endif
+
+    for (; i != line.size(); ++i) {
+        hilet up = prev_line[i];
+        hilet left = i >= bytes_per_pixel ? line[i - bytes_per_pixel] : uint8_t{0};
+        hilet left_up = i >= bytes_per_pixel ? prev_line[i - bytes_per_pixel] : uint8_t{0};
+        line[i] += png_paeth_predictor(left, up, left_up);
+    }
+}
+
+} // namespace detail
 
 hi_export class png {
 public:
@@ -47,24 +433,37 @@ public:
         return _height;
     }
 
-    void decode_image(pixmap_span<sfloat_rgba16> image) const
+    /** Decode the image.
+     *
+     * The image data is decompressed, un-filtered and converted one line at a
+     * time, so that the complete uncompressed image is never held in memory.
+     *
+     * @param image The image to write the pixels into, the size must match the PNG.
+     * @param nr_workers The number of bands of lines that are converted to pixels
+     *                   concurrently on the global thread pool, while the calling
+     *                   thread decompresses and un-filters. Zero to decode on the
+     *                   calling thread only.
+     * @throw parse_error When the image data is invalid.
+     */
+    void decode_image(pixmap_span<sfloat_rgba16> image, std::size_t nr_workers = 0) const
     {
-        // There is a filter selection byte in front of every line.
-        hilet image_data_size = _stride * _height;
+        hi_assert(image.width() == width() and image.height() == height());
 
-        auto image_data = decompress_IDATs(image_data_size);
-        hi_check(ssize(image_data) == image_data_size, "Uncompressed image data has incorrect size.");
-
-        unfilter_lines(image_data);
-
-        data_to_image(image_data, image);
+        auto reader = line_reader{_idat_chunk_data};
+        // Waiting for the pool from one of its own workers could dead-lock.
+        if (nr_workers != 0 and _height > band_height and not thread_pool::global().on_thread()) {
+            decode_image_bands(reader, image, nr_workers);
+        } else {
+            decode_image_lines(reader, image);
+        }
+        reader.finish();
     }
 
-    [[nodiscard]] static pixmap<sfloat_rgba16> load(std::filesystem::path const& path)
+    [[nodiscard]] static pixmap<sfloat_rgba16> load(std::filesystem::path const& path, std::size_t nr_workers = 0)
     {
         hilet png_data = png(file_view{path});
         auto image = pixmap<sfloat_rgba16>{png_data.width(), png_data.height()};
-        png_data.decode_image(image);
+        png_data.decode_image(image, nr_workers);
         return image;
     }
 
@@ -156,26 +555,6 @@ private:
         throw parse_error("string is not null terminated.");
     }
 
-    static uint8_t paeth_predictor(uint8_t _a, uint8_t _b, uint8_t _c) noexcept
-    {
-        hilet a = static_cast<int>(_a);
-        hilet b = static_cast<int>(_b);
-        hilet c = static_cast<int>(_c);
-
-        hilet p = a + b - c;
-        hilet pa = std::abs(p - a);
-        hilet pb = std::abs(p - b);
-        hilet pc = std::abs(p - c);
-
-        if (pa <= pb && pa <= pc) {
-            return narrow_cast<uint8_t>(a);
-        } else if (pb <= pc) {
-            return narrow_cast<uint8_t>(b);
-        } else {
-            return narrow_cast<uint8_t>(c);
-        }
-    }
-
     static uint16_t get_sample(std::span<std::byte const> bytes, ssize_t& offset, bool two_bytes)
     {
         uint16_t value = static_cast<uint8_t>(bytes[offset++]);
@@ -392,125 +771,196 @@ private:
         }
     }
 
-    [[nodiscard]] bstring decompress_IDATs(std::size_t image_data_size) const
-    {
-        if (ssize(_idat_chunk_data) == 1) {
-            return zlib_decompress(_idat_chunk_data[0], image_data_size);
-        } else {
-            // Merge all idat chunks together.
-            hilet compressed_data_size =
-                std::accumulate(_idat_chunk_data.cbegin(), _idat_chunk_data.cend(), ssize_t{0}, [](hilet& a, hilet& b) {
-                    return a + ssize(b);
-                });
-
-            bstring compressed_data;
-            compressed_data.reserve(compressed_data_size);
-            for (hilet chunk_data : _idat_chunk_data) {
-                std::copy(chunk_data.begin(), chunk_data.end(), std::back_inserter(compressed_data));
+    /** Decompresses the image data from the IDAT chunks, one line at a time.
+     *
+     * The zlib stream is split over the IDAT chunks at arbitrary byte positions.
+     */
+    class line_reader {
+    public:
+        line_reader(std::vector<std::span<std::byte const>> const& chunks) : _chunks(chunks)
+        {
+            auto header = std::array<uint8_t, 2>{};
+            for (auto& c : header) {
+                while (_input.empty()) {
+                    next_chunk();
+                }
+                c = std::to_integer<uint8_t>(_input.front());
+                _input = _input.subspan(1);
             }
+            detail::zlib_check_header(header[0], header[1]);
+        }
 
-            return zlib_decompress(compressed_data, image_data_size);
+        /** Decompress a single line, including the filter-type byte.
+         */
+        void read(std::span<std::byte> line)
+        {
+            auto offset = 0_uz;
+            while (offset != line.size()) {
+                hi_check(not _stream.finished(), "Uncompressed image data has incorrect size.");
+
+                hilet n = _stream.decompress(_input, line.subspan(offset));
+                if (n == 0 and _input.empty()) {
+                    next_chunk();
+                }
+                offset += n;
+            }
         }
-    }
 
-    void unfilter_lines(bstring& image_data) const
+        /** Check that the image data ends after the last line.
+         */
+        void finish()
+        {
+            auto extra = std::array<std::byte, 1>{};
+            while (not _stream.finished()) {
+                hilet n = _stream.decompress(_input, extra);
+                hi_check(n == 0, "Uncompressed image data has incorrect size.");
+                if (_input.empty() and not _stream.finished()) {
+                    next_chunk();
+                }
+            }
+        }
+
+    private:
+        std::vector<std::span<std::byte const>> const& _chunks;
+        std::size_t _chunk_index = 0;
+        std::span<std::byte const> _input = {};
+        inflate_stream _stream = {};
+
+        void next_chunk()
+        {
+            hi_check(_chunk_index != _chunks.size(), "Uncompressed image data has incorrect size.");
+            _input = _chunks[_chunk_index++];
+        }
+    };
+
+    /** The number of lines that are converted by a worker thread at a time.
+     */
+    constexpr static int band_height = 64;
+
+    /** Decode, un-filter and convert each line in turn on the calling thread.
+     */
+    void decode_image_lines(line_reader& reader, pixmap_span<sfloat_rgba16> image) const
     {
-        hilet image_bytes = std::span(reinterpret_cast<uint8_t *>(image_data.data()), image_data.size());
-        auto zero_line = std::vector<uint8_t>(_bytes_per_line, uint8_t{0});
+        // The current and previous line, the previous line starts as all zeros.
+        auto lines = std::vector<uint8_t>(_stride * 2, uint8_t{0});
+        auto prev_line = std::span<uint8_t const>{lines}.subspan(_stride + 1, _bytes_per_line);
 
-        auto prev_line = std::span(zero_line.data(), zero_line.size());
-        for (auto y = 0_uz; y != _height; ++y) {
-            hilet line = image_bytes.subspan(y * _stride, _stride);
+        for (auto y = 0; y != _height; ++y) {
+            hilet line = std::span{lines}.subspan((y % 2) * _stride, _stride);
+            reader.read(std::as_writable_bytes(line));
             unfilter_line(line, prev_line);
             prev_line = line.subspan(1, _bytes_per_line);
+
+            // The image is stored bottom-up.
+            data_to_image_line(std::as_bytes(line.subspan(1, _bytes_per_line)), image[_height - y - 1]);
+        }
+    }
+
+    /** Decode and un-filter bands of lines on the calling thread, and convert them on the global thread pool.
+     */
+    void decode_image_bands(line_reader& reader, pixmap_span<sfloat_rgba16> image, std::size_t nr_workers) const
+    {
+        struct band_type {
+            std::vector<uint8_t> lines;
+            std::atomic<bool> busy = false;
+        };
+
+        auto& pool = thread_pool::global();
+
+        // The tasks share ownership of the bands, so that a band outlives the notify
+        // that wakes up the calling thread.
+        hilet bands = std::make_shared<std::vector<band_type>>(nr_workers);
+        for (auto& band : *bands) {
+            band.lines.resize(_stride * band_height);
+        }
+
+        // Wait for the conversions still running on the pool, also when an exception is thrown.
+        hilet d = defer([&] {
+            for (hilet& band : *bands) {
+                band.busy.wait(true);
+            }
+        });
+
+        // The last un-filtered line of the previous band, the first line is filtered against zeros.
+        auto carry_line = std::vector<uint8_t>(_bytes_per_line, uint8_t{0});
+        for (auto band_y = 0, i = 0; band_y < _height; band_y += band_height, ++i) {
+            auto& band = (*bands)[i % bands->size()];
+            band.busy.wait(true);
+
+            auto prev_line = std::span<uint8_t const>{carry_line};
+            hilet nr_lines = std::min(band_height, _height - band_y);
+            for (auto y = 0; y != nr_lines; ++y) {
+                hilet line = std::span{band.lines}.subspan(y * _stride, _stride);
+                reader.read(std::as_writable_bytes(line));
+                unfilter_line(line, prev_line);
+                prev_line = line.subspan(1, _bytes_per_line);
+            }
+            std::copy(prev_line.begin(), prev_line.end(), carry_line.begin());
+
+            band.busy.store(true);
+            pool.post_function([this, bands, &band, image, band_y, nr_lines]() mutable {
+                for (auto y = 0; y != nr_lines; ++y) {
+                    hilet line = std::span<uint8_t const>{band.lines}.subspan(y * _stride + 1, _bytes_per_line);
+                    data_to_image_line(std::as_bytes(line), image[_height - band_y - y - 1]);
+                }
+                band.busy.store(false);
+                band.busy.notify_one();
+            });
         }
     }
 
     void unfilter_line(std::span<uint8_t> line, std::span<uint8_t const> prev_line) const
     {
+        hilet bytes_per_pixel = narrow_cast<std::size_t>(_bytes_per_pixel);
+
         switch (line[0]) {
         case 0:
             return;
         case 1:
-            return unfilter_line_sub(line.subspan(1, _bytes_per_line), prev_line);
+            return detail::png_unfilter_line_sub(line.subspan(1, _bytes_per_line), bytes_per_pixel);
         case 2:
-            return unfilter_line_up(line.subspan(1, _bytes_per_line), prev_line);
+            return detail::png_unfilter_line_up(line.subspan(1, _bytes_per_line), prev_line);
         case 3:
-            return unfilter_line_average(line.subspan(1, _bytes_per_line), prev_line);
+            return detail::png_unfilter_line_average(line.subspan(1, _bytes_per_line), prev_line, bytes_per_pixel);
         case 4:
-            return unfilter_line_paeth(line.subspan(1, _bytes_per_line), prev_line);
+            return detail::png_unfilter_line_paeth(line.subspan(1, _bytes_per_line), prev_line, bytes_per_pixel);
         default:
             throw parse_error("Unknown line-filter type");
         }
     }
 
-    void unfilter_line_sub(std::span<uint8_t> line, std::span<uint8_t const> prev_line) const noexcept
-    {
-        for (int i = 0; i != _bytes_per_line; ++i) {
-            hilet j = i - _bytes_per_pixel;
-
-            uint8_t prev_raw = j >= 0 ? line[j] : 0;
-            line[i] += prev_raw;
-        }
-    }
-
-    void unfilter_line_up(std::span<uint8_t> line, std::span<uint8_t const> prev_line) const noexcept
-    {
-        for (int i = 0; i != _bytes_per_line; ++i) {
-            line[i] += prev_line[i];
-        }
-    }
-
-    void unfilter_line_average(std::span<uint8_t> line, std::span<uint8_t const> prev_line) const noexcept
-    {
-        for (int i = 0; i != _bytes_per_line; ++i) {
-            hilet j = i - _bytes_per_pixel;
-
-            uint8_t prev_raw = j >= 0 ? line[j] : 0;
-            line[i] += (prev_raw + prev_line[i]) / 2;
-        }
-    }
-
-    void unfilter_line_paeth(std::span<uint8_t> line, std::span<uint8_t const> prev_line) const noexcept
+    void data_to_image_line(std::span<std::byte const> bytes, std::span<sfloat_rgba16> line) const noexcept
     {
-        for (int i = 0; i != _bytes_per_line; ++i) {
-            hilet j = i - _bytes_per_pixel;
-
-            uint8_t const up = prev_line[i];
-            uint8_t const left = j >= 0 ? line[j] : 0;
-            uint8_t const left_up = j >= 0 ? prev_line[j] : 0;
-            line[i] += paeth_predictor(left, up, left_up);
+        auto x = 0;
+#if defined(HI_HAS_SSE4_1)
+        // The transfer function is a table lookup per sample and the color conversion works on
+        // one f32x4 pixel; only the packing of two pixels to half-float shares a single register.
+        for (; x + 2 <= _width; x += 2) {
+            hilet pixels = native_simd<float16, 8>{
+                extract_linear_pixel_from_line(bytes, x).reg(), extract_linear_pixel_from_line(bytes, x + 1).reg()};
+            pixels.store(static_cast<void *>(std::addressof(line[x])));
         }
-    }
-
-    void data_to_image(bstring bytes, pixmap_span<sfloat_rgba16> image) const noexcept
-    {
-        auto bytes_span = std::span(bytes);
-
-        for (int y = 0; y != _height; ++y) {
-            int inv_y = _height - y - 1;
-
-            auto bytes_line = bytes_span.subspan(inv_y * _stride + 1, _bytes_per_line);
-            auto pixel_line = image[y];
-            data_to_image_line(bytes_line, pixel_line);
+#endif
+        for (; x != _width; ++x) {
+            line[x] = extract_linear_pixel_from_line(bytes, x);
         }
     }
 
-    void data_to_image_line(std::span<std::byte const> bytes, std::span<sfloat_rgba16> line) const noexcept
+    /** Extract a pixel and convert it to linear sRGB with pre-multiplied alpha.
+     */
+    [[nodiscard]] f32x4 extract_linear_pixel_from_line(std::span<std::byte const> bytes, int x) const noexcept
     {
         hilet alpha_mul = _bit_depth == 16 ? 1.0f / 65535.0f : 1.0f / 255.0f;
-        for (int x = 0; x != _width; ++x) {
-            hilet value = extract_pixel_from_line(bytes, x);
+        hilet value = extract_pixel_from_line(bytes, x);
 
-            hilet linear_RGB =
-                f32x4{_transfer_function[value.x()], _transfer_function[value.y()], _transfer_function[value.z()], 1.0f};
+        hilet linear_RGB =
+            f32x4{_transfer_function[value.x()], _transfer_function[value.y()], _transfer_function[value.z()], 1.0f};
 
-            hilet linear_sRGB_color = _color_to_sRGB * linear_RGB;
-            hilet alpha = static_cast<float>(value.w()) * alpha_mul;
+        hilet linear_sRGB_color = _color_to_sRGB * linear_RGB;
+        hilet alpha = static_cast<float>(value.w()) * alpha_mul;
 
-            // pre-multiply the alpha for use in texture-maps.
-            line[x] = linear_sRGB_color * alpha;
-        }
+        // pre-multiply the alpha for use in texture-maps.
+        return linear_sRGB_color * alpha;
     }
 
     u16x4 extract_pixel_from_line(std::span<std::byte const> bytes, int x) const noexcept
@@ -0,0 +1,212 @@
+// Copyright Take Vos 2023.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "png.hpp"
+#include "../utility/utility.hpp"
+#include "../macros.hpp"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace hi;
+
+namespace {
+
+/** Byte-at-a-time reference implementation of the PNG un-filter.
+ */
+void reference_unfilter(int filter_type, std::vector<uint8_t>& line, std::vector<uint8_t> const& prev_line, std::size_t bytes_per_pixel)
+{
+    for (auto i = 0_uz; i != line.size(); ++i) {
+        hilet a = i >= bytes_per_pixel ? line[i - bytes_per_pixel] : uint8_t{0};
+        hilet b = prev_line[i];
+        hilet c = i >= bytes_per_pixel ? prev_line[i - bytes_per_pixel] : uint8_t{0};
+
+        switch (filter_type) {
+        case 1:
+            line[i] += a;
+            break;
+        case 2:
+            line[i] += b;
+            break;
+        case 3:
+            line[i] += narrow_cast<uint8_t>((a + b) / 2);
+            break;
+        case 4:
+            line[i] += detail::png_paeth_predictor(a, b, c);
+            break;
+        default:
+            hi_no_default();
+        }
+    }
+}
+
+void unfilter(int filter_type, std::vector<uint8_t>& line, std::vector<uint8_t> const& prev_line, std::size_t bytes_per_pixel)
+{
+    switch (filter_type) {
+    case 1:
+        return detail::png_unfilter_line_sub(line, bytes_per_pixel);
+    case 2:
+        return detail::png_unfilter_line_up(line, prev_line);
+    case 3:
+        return detail::png_unfilter_line_average(line, prev_line, bytes_per_pixel);
+    case 4:
+        return detail::png_unfilter_line_paeth(line, prev_line, bytes_per_pixel);
+    default:
+        hi_no_default();
+    }
+}
+
+void unfilter_test(int filter_type)
+{
+    auto rng = std::mt19937{42};
+
+    for (auto bytes_per_pixel = 1_uz; bytes_per_pixel <= 8; ++bytes_per_pixel) {
+        // Include line lengths that are not a multiple of the SIMD register size.
+        for (auto size = 0_uz; size != 100; ++size) {
+            auto line = std::vector<uint8_t>(size);
+            auto prev_line = std::vector<uint8_t>(size);
+            for (auto& x : line) {
+                x = narrow_cast<uint8_t>(rng());
+            }
+            for (auto& x : prev_line) {
+                x = narrow_cast<uint8_t>(rng());
+            }
+
+            auto expected = line;
+            reference_unfilter(filter_type, expected, prev_line, bytes_per_pixel);
+            unfilter(filter_type, line, prev_line, bytes_per_pixel);
+            ASSERT_EQ(line, expected) << "bytes_per_pixel=" << bytes_per_pixel << " size=" << size;
+        }
+    }
+}
+
+void put_u32(bstring& r, std::size_t value)
+{
+    for (auto shift = 24; shift >= 0; shift -= 8) {
+        r.push_back(static_cast<std::byte>((value >> shift) & 0xff));
+    }
+}
+
+void put_chunk(bstring& r, char const *type, bstring_view data)
+{
+    put_u32(r, data.size());
+    for (auto i = 0; i != 4; ++i) {
+        r.push_back(static_cast<std::byte>(type[i]));
+    }
+    r.append(data);
+    // The CRC is not checked by the decoder.
+    put_u32(r, 0);
+}
+
+/** Make a 8-bit RGBA PNG file with random pixels, using every filter type.
+ *
+ * @param extra_lines The number of lines of image data after the last line of the image.
+ */
+[[nodiscard]] bstring make_png(std::size_t width, std::size_t height, std::size_t extra_lines = 0)
+{
+    auto rng = std::mt19937{42};
+
+    auto image_data = bstring{};
+    for (auto y = 0_uz; y != height + extra_lines; ++y) {
+        image_data.push_back(static_cast<std::byte>(y % 5));
+        for (auto x = 0_uz; x != width * 4; ++x) {
+            image_data.push_back(static_cast<std::byte>(rng() & 0xff));
+        }
+    }
+    hilet compressed = zlib_compress(image_data);
+
+    auto r = bstring{};
+    for (hilet c : {137, 80, 78, 71, 13, 10, 26, 10}) {
+        r.push_back(static_cast<std::byte>(c));
+    }
+
+    auto header = bstring{};
+    put_u32(header, width);
+    put_u32(header, height);
+    for (hilet c : {8, 6, 0, 0, 0}) {
+        header.push_back(static_cast<std::byte>(c));
+    }
+    put_chunk(r, "IHDR", header);
+
+    // Split the compressed data over several IDAT chunks.
+    for (auto offset = 0_uz; offset < compressed.size(); offset += 1000) {
+        put_chunk(r, "IDAT", bstring_view{compressed}.substr(offset, 1000));
+    }
+    put_chunk(r, "IEND", bstring_view{});
+    return r;
+}
+
+[[nodiscard]] std::filesystem::path write_png(char const *name, bstring const& data)
+{
+    auto path = std::filesystem::temp_directory_path() / name;
+    auto f = file(path, access_mode::truncate_or_create_for_write);
+    f.write(data);
+    return path;
+}
+
+} // namespace
+
+TEST(PNG, PaethPredictor)
+{
+    ASSERT_EQ(detail::png_paeth_predictor(10, 20, 10), 20);
+    ASSERT_EQ(detail::png_paeth_predictor(20, 10, 10), 20);
+    ASSERT_EQ(detail::png_paeth_predictor(10, 10, 20), 10);
+    ASSERT_EQ(detail::png_paeth_predictor(255, 0, 255), 0);
+    ASSERT_EQ(detail::png_paeth_predictor(0, 0, 0), 0);
+}
+
+TEST(PNG, UnfilterSub)
+{
+    unfilter_test(1);
+}
+
+TEST(PNG, UnfilterUp)
+{
+    unfilter_test(2);
+}
+
+TEST(PNG, UnfilterAverage)
+{
+    unfilter_test(3);
+}
+
+TEST(PNG, UnfilterPaeth)
+{
+    unfilter_test(4);
+}
+
+TEST(PNG, DecodeBands)
+{
+    // Multiple bands of lines, more bands than workers, and a partial last band.
+    hilet path = write_png("hikogui_png_tests_bands.png", make_png(37, 300));
+    {
+        hilet png_data = png{path};
+
+        auto serial = pixmap<sfloat_rgba16>{png_data.width(), png_data.height()};
+        png_data.decode_image(serial);
+
+        auto banded = pixmap<sfloat_rgba16>{png_data.width(), png_data.height()};
+        png_data.decode_image(banded, 3);
+
+        ASSERT_TRUE(serial == banded);
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(PNG, DecodeExtraData)
+{
+    hilet path = write_png("hikogui_png_tests_extra.png", make_png(37, 100, 1));
+    {
+        hilet png_data = png{path};
+
+        auto serial = pixmap<sfloat_rgba16>{png_data.width(), png_data.height()};
+        ASSERT_THROW(png_data.decode_image(serial), parse_error);
+
+        auto banded = pixmap<sfloat_rgba16>{png_data.width(), png_data.height()};
+        ASSERT_THROW(png_data.decode_image(banded, 3), parse_error);
+    }
+    std::filesystem::remove(path);
+}
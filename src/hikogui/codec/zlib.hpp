@@ -9,12 +9,57 @@
 #include "../parser/parser.hpp"
 #include "../macros.hpp"
 #include "inflate.hpp"
+#include "deflate.hpp"
 #include <cstddef>
 #include <filesystem>
 
 hi_export_module(hikogui.codec.zlib);
 
 namespace hi { inline namespace v1 {
+namespace detail {
+
+/** Calculate the Adler-32 checksum as used by zlib.
+ */
+[[nodiscard]] constexpr uint32_t adler32(std::span<std::byte const> bytes) noexcept
+{
+    constexpr auto modulo = uint32_t{65521};
+    // The largest number of bytes that can be summed before b overflows.
+    constexpr auto max_run = 5552_uz;
+
+    auto a = uint32_t{1};
+    auto b = uint32_t{0};
+    while (not bytes.empty()) {
+        hilet run = std::min(bytes.size(), max_run);
+        for (hilet c : bytes.first(run)) {
+            a += std::to_integer<uint32_t>(c);
+            b += a;
+        }
+        a %= modulo;
+        b %= modulo;
+        bytes = bytes.subspan(run);
+    }
+    return (b << 16) | a;
+}
+
+/** Check the two byte zlib header.
+ *
+ * Since a preset dictionary is not supported, the deflate stream starts directly after the header.
+ *
+ * @param CMF The compression method and flags byte.
+ * @param FLG The flags byte.
+ * @throw parse_error When the header is invalid or unsupported.
+ */
+inline void zlib_check_header(uint8_t CMF, uint8_t FLG)
+{
+    hilet header_chksum = CMF * 256 + FLG;
+    hi_check(header_chksum % 31 == 0, "zlib header checksum failed.");
+
+    hi_check((CMF & 0xf) == 8, "zlib compression method must be 8");
+    hi_check(((CMF >> 4) & 0xf) <= 7, "zlib LZ77 window too large");
+    hi_check((FLG & 0x20) == 0, "zlib must not use a preset dictionary");
+}
+
+} // namespace detail
 
 [[nodiscard]] inline bstring zlib_decompress(std::span<std::byte const> bytes, std::size_t max_size)
 {
@@ -26,17 +71,7 @@ namespace hi { inline namespace v1 {
     auto offset = 0_uz;
 
     hilet header = make_placement_ptr<zlib_header>(bytes, offset);
-
-    hilet header_chksum = header->CMF * 256 + header->FLG;
-    hi_check(header_chksum % 31 == 0, "zlib header checksum failed.");
-
-    hi_check((header->CMF & 0xf) == 8, "zlib compression method must be 8");
-    hi_check(((header->CMF >> 4) & 0xf) <= 7, "zlib LZ77 window too large");
-    hi_check((header->FLG & 0x20) == 0, "zlib must not use a preset dictionary");
-
-    if (header->FLG & 0x20) {
-        [[maybe_unused]] auto FDICT = make_placement_ptr<big_uint32_buf_t>(bytes, offset);
-    }
+    detail::zlib_check_header(header->CMF, header->FLG);
 
     auto r = inflate(bytes, offset, max_size);
 
@@ -50,4 +85,32 @@ namespace hi { inline namespace v1 {
     return zlib_decompress(as_span<std::byte const>(file_view(path)), max_size);
 }
 
+/** Compress data into the zlib format.
+ *
+ * @param bytes The data to compress.
+ * @param level The trade-off between speed and compression ratio.
+ * @return The zlib stream, including the header and the Adler-32 checksum.
+ */
+[[nodiscard]] inline bstring zlib_compress(std::span<std::byte const> bytes, deflate_level level = deflate_level::best)
+{
+    // Deflate with a 32 kByte window.
+    constexpr auto CMF = uint8_t{0x78};
+
+    // The compression level is informational only.
+    hilet FLEVEL = level == deflate_level::best ? uint8_t{2} : uint8_t{0};
+    auto FLG = narrow_cast<uint8_t>(FLEVEL << 6);
+    FLG |= narrow_cast<uint8_t>(31 - (CMF * 256 + FLG) % 31);
+
+    auto r = bstring{};
+    r.push_back(std::byte{CMF});
+    r.push_back(std::byte{FLG});
+    r.append(deflate(bytes, level));
+
+    hilet ADLER32 = detail::adler32(bytes);
+    for (auto i = 0; i != 4; ++i) {
+        r.push_back(static_cast<std::byte>(ADLER32 >> (24 - i * 8)));
+    }
+    return r;
+}
+
 }} // namespace hi::v1
@@ -6,6 +6,7 @@
 
 #include "atomic.hpp" // export
 #include "callback_flags.hpp" // export
+#include "futex.hpp" // export
 #include "global_state.hpp" // export
 #include "notifier.hpp" // export
 #include "rcu.hpp" // export
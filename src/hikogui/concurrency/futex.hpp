@@ -0,0 +1,79 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+/** @file concurrency/futex.hpp Functions to spin and block on an atomic.
+ * @ingroup concurrency
+ */
+
+#pragma once
+
+#include "../macros.hpp"
+#include <atomic>
+#include <cstdint>
+
+#if HI_OPERATING_SYSTEM == HI_OS_LINUX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if HI_PROCESSOR == HI_CPU_X64 or HI_PROCESSOR == HI_CPU_X86
+#include <immintrin.h>
+#endif
+
+hi_export_module(hikogui.concurrency.futex);
+
+hi_export namespace hi { inline namespace v1 {
+
+/** Tell the processor that the current thread is in a spin-loop.
+ *
+ * This reduces the power usage, and on processors with hyper-threading
+ * gives the execution resources to the other thread on the same core.
+ */
+hi_force_inline void spin_pause() noexcept
+{
+#if HI_PROCESSOR == HI_CPU_X64 or HI_PROCESSOR == HI_CPU_X86
+    _mm_pause();
+#elif HI_PROCESSOR == HI_CPU_ARM64 and HI_COMPILER == HI_CC_MSVC
+    __yield();
+#elif HI_PROCESSOR == HI_CPU_ARM64
+    __asm__ __volatile__("yield");
+#else
+    std::atomic_signal_fence(std::memory_order::seq_cst);
+#endif
+}
+
+/** Block the current thread while the atomic has the expected value.
+ *
+ * On Linux this is a direct FUTEX_WAIT on a process-private futex, on other
+ * operating systems `std::atomic::wait()` is used.
+ *
+ * @note This function may return spuriously.
+ * @param value The atomic to wait on.
+ * @param expected The value of the atomic for which the thread should block.
+ */
+inline void futex_wait(std::atomic<uint32_t>& value, uint32_t expected) noexcept
+{
+#if HI_OPERATING_SYSTEM == HI_OS_LINUX
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t));
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t *>(&value), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+    value.wait(expected, std::memory_order::relaxed);
+#endif
+}
+
+/** Wake one thread that is blocked in `futex_wait()` on the atomic.
+ *
+ * @param value The atomic that threads are waiting on.
+ */
+inline void futex_wake_one(std::atomic<uint32_t>& value) noexcept
+{
+#if HI_OPERATING_SYSTEM == HI_OS_LINUX
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t *>(&value), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+    value.notify_one();
+#endif
+}
+
+}} // namespace hi::v1
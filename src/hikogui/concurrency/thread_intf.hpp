@@ -23,7 +23,7 @@
 #include <mutex>
 #include <bit>
 
-hi_export_module(hikogui.conurrency.thread : intf);
+hi_export_module(hikogui.concurrency.thread : intf);
 
 hi_export namespace hi { inline namespace v1 {
 namespace detail {
@@ -0,0 +1,98 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "thread_intf.hpp"
+#include "unfair_mutex.hpp"
+#include "../utility/utility.hpp"
+#include "../macros.hpp"
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+hi_export_module(hikogui.concurrency.thread : impl);
+
+namespace hi::inline v1 {
+
+[[nodiscard]] inline thread_id current_thread_id() noexcept
+{
+    // gettid() is a system call, so the id is cached for the lifetime of the thread.
+    // Thread IDs on Linux are guaranteed to be not zero.
+    thread_local hilet id = static_cast<thread_id>(::gettid());
+    return id;
+}
+
+inline void set_thread_name(std::string_view name) noexcept
+{
+    // Linux thread names are limited to 15 characters.
+    hilet short_name = std::string{name.substr(0, 15)};
+    pthread_setname_np(pthread_self(), short_name.c_str());
+
+    hilet lock = std::scoped_lock(detail::thread_names_mutex);
+    detail::thread_names.emplace(current_thread_id(), std::string{name});
+}
+
+[[nodiscard]] inline std::vector<bool> mask_cpu_set_to_vec(cpu_set_t const& rhs) noexcept
+{
+    auto r = std::vector<bool>{};
+
+    r.resize(CPU_SETSIZE);
+    for (std::size_t i = 0; i != r.size(); ++i) {
+        r[i] = CPU_ISSET(i, &rhs);
+    }
+
+    return r;
+}
+
+[[nodiscard]] inline cpu_set_t mask_vec_to_cpu_set(std::vector<bool> const& rhs) noexcept
+{
+    cpu_set_t r;
+    CPU_ZERO(&r);
+    for (std::size_t i = 0; i != std::min(rhs.size(), std::size_t{CPU_SETSIZE}); ++i) {
+        if (rhs[i]) {
+            CPU_SET(i, &r);
+        }
+    }
+    return r;
+}
+
+[[nodiscard]] inline std::vector<bool> process_affinity_mask()
+{
+    cpu_set_t process_mask;
+    if (sched_getaffinity(0, sizeof(process_mask), &process_mask) != 0) {
+        throw os_error(std::format("Could not get process affinity mask. '{}'", get_last_error_message()));
+    }
+
+    return mask_cpu_set_to_vec(process_mask);
+}
+
+inline std::vector<bool> set_thread_affinity_mask(std::vector<bool> const& mask)
+{
+    hilet thread_handle = pthread_self();
+
+    cpu_set_t old_mask;
+    if (auto error = pthread_getaffinity_np(thread_handle, sizeof(old_mask), &old_mask); error != 0) {
+        throw os_error(std::format("Could not get the thread affinity. '{}'", get_last_error_message(error)));
+    }
+
+    hilet new_mask = mask_vec_to_cpu_set(mask);
+    if (auto error = pthread_setaffinity_np(thread_handle, sizeof(new_mask), &new_mask); error != 0) {
+        throw os_error(std::format("Could not set the thread affinity. '{}'", get_last_error_message(error)));
+    }
+
+    return mask_cpu_set_to_vec(old_mask);
+}
+
+[[nodiscard]] inline std::size_t current_cpu_id() noexcept
+{
+    hilet index = sched_getcpu();
+    hi_assert(index >= 0);
+    return narrow_cast<std::size_t>(index);
+}
+
+} // namespace hi::inline v1
@@ -9,6 +9,7 @@
 #pragma once
 
 #include "unfair_mutex_intf.hpp"
+#include "futex.hpp"
 #include "global_state.hpp"
 #include "../utility/utility.hpp"
 #include "../macros.hpp"
@@ -245,12 +246,12 @@ inline void unfair_mutex_impl<UseDeadLockDetector>::unlock() noexcept
 
     hi_axiom(holds_invariant());
 
-    if (semaphore.fetch_sub(1, std::memory_order::relaxed) != 1) {
+    // The release must be on the fetch_sub itself; a fence after the fetch_sub
+    // would not order the writes in the critical section before the unlock.
+    if (semaphore.fetch_sub(1, std::memory_order::release) != 1) {
         [[unlikely]] semaphore.store(0, std::memory_order::release);
 
-        semaphore.notify_one();
-    } else {
-        atomic_thread_fence(std::memory_order::release);
+        futex_wake_one(semaphore);
     }
 
     hi_axiom(holds_invariant());
@@ -262,11 +263,45 @@ template<bool UseDeadLockDetector>
     return semaphore.load(std::memory_order::relaxed) <= 2;
 }
 
+/** Spin until the mutex is released, for a number of spins based on previous contention.
+ *
+ * @return true if the lock was acquired.
+ */
+template<bool UseDeadLockDetector>
+[[nodiscard]] inline bool unfair_mutex_impl<UseDeadLockDetector>::lock_spin() noexcept
+{
+    hilet estimate = spin_estimate.load(std::memory_order::relaxed);
+    hilet nr_spins = std::min(estimate * 2 + min_nr_spins, max_nr_spins);
+
+    for (auto i = uint32_t{0}; i != nr_spins; ++i) {
+        spin_pause();
+
+        // Only try to acquire the lock when it looks free, so that spinning
+        // threads do not steal the cache-line from the owner.
+        auto expected = semaphore.load(std::memory_order::relaxed);
+        if (expected == 0 and semaphore.compare_exchange_weak(expected, 1, std::memory_order::acquire)) {
+            // Move the estimate 1/8th toward the number of spins that were needed.
+            spin_estimate.store(estimate - estimate / 8 + i / 8, std::memory_order::relaxed);
+            return true;
+        }
+    }
+
+    // Spinning did not help, the critical section is long, spin less next time.
+    spin_estimate.store(estimate / 2, std::memory_order::relaxed);
+    return false;
+}
+
 template<bool UseDeadLockDetector>
 hi_no_inline inline void unfair_mutex_impl<UseDeadLockDetector>::lock_contended(semaphore_value_type expected) noexcept
 {
     hi_axiom(holds_invariant());
 
+    if (lock_spin()) {
+        hi_axiom(holds_invariant());
+        return;
+    }
+
+    expected = semaphore.load(std::memory_order::relaxed);
     do {
         hilet should_wait = expected == 2;
 
@@ -274,7 +309,7 @@ hi_no_inline inline void unfair_mutex_impl<UseDeadLockDetector>::lock_contended(
         expected = 1;
         if (should_wait || semaphore.compare_exchange_strong(expected, 2)) {
             hi_axiom(holds_invariant());
-            semaphore.wait(2);
+            futex_wait(semaphore, 2);
         }
 
         hi_axiom(holds_invariant());
@@ -12,6 +12,7 @@
 #include "../macros.hpp"
 #include <atomic>
 #include <memory>
+#include <cstdint>
 
 hi_export_module(hikogui.concurrency.unfair_mutex : intf);
 
@@ -25,6 +26,11 @@ namespace hi { inline namespace v1 {
  * This mutex however does block on a operating system's futex/unfair_mutex
  * primitives and therefor thread priority are properly handled.
  *
+ * Before blocking, a thread spins for a short time to see if the mutex is released.
+ * The number of spins adapts to how long the previous threads needed to spin before
+ * the mutex was released, so that long critical sections are not wasting CPU time
+ * on spinning.
+ *
  * On windows and Linux the compiler generally emits the following sequence
  * of instructions:
  *  + non-contented:
@@ -67,12 +73,23 @@ private:
      *  1 - Locked, no other thread is waiting.
      *  2 - Locked, zero or more threads are waiting.
      */
-    std::atomic_unsigned_lock_free semaphore = 0;
-    using semaphore_value_type = typename decltype(semaphore)::value_type;
+    std::atomic<uint32_t> semaphore = 0;
+    using semaphore_value_type = uint32_t;
+
+    /** The running average of the number of spins needed to acquire a contended lock.
+     */
+    std::atomic<uint32_t> spin_estimate = 0;
+
+    /** The minimum and maximum number of spins before blocking.
+     */
+    constexpr static uint32_t min_nr_spins = 16;
+    constexpr static uint32_t max_nr_spins = 1024;
 
     bool holds_invariant() const noexcept;
 
     void lock_contended(semaphore_value_type expected) noexcept;
+
+    [[nodiscard]] bool lock_spin() noexcept;
 };
 
 #ifndef NDEBUG
@@ -9,6 +9,7 @@
 #include <iostream>
 #include <string>
 #include <thread>
+#include <vector>
 
 using namespace std;
 using namespace hi;
@@ -328,3 +329,46 @@ TEST(dead_lock_detector, good_lock4)
     unfair_mutex_deadlock_remove_object(&b);
     unfair_mutex_deadlock_remove_object(&c);
 }
+
+TEST(unfair_mutex, contention)
+{
+    auto mutex = unfair_mutex_impl<false>{};
+    auto value = 0;
+
+    auto threads = std::vector<std::jthread>{};
+    for (auto i = 0; i != 8; ++i) {
+        threads.emplace_back([&] {
+            for (auto j = 0; j != 10'000; ++j) {
+                hilet lock = std::scoped_lock(mutex);
+                ++value;
+            }
+        });
+    }
+    threads.clear();
+
+    ASSERT_EQ(value, 80'000);
+    ASSERT_FALSE(mutex.is_locked());
+}
+
+TEST(unfair_mutex, contention_long_critical_section)
+{
+    using namespace std::chrono_literals;
+
+    auto mutex = unfair_mutex_impl<false>{};
+    auto value = 0;
+
+    auto threads = std::vector<std::jthread>{};
+    for (auto i = 0; i != 4; ++i) {
+        threads.emplace_back([&] {
+            for (auto j = 0; j != 10; ++j) {
+                hilet lock = std::scoped_lock(mutex);
+                std::this_thread::sleep_for(100us);
+                ++value;
+            }
+        });
+    }
+    threads.clear();
+
+    ASSERT_EQ(value, 40);
+    ASSERT_FALSE(mutex.is_locked());
+}
@@ -0,0 +1,113 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "polymorphic_optional.hpp"
+#include "../utility/utility.hpp"
+#include "../macros.hpp"
+#include <array>
+#include <memory>
+#include <type_traits>
+#include <cstddef>
+
+hi_warning_push();
+// C26495: Variable '...' is uninitialized. Always initialize a member variable (type.6).
+// For performance reasons fifo_slot::_buffer must remain uninitialized.
+hi_warning_ignore_msvc(26495);
+
+namespace hi::inline v1 {
+namespace detail {
+
+/** A slot in a ring-buffer of a fifo.
+ *
+ * The fifo tracks which slots are occupied, so a slot does not need to know if it holds a value.
+ *
+ * When @a SlotSize is zero the slot holds a value of type @a T. Otherwise the slot
+ * is a `polymorphic_optional` which can hold any value derived from @a T.
+ *
+ * @tparam T The value type, or base type of the values.
+ * @tparam SlotSize Zero for plain values, or the size of the polymorphic slot.
+ */
+template<typename T, std::size_t SlotSize>
+class fifo_slot {
+public:
+    using value_type = T;
+    using optional_type = polymorphic_optional<value_type, SlotSize, SlotSize>;
+
+    constexpr static bool is_polymorphic = true;
+
+    template<typename Value, typename... Args>
+    hi_force_inline void emplace(Args&&...args) noexcept
+    {
+        _value.template emplace<Value>(std::forward<Args>(args)...);
+    }
+
+    template<typename Func>
+    hi_force_inline void invoke_and_reset(Func&& func) noexcept
+    {
+        _value.invoke_and_reset(std::forward<Func>(func));
+    }
+
+    hi_force_inline void reset() noexcept
+    {
+        _value.reset();
+    }
+
+private:
+    optional_type _value;
+};
+
+template<typename T>
+class fifo_slot<T, 0> {
+public:
+    using value_type = T;
+
+    constexpr static bool is_polymorphic = false;
+
+    constexpr fifo_slot() noexcept = default;
+    fifo_slot(fifo_slot const&) = delete;
+    fifo_slot(fifo_slot&&) = delete;
+    fifo_slot& operator=(fifo_slot const&) = delete;
+    fifo_slot& operator=(fifo_slot&&) = delete;
+
+    template<typename Value, typename... Args>
+    hi_force_inline void emplace(Args&&...args) noexcept(std::is_nothrow_constructible_v<Value, Args...>)
+    {
+        static_assert(std::is_same_v<Value, value_type>, "A plain fifo slot can only hold the value type.");
+        std::construct_at(pointer(), std::forward<Args>(args)...);
+    }
+
+    template<typename Func>
+    hi_force_inline void invoke_and_reset(Func&& func) noexcept
+    {
+        std::forward<Func>(func)(*pointer());
+        std::destroy_at(pointer());
+    }
+
+    [[nodiscard]] hi_force_inline value_type take() noexcept
+    {
+        auto r = std::move(*pointer());
+        std::destroy_at(pointer());
+        return r;
+    }
+
+    hi_force_inline void reset() noexcept
+    {
+        std::destroy_at(pointer());
+    }
+
+private:
+    alignas(value_type) std::array<std::byte, sizeof(value_type)> _buffer;
+
+    [[nodiscard]] hi_force_inline value_type *pointer() noexcept
+    {
+        return std::launder(reinterpret_cast<value_type *>(_buffer.data()));
+    }
+};
+
+} // namespace detail
+} // namespace hi::inline v1
+
+hi_warning_pop();
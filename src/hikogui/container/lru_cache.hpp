@@ -0,0 +1,154 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "../utility/utility.hpp"
+#include "../concurrency/concurrency.hpp"
+#include "../macros.hpp"
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace hi::inline v1 {
+
+/** A thread-safe, bounded, least-recently-used cache.
+ *
+ * When the cache is full, inserting a new entry evicts the entry that was
+ * least recently inserted or retrieved.
+ *
+ * Values are copied out of the cache, so that a value that is retrieved is not
+ * affected by another thread evicting or replacing it.
+ *
+ * @tparam Key The type of the key.
+ * @tparam T The type of the value.
+ * @tparam Hash The hash function for the key.
+ * @tparam KeyEqual The equality function for the key.
+ */
+template<typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class lru_cache {
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using size_type = std::size_t;
+
+    ~lru_cache() = default;
+    lru_cache(lru_cache const&) = delete;
+    lru_cache(lru_cache&&) = delete;
+    lru_cache& operator=(lru_cache const&) = delete;
+    lru_cache& operator=(lru_cache&&) = delete;
+
+    /** Create a cache.
+     *
+     * @param capacity The maximum number of entries in the cache.
+     */
+    explicit lru_cache(size_type capacity) noexcept : _capacity(capacity)
+    {
+        hi_assert(capacity > 0);
+        _map.reserve(capacity);
+    }
+
+    [[nodiscard]] size_type capacity() const noexcept
+    {
+        return _capacity;
+    }
+
+    [[nodiscard]] size_type size() const noexcept
+    {
+        hilet lock = std::scoped_lock(_mutex);
+        return _map.size();
+    }
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    /** Retrieve a copy of a value from the cache.
+     *
+     * The entry becomes the most recently used entry.
+     *
+     * @param key The key to lookup.
+     * @return A copy of the value, or empty if the key is not in the cache.
+     */
+    [[nodiscard]] std::optional<mapped_type> get(key_type const& key) noexcept
+    {
+        hilet lock = std::scoped_lock(_mutex);
+
+        hilet it = _map.find(key);
+        if (it == _map.end()) {
+            return std::nullopt;
+        }
+
+        touch(it->second);
+        return it->second.value;
+    }
+
+    /** Insert a value into the cache.
+     *
+     * The entry becomes the most recently used entry. If the key is already
+     * in the cache its value is replaced. If the cache is full the least recently
+     * used entry is evicted.
+     *
+     * @param key The key of the value.
+     * @param value The value to insert.
+     */
+    void insert(key_type key, mapped_type value) noexcept
+    {
+        hilet lock = std::scoped_lock(_mutex);
+
+        if (hilet it = _map.find(key); it != _map.end()) {
+            it->second.value = std::move(value);
+            touch(it->second);
+            return;
+        }
+
+        if (_map.size() == _capacity) {
+            // Erase by iterator; erasing by key would reference the key of the node being destroyed.
+            _map.erase(_map.find(*_lru.back()));
+            _lru.pop_back();
+        }
+
+        hilet [it, inserted] = _map.emplace(std::move(key), entry_type{std::move(value), {}});
+        hi_axiom(inserted);
+        _lru.push_front(std::addressof(it->first));
+        it->second.lru_it = _lru.begin();
+    }
+
+    /** Remove all entries from the cache.
+     */
+    void clear() noexcept
+    {
+        hilet lock = std::scoped_lock(_mutex);
+        _map.clear();
+        _lru.clear();
+    }
+
+private:
+    /** The list of keys, from the most recently to least recently used.
+     *
+     * The keys point into `_map`, which has stable references to its keys.
+     */
+    using lru_type = std::list<key_type const *>;
+
+    struct entry_type {
+        mapped_type value;
+        typename lru_type::iterator lru_it;
+    };
+
+    size_type _capacity;
+
+    mutable unfair_mutex _mutex;
+    std::unordered_map<key_type, entry_type, Hash, KeyEqual> _map;
+    lru_type _lru;
+
+    void touch(entry_type& entry) noexcept
+    {
+        _lru.splice(_lru.begin(), _lru, entry.lru_it);
+    }
+};
+
+} // namespace hi::inline v1
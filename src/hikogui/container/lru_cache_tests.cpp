@@ -0,0 +1,84 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "lru_cache.hpp"
+#include "../macros.hpp"
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace hi;
+
+TEST(lru_cache, insert_get)
+{
+    auto cache = lru_cache<std::string, int>{4};
+    ASSERT_TRUE(cache.empty());
+    ASSERT_FALSE(cache.get("foo"));
+
+    cache.insert("foo", 1);
+    cache.insert("bar", 2);
+    ASSERT_EQ(cache.size(), 2);
+    ASSERT_EQ(cache.get("foo"), 1);
+    ASSERT_EQ(cache.get("bar"), 2);
+
+    cache.insert("foo", 3);
+    ASSERT_EQ(cache.size(), 2);
+    ASSERT_EQ(cache.get("foo"), 3);
+
+    cache.clear();
+    ASSERT_TRUE(cache.empty());
+    ASSERT_FALSE(cache.get("foo"));
+}
+
+TEST(lru_cache, evict_least_recently_used)
+{
+    auto cache = lru_cache<int, int>{3};
+    cache.insert(1, 10);
+    cache.insert(2, 20);
+    cache.insert(3, 30);
+
+    // Use 1, so that 2 becomes the least recently used.
+    ASSERT_EQ(cache.get(1), 10);
+
+    cache.insert(4, 40);
+    ASSERT_EQ(cache.size(), 3);
+    ASSERT_EQ(cache.get(1), 10);
+    ASSERT_FALSE(cache.get(2));
+    ASSERT_EQ(cache.get(3), 30);
+    ASSERT_EQ(cache.get(4), 40);
+
+    // Replacing a value also makes it the most recently used.
+    cache.insert(1, 11);
+    cache.insert(5, 50);
+    ASSERT_EQ(cache.get(1), 11);
+    ASSERT_FALSE(cache.get(3));
+}
+
+TEST(lru_cache, threads)
+{
+    constexpr auto nr_threads = 4;
+    constexpr auto nr_keys = 100;
+
+    auto cache = lru_cache<int, std::string>{nr_keys / 2};
+
+    {
+        auto threads = std::vector<std::jthread>{};
+        for (auto i = 0; i != nr_threads; ++i) {
+            threads.emplace_back([&cache, i] {
+                for (auto j = 0; j != 10'000; ++j) {
+                    hilet key = (j * 7 + i) % nr_keys;
+                    if (auto value = cache.get(key)) {
+                        ASSERT_EQ(*value, std::to_string(key));
+                    } else {
+                        cache.insert(key, std::to_string(key));
+                    }
+                }
+            });
+        }
+    }
+
+    ASSERT_EQ(cache.size(), nr_keys / 2);
+}
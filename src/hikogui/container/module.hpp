@@ -2,15 +2,19 @@
 #pragma once
 
 #include "byte_string.hpp"
+#include "fifo_slot.hpp"
 #include "function_fifo.hpp"
 #include "gap_buffer.hpp"
 #include "hash_map.hpp"
 #include "lean_vector.hpp"
+#include "lru_cache.hpp"
+#include "mpmc_fifo.hpp"
 #include "packed_int_array.hpp"
 #include "polymorphic_optional.hpp"
 #include "secure_vector.hpp"
 #include "small_map.hpp"
 #include "small_vector.hpp"
+#include "spsc_fifo.hpp"
 #include "stable_set.hpp"
 #include "stack.hpp"
 #include "tree.hpp"
@@ -19,3 +23,4 @@
 #include "void_span.hpp"
 #include "wfree_fifo.hpp"
 #include "wfree_unordered_map.hpp"
+#include "work_stealing_deque.hpp"
@@ -0,0 +1,164 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "fifo_slot.hpp"
+#include "../utility/utility.hpp"
+#include "../macros.hpp"
+#include <array>
+#include <atomic>
+#include <optional>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace hi::inline v1 {
+
+/** A bounded multiple-producer/multiple-consumer fifo.
+ *
+ * This is Dmitry Vyukov's bounded queue. Each slot has a sequence number which
+ * tells producers and consumers if the slot is ready to be written or read, so that
+ * producers and consumers only contend on their own index. Adding and taking
+ * a value is a single compare-exchange when there is no contention.
+ *
+ * @tparam T The value type, or the base type of the values when @a SlotSize is not zero.
+ * @tparam Capacity The maximum number of values in the fifo, must be a power of two.
+ * @tparam SlotSize Zero to store values of type @a T, or the size of a `polymorphic_optional`
+ *         slot to store values derived from @a T.
+ */
+template<typename T, std::size_t Capacity, std::size_t SlotSize = 0>
+class mpmc_fifo {
+public:
+    static_assert(std::has_single_bit(Capacity), "Only power-of-two capacity allowed.");
+
+    using value_type = T;
+    using slot_type = detail::fifo_slot<value_type, SlotSize>;
+
+    constexpr static std::size_t capacity = Capacity;
+
+    mpmc_fifo() noexcept
+    {
+        for (auto i = 0_uz; i != capacity; ++i) {
+            _cells[i].sequence.store(i, std::memory_order::relaxed);
+        }
+    }
+
+    mpmc_fifo(mpmc_fifo const&) = delete;
+    mpmc_fifo(mpmc_fifo&&) = delete;
+    mpmc_fifo& operator=(mpmc_fifo const&) = delete;
+    mpmc_fifo& operator=(mpmc_fifo&&) = delete;
+
+    ~mpmc_fifo()
+    {
+        while (take_one([](auto&) {})) {}
+    }
+
+    /** Check if the fifo is empty.
+     *
+     * @note The result is only a snapshot when other threads are using the fifo.
+     */
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return _head.load(std::memory_order::relaxed) == _tail.load(std::memory_order::relaxed);
+    }
+
+    /** Create a value in-place at the end of the fifo.
+     *
+     * @tparam Value The type of value to create, derived from `value_type` for polymorphic slots.
+     * @param args The arguments passed to the constructor of the value.
+     * @return True if the value was added, false if the fifo was full.
+     */
+    template<typename Value = value_type, typename... Args>
+    bool try_emplace(Args&&...args) noexcept
+    {
+        auto head = _head.load(std::memory_order::relaxed);
+        while (true) {
+            auto& cell = get_cell(head);
+            hilet sequence = cell.sequence.load(std::memory_order::acquire);
+            hilet diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(head);
+
+            if (diff == 0) {
+                if (_head.compare_exchange_weak(head, head + 1, std::memory_order::relaxed)) {
+                    cell.slot.template emplace<Value>(std::forward<Args>(args)...);
+                    cell.sequence.store(head + 1, std::memory_order::release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // The slot still contains a value from the previous lap.
+                return false;
+            } else {
+                // Another producer claimed the slot.
+                head = _head.load(std::memory_order::relaxed);
+            }
+        }
+    }
+
+    template<typename Value>
+    bool try_push(Value&& value) noexcept
+    {
+        return try_emplace<std::decay_t<Value>>(std::forward<Value>(value));
+    }
+
+    /** Take one value from the front of the fifo.
+     *
+     * @param func A function called with a reference to the value, before the value is destroyed.
+     * @return True if a value was taken, false if the fifo was empty.
+     */
+    template<typename Func>
+    bool take_one(Func&& func) noexcept
+    {
+        auto tail = _tail.load(std::memory_order::relaxed);
+        while (true) {
+            auto& cell = get_cell(tail);
+            hilet sequence = cell.sequence.load(std::memory_order::acquire);
+            hilet diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(tail + 1);
+
+            if (diff == 0) {
+                if (_tail.compare_exchange_weak(tail, tail + 1, std::memory_order::relaxed)) {
+                    cell.slot.invoke_and_reset(std::forward<Func>(func));
+                    cell.sequence.store(tail + capacity, std::memory_order::release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // The slot has not been written yet.
+                return false;
+            } else {
+                // Another consumer claimed the slot.
+                tail = _tail.load(std::memory_order::relaxed);
+            }
+        }
+    }
+
+    /** Take a value from the front of the fifo.
+     *
+     * @return The value, or empty if the fifo was empty.
+     */
+    [[nodiscard]] std::optional<value_type> try_pop() noexcept
+        requires(not slot_type::is_polymorphic)
+    {
+        auto r = std::optional<value_type>{};
+        take_one([&r](value_type& value) {
+            r = std::move(value);
+        });
+        return r;
+    }
+
+private:
+    struct cell_type {
+        std::atomic<std::size_t> sequence;
+        slot_type slot;
+    };
+
+    alignas(hardware_destructive_interference_size) std::atomic<std::size_t> _head = 0;
+    alignas(hardware_destructive_interference_size) std::atomic<std::size_t> _tail = 0;
+    alignas(hardware_destructive_interference_size) std::array<cell_type, capacity> _cells;
+
+    [[nodiscard]] hi_force_inline cell_type& get_cell(std::size_t index) noexcept
+    {
+        return _cells[index % capacity];
+    }
+};
+
+} // namespace hi::inline v1
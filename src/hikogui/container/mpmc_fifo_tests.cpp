@@ -0,0 +1,103 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "mpmc_fifo.hpp"
+#include "../macros.hpp"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace hi;
+
+namespace {
+
+struct message_base {
+    virtual ~message_base() = default;
+    [[nodiscard]] virtual int value() const noexcept = 0;
+};
+
+struct message : message_base {
+    int x;
+    message(int x) : x(x) {}
+    [[nodiscard]] int value() const noexcept override
+    {
+        return x;
+    }
+};
+
+} // namespace
+
+TEST(mpmc_fifo, push_pop)
+{
+    auto fifo = mpmc_fifo<std::string, 2>{};
+    ASSERT_TRUE(fifo.empty());
+    ASSERT_FALSE(fifo.try_pop());
+
+    ASSERT_TRUE(fifo.try_push(std::string{"a"}));
+    ASSERT_TRUE(fifo.try_emplace("b"));
+    ASSERT_FALSE(fifo.try_push(std::string{"c"}));
+
+    ASSERT_EQ(fifo.try_pop(), "a");
+    ASSERT_TRUE(fifo.try_push(std::string{"c"}));
+    ASSERT_EQ(fifo.try_pop(), "b");
+    ASSERT_EQ(fifo.try_pop(), "c");
+    ASSERT_FALSE(fifo.try_pop());
+    ASSERT_TRUE(fifo.empty());
+
+    // Values left in the fifo are destroyed with the fifo.
+    ASSERT_TRUE(fifo.try_push(std::string(100, 'x')));
+}
+
+TEST(mpmc_fifo, polymorphic)
+{
+    auto fifo = mpmc_fifo<message_base, 4, 32>{};
+    ASSERT_TRUE(fifo.try_emplace<message>(1));
+    ASSERT_TRUE(fifo.try_push(message{2}));
+
+    auto sum = 0;
+    while (fifo.take_one([&](message_base const& m) {
+        sum = sum * 10 + m.value();
+    })) {}
+    ASSERT_EQ(sum, 12);
+}
+
+TEST(mpmc_fifo, threads)
+{
+    constexpr auto nr_threads = 4;
+    constexpr auto nr_values = 100'000;
+    auto fifo = std::make_unique<mpmc_fifo<int, 64>>();
+    auto taken = std::vector<std::atomic<int>>(nr_threads * nr_values);
+    auto nr_taken = std::atomic<int>{0};
+
+    auto threads = std::vector<std::jthread>{};
+    for (auto t = 0; t != nr_threads; ++t) {
+        threads.emplace_back([&, t] {
+            for (auto i = 0; i != nr_values; ++i) {
+                while (not fifo->try_push(t * nr_values + i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        threads.emplace_back([&] {
+            while (nr_taken.load() != nr_threads * nr_values) {
+                if (auto value = fifo->try_pop()) {
+                    taken[*value].fetch_add(1);
+                    nr_taken.fetch_add(1);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    threads.clear();
+
+    // Every value is taken exactly once.
+    for (auto i = 0; i != nr_threads * nr_values; ++i) {
+        ASSERT_EQ(taken[i].load(), 1) << i;
+    }
+}
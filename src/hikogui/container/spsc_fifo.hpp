@@ -0,0 +1,220 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "fifo_slot.hpp"
+#include "../utility/utility.hpp"
+#include "../macros.hpp"
+#include <array>
+#include <atomic>
+#include <optional>
+#include <span>
+#include <bit>
+#include <cstddef>
+
+namespace hi::inline v1 {
+
+/** A wait-free single-producer/single-consumer fifo.
+ *
+ * The head and tail indices are on separate cache-lines, and each side keeps a
+ * cached copy of the other side's index so that the shared cache-line is only read
+ * when the fifo appears full or empty. Batch operations publish many values
+ * with a single release-store.
+ *
+ * @tparam T The value type, or the base type of the values when @a SlotSize is not zero.
+ * @tparam Capacity The maximum number of values in the fifo, must be a power of two.
+ * @tparam SlotSize Zero to store values of type @a T, or the size of a `polymorphic_optional`
+ *         slot to store values derived from @a T.
+ */
+template<typename T, std::size_t Capacity, std::size_t SlotSize = 0>
+class spsc_fifo {
+public:
+    static_assert(std::has_single_bit(Capacity), "Only power-of-two capacity allowed.");
+
+    using value_type = T;
+    using slot_type = detail::fifo_slot<value_type, SlotSize>;
+
+    constexpr static std::size_t capacity = Capacity;
+
+    spsc_fifo() noexcept = default;
+    spsc_fifo(spsc_fifo const&) = delete;
+    spsc_fifo(spsc_fifo&&) = delete;
+    spsc_fifo& operator=(spsc_fifo const&) = delete;
+    spsc_fifo& operator=(spsc_fifo&&) = delete;
+
+    ~spsc_fifo()
+    {
+        hilet head = _head.load(std::memory_order::acquire);
+        for (auto i = _tail.load(std::memory_order::relaxed); i != head; ++i) {
+            get_slot(i).reset();
+        }
+    }
+
+    /** Check if the fifo is empty.
+     *
+     * @note Must be called on the consumer thread.
+     */
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return _head.load(std::memory_order::relaxed) == _tail.load(std::memory_order::relaxed);
+    }
+
+    /** Create a value in-place at the end of the fifo.
+     *
+     * @note Must be called on the producer thread.
+     * @tparam Value The type of value to create, derived from `value_type` for polymorphic slots.
+     * @param args The arguments passed to the constructor of the value.
+     * @return True if the value was added, false if the fifo was full.
+     */
+    template<typename Value = value_type, typename... Args>
+    hi_force_inline bool try_emplace(Args&&...args) noexcept
+    {
+        hilet head = _head.load(std::memory_order::relaxed);
+        if (head - _tail_cache == capacity) {
+            _tail_cache = _tail.load(std::memory_order::acquire);
+            if (head - _tail_cache == capacity) {
+                return false;
+            }
+        }
+
+        get_slot(head).template emplace<Value>(std::forward<Args>(args)...);
+        _head.store(head + 1, std::memory_order::release);
+        return true;
+    }
+
+    template<typename Value>
+    hi_force_inline bool try_push(Value&& value) noexcept
+    {
+        return try_emplace<std::decay_t<Value>>(std::forward<Value>(value));
+    }
+
+    /** Add values to the end of the fifo.
+     *
+     * @note Must be called on the producer thread.
+     * @param values The values to copy into the fifo.
+     * @return The number of values that were added, less than the number of values when the fifo is full.
+     */
+    std::size_t push(std::span<value_type const> values) noexcept
+        requires(not slot_type::is_polymorphic)
+    {
+        hilet head = _head.load(std::memory_order::relaxed);
+        if (capacity - (head - _tail_cache) < values.size()) {
+            _tail_cache = _tail.load(std::memory_order::acquire);
+        }
+
+        hilet n = std::min(values.size(), capacity - (head - _tail_cache));
+        for (auto i = 0_uz; i != n; ++i) {
+            get_slot(head + i).template emplace<value_type>(values[i]);
+        }
+        _head.store(head + n, std::memory_order::release);
+        return n;
+    }
+
+    /** Take one value from the front of the fifo.
+     *
+     * @note Must be called on the consumer thread.
+     * @param func A function called with a reference to the value, before the value is destroyed.
+     * @return True if a value was taken, false if the fifo was empty.
+     */
+    template<typename Func>
+    hi_force_inline bool take_one(Func&& func) noexcept
+    {
+        hilet tail = _tail.load(std::memory_order::relaxed);
+        if (tail == _head_cache) {
+            _head_cache = _head.load(std::memory_order::acquire);
+            if (tail == _head_cache) {
+                return false;
+            }
+        }
+
+        get_slot(tail).invoke_and_reset(std::forward<Func>(func));
+        _tail.store(tail + 1, std::memory_order::release);
+        return true;
+    }
+
+    /** Take all values from the fifo.
+     *
+     * The slots are released to the producer once, after all values were taken.
+     *
+     * @note Must be called on the consumer thread.
+     * @param func A function called with a reference to each value, before the value is destroyed.
+     * @return The number of values taken.
+     */
+    template<typename Func>
+    std::size_t take_all(Func const& func) noexcept
+    {
+        hilet tail = _tail.load(std::memory_order::relaxed);
+        _head_cache = _head.load(std::memory_order::acquire);
+
+        for (auto i = tail; i != _head_cache; ++i) {
+            get_slot(i).invoke_and_reset(func);
+        }
+        _tail.store(_head_cache, std::memory_order::release);
+        return _head_cache - tail;
+    }
+
+    /** Take a value from the front of the fifo.
+     *
+     * @note Must be called on the consumer thread.
+     * @return The value, or empty if the fifo was empty.
+     */
+    [[nodiscard]] std::optional<value_type> try_pop() noexcept
+        requires(not slot_type::is_polymorphic)
+    {
+        auto r = std::optional<value_type>{};
+        take_one([&r](value_type& value) {
+            r = std::move(value);
+        });
+        return r;
+    }
+
+    /** Take values from the front of the fifo.
+     *
+     * @note Must be called on the consumer thread.
+     * @param values The values to move the values from the fifo into.
+     * @return The number of values taken.
+     */
+    std::size_t pop(std::span<value_type> values) noexcept
+        requires(not slot_type::is_polymorphic)
+    {
+        hilet tail = _tail.load(std::memory_order::relaxed);
+        if (_head_cache - tail < values.size()) {
+            _head_cache = _head.load(std::memory_order::acquire);
+        }
+
+        hilet n = std::min(values.size(), _head_cache - tail);
+        for (auto i = 0_uz; i != n; ++i) {
+            values[i] = get_slot(tail + i).take();
+        }
+        _tail.store(tail + n, std::memory_order::release);
+        return n;
+    }
+
+private:
+    /** The index of the next slot to write, written by the producer.
+     */
+    alignas(hardware_destructive_interference_size) std::atomic<std::size_t> _head = 0;
+
+    /** The producer's copy of `_tail`.
+     */
+    std::size_t _tail_cache = 0;
+
+    /** The index of the next slot to read, written by the consumer.
+     */
+    alignas(hardware_destructive_interference_size) std::atomic<std::size_t> _tail = 0;
+
+    /** The consumer's copy of `_head`.
+     */
+    std::size_t _head_cache = 0;
+
+    alignas(hardware_destructive_interference_size) std::array<slot_type, capacity> _slots;
+
+    [[nodiscard]] hi_force_inline slot_type& get_slot(std::size_t index) noexcept
+    {
+        return _slots[index % capacity];
+    }
+};
+
+} // namespace hi::inline v1
@@ -0,0 +1,142 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "spsc_fifo.hpp"
+#include "../macros.hpp"
+#include <gtest/gtest.h>
+#include <array>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace std;
+using namespace hi;
+
+namespace {
+
+struct message_base {
+    virtual ~message_base() = default;
+    [[nodiscard]] virtual int value() const noexcept = 0;
+};
+
+struct small_message : message_base {
+    int x;
+    small_message(int x) : x(x) {}
+    [[nodiscard]] int value() const noexcept override
+    {
+        return x;
+    }
+};
+
+struct large_message : message_base {
+    std::array<int, 64> x = {};
+    large_message(int x) : x{x} {}
+    [[nodiscard]] int value() const noexcept override
+    {
+        return x[0];
+    }
+};
+
+} // namespace
+
+TEST(spsc_fifo, push_pop)
+{
+    auto fifo = spsc_fifo<std::string, 4>{};
+    ASSERT_TRUE(fifo.empty());
+    ASSERT_FALSE(fifo.try_pop());
+
+    ASSERT_TRUE(fifo.try_push(std::string{"a"}));
+    ASSERT_TRUE(fifo.try_emplace("b"));
+    ASSERT_TRUE(fifo.try_push(std::string{"c"}));
+    ASSERT_TRUE(fifo.try_push(std::string{"d"}));
+    ASSERT_FALSE(fifo.try_push(std::string{"e"}));
+    ASSERT_FALSE(fifo.empty());
+
+    ASSERT_EQ(fifo.try_pop(), "a");
+    ASSERT_TRUE(fifo.try_push(std::string{"e"}));
+    ASSERT_EQ(fifo.try_pop(), "b");
+
+    auto values = std::vector<std::string>{};
+    ASSERT_EQ(fifo.take_all([&](std::string& value) {
+        values.push_back(value);
+    }), 3);
+    ASSERT_EQ(values, (std::vector<std::string>{"c", "d", "e"}));
+    ASSERT_TRUE(fifo.empty());
+
+    // Values left in the fifo are destroyed with the fifo.
+    ASSERT_TRUE(fifo.try_push(std::string(100, 'x')));
+}
+
+TEST(spsc_fifo, batch)
+{
+    auto fifo = spsc_fifo<int, 8>{};
+    auto input = std::array<int, 10>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    auto output = std::array<int, 10>{};
+
+    ASSERT_EQ(fifo.push(input), 8);
+    ASSERT_EQ(fifo.pop(std::span{output}.first(3)), 3);
+    ASSERT_EQ(fifo.push(std::span{input}.subspan(8)), 2);
+    ASSERT_EQ(fifo.pop(std::span{output}.subspan(3)), 7);
+    ASSERT_EQ(output, input);
+    ASSERT_EQ(fifo.pop(output), 0);
+}
+
+TEST(spsc_fifo, polymorphic)
+{
+    auto fifo = spsc_fifo<message_base, 4, 32>{};
+    ASSERT_TRUE(fifo.try_emplace<small_message>(1));
+    ASSERT_TRUE(fifo.try_emplace<large_message>(2));
+    ASSERT_TRUE(fifo.try_push(small_message{3}));
+
+    auto sum = 0;
+    ASSERT_EQ(fifo.take_all([&](message_base const& message) {
+        sum = sum * 10 + message.value();
+    }), 3);
+    ASSERT_EQ(sum, 123);
+}
+
+TEST(spsc_fifo, threads)
+{
+    constexpr auto nr_values = 100'000;
+    auto fifo = std::make_unique<spsc_fifo<int, 256>>();
+
+    auto producer = std::jthread{[&] {
+        auto batch = std::array<int, 16>{};
+        for (auto i = 0; i != nr_values;) {
+            if (i % 3 == 0) {
+                if (fifo->try_push(i)) {
+                    ++i;
+                } else {
+                    std::this_thread::yield();
+                }
+            } else {
+                hilet n = std::min(narrow_cast<int>(batch.size()), nr_values - i);
+                for (auto j = 0; j != n; ++j) {
+                    batch[j] = i + j;
+                }
+                if (hilet pushed = fifo->push(std::span{batch}.first(n))) {
+                    i += narrow_cast<int>(pushed);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }};
+
+    auto expected = 0;
+    while (expected != nr_values) {
+        if (expected % 2 == 0) {
+            hilet n = fifo->take_all([&](int value) {
+                ASSERT_EQ(value, expected++);
+            });
+            if (n == 0) {
+                std::this_thread::yield();
+            }
+        } else if (auto value = fifo->try_pop()) {
+            ASSERT_EQ(*value, expected++);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
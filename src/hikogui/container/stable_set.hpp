@@ -4,14 +4,15 @@
 
 #pragma once
 
+#include "wfree_unordered_map.hpp"
 #include "../utility/utility.hpp"
 #include "../concurrency/concurrency.hpp"
 #include "../macros.hpp"
 #include <mutex>
 #include <memory>
 #include <atomic>
-#include <map>
-#include <unordered_map>
+#include <array>
+#include <bit>
 #include <functional>
 
 
@@ -22,21 +23,21 @@ namespace hi::inline v1 {
  *
  * This container holds a set of unique objects, associated with a stable index.
  *
- * Currently the main use case is for `grapheme`. Where it stores multi code-point
- * graphemes into the stable_set, while holding the index in the `grapheme` object.
+ * Currently the main use case is for `text_style` objects which only hold an index while
+ * the `actual_text_style` objects are stored in the stable_set.
  *
- * Another use case is for `text_style` objects which only hold an index while
- * the `actual_text_style`  objects are stored in the stable_set.
+ * Reading objects from the set is lock-free:
+ *  - Objects are stored in chunks that double in size, so objects never move.
+ *  - The size of the set is published after the object is constructed.
+ *  - Looking up the index of an existing object uses a `wfree_unordered_map`.
+ *
+ * Only adding a new object to the set takes a mutex.
  */
 template<typename Key>
 class stable_set {
 public:
     using value_type = Key;
     using size_type = size_t;
-    using map_type = std::conditional_t<
-        std::is_default_constructible<std::hash<Key>>::value,
-        std::unordered_map<Key, size_type>,
-        std::map<Key, size_type>>;
     using key_type = Key;
     using difference_type = ptrdiff_t;
     using reference = value_type const&;
@@ -44,8 +45,21 @@ public:
     using pointer = value_type const *;
     using const_pointer = value_type const *;
 
-    ~stable_set() = default;
-    constexpr stable_set() noexcept = default;
+    ~stable_set()
+    {
+        hilet size_ = _size.load(std::memory_order::acquire);
+        for (auto i = 0_uz; i != size_; ++i) {
+            std::destroy_at(std::addressof(get(i)));
+        }
+
+        for (auto chunk_index = 0_uz; chunk_index != _chunks.size(); ++chunk_index) {
+            if (auto chunk = _chunks[chunk_index].load(std::memory_order::acquire)) {
+                std::allocator<value_type>{}.deallocate(chunk, chunk_size(chunk_index));
+            }
+        }
+    }
+
+    stable_set() noexcept = default;
     stable_set(stable_set const&) = delete;
     stable_set(stable_set&&) = delete;
     stable_set& operator=(stable_set const&) = delete;
@@ -53,8 +67,7 @@ public:
 
     [[nodiscard]] size_t size() const noexcept
     {
-        hilet lock = std::scoped_lock(_mutex);
-        return _vector.size();
+        return _size.load(std::memory_order::acquire);
     }
 
     [[nodiscard]] bool empty() const noexcept
@@ -75,9 +88,8 @@ public:
      */
     [[nodiscard]] const_reference operator[](size_t index) const noexcept
     {
-        hilet lock = std::scoped_lock(_mutex);
-        hi_assert_bounds(index, _vector);
-        return *_vector[index];
+        hi_assert_bounds(index, *this);
+        return get(index);
     }
 
     /** Insert an object into the stable-set.
@@ -92,13 +104,10 @@ public:
     template<typename Arg>
     [[nodiscard]] size_t insert(Arg&& arg) noexcept requires(std::is_same_v<std::decay_t<Arg>, value_type>)
     {
-        hilet lock = std::scoped_lock(_mutex);
-
-        hilet[it, is_inserted] = _map.emplace(std::forward<Arg>(arg), _vector.size());
-        if (is_inserted) {
-            _vector.push_back(std::addressof(it->first));
+        if (hilet index = _index.get(arg)) {
+            return *index;
         }
-        return it->second;
+        return insert_slow(std::forward<Arg>(arg));
     }
 
     /** Emplace an object into the stable-set.
@@ -113,21 +122,70 @@ public:
     template<typename... Args>
     [[nodiscard]] size_t emplace(Args&&...args) noexcept
     {
-        hilet lock = std::scoped_lock(_mutex);
-
-        hilet[it, is_inserted] = _map.emplace(value_type{std::forward<Args>(args)...}, _vector.size());
-        if (is_inserted) {
-            _vector.push_back(std::addressof(it->first));
-        }
-        return it->second;
+        return insert(value_type{std::forward<Args>(args)...});
     }
 
 private:
-    // clang-format sucks.
-    using vector_type = std::vector<const_pointer>;
+    /** The number of objects in the first chunk, each following chunk is twice the size.
+     */
+    constexpr static std::size_t first_chunk_size = 16;
+    constexpr static std::size_t first_chunk_bits = std::countr_zero(first_chunk_size);
 
-    vector_type _vector;
-    map_type _map;
+    std::array<std::atomic<value_type *>, sizeof(std::size_t) * 8 - first_chunk_bits> _chunks = {};
+    std::atomic<std::size_t> _size = 0;
+    wfree_unordered_map<value_type, size_type> _index;
+
+    /** Mutex to serialize adding new objects.
+     */
     mutable unfair_mutex _mutex;
+
+    [[nodiscard]] constexpr static std::size_t chunk_size(std::size_t chunk_index) noexcept
+    {
+        return first_chunk_size << chunk_index;
+    }
+
+    /** Get the chunk and the offset in the chunk of an object.
+     */
+    [[nodiscard]] constexpr static std::pair<std::size_t, std::size_t> chunk_position(std::size_t index) noexcept
+    {
+        hilet biased_index = index + first_chunk_size;
+        hilet chunk_index = narrow_cast<std::size_t>(std::bit_width(biased_index)) - 1 - first_chunk_bits;
+        return {chunk_index, biased_index - chunk_size(chunk_index)};
+    }
+
+    [[nodiscard]] value_type& get(std::size_t index) const noexcept
+    {
+        hilet[chunk_index, offset] = chunk_position(index);
+        hilet chunk = _chunks[chunk_index].load(std::memory_order::acquire);
+        hi_axiom_not_null(chunk);
+        return chunk[offset];
+    }
+
+    template<typename Arg>
+    hi_no_inline size_t insert_slow(Arg&& arg) noexcept
+    {
+        hilet lock = std::scoped_lock(_mutex);
+
+        // Another thread may have added the object while we were waiting for the lock.
+        if (hilet index = _index.get(arg)) {
+            return *index;
+        }
+
+        hilet index = _size.load(std::memory_order::relaxed);
+        hilet[chunk_index, offset] = chunk_position(index);
+
+        auto chunk = _chunks[chunk_index].load(std::memory_order::relaxed);
+        if (chunk == nullptr) {
+            chunk = std::allocator<value_type>{}.allocate(chunk_size(chunk_index));
+            _chunks[chunk_index].store(chunk, std::memory_order::release);
+        }
+
+        // Publish the object before its index, so that readers that find the
+        // index can always read the object.
+        hilet& value = *std::construct_at(chunk + offset, std::forward<Arg>(arg));
+        _size.store(index + 1, std::memory_order::release);
+        _index.insert(value, index);
+        return index;
+    }
 };
 } // namespace hi::inline v1
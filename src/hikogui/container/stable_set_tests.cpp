@@ -0,0 +1,73 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "stable_set.hpp"
+#include "../macros.hpp"
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace hi;
+
+TEST(stable_set, insert)
+{
+    auto set = stable_set<std::string>{};
+    ASSERT_TRUE(set.empty());
+
+    ASSERT_EQ(set.insert(std::string{"foo"}), 0);
+    ASSERT_EQ(set.insert(std::string{"bar"}), 1);
+    ASSERT_EQ(set.emplace("foo"), 0);
+    ASSERT_EQ(set.size(), 2);
+    ASSERT_EQ(set[0], "foo");
+    ASSERT_EQ(set[1], "bar");
+}
+
+TEST(stable_set, stable_references)
+{
+    auto set = stable_set<std::string>{};
+
+    ASSERT_EQ(set.emplace("first"), 0);
+    auto const *first = std::addressof(set[0]);
+
+    for (auto i = 1; i != 10'000; ++i) {
+        ASSERT_EQ(set.emplace(std::to_string(i)), i);
+    }
+
+    ASSERT_EQ(std::addressof(set[0]), first);
+    ASSERT_EQ(set.size(), 10'000);
+    for (auto i = 1; i != 10'000; ++i) {
+        ASSERT_EQ(set[i], std::to_string(i));
+    }
+}
+
+TEST(stable_set, intern_threads)
+{
+    constexpr auto nr_threads = 8;
+    constexpr auto nr_values = 1000;
+
+    auto set = stable_set<std::string>{};
+    auto results = std::vector<std::vector<size_t>>(nr_threads, std::vector<size_t>(nr_values));
+
+    {
+        auto threads = std::vector<std::jthread>{};
+        for (auto i = 0; i != nr_threads; ++i) {
+            threads.emplace_back([&set, &results, i] {
+                for (auto j = 0; j != nr_values; ++j) {
+                    // Each thread interns the same values, starting at a different value.
+                    hilet value = (j + i * 127) % nr_values;
+                    hilet index = set.emplace(std::to_string(value));
+                    ASSERT_EQ(set[index], std::to_string(value));
+                    results[i][value] = index;
+                }
+            });
+        }
+    }
+
+    ASSERT_EQ(set.size(), nr_values);
+    for (auto i = 1; i != nr_threads; ++i) {
+        ASSERT_EQ(results[i], results[0]);
+    }
+}
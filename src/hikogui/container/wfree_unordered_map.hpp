@@ -1,221 +1,656 @@
-// Copyright Take Vos 2019, 2021.
+// Copyright Take Vos 2019, 2021, 2024.
 // Distributed under the Boost Software License, Version 1.0.
 // (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
 
 #pragma once
 
+#include "../concurrency/concurrency.hpp"
 #include "../utility/utility.hpp"
 #include "../macros.hpp"
 #include <atomic>
-#include <array>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <tuple>
 #include <vector>
-#include <typeinfo>
-#include <typeindex>
+#include <bit>
+#include <cstdint>
 
+namespace hi::inline v1 {
 
+/** Unordered map with wait-free lookup, and lock-free insert and erase.
+ *
+ * The map is an open-addressing hash table with linear probing. The table grows
+ * when it becomes three-quarters full:
+ *  - A table twice the size is attached to the current table. When at most a quarter
+ *    of the slots hold live entries, the rest being erased, the new table has the same
+ *    size instead; erased entries are not migrated.
+ *  - Every thread that modifies the map helps migrating a chunk of slots.
+ *  - A slot is first frozen, then its entry is copied to the new table, then it is marked as moved.
+ *  - A modification of a key first migrates the slots of that key's probe sequence,
+ *    so that any newer value of a key is always found in the newest table.
+ *  - When all slots are moved the new table replaces the current table.
+ *  - A thread that finds the new table half full before the migration is finished
+ *    migrates the remaining slots itself, instead of waiting for other threads.
+ *
+ * Lookups hold a `wfree_idle_count` read-lock, check the newest table first and fall
+ * back to the older table. Entries and tables that are replaced are reclaimed once
+ * all readers that could have seen them have left, similar to `hi::rcu`.
+ *
+ * Entries are immutable; `insert()` replaces an entry with a new one, so lookups
+ * return a copy of the value.
+ *
+ * @tparam K The key type.
+ * @tparam V The value type, must be copy constructible.
+ * @tparam Hash The hash function for the keys.
+ * @tparam KeyEqual The equality function for the keys.
+ */
+template<typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+class wfree_unordered_map {
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
 
-namespace hi::inline v1 {
+    /** The smallest capacity of the table.
+     */
+    constexpr static std::size_t minimum_capacity = 16;
 
-template<typename K, typename V>
-struct wfree_unordered_map_item {
-    /*! The value.
-     * It comes first because it is of unknown size
+    /** Construct a map.
+     *
+     * @param capacity The initial number of slots in the table, rounded up to a power of two.
      */
-    V value;
+    explicit wfree_unordered_map(std::size_t capacity = minimum_capacity) :
+        _root(new table_type(std::bit_ceil(std::max(capacity, minimum_capacity))))
+    {
+    }
 
-    /*! Hash for quick comparison and for state.
-     * Special values:
-     *  * 0 = Empty
-     *  * 1 = Busy
-     *  * 2 = Tombstone
+    wfree_unordered_map(wfree_unordered_map const&) = delete;
+    wfree_unordered_map(wfree_unordered_map&&) = delete;
+    wfree_unordered_map& operator=(wfree_unordered_map const&) = delete;
+    wfree_unordered_map& operator=(wfree_unordered_map&&) = delete;
+
+    ~wfree_unordered_map()
+    {
+        // Nodes may be shared between a table and its next table, and may also be retired.
+        auto nodes = std::vector<node_type *>{};
+        auto tables = std::vector<table_type *>{};
+
+        for (auto table = _root.load(std::memory_order::acquire); table != nullptr;
+             table = table->next.load(std::memory_order::acquire)) {
+            tables.push_back(table);
+            nodes.insert(nodes.end(), table->owned_nodes.begin(), table->owned_nodes.end());
+            for (auto i = 0_uz; i != table->capacity; ++i) {
+                if (hilet node = get_node(table->slots[i].load(std::memory_order::relaxed))) {
+                    nodes.push_back(node);
+                }
+            }
+        }
+
+        for (hilet& [version, node, table] : _retired) {
+            if (node != nullptr) {
+                nodes.push_back(node);
+            }
+            if (table != nullptr) {
+                add_deleted_nodes(table, nodes);
+                tables.push_back(table);
+            }
+        }
+
+        std::sort(nodes.begin(), nodes.end());
+        nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+        for (auto node : nodes) {
+            delete node;
+        }
+        for (auto table : tables) {
+            delete table;
+        }
+    }
+
+    /** The number of slots in the current table.
+     */
+    [[nodiscard]] std::size_t capacity() const noexcept
+    {
+        hilet lock = std::scoped_lock(_idle_count);
+        return _root.load(std::memory_order::acquire)->capacity;
+    }
+
+    /** Get a copy of the value of a key.
      *
-     * Natural hash values 0, 1, 2 must be mapped to 3, 4, 5.
+     * @note This function is wait-free.
+     * @param key The key to find.
+     * @return The value, or empty if the key is not in the map.
      */
-    std::atomic<std::size_t> hash;
-    K key;
+    [[nodiscard]] std::optional<mapped_type> get(key_type const& key) const noexcept
+    {
+        hilet hash = make_hash(key);
+
+        hilet lock = std::scoped_lock(_idle_count);
+        hilet [state, node] = find(_root.load(std::memory_order::acquire), key, hash);
+        if (state == find_state::found) {
+            return node->value;
+        } else {
+            return std::nullopt;
+        }
+    }
 
-    constexpr wfree_unordered_map_item() noexcept requires(std::is_same_v<K, std::type_index>) :
-        value(), hash(0), key(std::type_index(typeid(void)))
+    /** Get a copy of the value of a key.
+     *
+     * @note This function is wait-free.
+     * @param key The key to find.
+     * @param default_value The value to return when the key is not in the map.
+     * @return The value, or the default value if the key is not in the map.
+     */
+    [[nodiscard]] mapped_type get(key_type const& key, mapped_type const& default_value) const noexcept
     {
+        if (auto optional_value = get(key)) {
+            return *std::move(optional_value);
+        } else {
+            return default_value;
+        }
     }
 
-    constexpr wfree_unordered_map_item() noexcept requires(not std::is_same_v<K, std::type_index>) : value(), hash(0), key() {}
+    [[nodiscard]] bool contains(key_type const& key) const noexcept
+    {
+        return get(key).has_value();
+    }
 
-    constexpr wfree_unordered_map_item(wfree_unordered_map_item const &) noexcept = delete;
-    constexpr wfree_unordered_map_item(wfree_unordered_map_item &&) noexcept = delete;
-    ~wfree_unordered_map_item() noexcept = default;
-    constexpr wfree_unordered_map_item &operator=(wfree_unordered_map_item const &) noexcept = delete;
-    constexpr wfree_unordered_map_item &operator=(wfree_unordered_map_item &&) noexcept = delete;
-};
+    /** Insert a value, or replace the value of an existing key.
+     *
+     * @param key The key.
+     * @param value The value.
+     */
+    void insert(key_type key, mapped_type value) noexcept
+    {
+        hilet hash = make_hash(key);
+        auto node = new node_type{hash, std::move(key), std::move(value)};
+        modify(node->key, hash, operation::insert, node);
+    }
 
-/*! Unordered map with wait-free insert, get and erase.
- *
- * This class can be instantiated as a global variable without
- * needing initialization.
- */
-template<typename K, typename V, std::size_t MAX_NR_ITEMS>
-class wfree_unordered_map {
-public:
-    using key_type = K;
-    using mapped_type = V;
+    /** Erase a key.
+     *
+     * @param key The key to erase.
+     * @return The value of the erased key, or empty if the key was not in the map.
+     */
+    std::optional<mapped_type> erase(key_type const& key) noexcept
+    {
+        hilet hash = make_hash(key);
+        return modify(key, hash, operation::erase, nullptr);
+    }
+
+    /** Get a list of all the keys in the map.
+     *
+     * @note The list is a snapshot when other threads are modifying the map.
+     */
+    [[nodiscard]] std::vector<key_type> keys() const noexcept
+    {
+        hilet lock = std::scoped_lock(_idle_count);
+        hilet root = _root.load(std::memory_order::acquire);
+
+        // The current entry of a key may be in either table, use find() to get the current
+        // entry and remove duplicates.
+        auto nodes = std::vector<node_type *>{};
+        for (auto table = root; table != nullptr; table = table->next.load(std::memory_order::acquire)) {
+            for (auto i = 0_uz; i != table->capacity; ++i) {
+                hilet slot = table->slots[i].load(std::memory_order::acquire);
+                if (hilet node = get_node(slot); node != nullptr and not(slot & deleted_tag)) {
+                    hilet [state, current] = find(root, node->key, node->hash);
+                    if (state == find_state::found) {
+                        nodes.push_back(current);
+                    }
+                }
+            }
+        }
+
+        std::sort(nodes.begin(), nodes.end());
+        nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+
+        auto r = std::vector<key_type>{};
+        r.reserve(nodes.size());
+        for (auto node : nodes) {
+            r.push_back(node->key);
+        }
+        return r;
+    }
 
 private:
-    constexpr static std::size_t CAPACITY = MAX_NR_ITEMS * 2;
+    struct node_type {
+        std::size_t hash;
+        key_type key;
+        mapped_type value;
+    };
 
-    std::array<wfree_unordered_map_item<K, V>, CAPACITY> items = {};
+    static_assert(alignof(node_type) >= 8, "The lower 3 bits of a node pointer are used as tags.");
 
-public:
-    constexpr wfree_unordered_map() noexcept = default;
-    constexpr wfree_unordered_map(wfree_unordered_map const &) noexcept = delete;
-    constexpr wfree_unordered_map(wfree_unordered_map &&) noexcept = delete;
-    ~wfree_unordered_map() noexcept = default;
-    constexpr wfree_unordered_map &operator=(wfree_unordered_map const &) noexcept = delete;
-    constexpr wfree_unordered_map &operator=(wfree_unordered_map &&) noexcept = delete;
+    /** The slot's node was erased; the node is kept to remember the key.
+     */
+    constexpr static uintptr_t deleted_tag = 1;
+
+    /** The slot is being migrated to the next table, it will never be modified again.
+     */
+    constexpr static uintptr_t frozen_tag = 2;
+
+    /** The slot's node has been copied to the next table.
+     */
+    constexpr static uintptr_t moved_tag = 4;
+
+    constexpr static uintptr_t tag_mask = 7;
+
+    /** The number of slots migrated at a time by a thread helping the migration.
+     */
+    constexpr static std::size_t migrate_chunk_size = 64;
+
+    struct table_type {
+        std::size_t capacity;
+        std::unique_ptr<std::atomic<uintptr_t>[]> slots;
+
+        /** The number of slots that are not empty.
+         */
+        std::atomic<std::size_t> nr_used = 0;
+
+        /** The number of slots with an erased node.
+         */
+        std::atomic<std::size_t> nr_erased = 0;
+
+        /** The table which will replace this table when all slots are migrated.
+         */
+        std::atomic<table_type *> next = nullptr;
+
+        /** The next chunk of slots to migrate.
+         */
+        std::atomic<std::size_t> migrate_index = 0;
 
-    static std::size_t make_hash(K const &key) noexcept
+        /** The number of slots that have been migrated.
+         */
+        std::atomic<std::size_t> nr_migrated = 0;
+
+        /** Nodes that were replaced in the next table, but may still be referenced by this table.
+         *
+         * Protected by `_retired_mutex`.
+         */
+        std::vector<node_type *> owned_nodes;
+
+        table_type(std::size_t capacity) : capacity(capacity), slots(std::make_unique<std::atomic<uintptr_t>[]>(capacity))
+        {
+            hi_axiom(std::has_single_bit(capacity));
+        }
+    };
+
+    enum class operation { insert, erase, copy };
+    enum class find_state { not_found, found, deleted };
+    enum class modify_state { done, not_found, retry };
+
+    std::atomic<table_type *> _root;
+    mutable wfree_idle_count _idle_count;
+
+    mutable unfair_mutex _retired_mutex;
+    std::vector<std::tuple<uint64_t, node_type *, table_type *>> _retired;
+
+    [[no_unique_address]] hasher _hasher;
+    [[no_unique_address]] key_equal _key_equal;
+
+    [[nodiscard]] std::size_t make_hash(key_type const& key) const noexcept
     {
-        hilet hash = std::hash<K>{}(key);
-        return hash >= 3 ? hash : hash + 3;
+        return _hasher(key);
     }
 
-    void insert(K key, V value) noexcept
+    [[nodiscard]] static node_type *get_node(uintptr_t slot) noexcept
     {
-        hilet hash = make_hash(key);
+        return std::bit_cast<node_type *>(slot & ~tag_mask);
+    }
 
-        auto index = hash % CAPACITY;
-        while (true) {
-            auto &item = items[index];
-
-            // First look for an empty (0) item, highly likely when doing insert.
-            std::size_t item_hash = 0;
-            if (item.hash.compare_exchange_strong(item_hash, 1, std::memory_order::acquire)) {
-                // Success, we found an empty entry, we marked it as busy (1).
-                item.key = std::move(key);
-                item.value = value;
-                item.hash.store(hash, std::memory_order::release);
-                return;
-
-            } else if (item_hash == hash && key == item.key) {
-                // Key was already in map, replace the value.
-                item.value = value;
-                return;
-
-            } else {
-                // Either this item was already in use by another key, or
-                // Another thread was ahead of us with claiming this item (hopefully the other
-                // thread doesn't insert the same key).
-                // Even though compare_exchange was used here, this algorithm is wait-free since all threads
-                // including the one here are making normal progress.
-                index = (index + 1) % CAPACITY;
+    [[nodiscard]] bool matches(node_type const *node, key_type const& key, std::size_t hash) const noexcept
+    {
+        return node->hash == hash and _key_equal(node->key, key);
+    }
+
+    /** Find the current entry of a key.
+     *
+     * @note Must be called while holding the `_idle_count` lock.
+     */
+    [[nodiscard]] std::pair<find_state, node_type *>
+    find(table_type const *table, key_type const& key, std::size_t hash) const noexcept
+    {
+        // Newer values are always in the next table.
+        if (hilet next = table->next.load(std::memory_order::acquire)) {
+            if (hilet r = find(next, key, hash); r.first != find_state::not_found) {
+                return r;
             }
         }
+
+        hilet mask = table->capacity - 1;
+        for (auto i = 0_uz; i != table->capacity; ++i) {
+            hilet slot = table->slots[(hash + i) & mask].load(std::memory_order::acquire);
+            hilet node = get_node(slot);
+
+            if (node == nullptr or matches(node, key, hash)) {
+                if (slot & frozen_tag) {
+                    // The key may have been migrated and modified after we checked the next table.
+                    // If it is not in the next table, then this slot is still the current entry.
+                    if (hilet r = find(table->next.load(std::memory_order::acquire), key, hash);
+                        r.first != find_state::not_found) {
+                        return r;
+                    }
+                }
+
+                if (node == nullptr) {
+                    return {find_state::not_found, nullptr};
+                } else if (slot & deleted_tag) {
+                    return {find_state::deleted, node};
+                } else {
+                    return {find_state::found, node};
+                }
+            }
+        }
+        return {find_state::not_found, nullptr};
     }
 
-    std::vector<K> keys() const noexcept
+    /** Modify the map.
+     *
+     * @param key The key to modify.
+     * @param hash The hash of the key.
+     * @param op The operation to perform.
+     * @param new_node The new node for insert, nullptr for erase.
+     * @return The value of the erased key.
+     */
+    std::optional<mapped_type> modify(key_type const& key, std::size_t hash, operation op, node_type *new_node) noexcept
     {
-        std::vector<K> r;
-        // XXX - with counting items, we could reserve capacity.
-
-        for (hilet &item : items) {
-            if (item.hash >= 3) {
-                r.push_back(item.key);
+        while (true) {
+            auto r = std::optional<mapped_type>{};
+            _idle_count.lock();
+            hilet state = modify(_root.load(std::memory_order::acquire), key, hash, op, new_node, r);
+            _idle_count.unlock();
+
+            reclaim();
+            if (state != modify_state::retry) {
+                return r;
             }
+
+            // The next table is half full, but the current table is still being migrated.
+            // Finish the migration, instead of waiting on the threads that claimed the remaining chunks.
+            _idle_count.lock();
+            finish_migrate(_root.load(std::memory_order::acquire));
+            _idle_count.unlock();
         }
-        return r;
     }
 
-    V &operator[](K const &key) noexcept
+    /** Modify a table.
+     *
+     * @note Must be called while holding the `_idle_count` lock.
+     */
+    modify_state modify(
+        table_type *table,
+        key_type const& key,
+        std::size_t hash,
+        operation op,
+        node_type *new_node,
+        std::optional<mapped_type>& erased_value) noexcept
     {
-        hilet hash = make_hash(key);
+        hilet mask = table->capacity - 1;
+
+    restart:
+        // Copies are never forwarded to the table after the next table, see below.
+        if (hilet next = op == operation::copy ? nullptr : table->next.load(std::memory_order::acquire)) {
+            help_migrate(table, next);
+
+            // Migrate the probe sequence of the key, so that the key is found in the next table.
+            for (auto i = 0_uz; i != table->capacity; ++i) {
+                hilet index = (hash + i) & mask;
+                hilet node = get_node(migrate_slot(table, next, index));
+                if (node == nullptr or matches(node, key, hash)) {
+                    break;
+                }
+            }
 
-        auto index = hash % CAPACITY;
-        while (true) {
-            auto &item = items[index];
+            return modify(next, key, hash, op, new_node, erased_value);
+        }
 
-            // First look for an empty (0) item, highly likely when doing insert.
-            std::size_t item_hash = 0;
-            if (item.hash.compare_exchange_strong(item_hash, 1, std::memory_order::acquire)) {
-                // Success, we found an empty entry, we marked it as busy (1).
-                item.key = std::move(key);
-                item.hash.store(hash, std::memory_order::release);
+        for (auto i = 0_uz; i != table->capacity; ++i) {
+            auto& slot = table->slots[(hash + i) & mask];
+            auto slot_value = slot.load(std::memory_order::acquire);
+
+            while (true) {
+                hilet node = get_node(slot_value);
+                if (op == operation::copy and node != nullptr and matches(node, key, hash)) {
+                    // The key was already copied, or modified after it was copied.
+                    //
+                    // A thread that was preempted while migrating a slot of the previous table may
+                    // make a stale copy after this table started migrating itself. The thread that
+                    // marked that slot as moved copied the key into this table before this table
+                    // could grow, and slots are never emptied; so a stale copy always ends here.
+                    return modify_state::done;
+                }
+
+                if (slot_value & frozen_tag) {
+                    // Copies are made before this table can grow, so they never find a frozen slot.
+                    hi_axiom(op != operation::copy);
+                    goto restart;
+                }
+
+                if (node == nullptr) {
+                    if (op == operation::erase) {
+                        return modify_state::not_found;
+                    }
+
+                    // Grow the table when it becomes three-quarters full. While the previous table is being
+                    // migrated, half of this table is reserved for copies; the previous table is either half
+                    // the size of this table, or had at most a quarter of its slots live, so copies always
+                    // find an empty slot.
+                    hilet is_root = table == _root.load(std::memory_order::acquire);
+                    hilet max_used = is_root ? table->capacity / 4 * 3 : table->capacity / 2;
+                    hilet nr_used = table->nr_used.fetch_add(1, std::memory_order::relaxed);
+                    if (op != operation::copy and nr_used >= max_used) {
+                        table->nr_used.fetch_sub(1, std::memory_order::relaxed);
+                        if (not grow(table)) {
+                            return modify_state::retry;
+                        }
+                        goto restart;
+                    }
+
+                    if (slot.compare_exchange_strong(
+                            slot_value, std::bit_cast<uintptr_t>(new_node), std::memory_order::acq_rel, std::memory_order::acquire)) {
+                        return modify_state::done;
+                    }
+                    table->nr_used.fetch_sub(1, std::memory_order::relaxed);
+
+                } else if (matches(node, key, hash)) {
+                    if (op == operation::erase) {
+                        if (slot_value & deleted_tag) {
+                            return modify_state::not_found;
+                        }
+                        if (slot.compare_exchange_strong(
+                                slot_value, slot_value | deleted_tag, std::memory_order::acq_rel, std::memory_order::acquire)) {
+                            table->nr_erased.fetch_add(1, std::memory_order::relaxed);
+                            erased_value = node->value;
+                            return modify_state::done;
+                        }
+
+                    } else {
+                        if (slot.compare_exchange_strong(
+                                slot_value, std::bit_cast<uintptr_t>(new_node), std::memory_order::acq_rel, std::memory_order::acquire)) {
+                            if (slot_value & deleted_tag) {
+                                table->nr_erased.fetch_sub(1, std::memory_order::relaxed);
+                            }
+                            if (hilet root = _root.load(std::memory_order::acquire); root != table) {
+                                // The table being migrated may still reference the node.
+                                hilet lock = std::scoped_lock(_retired_mutex);
+                                root->owned_nodes.push_back(node);
+                            } else {
+                                retire(node, nullptr);
+                            }
+                            return modify_state::done;
+                        }
+                    }
 
-                if constexpr (std::is_default_constructible_v<V>) {
-                    item.value = {};
                 } else {
-                    // Make sure we default initialize the memory.
-                    std::memset(&(item.value), 0, sizeof(item.value));
+                    // A different key, continue with the probe sequence.
+                    break;
                 }
-                return item.value;
-
-            } else if (item_hash == hash && key == item.key) {
-                // Key was already in map, replace the value.
-                return item.value;
-
-            } else {
-                // Either this item was already in use by another key, or
-                // Another thread was ahead of us with claiming this item (hopefully the other
-                // thread doesn't insert the same key).
-                // Even though compare_exchange was used here, this algorithm is wait-free since all threads
-                // including the one here are making normal progress.
-                index = (index + 1) % CAPACITY;
             }
         }
+
+        // The table is completely full. Copies always fit because of the slots reserved for them.
+        hi_axiom(op != operation::copy);
+        if (not grow(table)) {
+            return modify_state::retry;
+        }
+        goto restart;
     }
 
-    std::optional<V> get(K const &key) const noexcept
+    /** Attach a new table to a table.
+     *
+     * The new table is twice the size, or the same size when most of the used slots
+     * hold erased nodes. In both cases the live entries fit in the half of the new
+     * table that is reserved for copies.
+     *
+     * @note Must be called while holding the `_idle_count` lock.
+     * @return False if the table can not grow yet, because it is still the next table of the root.
+     */
+    [[nodiscard]] bool grow(table_type *table) noexcept
     {
-        hilet hash = make_hash(key);
+        if (table != _root.load(std::memory_order::acquire)) {
+            return false;
+        }
 
-        auto index = hash % CAPACITY;
-        while (true) {
-            auto &item = items[index];
+        hilet nr_used = table->nr_used.load(std::memory_order::relaxed);
+        hilet nr_erased = table->nr_erased.load(std::memory_order::relaxed);
+        hilet nr_live = nr_used - std::min(nr_used, nr_erased);
+        hilet new_capacity = nr_live <= table->capacity / 4 ? table->capacity : table->capacity * 2;
 
-            auto item_hash = item.hash.load(std::memory_order::acquire);
+        auto expected = static_cast<table_type *>(nullptr);
+        auto next = new table_type(new_capacity);
+        if (not table->next.compare_exchange_strong(expected, next, std::memory_order::acq_rel)) {
+            delete next;
+        }
+        return true;
+    }
+
+    /** Freeze a slot and copy its node to the next table.
+     *
+     * The thread that marks the last slot as moved replaces the root table with the next table.
+     *
+     * @note Must be called while holding the `_idle_count` lock.
+     * @return The value of the slot.
+     */
+    uintptr_t migrate_slot(table_type *table, table_type *next, std::size_t index) noexcept
+    {
+        auto& slot = table->slots[index];
+        auto slot_value = slot.load(std::memory_order::acquire);
+        while (not(slot_value & frozen_tag)) {
+            slot.compare_exchange_weak(slot_value, slot_value | frozen_tag, std::memory_order::acq_rel, std::memory_order::acquire);
+        }
 
-            if (item_hash == hash && key == item.key) {
-                // Found key
-                return {item.value};
+        if (slot_value & moved_tag) {
+            return slot_value;
+        }
 
-            } else if (item_hash == 0) {
-                // Item is empty.
-                return {};
+        // Erased nodes are not copied; they are reclaimed with the table.
+        if (hilet node = get_node(slot_value); node != nullptr and not(slot_value & deleted_tag)) {
+            auto dummy = std::optional<mapped_type>{};
+            hilet state = modify(next, node->key, node->hash, operation::copy, node, dummy);
+            hi_axiom(state == modify_state::done);
+        }
 
-            } else {
-                index = (index + 1) % CAPACITY;
+        hilet old_slot_value = slot.fetch_or(moved_tag, std::memory_order::acq_rel);
+        if (not(old_slot_value & moved_tag)) {
+            if (table->nr_migrated.fetch_add(1, std::memory_order::acq_rel) + 1 == table->capacity) {
+                auto expected = table;
+                hilet promoted = _root.compare_exchange_strong(expected, next, std::memory_order::acq_rel);
+                hi_axiom(promoted);
+                retire(nullptr, table);
             }
         }
+        return old_slot_value | moved_tag;
     }
 
-    V get(K const &key, V const &default_value) const noexcept
+    /** Migrate a chunk of slots to the next table.
+     *
+     * @note Must be called while holding the `_idle_count` lock.
+     */
+    void help_migrate(table_type *table, table_type *next) noexcept
     {
-        if (hilet optional_value = get(key)) {
-            return *optional_value;
-        } else {
-            return default_value;
+        hilet first = table->migrate_index.fetch_add(migrate_chunk_size, std::memory_order::relaxed);
+        if (first >= table->capacity) {
+            return;
+        }
+
+        hilet last = std::min(first + migrate_chunk_size, table->capacity);
+        for (auto i = first; i != last; ++i) {
+            migrate_slot(table, next, i);
         }
     }
 
-    std::optional<V> erase(K const &key) noexcept
+    /** Migrate all remaining slots of a table to the next table.
+     *
+     * @note Must be called while holding the `_idle_count` lock.
+     */
+    void finish_migrate(table_type *table) noexcept
     {
-        hilet hash = make_hash(key);
+        if (hilet next = table->next.load(std::memory_order::acquire)) {
+            for (auto i = 0_uz; i != table->capacity; ++i) {
+                migrate_slot(table, next, i);
+            }
+        }
+    }
 
-        auto index = hash % CAPACITY;
-        while (true) {
-            auto &item = items[index];
-            auto item_hash = item.hash.load(std::memory_order::acquire);
+    /** Retire a node or a table.
+     *
+     * @note Must be called while holding the `_idle_count` lock.
+     */
+    void retire(node_type *node, table_type *table) noexcept
+    {
+        hilet version = *_idle_count;
+        hilet lock = std::scoped_lock(_retired_mutex);
+        _retired.emplace_back(version, node, table);
+    }
 
-            if (item_hash == hash && key == item.key) {
-                // Set tombstone. Don't actually delete the key or value.
-                item.hash.store(1, std::memory_order::release);
-                return {item.value};
+    /** Reclaim the retired nodes and tables that can no longer be accessed by any thread.
+     *
+     * @note Must be called while not holding the `_idle_count` lock.
+     */
+    void reclaim() noexcept
+    {
+        hilet version = *_idle_count;
+
+        auto nodes = std::vector<node_type *>{};
+        auto tables = std::vector<table_type *>{};
+        {
+            hilet lock = std::scoped_lock(_retired_mutex);
+            auto it = _retired.begin();
+            for (; it != _retired.end() and std::get<0>(*it) < version; ++it) {
+                if (auto node = std::get<1>(*it)) {
+                    nodes.push_back(node);
+                }
+                if (auto table = std::get<2>(*it)) {
+                    add_deleted_nodes(table, nodes);
+                    tables.push_back(table);
+                }
+            }
+            _retired.erase(_retired.begin(), it);
+        }
 
-            } else if (item_hash == 0) {
-                // Item is empty.
-                return {};
+        for (auto node : nodes) {
+            delete node;
+        }
+        for (auto table : tables) {
+            delete table;
+        }
+    }
 
-            } else {
-                index = (index + 1) % CAPACITY;
+    /** Add the nodes owned by a table.
+     *
+     * These are the erased nodes in the table, and the nodes that were replaced in the next table.
+     */
+    static void add_deleted_nodes(table_type *table, std::vector<node_type *>& nodes) noexcept
+    {
+        nodes.insert(nodes.end(), table->owned_nodes.begin(), table->owned_nodes.end());
+        for (auto i = 0_uz; i != table->capacity; ++i) {
+            hilet slot = table->slots[i].load(std::memory_order::relaxed);
+            if (hilet node = get_node(slot); node != nullptr and (slot & deleted_tag)) {
+                nodes.push_back(node);
             }
         }
     }
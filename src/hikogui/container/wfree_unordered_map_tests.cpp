@@ -0,0 +1,135 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "wfree_unordered_map.hpp"
+#include "../macros.hpp"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace hi;
+
+TEST(wfree_unordered_map, insert_get_erase)
+{
+    auto map = wfree_unordered_map<std::string, int>{};
+    ASSERT_FALSE(map.get("foo"));
+    ASSERT_EQ(map.get("foo", 5), 5);
+
+    map.insert("foo", 1);
+    map.insert("bar", 2);
+    ASSERT_EQ(map.get("foo"), 1);
+    ASSERT_EQ(map.get("bar"), 2);
+
+    map.insert("foo", 3);
+    ASSERT_EQ(map.get("foo"), 3);
+
+    ASSERT_EQ(map.erase("foo"), 3);
+    ASSERT_FALSE(map.erase("foo"));
+    ASSERT_FALSE(map.contains("foo"));
+    ASSERT_TRUE(map.contains("bar"));
+
+    map.insert("foo", 4);
+    ASSERT_EQ(map.get("foo"), 4);
+
+    auto keys = map.keys();
+    std::sort(keys.begin(), keys.end());
+    ASSERT_EQ(keys, (std::vector<std::string>{"bar", "foo"}));
+}
+
+TEST(wfree_unordered_map, grow)
+{
+    auto map = wfree_unordered_map<int, int>{};
+    hilet initial_capacity = map.capacity();
+
+    for (auto i = 0; i != 10'000; ++i) {
+        map.insert(i, i * 2);
+        if (i % 3 == 0) {
+            ASSERT_EQ(map.erase(i), i * 2);
+        }
+    }
+    ASSERT_GT(map.capacity(), initial_capacity);
+
+    for (auto i = 0; i != 10'000; ++i) {
+        if (i % 3 == 0) {
+            ASSERT_FALSE(map.contains(i));
+        } else {
+            ASSERT_EQ(map.get(i), i * 2);
+        }
+    }
+    ASSERT_EQ(map.keys().size(), 6'666);
+}
+
+TEST(wfree_unordered_map, churn)
+{
+    constexpr auto nr_live = 8;
+
+    auto map = wfree_unordered_map<int, int>{};
+
+    // Distinct keys are added and removed, but only a few are in the map at a time.
+    for (auto i = 0; i != 100'000; ++i) {
+        map.insert(i, i * 2);
+        if (i >= nr_live) {
+            ASSERT_EQ(map.erase(i - nr_live), (i - nr_live) * 2);
+        }
+    }
+
+    // Erased entries are dropped when the table is rebuilt, instead of doubling the table.
+    ASSERT_LE(map.capacity(), 64);
+
+    for (auto i = 100'000 - nr_live; i != 100'000; ++i) {
+        ASSERT_EQ(map.get(i), i * 2);
+    }
+    ASSERT_EQ(map.keys().size(), nr_live);
+}
+
+TEST(wfree_unordered_map, concurrent)
+{
+    constexpr auto nr_writers = 4;
+    constexpr auto nr_keys = 10'000;
+
+    auto map = wfree_unordered_map<int, int>{};
+    auto done = std::atomic<bool>{false};
+
+    // Readers only ever see values that were written for a key.
+    auto readers = std::vector<std::jthread>{};
+    for (auto t = 0; t != 2; ++t) {
+        readers.emplace_back([&] {
+            while (not done.load()) {
+                for (auto i = 0; i < nr_keys; i += 97) {
+                    if (hilet value = map.get(i)) {
+                        ASSERT_EQ(*value % nr_keys, i);
+                    }
+                }
+            }
+        });
+    }
+
+    // Each writer inserts all keys, so that the same keys are modified concurrently.
+    auto writers = std::vector<std::jthread>{};
+    for (auto t = 0; t != nr_writers; ++t) {
+        writers.emplace_back([&, t] {
+            for (auto i = 0; i != nr_keys; ++i) {
+                map.insert(i, t * nr_keys + i);
+                if (i % 5 == t) {
+                    map.erase(i);
+                    map.insert(i, t * nr_keys + i);
+                }
+            }
+        });
+    }
+    writers.clear();
+    done = true;
+    readers.clear();
+
+    for (auto i = 0; i != nr_keys; ++i) {
+        hilet value = map.get(i);
+        ASSERT_TRUE(value) << i;
+        ASSERT_EQ(*value % nr_keys, i);
+    }
+    ASSERT_EQ(map.keys().size(), nr_keys);
+}
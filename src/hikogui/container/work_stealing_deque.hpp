@@ -0,0 +1,172 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "../utility/utility.hpp"
+#include "../macros.hpp"
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace hi::inline v1 {
+
+/** A lock-free work-stealing deque.
+ *
+ * This is the Chase-Lev deque with the memory orderings from
+ * "Correct and Efficient Work-Stealing for Weak Memory Models" by Lê et al.
+ *
+ * The owner thread pushes and pops pointers at the bottom of the deque, other
+ * threads steal pointers from the top. The deque grows when it is full; the old
+ * ring-buffers are kept alive until the deque is destroyed, since a thief may
+ * still be reading from them.
+ *
+ * @tparam T The type of object being pointed to.
+ */
+template<typename T>
+class work_stealing_deque {
+public:
+    using value_type = T *;
+
+    /** Construct a deque.
+     *
+     * @param capacity The initial capacity, must be a power of two.
+     */
+    explicit work_stealing_deque(std::size_t capacity = 256) : _ring(nullptr)
+    {
+        hi_assert(std::has_single_bit(capacity));
+        _rings.push_back(std::make_unique<ring_type>(capacity));
+        _ring.store(_rings.back().get(), std::memory_order::relaxed);
+    }
+
+    work_stealing_deque(work_stealing_deque const&) = delete;
+    work_stealing_deque(work_stealing_deque&&) = delete;
+    work_stealing_deque& operator=(work_stealing_deque const&) = delete;
+    work_stealing_deque& operator=(work_stealing_deque&&) = delete;
+
+    /** Check if the deque is empty.
+     *
+     * @note The result is only a snapshot when called from a thief.
+     */
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return _bottom.load(std::memory_order::relaxed) <= _top.load(std::memory_order::relaxed);
+    }
+
+    /** Push a pointer on the bottom of the deque.
+     *
+     * @note Must only be called by the owner.
+     */
+    void push(value_type value)
+    {
+        hilet bottom = _bottom.load(std::memory_order::relaxed);
+        hilet top = _top.load(std::memory_order::acquire);
+        auto ring = _ring.load(std::memory_order::relaxed);
+
+        if (bottom - top > narrow_cast<int64_t>(ring->capacity) - 1) {
+            ring = grow(ring, top, bottom);
+        }
+
+        ring->store(bottom, value);
+        std::atomic_thread_fence(std::memory_order::release);
+        _bottom.store(bottom + 1, std::memory_order::relaxed);
+    }
+
+    /** Pop a pointer from the bottom of the deque.
+     *
+     * @note Must only be called by the owner.
+     * @return The pointer, or nullptr when the deque was empty.
+     */
+    [[nodiscard]] value_type pop() noexcept
+    {
+        hilet bottom = _bottom.load(std::memory_order::relaxed) - 1;
+        hilet ring = _ring.load(std::memory_order::relaxed);
+        _bottom.store(bottom, std::memory_order::relaxed);
+        std::atomic_thread_fence(std::memory_order::seq_cst);
+        auto top = _top.load(std::memory_order::relaxed);
+
+        if (top > bottom) {
+            // The deque was empty.
+            _bottom.store(bottom + 1, std::memory_order::relaxed);
+            return nullptr;
+        }
+
+        auto r = ring->load(bottom);
+        if (top == bottom) {
+            // The last item, race against thieves for it.
+            if (not _top.compare_exchange_strong(top, top + 1, std::memory_order::seq_cst, std::memory_order::relaxed)) {
+                r = nullptr;
+            }
+            _bottom.store(bottom + 1, std::memory_order::relaxed);
+        }
+        return r;
+    }
+
+    /** Steal a pointer from the top of the deque.
+     *
+     * @note May be called from any thread.
+     * @return The pointer, or nullptr when the deque was empty or the steal lost a race.
+     */
+    [[nodiscard]] value_type steal() noexcept
+    {
+        auto top = _top.load(std::memory_order::acquire);
+        std::atomic_thread_fence(std::memory_order::seq_cst);
+        hilet bottom = _bottom.load(std::memory_order::acquire);
+
+        if (top >= bottom) {
+            return nullptr;
+        }
+
+        hilet ring = _ring.load(std::memory_order::acquire);
+        hilet r = ring->load(top);
+        if (not _top.compare_exchange_strong(top, top + 1, std::memory_order::seq_cst, std::memory_order::relaxed)) {
+            return nullptr;
+        }
+        return r;
+    }
+
+private:
+    struct ring_type {
+        std::size_t capacity;
+        std::unique_ptr<std::atomic<value_type>[]> items;
+
+        explicit ring_type(std::size_t capacity) : capacity(capacity), items(std::make_unique<std::atomic<value_type>[]>(capacity))
+        {
+        }
+
+        [[nodiscard]] value_type load(int64_t index) const noexcept
+        {
+            return items[narrow_cast<std::size_t>(index) & (capacity - 1)].load(std::memory_order::relaxed);
+        }
+
+        void store(int64_t index, value_type value) noexcept
+        {
+            items[narrow_cast<std::size_t>(index) & (capacity - 1)].store(value, std::memory_order::relaxed);
+        }
+    };
+
+    alignas(hardware_destructive_interference_size) std::atomic<int64_t> _top = 0;
+    alignas(hardware_destructive_interference_size) std::atomic<int64_t> _bottom = 0;
+    std::atomic<ring_type *> _ring;
+
+    /** All rings ever allocated, only accessed by the owner.
+     */
+    std::vector<std::unique_ptr<ring_type>> _rings;
+
+    [[nodiscard]] ring_type *grow(ring_type *ring, int64_t top, int64_t bottom)
+    {
+        _rings.push_back(std::make_unique<ring_type>(ring->capacity * 2));
+        hilet new_ring = _rings.back().get();
+        for (auto i = top; i != bottom; ++i) {
+            new_ring->store(i, ring->load(i));
+        }
+        _ring.store(new_ring, std::memory_order::release);
+        return new_ring;
+    }
+};
+
+} // namespace hi::inline v1
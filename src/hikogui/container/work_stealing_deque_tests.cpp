@@ -0,0 +1,86 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "work_stealing_deque.hpp"
+#include "../macros.hpp"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace hi;
+
+TEST(work_stealing_deque, push_pop_steal)
+{
+    auto values = std::vector<int>(1000);
+    auto deque = work_stealing_deque<int>(4);
+    ASSERT_TRUE(deque.empty());
+    ASSERT_EQ(deque.pop(), nullptr);
+    ASSERT_EQ(deque.steal(), nullptr);
+
+    // Grows beyond the initial capacity.
+    for (auto& value : values) {
+        deque.push(&value);
+    }
+    ASSERT_FALSE(deque.empty());
+
+    // The owner pops from the bottom, thieves steal from the top.
+    ASSERT_EQ(deque.pop(), &values[999]);
+    ASSERT_EQ(deque.steal(), &values[0]);
+    ASSERT_EQ(deque.steal(), &values[1]);
+    ASSERT_EQ(deque.pop(), &values[998]);
+
+    for (auto i = 997; i >= 2; --i) {
+        ASSERT_EQ(deque.pop(), &values[i]);
+    }
+    ASSERT_TRUE(deque.empty());
+    ASSERT_EQ(deque.pop(), nullptr);
+}
+
+TEST(work_stealing_deque, concurrent_steal)
+{
+    constexpr auto nr_values = 100'000;
+    constexpr auto nr_thieves = 4;
+
+    auto values = std::vector<int>(nr_values);
+    auto taken = std::vector<std::atomic<int>>(nr_values);
+    auto deque = work_stealing_deque<int>(16);
+    auto done = std::atomic<bool>{false};
+
+    auto thieves = std::vector<std::jthread>{};
+    for (auto i = 0; i != nr_thieves; ++i) {
+        thieves.emplace_back([&] {
+            while (not done.load()) {
+                if (auto ptr = deque.steal()) {
+                    taken[ptr - values.data()].fetch_add(1);
+                }
+            }
+        });
+    }
+
+    // The owner interleaves pushes with pops.
+    for (auto i = 0; i != nr_values; ++i) {
+        deque.push(&values[i]);
+        if (i % 3 == 0) {
+            if (auto ptr = deque.pop()) {
+                taken[ptr - values.data()].fetch_add(1);
+            }
+        }
+    }
+    while (auto ptr = deque.pop()) {
+        taken[ptr - values.data()].fetch_add(1);
+    }
+    while (not deque.empty()) {
+        std::this_thread::yield();
+    }
+
+    done = true;
+    thieves.clear();
+
+    // Every value is taken exactly once.
+    for (auto i = 0; i != nr_values; ++i) {
+        ASSERT_EQ(taken[i].load(), 1) << i;
+    }
+}
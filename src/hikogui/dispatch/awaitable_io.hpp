@@ -0,0 +1,237 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+/** @file awaitable_io.hpp
+ *
+ * Asynchronous file and socket I/O for co-routines running on a `hi::loop`.
+ *
+ * On Linux the operations are executed by the thread's `io_ring`. When io_uring
+ * is not available, or disabled with `io_ring::enabled`, file operations are
+ * executed synchronously and socket operations wait for readiness through
+ * `loop::add_socket()`.
+ *
+ * @note Only available on Linux.
+ */
+
+#pragma once
+
+#include "io_ring_linux_impl.hpp"
+#include "loop.hpp"
+#include "../telemetry/telemetry.hpp"
+#include "../utility/utility.hpp"
+#include "../macros.hpp"
+#include <sys/socket.h>
+#include <unistd.h>
+#include <bit>
+#include <coroutine>
+#include <format>
+#include <span>
+#include <system_error>
+#include <cerrno>
+#include <cstddef>
+
+hi_export_module(hikogui.dispatch.awaitable_io);
+
+namespace hi::inline v1 {
+
+enum class io_operation { read, write, accept, recv, send };
+
+/** An awaitable for a single I/O operation.
+ *
+ * The result of `co_await` is the number of bytes transferred, or for accept the
+ * file descriptor of the new connection.
+ *
+ * @note In the fallback mode only one operation per direction should be in flight on a socket.
+ */
+class awaitable_io {
+public:
+    awaitable_io(io_operation operation, int fd, void *buffer, std::size_t size, uint64_t offset, int flags) noexcept :
+        _operation(operation), _fd(fd), _buffer(buffer), _size(size), _offset(offset), _flags(flags)
+    {
+    }
+
+    awaitable_io(awaitable_io const&) = delete;
+    awaitable_io(awaitable_io&&) = delete;
+    awaitable_io& operator=(awaitable_io const&) = delete;
+    awaitable_io& operator=(awaitable_io&&) = delete;
+
+    [[nodiscard]] bool await_ready() noexcept
+    {
+        _ring = io_ring::local();
+        if (_ring != nullptr) {
+            return false;
+        }
+
+        // Regular files are always ready, in the fallback mode they are read and written synchronously.
+        if (_operation == io_operation::read or _operation == io_operation::write) {
+            _state.result = perform();
+            return true;
+        }
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        _state.handle = handle;
+
+        if (_ring != nullptr) {
+            auto& sqe = _ring->add(_state);
+            sqe.fd = _fd;
+            sqe.addr = std::bit_cast<uint64_t>(_buffer);
+            sqe.len = narrow_cast<uint32_t>(_size);
+
+            switch (_operation) {
+            case io_operation::read:
+            case io_operation::write:
+                sqe.off = _offset;
+                if (hilet index = _ring->find_buffer(_buffer, _size); index >= 0) {
+                    sqe.opcode = _operation == io_operation::read ? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+                    sqe.buf_index = narrow_cast<uint16_t>(index);
+                } else {
+                    sqe.opcode = _operation == io_operation::read ? IORING_OP_READ : IORING_OP_WRITE;
+                }
+                return;
+            case io_operation::accept:
+                sqe.opcode = IORING_OP_ACCEPT;
+                sqe.accept_flags = SOCK_CLOEXEC;
+                return;
+            case io_operation::recv:
+                sqe.opcode = IORING_OP_RECV;
+                sqe.msg_flags = narrow_cast<uint32_t>(_flags);
+                return;
+            case io_operation::send:
+                sqe.opcode = IORING_OP_SEND;
+                sqe.msg_flags = narrow_cast<uint32_t>(_flags | MSG_NOSIGNAL);
+                return;
+            }
+            hi_no_default();
+        }
+
+        hilet event_mask = _operation == io_operation::send ? socket_event::write : socket_event::read;
+        loop::local().add_socket(_fd, event_mask, [this](int, socket_events const&) {
+            _state.result = perform();
+            if (_state.result == -EAGAIN or _state.result == -EWOULDBLOCK) {
+                // Spurious wake-up, wait for the next event.
+                return;
+            }
+
+            loop::local().remove_socket(_fd);
+            _state.handle.resume();
+        });
+    }
+
+    /**
+     * @return The number of bytes transferred, or for accept the new file descriptor.
+     * @throws io_error When the operation failed.
+     */
+    int await_resume() const
+    {
+        if (_state.result < 0) {
+            throw io_error(std::format("Asynchronous I/O operation failed. {}", std::generic_category().message(-_state.result)));
+        }
+        return _state.result;
+    }
+
+private:
+    io_operation _operation;
+    int _fd;
+    void *_buffer;
+    std::size_t _size;
+    uint64_t _offset;
+    int _flags;
+    io_ring *_ring = nullptr;
+    detail::io_ring_operation _state;
+
+    /** Perform the operation synchronously.
+     *
+     * @return The result of the operation, or the negative errno.
+     */
+    [[nodiscard]] int perform() const noexcept
+    {
+        auto r = ssize_t{0};
+        do {
+            switch (_operation) {
+            case io_operation::read:
+                r = ::pread(_fd, _buffer, _size, narrow_cast<off_t>(_offset));
+                break;
+            case io_operation::write:
+                r = ::pwrite(_fd, _buffer, _size, narrow_cast<off_t>(_offset));
+                break;
+            case io_operation::accept:
+                r = ::accept4(_fd, nullptr, nullptr, SOCK_CLOEXEC);
+                break;
+            case io_operation::recv:
+                r = ::recv(_fd, _buffer, _size, _flags | MSG_DONTWAIT);
+                break;
+            case io_operation::send:
+                r = ::send(_fd, _buffer, _size, _flags | MSG_DONTWAIT | MSG_NOSIGNAL);
+                break;
+            default:
+                hi_no_default();
+            }
+        } while (r == -1 and errno == EINTR);
+
+        return r == -1 ? -errno : narrow_cast<int>(r);
+    }
+};
+
+/** Read from a file at an offset.
+ *
+ * @param fd The file descriptor.
+ * @param buffer The buffer to read into; must stay alive until the operation completes.
+ * @param offset The offset in the file.
+ * @return An awaitable which returns the number of bytes read.
+ */
+[[nodiscard]] inline awaitable_io async_read(int fd, std::span<std::byte> buffer, uint64_t offset) noexcept
+{
+    return {io_operation::read, fd, buffer.data(), buffer.size(), offset, 0};
+}
+
+/** Write to a file at an offset.
+ *
+ * @param fd The file descriptor.
+ * @param buffer The data to write; must stay alive until the operation completes.
+ * @param offset The offset in the file.
+ * @return An awaitable which returns the number of bytes written.
+ */
+[[nodiscard]] inline awaitable_io async_write(int fd, std::span<std::byte const> buffer, uint64_t offset) noexcept
+{
+    return {io_operation::write, fd, const_cast<std::byte *>(buffer.data()), buffer.size(), offset, 0};
+}
+
+/** Accept a connection on a listening socket.
+ *
+ * @param fd The listening socket.
+ * @return An awaitable which returns the file descriptor of the new connection.
+ */
+[[nodiscard]] inline awaitable_io async_accept(int fd) noexcept
+{
+    return {io_operation::accept, fd, nullptr, 0, 0, 0};
+}
+
+/** Receive data from a socket.
+ *
+ * @param fd The socket.
+ * @param buffer The buffer to receive into; must stay alive until the operation completes.
+ * @param flags The flags passed to `recv()`.
+ * @return An awaitable which returns the number of bytes received, zero on end-of-stream.
+ */
+[[nodiscard]] inline awaitable_io async_recv(int fd, std::span<std::byte> buffer, int flags = 0) noexcept
+{
+    return {io_operation::recv, fd, buffer.data(), buffer.size(), 0, flags};
+}
+
+/** Send data on a socket.
+ *
+ * @param fd The socket.
+ * @param buffer The data to send; must stay alive until the operation completes.
+ * @param flags The flags passed to `send()`.
+ * @return An awaitable which returns the number of bytes sent.
+ */
+[[nodiscard]] inline awaitable_io async_send(int fd, std::span<std::byte const> buffer, int flags = 0) noexcept
+{
+    return {io_operation::send, fd, const_cast<std::byte *>(buffer.data()), buffer.size(), 0, flags};
+}
+
+} // namespace hi::inline v1
@@ -0,0 +1,174 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "awaitable_io.hpp"
+#include "../coroutine/module.hpp"
+#include "../macros.hpp"
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <cstdlib>
+#include <unistd.h>
+#include <array>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace hi;
+
+namespace {
+
+[[nodiscard]] int make_temporary_file()
+{
+    char path[] = "/tmp/hikogui_awaitable_io_XXXXXX";
+    hilet fd = mkstemp(path);
+    if (fd != -1) {
+        unlink(path);
+    }
+    return fd;
+}
+
+scoped_task<int> write_then_read(int fd, std::span<std::byte const> data, std::span<std::byte> buffer)
+{
+    auto written = 0_uz;
+    while (written != data.size()) {
+        written += narrow_cast<std::size_t>(co_await async_write(fd, data.subspan(written), written));
+    }
+
+    co_return co_await async_read(fd, buffer, 0);
+}
+
+scoped_task<int> echo(int fd)
+{
+    auto buffer = std::array<std::byte, 64>{};
+    hilet size = co_await async_recv(fd, buffer);
+    co_return co_await async_send(fd, std::span{buffer}.first(narrow_cast<std::size_t>(size)));
+}
+
+scoped_task<int> send_then_recv(int fd, std::span<std::byte const> data, std::span<std::byte> buffer)
+{
+    co_await async_send(fd, data);
+    co_return co_await async_recv(fd, buffer);
+}
+
+void file_read_write()
+{
+    hilet fd = make_temporary_file();
+    ASSERT_NE(fd, -1);
+
+    auto data = std::vector<std::byte>(10'000);
+    for (auto i = 0_uz; i != data.size(); ++i) {
+        data[i] = static_cast<std::byte>(i * 7);
+    }
+    auto buffer = std::vector<std::byte>(data.size());
+
+    auto task = write_then_read(fd, data, buffer);
+    loop::local().resume();
+    ASSERT_TRUE(task.done());
+    ASSERT_EQ(task.value(), narrow_cast<int>(data.size()));
+    ASSERT_EQ(buffer, data);
+    close(fd);
+}
+
+void socket_send_recv()
+{
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds), 0);
+
+    auto data = std::array<std::byte, 5>{std::byte{'h'}, std::byte{'e'}, std::byte{'l'}, std::byte{'l'}, std::byte{'o'}};
+    auto buffer = std::array<std::byte, 64>{};
+
+    auto server = echo(fds[1]);
+    auto client = send_then_recv(fds[0], data, buffer);
+    loop::local().resume();
+
+    ASSERT_TRUE(server.done());
+    ASSERT_TRUE(client.done());
+    ASSERT_EQ(server.value(), narrow_cast<int>(data.size()));
+    ASSERT_EQ(client.value(), narrow_cast<int>(data.size()));
+    ASSERT_TRUE(std::equal(data.begin(), data.end(), buffer.begin()));
+    close(fds[0]);
+    close(fds[1]);
+}
+
+} // namespace
+
+TEST(awaitable_io, file_read_write)
+{
+    file_read_write();
+}
+
+TEST(awaitable_io, socket_send_recv)
+{
+    socket_send_recv();
+}
+
+TEST(awaitable_io, accept)
+{
+    hilet listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    ASSERT_NE(listen_fd, -1);
+
+    auto address = sockaddr_in{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(bind(listen_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)), 0);
+    ASSERT_EQ(listen(listen_fd, 1), 0);
+    auto address_size = socklen_t{sizeof(address)};
+    ASSERT_EQ(getsockname(listen_fd, reinterpret_cast<sockaddr *>(&address), &address_size), 0);
+
+    auto task = [](int fd) -> scoped_task<int> {
+        co_return co_await async_accept(fd);
+    }(listen_fd);
+
+    hilet client_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    ASSERT_EQ(connect(client_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)), 0);
+
+    loop::local().resume();
+    ASSERT_TRUE(task.done());
+    ASSERT_GE(task.value(), 0);
+
+    close(task.value());
+    close(client_fd);
+    close(listen_fd);
+}
+
+TEST(awaitable_io, registered_buffers)
+{
+    hilet ring = io_ring::local();
+    if (ring == nullptr) {
+        GTEST_SKIP() << "io_uring is not available.";
+    }
+
+    hilet fd = make_temporary_file();
+    ASSERT_NE(fd, -1);
+
+    auto data = std::vector<std::byte>(4096, std::byte{0x5a});
+    auto buffer = std::vector<std::byte>(4096);
+    ring->register_buffers({std::span{data}, std::span{buffer}});
+    ASSERT_EQ(ring->find_buffer(data.data() + 10, 100), 0);
+    ASSERT_EQ(ring->find_buffer(buffer.data(), buffer.size()), 1);
+    ASSERT_EQ(ring->find_buffer(buffer.data(), buffer.size() + 1), -1);
+
+    auto task = write_then_read(fd, data, buffer);
+    loop::local().resume();
+    ASSERT_TRUE(task.done());
+    ASSERT_EQ(task.value(), narrow_cast<int>(data.size()));
+    ASSERT_EQ(buffer, data);
+
+    ring->register_buffers({});
+    close(fd);
+}
+
+TEST(awaitable_io, fallback)
+{
+    // io_ring::enabled is checked when a thread first uses asynchronous I/O.
+    io_ring::enabled = false;
+    auto thread = std::jthread{[] {
+        ASSERT_EQ(io_ring::local(), nullptr);
+        file_read_write();
+        socket_send_recv();
+    }};
+    thread.join();
+    io_ring::enabled = true;
+}
@@ -5,5 +5,11 @@
 #include "function_timer.hpp" // export
 #include "loop.hpp" // export
 #include "socket_event.hpp" // export
+#include "thread_pool.hpp" // export
+#include "../macros.hpp"
+
+#if HI_OPERATING_SYSTEM == HI_OS_LINUX
+#include "awaitable_io.hpp" // export
+#endif
 
 hi_export_module(hikogui.dispatch);
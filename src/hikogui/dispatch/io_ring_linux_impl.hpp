@@ -0,0 +1,440 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+/** @file io_ring_linux_impl.hpp
+ *
+ * A thread-local io_uring completion queue that is driven by the thread's `hi::loop`.
+ *
+ * It works as follows:
+ *
+ * Operations are added to the submission queue without a system call. The first operation
+ * added during a loop iteration posts a function on the loop which submits all queued
+ * operations with a single `io_uring_enter()` call.
+ *
+ * An eventfd is registered with the ring, the kernel signals it when completions are
+ * posted on the completion queue. While operations are in flight this eventfd is added
+ * to the loop using `loop::add_socket()`, so that `epoll_wait()` wakes up on completions
+ * and `loop::resume()` does not exit while operations are pending.
+ *
+ * The ring is accessed through the raw system calls so that there is no dependency on liburing.
+ */
+
+#pragma once
+
+#include "loop.hpp"
+#include "../telemetry/telemetry.hpp"
+#include "../utility/utility.hpp"
+#include "../macros.hpp"
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <coroutine>
+#include <format>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+#include <cerrno>
+
+hi_export_module(hikogui.dispatch.io_ring : impl);
+
+namespace hi::inline v1 {
+namespace detail {
+
+/** The state of an operation in flight on the io_ring.
+ *
+ * A pointer to this object is passed as `user_data` through the ring.
+ */
+struct io_ring_operation {
+    /** The result of the operation; a negative value is an errno.
+     */
+    int result = 0;
+
+    /** The co-routine to resume when the operation completes.
+     */
+    std::coroutine_handle<> handle = {};
+};
+
+} // namespace detail
+
+class io_ring {
+public:
+    /** Use io_uring when it is available.
+     *
+     * When set to false before the first asynchronous operation on a thread,
+     * that thread will use the epoll path of the loop.
+     */
+    inline static std::atomic<bool> enabled = true;
+
+    /** Get the io_ring of the current thread.
+     *
+     * @return The thread's io_ring, or nullptr when io_uring is not available.
+     */
+    [[nodiscard]] hi_no_inline static io_ring *local() noexcept
+    {
+        if (not _local_initialized) {
+            _local_initialized = true;
+            if (enabled.load(std::memory_order::relaxed)) {
+                try {
+                    _local = std::make_unique<io_ring>();
+                } catch (io_error const& e) {
+                    hi_log_info("io_uring is not available, falling back to epoll. {}", e.what());
+                }
+            }
+        }
+        return _local.get();
+    }
+
+    /** Create a io_uring.
+     *
+     * @param nr_entries The number of entries in the submission queue.
+     * @throws io_error When io_uring is not available.
+     */
+    explicit io_ring(unsigned nr_entries = 256)
+    {
+        auto params = io_uring_params{};
+        _fd = narrow_cast<int>(::syscall(__NR_io_uring_setup, nr_entries, &params));
+        if (_fd == -1) {
+            throw io_error(std::format("Could not create io_uring. {}", get_last_error_message()));
+        }
+
+        try {
+            setup(params);
+        } catch (...) {
+            // The destructor is not called when the constructor throws.
+            release();
+            throw;
+        }
+    }
+
+    ~io_ring()
+    {
+        if (_nr_in_flight != 0) {
+            // The loop may already be destroyed, since this is called while thread_local objects are
+            // destroyed. Closing the eventfd removes it from the loop's epoll set.
+            hi_log_error("io_ring destroyed with {} operations in flight.", _nr_in_flight);
+        }
+
+        release();
+    }
+
+    io_ring(io_ring const&) = delete;
+    io_ring(io_ring&&) = delete;
+    io_ring& operator=(io_ring const&) = delete;
+    io_ring& operator=(io_ring&&) = delete;
+
+    /** Register buffers for fixed-buffer read and write operations.
+     *
+     * Fixed buffers are pinned in memory by the kernel once, instead of on each operation.
+     * Read and write operations on memory inside one of these buffers automatically use
+     * the fixed-buffer operations.
+     *
+     * @note Replaces previously registered buffers.
+     * @param buffers The buffers to register; the memory must outlive the registration.
+     * @throws io_error When the buffers could not be registered.
+     */
+    void register_buffers(std::vector<std::span<std::byte>> buffers)
+    {
+        if (not _buffers.empty()) {
+            if (::syscall(__NR_io_uring_register, _fd, IORING_UNREGISTER_BUFFERS, nullptr, 0) != 0) {
+                throw io_error(std::format("Could not unregister io_uring buffers. {}", get_last_error_message()));
+            }
+            _buffers.clear();
+        }
+
+        auto iovecs = std::vector<iovec>{};
+        iovecs.reserve(buffers.size());
+        for (hilet buffer : buffers) {
+            iovecs.push_back(iovec{buffer.data(), buffer.size()});
+        }
+
+        if (not iovecs.empty()) {
+            if (::syscall(
+                    __NR_io_uring_register, _fd, IORING_REGISTER_BUFFERS, iovecs.data(), narrow_cast<unsigned>(iovecs.size())) !=
+                0) {
+                throw io_error(std::format("Could not register io_uring buffers. {}", get_last_error_message()));
+            }
+        }
+        _buffers = std::move(buffers);
+    }
+
+    /** Find the registered buffer which contains a range of memory.
+     *
+     * @return The index of the registered buffer, or -1 if not found.
+     */
+    [[nodiscard]] int find_buffer(void const *ptr, std::size_t size) const noexcept
+    {
+        hilet first = static_cast<std::byte const *>(ptr);
+        for (auto i = 0_uz; i != _buffers.size(); ++i) {
+            hilet& buffer = _buffers[i];
+            if (first >= buffer.data() and first + size <= buffer.data() + buffer.size()) {
+                return narrow_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    /** Add an operation to the submission queue.
+     *
+     * The operation is submitted at the end of the current loop iteration,
+     * together with the other operations added during this iteration.
+     *
+     * @param operation The operation to complete when the kernel finishes.
+     * @return A zero initialized submission queue entry to be filled in by the caller.
+     */
+    [[nodiscard]] io_uring_sqe& add(detail::io_ring_operation& operation)
+    {
+        if (sq_full()) {
+            // The submission queue is full, submit early.
+            submit();
+            while (sq_full()) {
+                // The kernel refuses new submissions until completions are reaped.
+                wait_for_completion();
+                submit();
+            }
+        }
+
+        hilet index = _sq_local_tail & _sq_mask;
+        auto& sqe = _sqes[index];
+        sqe = io_uring_sqe{};
+        sqe.user_data = std::bit_cast<uint64_t>(&operation);
+        _sq_array[index] = index;
+        ++_sq_local_tail;
+
+        if (_nr_in_flight++ == 0) {
+            // Wake up the loop on completions, and keep the loop alive while operations are in flight.
+            loop::local().add_socket(_event_fd, socket_event::read, [this](int, socket_events const&) {
+                reap();
+            });
+        }
+
+        if (_nr_unsubmitted++ == 0) {
+            loop::local().post_function([this] {
+                submit();
+            });
+        }
+        return sqe;
+    }
+
+    /** Submit all the queued operations.
+     *
+     * When the kernel is busy the completion queue is drained to make room, and when that
+     * does not help the remaining operations are submitted on the next loop iteration.
+     */
+    void submit() noexcept
+    {
+        std::atomic_ref{*_sq_tail}.store(_sq_local_tail, std::memory_order::release);
+
+        while (_nr_unsubmitted != 0) {
+            hilet r = ::syscall(__NR_io_uring_enter, _fd, _nr_unsubmitted, 0, 0, nullptr, 0);
+            if (r >= 0) {
+                _nr_unsubmitted -= narrow_cast<unsigned>(r);
+
+            } else if (errno == EAGAIN or errno == EBUSY) {
+                if (collect() == 0) {
+                    loop::local().post_function([this] {
+                        submit();
+                    });
+                    return;
+                }
+
+            } else if (errno != EINTR) {
+                hi_log_fatal("Failed on io_uring_enter(). {}", get_last_error_message());
+            }
+        }
+    }
+
+    /** Complete the operations on the completion queue.
+     */
+    void reap() noexcept
+    {
+        auto value = uint64_t{};
+        [[maybe_unused]] hilet r = ::read(_event_fd, &value, sizeof(value));
+
+        collect();
+        if (_nr_in_flight == 0) {
+            loop::local().remove_socket(_event_fd);
+        }
+
+        // Resume after the completion queue is released, a co-routine may add new operations.
+        auto completed = std::exchange(_completed, {});
+        for (auto operation : completed) {
+            operation->handle.resume();
+        }
+    }
+
+private:
+    inline static thread_local std::unique_ptr<io_ring> _local;
+    inline static thread_local bool _local_initialized = false;
+
+    int _fd = -1;
+    int _event_fd = -1;
+
+    void *_sq_ring = nullptr;
+    std::size_t _sq_ring_size = 0;
+    void *_cq_ring = nullptr;
+    std::size_t _cq_ring_size = 0;
+    io_uring_sqe *_sqes = nullptr;
+    std::size_t _sqes_size = 0;
+
+    unsigned *_sq_head = nullptr;
+    unsigned *_sq_tail = nullptr;
+    unsigned *_sq_array = nullptr;
+    unsigned _sq_mask = 0;
+    unsigned _sq_entries = 0;
+
+    /** The tail of the submission queue, published to the kernel on submit().
+     */
+    unsigned _sq_local_tail = 0;
+
+    unsigned *_cq_head = nullptr;
+    unsigned *_cq_tail = nullptr;
+    unsigned _cq_mask = 0;
+    io_uring_cqe *_cqes = nullptr;
+
+    /** Number of operations added, but not yet submitted.
+     */
+    unsigned _nr_unsubmitted = 0;
+
+    /** Number of operations submitted or queued, but not yet completed.
+     */
+    std::size_t _nr_in_flight = 0;
+
+    std::vector<std::span<std::byte>> _buffers;
+
+    /** Operations taken from the completion queue, to be resumed by reap().
+     */
+    std::vector<detail::io_ring_operation *> _completed;
+
+    [[nodiscard]] bool sq_full() const noexcept
+    {
+        return _sq_local_tail - std::atomic_ref{*_sq_head}.load(std::memory_order::acquire) == _sq_entries;
+    }
+
+    /** Take the completed operations from the completion queue.
+     *
+     * The operations are resumed by the next reap(); the eventfd stays signaled until then.
+     *
+     * @return The number of completed operations that were taken.
+     */
+    std::size_t collect() noexcept
+    {
+        auto head = *_cq_head;
+        hilet tail = std::atomic_ref{*_cq_tail}.load(std::memory_order::acquire);
+
+        auto r = 0_uz;
+        for (; head != tail; ++head, ++r) {
+            hilet& cqe = _cqes[head & _cq_mask];
+            auto operation = std::bit_cast<detail::io_ring_operation *>(cqe.user_data);
+            operation->result = cqe.res;
+            _completed.push_back(operation);
+        }
+        std::atomic_ref{*_cq_head}.store(head, std::memory_order::release);
+
+        _nr_in_flight -= r;
+        return r;
+    }
+
+    /** Block until at least one submitted operation completes, and take it from the completion queue.
+     */
+    void wait_for_completion() noexcept
+    {
+        if (_nr_in_flight == _nr_unsubmitted) {
+            hi_log_fatal("The io_uring submission queue is full and no operations are in flight.");
+        }
+
+        while (::syscall(__NR_io_uring_enter, _fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0) {
+            if (errno != EINTR) {
+                hi_log_fatal("Failed on io_uring_enter(). {}", get_last_error_message());
+            }
+        }
+        collect();
+    }
+
+    /** Map the rings and register the eventfd.
+     *
+     * @throws io_error When a ring could not be mapped, or the eventfd could not be created or registered.
+     */
+    void setup(io_uring_params const& params)
+    {
+        _sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        _cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            _sq_ring_size = _cq_ring_size = std::max(_sq_ring_size, _cq_ring_size);
+        }
+
+        _sq_ring = map(_sq_ring_size, IORING_OFF_SQ_RING);
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            _cq_ring = _sq_ring;
+        } else {
+            _cq_ring = map(_cq_ring_size, IORING_OFF_CQ_RING);
+        }
+
+        _sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        _sqes = static_cast<io_uring_sqe *>(map(_sqes_size, IORING_OFF_SQES));
+
+        _sq_head = ring_field(_sq_ring, params.sq_off.head);
+        _sq_tail = ring_field(_sq_ring, params.sq_off.tail);
+        _sq_mask = *ring_field(_sq_ring, params.sq_off.ring_mask);
+        _sq_array = ring_field(_sq_ring, params.sq_off.array);
+        _sq_entries = params.sq_entries;
+        _sq_local_tail = *_sq_tail;
+
+        _cq_head = ring_field(_cq_ring, params.cq_off.head);
+        _cq_tail = ring_field(_cq_ring, params.cq_off.tail);
+        _cq_mask = *ring_field(_cq_ring, params.cq_off.ring_mask);
+        _cqes = reinterpret_cast<io_uring_cqe *>(static_cast<char *>(_cq_ring) + params.cq_off.cqes);
+
+        _event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (_event_fd == -1) {
+            throw io_error(std::format("Could not create eventfd for io_uring. {}", get_last_error_message()));
+        }
+        if (::syscall(__NR_io_uring_register, _fd, IORING_REGISTER_EVENTFD, &_event_fd, 1) != 0) {
+            throw io_error(std::format("Could not register eventfd with io_uring. {}", get_last_error_message()));
+        }
+    }
+
+    /** Unmap the rings and close the file descriptors that were created.
+     */
+    void release() noexcept
+    {
+        if (_event_fd != -1) {
+            ::close(_event_fd);
+        }
+        if (_sqes) {
+            ::munmap(_sqes, _sqes_size);
+        }
+        if (_cq_ring and _cq_ring != _sq_ring) {
+            ::munmap(_cq_ring, _cq_ring_size);
+        }
+        if (_sq_ring) {
+            ::munmap(_sq_ring, _sq_ring_size);
+        }
+        if (_fd != -1) {
+            ::close(_fd);
+        }
+    }
+
+    [[nodiscard]] void *map(std::size_t size, off_t offset)
+    {
+        auto ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, offset);
+        if (ptr == MAP_FAILED) {
+            throw io_error(std::format("Could not map io_uring. {}", get_last_error_message()));
+        }
+        return ptr;
+    }
+
+    [[nodiscard]] static unsigned *ring_field(void *ring, unsigned offset) noexcept
+    {
+        return reinterpret_cast<unsigned *>(static_cast<char *>(ring) + offset);
+    }
+};
+
+} // namespace hi::inline v1
@@ -3,6 +3,10 @@
 #pragma once
 
 #include "loop_intf.hpp" // export
+#if HI_OPERATING_SYSTEM == HI_OS_WINDOWS
 #include "loop_win32_impl.hpp" // export
+#elif HI_OPERATING_SYSTEM == HI_OS_LINUX
+#include "loop_linux_impl.hpp" // export
+#endif
 
 hi_export_module(hikogui.dispatch.loop);
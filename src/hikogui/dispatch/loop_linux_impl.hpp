@@ -0,0 +1,390 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+/** @file loop_linux_impl.hpp
+ *
+ * This is the Linux implementation of the main loop.
+ *
+ * It works as follows:
+ *
+ * The loop blocks on `epoll_wait()` on a single epoll file descriptor, which waits on:
+ *  - An eventfd, written by `notify_has_send()` when a function is posted to the loop.
+ *  - A timerfd, armed on the deadline of the first function of the function-timer.
+ *  - A timerfd, firing at the maximum frame rate while render functions are subscribed.
+ *    There is no vertical-blank source on Linux, this is the same as the win32 fallback
+ *    when vsync is not used.
+ *  - The sockets registered with `add_socket()`.
+ *
+ * Like on win32, timers and posted functions are handled after every wake-up,
+ * so that functions that where posted wait-free are handled as well.
+ */
+
+#pragma once
+
+#include "loop_intf.hpp"
+#include "socket_event.hpp"
+#include "../telemetry/telemetry.hpp"
+#include "../utility/utility.hpp"
+#include "../macros.hpp"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <ctime>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <utility>
+#include <stop_token>
+#include <chrono>
+
+hi_export_module(hikogui.dispatch.loop : impl);
+
+namespace hi::inline v1 {
+
+class loop_impl_linux final : public loop::impl_type {
+public:
+    loop_impl_linux() : loop::impl_type()
+    {
+        _epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (_epoll_fd == -1) {
+            hi_log_fatal("Could not create an epoll file descriptor. {}", get_last_error_message());
+        }
+
+        _function_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (_function_fd == -1) {
+            hi_log_fatal("Could not create an async-event file descriptor. {}", get_last_error_message());
+        }
+
+        _timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (_timer_fd == -1) {
+            hi_log_fatal("Could not create a timer file descriptor. {}", get_last_error_message());
+        }
+
+        _vsync_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (_vsync_fd == -1) {
+            hi_log_fatal("Could not create a vsync-timer file descriptor. {}", get_last_error_message());
+        }
+
+        for (hilet fd : {_function_fd, _timer_fd, _vsync_fd}) {
+            auto event = epoll_event{};
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+                hi_log_fatal("Could not add file descriptor {} to epoll. {}", fd, get_last_error_message());
+            }
+        }
+    }
+
+    ~loop_impl_linux()
+    {
+        // The sockets are owned by the caller of add_socket(), they are not closed here.
+        for (hilet fd : {_vsync_fd, _timer_fd, _function_fd, _epoll_fd}) {
+            if (::close(fd) != 0) {
+                hi_log_error("Could not close file descriptor {}. {}", fd, get_last_error_message());
+            }
+        }
+    }
+
+    void set_maximum_frame_rate(double frame_rate) noexcept override
+    {
+        hi_axiom(on_thread());
+        hi_axiom(frame_rate > 0.0);
+
+        _maximum_frame_rate = frame_rate;
+        _minimum_frame_time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>{1.0 / frame_rate});
+        if (not _render_functions.empty()) {
+            arm_vsync_timer();
+        }
+    }
+
+    void set_vsync_monitor_id([[maybe_unused]] uintptr_t id) noexcept override
+    {
+        // There is no vertical-blank source on Linux yet; frames are paced by the vsync-timer.
+    }
+
+    void subscribe_render(std::weak_ptr<loop::render_callback_type> f) noexcept override
+    {
+        hi_axiom(on_thread());
+        _render_functions.push_back(std::move(f));
+
+        // Start the frame timer once there is a window.
+        if (_render_functions.size() == 1) {
+            arm_vsync_timer();
+        }
+    }
+
+    void add_socket(int fd, socket_event event_mask, std::function<void(int, socket_events const&)> f) override
+    {
+        hi_axiom(on_thread());
+
+        auto event = epoll_event{};
+        event.events = socket_event_to_epoll(event_mask);
+        event.data.fd = fd;
+
+        // Only one callback can be associated with a socket, replace the previous one.
+        hilet op = _sockets.contains(fd) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+        if (epoll_ctl(_epoll_fd, op, fd, &event) != 0) {
+            throw io_error(std::format("Could not add socket {} to the loop. {}", fd, get_last_error_message()));
+        }
+
+        _sockets[fd] = std::make_shared<socket_type>(fd, event_mask, std::move(f));
+    }
+
+    void remove_socket(int fd) override
+    {
+        hi_axiom(on_thread());
+
+        if (_sockets.erase(fd) == 0) {
+            return;
+        }
+
+        // A socket that was already closed is automatically removed from epoll.
+        if (epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, fd, nullptr) != 0 and errno != EBADF and errno != ENOENT) {
+            throw io_error(std::format("Could not remove socket {} from the loop. {}", fd, get_last_error_message()));
+        }
+    }
+
+    int resume(std::stop_token stop_token) noexcept override
+    {
+        _exit_code = {};
+        while (not _exit_code) {
+            resume_once(true);
+
+            if (stop_token.stop_possible()) {
+                if (stop_token.stop_requested()) {
+                    // Stop immediately when stop is requested.
+                    _exit_code = 0;
+                }
+            } else {
+                if (_render_functions.empty() and _function_fifo.empty() and _function_timer.empty() and _sockets.empty()) {
+                    // If there is not stop token, then exit when there are no more resources to wait on.
+                    _exit_code = 0;
+                }
+            }
+        }
+
+        return *_exit_code;
+    }
+
+    void resume_once(bool block) noexcept override
+    {
+        using namespace std::chrono_literals;
+
+        hi_axiom(on_thread());
+
+        update_timer();
+
+        // The timerfd handles the deadline of the timers; the timeout makes sure the
+        // stop-token is checked regularly, the same as on win32.
+        hilet timeout_ms = block ? 100 : 0;
+
+        std::array<epoll_event, max_nr_events> events;
+        hilet nr_events = epoll_wait(_epoll_fd, events.data(), narrow_cast<int>(events.size()), timeout_ms);
+        if (nr_events == -1 and errno != EINTR) {
+            hi_log_fatal("Failed on epoll_wait(), {}", get_last_error_message());
+        }
+
+        for (auto i = 0; i < nr_events; ++i) {
+            hilet& event = events[i];
+
+            if (event.data.fd == _function_fd) {
+                // handle_functions() and handle_timers() is called after every wake-up of epoll_wait().
+                read_counter(_function_fd);
+
+            } else if (event.data.fd == _timer_fd) {
+                // The deadline may have been reached using the monotonic clock slightly before
+                // the utc-clock, force the timer to be re-armed.
+                read_counter(_timer_fd);
+                _timer_deadline = utc_nanoseconds::min();
+
+            } else if (event.data.fd == _vsync_fd) {
+                read_counter(_vsync_fd);
+                handle_vsync();
+
+            } else {
+                handle_socket(event.data.fd, event.events);
+            }
+        }
+
+        // Make sure timers are handled first, possibly they are time critical.
+        handle_timers();
+
+        // When functions are added wait-free, the function-event is never triggered.
+        // So handle messages after any kind of wake up.
+        handle_functions();
+    }
+
+private:
+    struct socket_type {
+        int fd;
+        socket_event mode;
+        std::function<void(int, socket_events const&)> callback;
+    };
+
+    /** The maximum number of events handled for each call to `epoll_wait()`.
+     */
+    constexpr static size_t max_nr_events = 64;
+
+    /** The epoll file descriptor on which the loop blocks.
+     */
+    int _epoll_fd = -1;
+
+    /** eventfd to wake up the loop when a function is posted.
+     */
+    int _function_fd = -1;
+
+    /** timerfd to wake up the loop on the deadline of the function-timer.
+     */
+    int _timer_fd = -1;
+
+    /** timerfd to wake up the loop for rendering at the maximum frame rate.
+     */
+    int _vsync_fd = -1;
+
+    /** The deadline to which `_timer_fd` is armed.
+     */
+    utc_nanoseconds _timer_deadline = utc_nanoseconds::max();
+
+    /** The sockets by file descriptor.
+     *
+     * The socket is held by a shared_ptr, so that a callback may remove its own socket.
+     */
+    std::unordered_map<int, std::shared_ptr<socket_type>> _sockets;
+
+    void notify_has_send() noexcept override
+    {
+        hilet value = uint64_t{1};
+        if (::write(_function_fd, &value, sizeof(value)) != sizeof(value) and errno != EAGAIN) {
+            hi_log_error("Could not trigger async-event. {}", get_last_error_message());
+        }
+    }
+
+    /** Reset the counter of an eventfd or the expirations of a timerfd.
+     */
+    static void read_counter(int fd) noexcept
+    {
+        auto value = uint64_t{};
+        if (::read(fd, &value, sizeof(value)) != sizeof(value) and errno != EAGAIN) {
+            hi_log_error("Could not read from file descriptor {}. {}", fd, get_last_error_message());
+        }
+    }
+
+    [[nodiscard]] static timespec to_timespec(std::chrono::nanoseconds duration) noexcept
+    {
+        auto r = timespec{};
+        r.tv_sec = narrow_cast<time_t>(duration.count() / 1'000'000'000);
+        r.tv_nsec = narrow_cast<long>(duration.count() % 1'000'000'000);
+        return r;
+    }
+
+    /** Arm the timerfd on the deadline of the first function on the function-timer.
+     *
+     * @note This function is cheap when the deadline did not change.
+     */
+    void update_timer() noexcept
+    {
+        using namespace std::chrono_literals;
+
+        hilet deadline = _function_timer.current_deadline();
+        if (deadline == _timer_deadline) {
+            return;
+        }
+        _timer_deadline = deadline;
+
+        // A zero it_value disarms the timer.
+        auto spec = itimerspec{};
+        if (deadline != utc_nanoseconds::max()) {
+            // The timerfd uses the monotonic clock, so that changes to the wall-clock do not affect it.
+            hilet timeout = std::max(std::chrono::nanoseconds{deadline - std::chrono::utc_clock::now()}, 1ns);
+            spec.it_value = to_timespec(timeout);
+        }
+
+        if (timerfd_settime(_timer_fd, 0, &spec, nullptr) != 0) {
+            hi_log_error("Could not arm the timer. {}", get_last_error_message());
+        }
+    }
+
+    /** Arm or disarm the vsync timer.
+     *
+     * The vsync timer is armed while render functions are subscribed.
+     */
+    void arm_vsync_timer() noexcept
+    {
+        auto spec = itimerspec{};
+        if (not _render_functions.empty()) {
+            spec.it_value = to_timespec(_minimum_frame_time);
+            spec.it_interval = spec.it_value;
+        }
+
+        if (timerfd_settime(_vsync_fd, 0, &spec, nullptr) != 0) {
+            hi_log_error("Could not arm the vsync-timer. {}", get_last_error_message());
+        }
+    }
+
+    void handle_vsync() noexcept
+    {
+        hilet display_time = std::chrono::utc_clock::now() + std::chrono::milliseconds(30);
+
+        for (auto& render_function : _render_functions) {
+            if (auto render_function_ = render_function.lock()) {
+                (*render_function_)(display_time);
+            }
+        }
+
+        std::erase_if(_render_functions, [](auto& render_function) {
+            return render_function.expired();
+        });
+
+        if (_render_functions.empty()) {
+            // Stop the vsync timer when there are no more windows.
+            arm_vsync_timer();
+        }
+    }
+
+    /** Call the callback of a socket.
+     *
+     * @param fd The file descriptor of the socket.
+     * @param events The events returned by `epoll_wait()`.
+     */
+    void handle_socket(int fd, uint32_t events) noexcept
+    {
+        hilet it = _sockets.find(fd);
+        if (it == _sockets.end()) {
+            // The socket was removed by a callback handled in the same iteration.
+            return;
+        }
+
+        // Keep the socket alive, in case the callback removes it.
+        hilet socket = it->second;
+
+        auto error = 0;
+        if (events & EPOLLERR) {
+            auto error_size = socklen_t{sizeof(error)};
+            if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &error_size) != 0) {
+                error = errno;
+            }
+        }
+
+        socket->callback(fd, socket_events_from_epoll(events, socket->mode, error));
+    }
+
+    /** Handle all function calls.
+     */
+    void handle_functions() noexcept
+    {
+        _function_fifo.run_all();
+    }
+
+    void handle_timers() noexcept
+    {
+        _function_timer.run_all(std::chrono::utc_clock::now());
+    }
+};
+
+inline loop::loop() : _pimpl(std::make_unique<loop_impl_linux>()) {}
+
+} // namespace hi::inline v1
@@ -0,0 +1,90 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "loop.hpp"
+#include "../macros.hpp"
+#include <gtest/gtest.h>
+#include <thread>
+#include <chrono>
+
+#if HI_OPERATING_SYSTEM == HI_OS_LINUX
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace hi;
+using namespace std::chrono_literals;
+
+TEST(loop, post_function_from_other_thread)
+{
+    auto l = loop{};
+
+    auto count = 0;
+    for (auto i = 0; i != 10; ++i) {
+        auto thread = std::jthread{[&] {
+            l.post_function([&] {
+                ++count;
+            });
+        }};
+        thread.join();
+
+        // Each post must wake up a blocking loop and be handled by it.
+        l.resume_once(true);
+        ASSERT_EQ(count, i + 1);
+    }
+
+    // Without a stop token the loop exits when there is nothing left to wait on.
+    ASSERT_EQ(l.resume(), 0);
+}
+
+TEST(loop, delay_function)
+{
+    auto l = loop{};
+
+    auto called_at = utc_nanoseconds{};
+    hilet deadline = std::chrono::utc_clock::now() + 5ms;
+    auto token = l.delay_function(deadline, [&] {
+        called_at = std::chrono::utc_clock::now();
+    });
+
+    ASSERT_EQ(l.resume(), 0);
+    // The function must not be called before its deadline.
+    ASSERT_GE(called_at, deadline);
+}
+
+#if HI_OPERATING_SYSTEM == HI_OS_LINUX
+TEST(loop, socket)
+{
+    auto l = loop{};
+
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+
+    auto nr_reads = 0;
+    auto closed = false;
+    l.add_socket(fds[0], socket_event::read | socket_event::close, [&](int fd, socket_events const& events) {
+        if (to_bool(events.events & socket_event::read)) {
+            char buffer[16];
+            while (::read(fd, buffer, sizeof(buffer)) > 0) {}
+            ++nr_reads;
+        }
+        if (to_bool(events.events & socket_event::close)) {
+            closed = true;
+            // A callback is allowed to remove its own socket.
+            l.remove_socket(fd);
+        }
+    });
+
+    ASSERT_EQ(::write(fds[1], "x", 1), 1);
+    while (nr_reads == 0) {
+        l.resume_once(true);
+    }
+
+    ::close(fds[1]);
+    ASSERT_EQ(l.resume(), 0);
+    ASSERT_TRUE(closed);
+    ::close(fds[0]);
+}
+#endif
@@ -0,0 +1,90 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "socket_event_intf.hpp"
+#include "../utility/utility.hpp"
+#include "../macros.hpp"
+#include <sys/epoll.h>
+#include <cerrno>
+#include <cstdint>
+
+hi_export_module(hikogui.dispatch.socket_event : impl);
+
+namespace hi::inline v1 {
+
+/** Convert a socket_event mask to the events to wait for with `epoll_ctl()`.
+ *
+ * Linux only reports readiness; `accept` is reported as readable and
+ * `connect` is reported as writable.
+ */
+[[nodiscard]] constexpr uint32_t socket_event_to_epoll(socket_event rhs) noexcept
+{
+    auto r = uint32_t{0};
+
+    r |= to_bool(rhs & (socket_event::read | socket_event::accept)) ? EPOLLIN : 0;
+    r |= to_bool(rhs & (socket_event::write | socket_event::connect)) ? EPOLLOUT : 0;
+    r |= to_bool(rhs & socket_event::close) ? EPOLLRDHUP : 0;
+    r |= to_bool(rhs & socket_event::out_of_band) ? EPOLLPRI : 0;
+
+    return r;
+}
+
+[[nodiscard]] constexpr socket_error socket_error_from_errno(int rhs) noexcept
+{
+    switch (rhs) {
+    case 0: return socket_error::success;
+    case EAFNOSUPPORT: return socket_error::af_not_supported;
+    case ECONNREFUSED: return socket_error::connection_refused;
+    case ENETUNREACH: return socket_error::network_unreachable;
+    case EHOSTUNREACH: return socket_error::network_unreachable;
+    case ENOBUFS: return socket_error::no_buffers;
+    case ETIMEDOUT: return socket_error::timeout;
+    case ENETDOWN: return socket_error::network_down;
+    case ECONNRESET: return socket_error::connection_reset;
+    case EPIPE: return socket_error::connection_reset;
+    default: return socket_error::connection_aborted;
+    }
+}
+
+/** Convert the events returned by `epoll_wait()` to socket_events.
+ *
+ * @param rhs The events returned by `epoll_wait()`.
+ * @param event_mask The events the socket was registered with, used to
+ *                   distinguish between read/accept and write/connect.
+ * @param error The pending error of the socket, from `SO_ERROR`.
+ */
+[[nodiscard]] constexpr socket_events socket_events_from_epoll(uint32_t rhs, socket_event event_mask, int error) noexcept
+{
+    auto r = socket_events{};
+
+    if (rhs & EPOLLIN) {
+        r.events |= event_mask & (socket_event::read | socket_event::accept);
+    }
+    if (rhs & EPOLLOUT) {
+        r.events |= event_mask & (socket_event::write | socket_event::connect);
+    }
+    if (rhs & (EPOLLRDHUP | EPOLLHUP)) {
+        r.events |= socket_event::close;
+    }
+    if (rhs & EPOLLPRI) {
+        r.events |= event_mask & socket_event::out_of_band;
+    }
+    if (rhs & EPOLLERR) {
+        // A failed connect is reported as an error on the connect event, like on win32.
+        r.events |= event_mask & (socket_event::connect | socket_event::close);
+    }
+
+    hilet socket_error = socket_error_from_errno(error);
+    for (auto i = 0_uz; i != socket_event_max; ++i) {
+        if (to_bool(r.events & static_cast<socket_event>(1 << i))) {
+            r.errors[i] = socket_error;
+        }
+    }
+
+    return r;
+}
+
+} // namespace hi::inline v1
@@ -10,7 +10,7 @@
 #include "../utility/utility.hpp"
 #include "../macros.hpp"
 
-hi_export_module(hikogui.dipatch.socket_event : impl);
+hi_export_module(hikogui.dispatch.socket_event : impl);
 
 namespace hi::inline v1 {
 
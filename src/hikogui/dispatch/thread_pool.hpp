@@ -0,0 +1,307 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "../container/work_stealing_deque.hpp"
+#include "../concurrency/concurrency.hpp"
+#include "../telemetry/telemetry.hpp"
+#include "../utility/utility.hpp"
+#include "../macros.hpp"
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <deque>
+#include <format>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+hi_export_module(hikogui.dispatch.thread_pool);
+
+hi_export namespace hi::inline v1 {
+
+/** A work-stealing thread pool.
+ *
+ * Each worker thread owns a work-stealing deque. Functions posted from a worker
+ * are pushed on that worker's deque, and are executed in LIFO order by the worker
+ * for cache locality. Idle workers steal the oldest functions from other workers.
+ * Functions posted from outside the pool are placed on a shared injection queue.
+ *
+ * Idle workers sleep on an atomic counter, which is incremented and notified for
+ * each posted function.
+ *
+ * The thread pool has the same `post_function()` interface as `hi::loop`, and
+ * co-routines can move to a pool with `co_await resume_on(pool)`.
+ */
+class thread_pool {
+public:
+    using function_type = std::function<void()>;
+
+    /** Create a thread pool.
+     *
+     * @param nr_threads The number of worker threads, zero means one thread per available CPU.
+     * @param pin_threads Pin each worker thread to a separate CPU.
+     */
+    explicit thread_pool(std::size_t nr_threads = 0, bool pin_threads = true)
+    {
+        auto cpus = std::vector<std::size_t>{};
+        hilet mask = process_affinity_mask();
+        for (auto cpu = 0_uz; cpu != mask.size(); ++cpu) {
+            if (mask[cpu]) {
+                cpus.push_back(cpu);
+            }
+        }
+
+        if (nr_threads == 0) {
+            nr_threads = std::max(cpus.size(), 1_uz);
+        }
+
+        for (auto i = 0_uz; i != nr_threads; ++i) {
+            _workers.push_back(std::make_unique<worker_type>());
+        }
+
+        for (auto i = 0_uz; i != nr_threads; ++i) {
+            hilet cpu = (pin_threads and not cpus.empty()) ? cpus[i % cpus.size()] : std::numeric_limits<std::size_t>::max();
+            _workers[i]->thread = std::jthread{[this, i, cpu] {
+                worker_main(i, cpu);
+            }};
+        }
+    }
+
+    /** Destroy the thread pool.
+     *
+     * All functions that were posted, including the functions posted by these
+     * functions, are executed before the destructor returns.
+     */
+    ~thread_pool()
+    {
+        _stop.store(true, std::memory_order::relaxed);
+        _wake_count.fetch_add(1, std::memory_order::seq_cst);
+        _wake_count.notify_all();
+
+        for (auto& worker : _workers) {
+            worker->thread.join();
+        }
+    }
+
+    thread_pool(thread_pool const&) = delete;
+    thread_pool(thread_pool&&) = delete;
+    thread_pool& operator=(thread_pool const&) = delete;
+    thread_pool& operator=(thread_pool&&) = delete;
+
+    /** Get the global thread pool.
+     *
+     * The global thread pool has one thread per available CPU and is used for
+     * fanning out CPU bound work, like decoding images and shaping text.
+     *
+     * @throws std::system_error When the worker threads could not be started.
+     */
+    [[nodiscard]] hi_no_inline static thread_pool& global()
+    {
+        static auto r = thread_pool{};
+        return r;
+    }
+
+    /** The number of worker threads.
+     */
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        return _workers.size();
+    }
+
+    /** Check if the current thread is a worker of this thread pool.
+     */
+    [[nodiscard]] bool on_thread() const noexcept
+    {
+        return _current_pool == this;
+    }
+
+    /** Post a function to be called from one of the worker threads.
+     *
+     * @note The function must not throw.
+     * @param func The function to call.
+     */
+    void post_function(auto&& func) noexcept
+    {
+        auto ptr = new function_type(hi_forward(func));
+
+        if (_current_pool == this) {
+            _workers[_current_worker]->deque.push(ptr);
+        } else {
+            hilet lock = std::scoped_lock(_injection_mutex);
+            _injection.push_back(ptr);
+        }
+
+        notify();
+    }
+
+private:
+    struct worker_type {
+        work_stealing_deque<function_type> deque;
+        std::jthread thread;
+    };
+
+    /** Number of empty scans of all the queues before a worker goes to sleep.
+     */
+    constexpr static std::size_t nr_spins = 64;
+
+    inline static thread_local thread_pool *_current_pool = nullptr;
+    inline static thread_local std::size_t _current_worker = 0;
+
+    std::vector<std::unique_ptr<worker_type>> _workers;
+
+    mutable unfair_mutex _injection_mutex;
+    std::deque<function_type *> _injection;
+
+    /** Incremented on each post, idle workers wait for this value to change.
+     */
+    alignas(hardware_destructive_interference_size) std::atomic<uint32_t> _wake_count = 0;
+    std::atomic<std::size_t> _nr_sleeping = 0;
+    std::atomic<bool> _stop = false;
+
+    void notify() noexcept
+    {
+        _wake_count.fetch_add(1, std::memory_order::seq_cst);
+        if (_nr_sleeping.load(std::memory_order::seq_cst) != 0) {
+            _wake_count.notify_one();
+        }
+    }
+
+    [[nodiscard]] function_type *find_function(std::size_t index, uint64_t& random) noexcept
+    {
+        if (auto ptr = _workers[index]->deque.pop()) {
+            return ptr;
+        }
+
+        {
+            hilet lock = std::scoped_lock(_injection_mutex);
+            if (not _injection.empty()) {
+                auto ptr = _injection.front();
+                _injection.pop_front();
+                return ptr;
+            }
+        }
+
+        // Steal from the other workers, starting at a random victim.
+        random ^= random << 13;
+        random ^= random >> 7;
+        random ^= random << 17;
+        hilet first = narrow_cast<std::size_t>(random % _workers.size());
+        for (auto i = 0_uz; i != _workers.size(); ++i) {
+            hilet victim = (first + i) % _workers.size();
+            if (victim == index) {
+                continue;
+            }
+            if (auto ptr = _workers[victim]->deque.steal()) {
+                return ptr;
+            }
+        }
+        return nullptr;
+    }
+
+    void worker_main(std::size_t index, std::size_t cpu) noexcept
+    {
+        set_thread_name(std::format("pool-{}", index));
+        if (cpu != std::numeric_limits<std::size_t>::max()) {
+            try {
+                set_thread_affinity(cpu);
+            } catch (os_error const& e) {
+                hi_log_warning("Could not pin thread pool worker {} to CPU {}. {}", index, cpu, e.what());
+            }
+        }
+
+        _current_pool = this;
+        _current_worker = index;
+
+        auto random = narrow_cast<uint64_t>(index * 0x9e37'79b9'7f4a'7c15ULL + 1);
+        auto nr_empty_scans = 0_uz;
+        while (true) {
+            if (auto ptr = find_function(index, random)) {
+                nr_empty_scans = 0;
+                (*ptr)();
+                delete ptr;
+                continue;
+            }
+
+            if (++nr_empty_scans < nr_spins) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            // Read the wake count before the final scan, so that a post after
+            // the scan will make the wait return immediately.
+            hilet wake_count = _wake_count.load(std::memory_order::seq_cst);
+            _nr_sleeping.fetch_add(1, std::memory_order::seq_cst);
+            if (auto ptr = find_function(index, random)) {
+                _nr_sleeping.fetch_sub(1, std::memory_order::relaxed);
+                nr_empty_scans = 0;
+                (*ptr)();
+                delete ptr;
+                continue;
+            }
+
+            if (_stop.load(std::memory_order::relaxed)) {
+                _nr_sleeping.fetch_sub(1, std::memory_order::relaxed);
+                break;
+            }
+
+            _wake_count.wait(wake_count, std::memory_order::seq_cst);
+            _nr_sleeping.fetch_sub(1, std::memory_order::relaxed);
+        }
+
+        _current_pool = nullptr;
+    }
+};
+
+/** An awaitable which resumes the co-routine on an executor.
+ *
+ * @tparam Executor An object with a `post_function()` member, such as `hi::loop` or `hi::thread_pool`.
+ */
+template<typename Executor>
+class awaitable_resume_on {
+public:
+    explicit awaitable_resume_on(Executor& executor) noexcept : _executor(std::addressof(executor)) {}
+
+    [[nodiscard]] bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle) noexcept
+    {
+        _executor->post_function([handle] {
+            handle.resume();
+        });
+    }
+
+    void await_resume() const noexcept {}
+
+private:
+    Executor *_executor;
+};
+
+/** Resume the current co-routine on an executor.
+ *
+ * ```cpp
+ * co_await resume_on(thread_pool::global());
+ * auto image = decode_png(data);
+ * co_await resume_on(loop::main());
+ * ```
+ *
+ * @param executor An object with a `post_function()` member, such as `hi::loop` or `hi::thread_pool`.
+ * @return An awaitable that resumes the co-routine from the executor.
+ */
+template<typename Executor>
+[[nodiscard]] awaitable_resume_on<Executor> resume_on(Executor& executor) noexcept
+    requires requires { executor.post_function([] {}); }
+{
+    return awaitable_resume_on<Executor>{executor};
+}
+
+} // namespace hi::inline v1
@@ -0,0 +1,106 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "thread_pool.hpp"
+#include "../coroutine/module.hpp"
+#include "../macros.hpp"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <latch>
+#include <memory>
+#include <thread>
+
+using namespace std;
+using namespace hi;
+
+namespace {
+
+/** Count the nodes of a binary tree of the given depth, forking each sub-tree onto the pool.
+ */
+void fork_join(thread_pool& pool, int depth, std::atomic<int>& count, std::latch& done)
+{
+    count.fetch_add(1, std::memory_order::relaxed);
+    if (depth == 0) {
+        done.count_down();
+        return;
+    }
+
+    pool.post_function([&pool, depth, &count, &done] {
+        fork_join(pool, depth - 1, count, done);
+    });
+    pool.post_function([&pool, depth, &count, &done] {
+        fork_join(pool, depth - 1, count, done);
+    });
+}
+
+} // namespace
+
+TEST(thread_pool, many_small_functions)
+{
+    auto pool = thread_pool{4, false};
+    ASSERT_EQ(pool.size(), 4);
+    ASSERT_FALSE(pool.on_thread());
+
+    constexpr auto nr_functions = 100'000;
+    auto count = std::atomic<int>{0};
+    auto done = std::latch{nr_functions};
+    for (auto i = 0; i != nr_functions; ++i) {
+        pool.post_function([&] {
+            count.fetch_add(1, std::memory_order::relaxed);
+            done.count_down();
+        });
+    }
+    done.wait();
+    ASSERT_EQ(count.load(), nr_functions);
+}
+
+TEST(thread_pool, fork_join)
+{
+    auto pool = thread_pool{};
+
+    constexpr auto depth = 16;
+    auto count = std::atomic<int>{0};
+    auto done = std::latch{1 << depth};
+    pool.post_function([&] {
+        fork_join(pool, depth, count, done);
+    });
+    done.wait();
+    ASSERT_EQ(count.load(), (2 << depth) - 1);
+}
+
+TEST(thread_pool, drain_on_destruction)
+{
+    auto count = std::atomic<int>{0};
+    {
+        auto pool = thread_pool{2, false};
+        for (auto i = 0; i != 1000; ++i) {
+            pool.post_function([&] {
+                // Functions posted from a worker during destruction are executed as well.
+                pool.post_function([&] {
+                    count.fetch_add(1);
+                });
+            });
+        }
+    }
+    ASSERT_EQ(count.load(), 1000);
+}
+
+TEST(thread_pool, resume_on)
+{
+    auto task = [](thread_pool& pool, bool& on_pool) -> scoped_task<int> {
+        co_await resume_on(pool);
+        on_pool = pool.on_thread();
+        co_return 42;
+    };
+
+    auto on_pool = false;
+    auto pool = std::make_unique<thread_pool>(2, false);
+    auto t = task(*pool, on_pool);
+
+    // Destroying the pool waits until the co-routine has finished on the worker.
+    pool.reset();
+    ASSERT_TRUE(t.done());
+    ASSERT_EQ(t.value(), 42);
+    ASSERT_TRUE(on_pool);
+}
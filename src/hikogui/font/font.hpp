@@ -8,6 +8,7 @@
 #include "font_font.hpp" // export
 #include "font_book.hpp" // export
 #include "font_family_id.hpp" // export
+#include "font_index.hpp" // export
 #include "font_metrics.hpp" // export
 #include "font_variant.hpp" // export
 #include "font_weight.hpp" // export
@@ -15,6 +16,7 @@
 #include "glyph_id.hpp" // export
 #include "glyph_metrics.hpp" // export
 #include "hikogui_icon.hpp" // export
+#include "shape_run_cache.hpp" // export
 #include "true_type_font.hpp" // export
 
 hi_export_module(hikogui.font);
@@ -7,18 +7,24 @@
 #include "font.hpp"
 #include "font_family_id.hpp"
 #include "true_type_font.hpp"
+#include "font_index.hpp"
 #include "elusive_icon.hpp"
 #include "hikogui_icon.hpp"
 #include "../unicode/unicode.hpp"
 #include "../geometry/module.hpp"
 #include "../utility/utility.hpp"
 #include "../coroutine/module.hpp"
+#include "../dispatch/dispatch.hpp"
 #include "../path/path.hpp"
 #include <limits>
 #include <array>
 #include <new>
 #include <atomic>
 #include <filesystem>
+#include <latch>
+#include <map>
+#include <string_view>
+#include <tuple>
 
 hi_export_module(hikogui.font.font_book);
 
@@ -99,6 +105,32 @@ public:
     font_book& operator=(font_book&&) = delete;
     font_book() = default;
 
+    /** Use a persistent index of the metadata of font-files.
+     *
+     * Fonts that are registered after this call, and that are in the index,
+     * are created from the index without opening the font-file.
+     * The index is saved by `save_index()`.
+     *
+     * @param path The location of the index-file.
+     */
+    void use_index(std::filesystem::path const& path) noexcept
+    {
+        _index = std::make_unique<font_index>(path);
+    }
+
+    /** Save the font index.
+     *
+     * Entries of font-files that were not registered since the index was loaded
+     * are removed from the index-file. Call this after all font-files and font
+     * directories are registered.
+     */
+    void save_index() noexcept
+    {
+        if (_index) {
+            _index->save();
+        }
+    }
+
     /** Register a font.
      * Duplicate registrations will be ignored.
      *
@@ -112,39 +144,61 @@ public:
      */
     font& register_font_file(std::filesystem::path const& path, bool post_process = true)
     {
-        auto font = std::make_unique<true_type_font>(path);
-        auto font_ptr = font.get();
-
-        hi_log_info("Parsed font {}: {}", path.string(), to_string(*font));
-
-        hilet font_family_id = register_family(font->family_name);
-        _font_variants[*font_family_id][font->font_variant()] = font_ptr;
-
-        _fonts.emplace_back(std::move(font));
-        _font_ptrs.push_back(font_ptr);
+        auto& r = register_font(path, make_font(path));
 
         if (post_process) {
             this->post_process();
         }
 
-        return *font_ptr;
+        return r;
     }
 
     /** Register all fonts found in a directory.
+     *
+     * The font-files that are not in the font index are parsed in parallel on
+     * the global thread pool. The fonts are registered in the order in which
+     * they were found, independent of the order in which the parsing finished.
      *
      * @see register_font()
      */
     void register_font_directory(std::filesystem::path const& path, bool post_process = true)
     {
-        hilet font_directory_glob = path / "**" / "*.ttf";
-        for (hilet& font_path : glob(font_directory_glob)) {
-            hilet t = trace<"font_scan">{};
+        auto font_paths = std::vector<std::filesystem::path>{};
+        for (hilet& font_path : glob(path / "**" / "*.ttf")) {
+            font_paths.push_back(font_path);
+        }
 
-            try {
-                register_font_file(font_path, false);
+        // Each font-file has its own slot for the result, so that parsing
+        // can be done in any order on any thread.
+        auto fonts = std::vector<std::unique_ptr<true_type_font>>(font_paths.size());
+        auto errors = std::vector<std::string>(font_paths.size());
+
+        auto parse_indices = std::vector<size_t>{};
+        for (auto i = 0_uz; i != font_paths.size(); ++i) {
+            if (_index) {
+                if (hilet entry = _index->find(font_paths[i])) {
+                    fonts[i] = std::make_unique<true_type_font>(font_paths[i], *entry);
+                    continue;
+                }
+            }
+            parse_indices.push_back(i);
+        }
 
-            } catch (std::exception const& e) {
-                hi_log_error("Failed parsing font at {}: \"{}\"", font_path.string(), e.what());
+        parse_font_files(font_paths, parse_indices, fonts, errors);
+
+        if (_index) {
+            for (hilet i : parse_indices) {
+                if (fonts[i]) {
+                    _index->insert(font_paths[i], fonts[i]->make_index_entry());
+                }
+            }
+        }
+
+        for (auto i = 0_uz; i != font_paths.size(); ++i) {
+            if (fonts[i]) {
+                register_font(font_paths[i], std::move(fonts[i]));
+            } else {
+                hi_log_error("Failed parsing font at {}: \"{}\"", font_paths[i].string(), errors[i]);
             }
         }
 
@@ -159,8 +213,11 @@ public:
      */
     void post_process() noexcept
     {
+        hilet t = trace<"font_post_process">{};
+
         // Sort the list of fonts based on the amount of unicode code points it supports.
-        std::sort(begin(_font_ptrs), end(_font_ptrs), [](hilet& lhs, hilet& rhs) {
+        // The sort is stable so that the fallback chains do not depend on the sort algorithm.
+        std::stable_sort(begin(_font_ptrs), end(_font_ptrs), [](hilet& lhs, hilet& rhs) {
             return lhs->char_map.count() > rhs->char_map.count();
         });
 
@@ -175,22 +232,21 @@ public:
             size(bold_fallback_chain),
             size(italic_fallback_chain));
 
+        // Group the fonts of the same family, italic and weight.
+        auto buckets = std::map<fallback_bucket_key, std::vector<hi::font *>>{};
+        for (hilet& font : _font_ptrs) {
+            buckets[make_fallback_bucket_key(*font)].push_back(font);
+        }
+
         // For each font, find fallback list.
         for (hilet& font : _font_ptrs) {
             auto fallback_chain = std::vector<hi::font *>{};
 
             // Put the fonts from the same family, italic and weight first.
-            for (hilet& fallback : _font_ptrs) {
-                // clang-format off
-            if (
-                (fallback != font) and
-                (fallback->family_name == font->family_name) and
-                (fallback->style == font->style) and
-                almost_equal(fallback->weight, font->weight)
-            ) {
-                fallback_chain.push_back(fallback);
-            }
-                // clang-format on
+            for (hilet& fallback : buckets[make_fallback_bucket_key(*font)]) {
+                if (fallback != font) {
+                    fallback_chain.push_back(fallback);
+                }
             }
 
             if (almost_equal(font->weight, font_weight::bold)) {
@@ -344,6 +400,96 @@ private:
     std::vector<std::unique_ptr<font>> _fonts;
     std::vector<hi::font *> _font_ptrs;
 
+    /** The persistent index of the metadata of font-files, or nullptr when not used.
+     */
+    std::unique_ptr<font_index> _index;
+
+    /** The family-name, style and boldness of a font.
+     *
+     * Fonts with the same key are put first in each other's fallback chain.
+     * The boldness matches `almost_equal()` for font-weights.
+     */
+    using fallback_bucket_key = std::tuple<std::string_view, font_style, bool>;
+
+    [[nodiscard]] static fallback_bucket_key make_fallback_bucket_key(hi::font const& font) noexcept
+    {
+        return {font.family_name, font.style, font.weight > font_weight::medium};
+    }
+
+    font& register_font(std::filesystem::path const& path, std::unique_ptr<true_type_font> font)
+    {
+        auto font_ptr = font.get();
+
+        hi_log_info("Parsed font {}: {}", path.string(), to_string(*font));
+
+        hilet font_family_id = register_family(font->family_name);
+        _font_variants[*font_family_id][font->font_variant()] = font_ptr;
+
+        _fonts.emplace_back(std::move(font));
+        _font_ptrs.push_back(font_ptr);
+        return *font_ptr;
+    }
+
+    /** Parse font-files in parallel.
+     *
+     * @param paths The locations of the font-files.
+     * @param indices The indices of the font-files in @a paths to parse.
+     * @param[out] fonts The parsed fonts, at the same index as the path.
+     * @param[out] errors The error messages for fonts that could not be parsed, at the same index as the path.
+     */
+    static void parse_font_files(
+        std::span<std::filesystem::path const> paths,
+        std::span<size_t const> indices,
+        std::span<std::unique_ptr<true_type_font>> fonts,
+        std::span<std::string> errors)
+    {
+        auto parse = [&](size_t i) noexcept {
+            hilet t = trace<"font_scan">{};
+
+            try {
+                fonts[i] = std::make_unique<true_type_font>(paths[i]);
+            } catch (std::exception const& e) {
+                errors[i] = e.what();
+            }
+        };
+
+        auto& pool = thread_pool::global();
+
+        // Waiting for the pool from one of its own workers could dead-lock.
+        if (indices.size() < 2 or pool.on_thread()) {
+            for (hilet i : indices) {
+                parse(i);
+            }
+            return;
+        }
+
+        auto done = std::latch{narrow_cast<std::ptrdiff_t>(indices.size())};
+        for (hilet i : indices) {
+            pool.post_function([&parse, &done, i] {
+                parse(i);
+                done.count_down();
+            });
+        }
+        done.wait();
+    }
+
+    /** Create a font, from the index when possible.
+     */
+    [[nodiscard]] std::unique_ptr<true_type_font> make_font(std::filesystem::path const& path)
+    {
+        if (_index) {
+            if (hilet entry = _index->find(path)) {
+                return std::make_unique<true_type_font>(path, *entry);
+            }
+        }
+
+        auto r = std::make_unique<true_type_font>(path);
+        if (_index) {
+            _index->insert(path, r->make_index_entry());
+        }
+        return r;
+    }
+
     [[nodiscard]] std::vector<hi::font *> make_fallback_chain(font_weight weight, font_style style) noexcept
     {
         auto r = _font_ptrs;
@@ -385,6 +531,12 @@ hi_export inline void register_font_directory(std::filesystem::path const& path)
     return font_book::global().register_font_directory(path);
 }
 
+/** Register all fonts found in a set of directories.
+ *
+ * After all directories are scanned the font index, if any, is saved.
+ *
+ * @param range The directories to scan.
+ */
 hi_export template<typename Range>
 inline void register_font_directories(Range&& range) noexcept
 {
@@ -392,6 +544,7 @@ inline void register_font_directories(Range&& range) noexcept
         font_book::global().register_font_directory(path, false);
     }
     font_book::global().post_process();
+    font_book::global().save_index();
 }
 
 /** Find font family id.
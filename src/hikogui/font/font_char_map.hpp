@@ -59,6 +59,28 @@ public:
         return _count;
     }
 
+    /** A range of code-points mapped to consecutive glyphs.
+     */
+    struct range_type {
+        char32_t start_code_point;
+        char32_t end_code_point;
+        uint16_t start_glyph;
+    };
+
+    /** Get the ranges of code-points in the character map.
+     *
+     * The ranges can be added to another character map with `add()` to make a copy.
+     */
+    [[nodiscard]] constexpr std::vector<range_type> ranges() const noexcept
+    {
+        auto r = std::vector<range_type>{};
+        r.reserve(_map.size());
+        for (hilet& entry : _map) {
+            r.emplace_back(entry.start_code_point(), entry.end_code_point, entry.start_glyph);
+        }
+        return r;
+    }
+
     /** Update a code-point mask.
      *
      * @param mask The mask to be updated.
@@ -33,3 +33,25 @@ TEST(font_char_map, add_and_search)
     ASSERT_EQ(cm.find(U'8'), 208);
     ASSERT_EQ(cm.find(U'9'), 209);
 }
+
+TEST(font_char_map, ranges)
+{
+    auto cm = hi::font_char_map{};
+
+    cm.add(U'0', U'3', 200);
+    cm.add(U'4', U'4', 204);
+    cm.add(U'8', U'9', 208);
+    cm.prepare();
+
+    auto copy = hi::font_char_map{};
+    for (hilet& range : cm.ranges()) {
+        copy.add(range.start_code_point, range.end_code_point, range.start_glyph);
+    }
+    copy.prepare();
+
+    ASSERT_EQ(cm.ranges().size(), 2);
+    ASSERT_EQ(copy.count(), cm.count());
+    for (auto c = U'0'; c <= U'9'; ++c) {
+        ASSERT_EQ(copy.find(c), cm.find(c));
+    }
+}
@@ -0,0 +1,429 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+/** @file font/font_index.hpp Defines the font_index type.
+ * @ingroup font
+ */
+
+#pragma once
+
+#include "font_char_map.hpp"
+#include "font_metrics.hpp"
+#include "font_style.hpp"
+#include "font_weight.hpp"
+#include "../file/file.hpp"
+#include "../telemetry/telemetry.hpp"
+#include "../utility/utility.hpp"
+#include "../macros.hpp"
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+hi_export_module(hikogui.font.font_index);
+
+namespace hi { inline namespace v1 {
+
+/** The metadata of a font-file stored in the font index.
+ *
+ * The metadata is enough to select a font and find its glyphs, the
+ * font-file is only opened when the glyphs are needed.
+ *
+ * @ingroup font
+ */
+hi_export struct font_index_entry {
+    std::string family_name;
+    std::string sub_family_name;
+    std::string features;
+
+    bool monospace = false;
+    bool serif = false;
+    font_style style = font_style::normal;
+    bool condensed = false;
+    font_weight weight = font_weight::regular;
+    float optical_size = 12.0f;
+
+    font_metrics metrics;
+    font_char_map char_map;
+
+    float em_scale = 0.0f;
+    uint16_t num_horizontal_metrics = 0;
+    uint16_t num_glyphs = 0;
+    bool loca_is_offset32 = false;
+};
+
+/** A persistent index of the metadata of font-files.
+ *
+ * Parsing the 'name', 'OS/2' and 'cmap' tables of every font-file in the
+ * font directories is expensive during startup. The index stores the
+ * parsed metadata of each font-file, keyed by the path of the file.
+ *
+ * An entry is only used when the size and the modification time of the
+ * font-file are unchanged since the entry was added.
+ *
+ * @ingroup font
+ */
+hi_export class font_index {
+public:
+    /** The version of the file format, increment on every change to the format.
+     */
+    constexpr static uint32_t version = 1;
+
+    ~font_index() = default;
+    font_index(font_index const&) = delete;
+    font_index(font_index&&) = delete;
+    font_index& operator=(font_index const&) = delete;
+    font_index& operator=(font_index&&) = delete;
+
+    /** Open a font index.
+     *
+     * When the index-file does not exist or is invalid the index starts empty.
+     * Entries of font-files that no longer exist are pruned.
+     *
+     * @param path The location of the index-file.
+     */
+    explicit font_index(std::filesystem::path path) noexcept : _path(std::move(path))
+    {
+        load();
+    }
+
+    [[nodiscard]] std::filesystem::path const& path() const noexcept
+    {
+        return _path;
+    }
+
+    [[nodiscard]] size_t size() const noexcept
+    {
+        return _items.size();
+    }
+
+    /** Check if entries were added or pruned since the index was loaded or saved.
+     */
+    [[nodiscard]] bool modified() const noexcept
+    {
+        return _modified;
+    }
+
+    /** Find the metadata of a font-file.
+     *
+     * @param font_path The location of the font-file.
+     * @return The metadata of the font-file, or nullptr if the font-file is not
+     *         in the index or was modified since it was added.
+     */
+    [[nodiscard]] font_index_entry const *find(std::filesystem::path const& font_path) noexcept
+    {
+        hilet it = _items.find(font_path.string());
+        if (it == _items.end()) {
+            ++global_counter<"font_index:miss">;
+            return nullptr;
+        }
+
+        hilet [file_size, file_time] = file_stat(font_path);
+        if (it->second.file_size != file_size or it->second.file_time != file_time) {
+            ++global_counter<"font_index:stale">;
+            return nullptr;
+        }
+
+        ++global_counter<"font_index:hit">;
+        it->second.used = true;
+        return std::addressof(it->second.entry);
+    }
+
+    /** Add the metadata of a font-file.
+     *
+     * @param font_path The location of the font-file.
+     * @param entry The metadata parsed from the font-file.
+     */
+    void insert(std::filesystem::path const& font_path, font_index_entry entry) noexcept
+    {
+        hilet [file_size, file_time] = file_stat(font_path);
+        if (file_size == 0) {
+            // The font-file could not be found, it would never match.
+            return;
+        }
+
+        _items.insert_or_assign(font_path.string(), item_type{file_size, file_time, true, std::move(entry)});
+        _modified = true;
+    }
+
+    /** Save the index when it was modified.
+     *
+     * Only the entries that were found or added since the index was loaded are
+     * saved, so that entries of removed font-files do not accumulate.
+     */
+    void save() noexcept
+    {
+        if (not _modified) {
+            return;
+        }
+
+        try {
+            hilet bytes = encode();
+
+            auto tmp_path = _path;
+            tmp_path += ".tmp";
+
+            auto file = hi::file(tmp_path, access_mode::truncate_or_create_for_write | access_mode::rename);
+            file.write(std::span{bytes});
+            file.flush();
+            file.rename(_path, true);
+
+        } catch (std::exception const& e) {
+            hi_log_error("Could not save font index to file {}. \"{}\"", _path.string(), e.what());
+        }
+
+        _modified = false;
+    }
+
+private:
+    struct header_type {
+        std::array<char, 4> magic;
+        little_uint32_buf_t version;
+        little_uint32_buf_t count;
+    };
+
+    struct item_header_type {
+        little_uint64_buf_t file_size;
+        little_int64_buf_t file_time;
+        little_uint32_buf_t optical_size;
+        little_uint32_buf_t em_scale;
+        std::array<little_uint32_buf_t, 8> metrics;
+        little_uint16_buf_t num_horizontal_metrics;
+        little_uint16_buf_t num_glyphs;
+        little_uint16_buf_t path_size;
+        little_uint16_buf_t family_name_size;
+        little_uint16_buf_t sub_family_name_size;
+        little_uint16_buf_t features_size;
+        little_uint32_buf_t range_count;
+        uint8_t flags;
+        uint8_t style;
+        uint8_t weight;
+        uint8_t reserved;
+    };
+
+    struct range_type {
+        little_uint32_buf_t start_code_point;
+        little_uint32_buf_t end_code_point;
+        little_uint16_buf_t start_glyph;
+    };
+
+    constexpr static uint8_t flag_monospace = 0x01;
+    constexpr static uint8_t flag_serif = 0x02;
+    constexpr static uint8_t flag_condensed = 0x04;
+    constexpr static uint8_t flag_loca_is_offset32 = 0x08;
+
+    struct item_type {
+        uint64_t file_size;
+        int64_t file_time;
+
+        /** The entry was found or inserted since the index was loaded.
+         */
+        bool used;
+
+        font_index_entry entry;
+    };
+
+    std::filesystem::path _path;
+    std::unordered_map<std::string, item_type> _items;
+    bool _modified = false;
+
+    /** Get the size and modification time of a file.
+     *
+     * @return The size and modification time, or zeros when the file could not be found.
+     */
+    [[nodiscard]] static std::pair<uint64_t, int64_t> file_stat(std::filesystem::path const& path) noexcept
+    {
+        auto ec = std::error_code{};
+        hilet file_size = std::filesystem::file_size(path, ec);
+        if (ec) {
+            return {0, 0};
+        }
+
+        hilet file_time = std::filesystem::last_write_time(path, ec);
+        if (ec) {
+            return {0, 0};
+        }
+
+        return {file_size, file_time.time_since_epoch().count()};
+    }
+
+    void load() noexcept
+    {
+        if (not std::filesystem::exists(_path)) {
+            return;
+        }
+
+        try {
+            hilet view = file_view{_path};
+            decode(as_span<std::byte const>(view));
+
+        } catch (std::exception const& e) {
+            hi_log_warning("Could not read font index from file {}. \"{}\"", _path.string(), e.what());
+            _items.clear();
+        }
+    }
+
+    void decode(std::span<std::byte const> bytes)
+    {
+        auto offset = 0_uz;
+        hilet& header = implicit_cast<header_type>(offset, bytes);
+        if (std::string_view{header.magic.data(), header.magic.size()} != "HIFI" or *header.version != version) {
+            // An index of a different version is silently replaced.
+            return;
+        }
+
+        hilet count = *header.count;
+        for (auto i = 0_uz; i != count; ++i) {
+            hilet& item_header = implicit_cast<item_header_type>(offset, bytes);
+
+            auto item = item_type{*item_header.file_size, *item_header.file_time, false, {}};
+            auto& entry = item.entry;
+
+            auto path = decode_string(offset, bytes, *item_header.path_size);
+            entry.family_name = decode_string(offset, bytes, *item_header.family_name_size);
+            entry.sub_family_name = decode_string(offset, bytes, *item_header.sub_family_name_size);
+            entry.features = decode_string(offset, bytes, *item_header.features_size);
+
+            entry.monospace = to_bool(item_header.flags & flag_monospace);
+            entry.serif = to_bool(item_header.flags & flag_serif);
+            entry.condensed = to_bool(item_header.flags & flag_condensed);
+            entry.loca_is_offset32 = to_bool(item_header.flags & flag_loca_is_offset32);
+
+            hi_check(item_header.style <= std::to_underlying(font_style::oblique), "Invalid font style in font index.");
+            entry.style = static_cast<font_style>(item_header.style);
+            hi_check(item_header.weight <= std::to_underlying(font_weight::extra_black), "Invalid font weight in font index.");
+            entry.weight = static_cast<font_weight>(item_header.weight);
+
+            entry.optical_size = std::bit_cast<float>(*item_header.optical_size);
+            entry.em_scale = std::bit_cast<float>(*item_header.em_scale);
+            entry.num_horizontal_metrics = *item_header.num_horizontal_metrics;
+            entry.num_glyphs = *item_header.num_glyphs;
+
+            entry.metrics.ascender = std::bit_cast<float>(*item_header.metrics[0]);
+            entry.metrics.descender = std::bit_cast<float>(*item_header.metrics[1]);
+            entry.metrics.line_gap = std::bit_cast<float>(*item_header.metrics[2]);
+            entry.metrics.cap_height = std::bit_cast<float>(*item_header.metrics[3]);
+            entry.metrics.x_height = std::bit_cast<float>(*item_header.metrics[4]);
+            entry.metrics.digit_advance = std::bit_cast<float>(*item_header.metrics[5]);
+            entry.metrics.line_spacing = std::bit_cast<float>(*item_header.metrics[6]);
+            entry.metrics.paragraph_spacing = std::bit_cast<float>(*item_header.metrics[7]);
+
+            hilet ranges = implicit_cast<range_type>(offset, bytes, *item_header.range_count);
+            entry.char_map.reserve(ranges.size());
+            for (hilet& range : ranges) {
+                hilet start_code_point = char_cast<char32_t>(*range.start_code_point);
+                hilet end_code_point = char_cast<char32_t>(*range.end_code_point);
+                hilet start_glyph = *range.start_glyph;
+                hi_check(start_code_point <= end_code_point, "Invalid code-point range in font index.");
+                hi_check(end_code_point < 0x11'0000, "Invalid code-point range in font index.");
+                hi_check(
+                    start_glyph + wide_cast<size_t>(end_code_point - start_code_point) < 0xfffe,
+                    "Invalid glyph range in font index.");
+                entry.char_map.add(start_code_point, end_code_point, start_glyph);
+            }
+            entry.char_map.prepare();
+
+            if (file_stat(path).first == 0) {
+                // The font-file was removed, prune its entry when the index is saved.
+                _modified = true;
+                continue;
+            }
+
+            _items.insert_or_assign(std::move(path), std::move(item));
+        }
+    }
+
+    [[nodiscard]] static std::string decode_string(size_t& offset, std::span<std::byte const> bytes, size_t size)
+    {
+        hilet chars = implicit_cast<char>(offset, bytes, size);
+        return std::string{chars.begin(), chars.end()};
+    }
+
+    [[nodiscard]] std::vector<std::byte> encode() const noexcept
+    {
+        auto r = std::vector<std::byte>{};
+
+        auto append = [&r](auto const& value) {
+            hilet value_bytes = std::as_bytes(std::span{std::addressof(value), 1});
+            r.insert(r.end(), value_bytes.begin(), value_bytes.end());
+        };
+
+        auto append_string = [&r](std::string_view str) {
+            hilet str_bytes = std::as_bytes(std::span{str});
+            r.insert(r.end(), str_bytes.begin(), str_bytes.end());
+        };
+
+        auto count = 0_uz;
+        for (hilet& [path, item] : _items) {
+            count += item.used ? 1 : 0;
+        }
+
+        auto header = header_type{};
+        header.magic = {'H', 'I', 'F', 'I'};
+        header.version = version;
+        header.count = narrow_cast<uint32_t>(count);
+        append(header);
+
+        for (hilet& [path, item] : _items) {
+            if (not item.used) {
+                continue;
+            }
+
+            hilet& entry = item.entry;
+            hilet ranges = entry.char_map.ranges();
+
+            auto item_header = item_header_type{};
+            item_header.file_size = item.file_size;
+            item_header.file_time = item.file_time;
+            item_header.optical_size = std::bit_cast<uint32_t>(entry.optical_size);
+            item_header.em_scale = std::bit_cast<uint32_t>(entry.em_scale);
+            item_header.metrics[0] = std::bit_cast<uint32_t>(entry.metrics.ascender);
+            item_header.metrics[1] = std::bit_cast<uint32_t>(entry.metrics.descender);
+            item_header.metrics[2] = std::bit_cast<uint32_t>(entry.metrics.line_gap);
+            item_header.metrics[3] = std::bit_cast<uint32_t>(entry.metrics.cap_height);
+            item_header.metrics[4] = std::bit_cast<uint32_t>(entry.metrics.x_height);
+            item_header.metrics[5] = std::bit_cast<uint32_t>(entry.metrics.digit_advance);
+            item_header.metrics[6] = std::bit_cast<uint32_t>(entry.metrics.line_spacing);
+            item_header.metrics[7] = std::bit_cast<uint32_t>(entry.metrics.paragraph_spacing);
+            item_header.num_horizontal_metrics = entry.num_horizontal_metrics;
+            item_header.num_glyphs = entry.num_glyphs;
+            item_header.path_size = narrow_cast<uint16_t>(path.size());
+            item_header.family_name_size = narrow_cast<uint16_t>(entry.family_name.size());
+            item_header.sub_family_name_size = narrow_cast<uint16_t>(entry.sub_family_name.size());
+            item_header.features_size = narrow_cast<uint16_t>(entry.features.size());
+            item_header.range_count = narrow_cast<uint32_t>(ranges.size());
+            item_header.flags = narrow_cast<uint8_t>(
+                (entry.monospace ? flag_monospace : 0) | (entry.serif ? flag_serif : 0) |
+                (entry.condensed ? flag_condensed : 0) | (entry.loca_is_offset32 ? flag_loca_is_offset32 : 0));
+            item_header.style = narrow_cast<uint8_t>(std::to_underlying(entry.style));
+            item_header.weight = narrow_cast<uint8_t>(std::to_underlying(entry.weight));
+            item_header.reserved = 0;
+            append(item_header);
+
+            append_string(path);
+            append_string(entry.family_name);
+            append_string(entry.sub_family_name);
+            append_string(entry.features);
+
+            for (hilet& range : ranges) {
+                auto range_buf = range_type{};
+                range_buf.start_code_point = char_cast<uint32_t>(range.start_code_point);
+                range_buf.end_code_point = char_cast<uint32_t>(range.end_code_point);
+                range_buf.start_glyph = range.start_glyph;
+                append(range_buf);
+            }
+        }
+
+        return r;
+    }
+};
+
+}} // namespace hi::v1
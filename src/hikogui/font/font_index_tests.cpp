@@ -0,0 +1,163 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "font_index.hpp"
+#include "../file/file.hpp"
+#include "../macros.hpp"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <string_view>
+
+using namespace std::literals;
+
+namespace {
+
+void write_file(std::filesystem::path const& path, std::string_view text)
+{
+    auto file = hi::file(path, hi::access_mode::truncate_or_create_for_write);
+    file.write(text);
+}
+
+[[nodiscard]] hi::font_index_entry make_entry()
+{
+    auto r = hi::font_index_entry{};
+    r.family_name = "Test Sans";
+    r.sub_family_name = "Bold Italic";
+    r.features = "kern,GPOS,";
+    r.serif = false;
+    r.monospace = true;
+    r.style = hi::font_style::italic;
+    r.weight = hi::font_weight::bold;
+    r.metrics.ascender = 0.75f;
+    r.metrics.descender = 0.25f;
+    r.metrics.x_height = 0.5f;
+    r.em_scale = 1.0f / 2048.0f;
+    r.num_horizontal_metrics = 42;
+    r.num_glyphs = 300;
+    r.loca_is_offset32 = true;
+
+    r.char_map.add(U'a', U'z', 100);
+    r.char_map.add(U'0', U'9', 200);
+    r.char_map.add(U'é', U'é', 250);
+    r.char_map.prepare();
+    return r;
+}
+
+class font_index_tests : public ::testing::Test {
+protected:
+    std::filesystem::path directory;
+    std::filesystem::path index_path;
+    std::filesystem::path font_path;
+
+    void SetUp() override
+    {
+        directory = std::filesystem::temp_directory_path() / "hikogui_font_index_tests";
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+
+        index_path = directory / "font_index.bin";
+        font_path = directory / "test.ttf";
+        write_file(font_path, "not really a font");
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(directory);
+    }
+};
+
+} // namespace
+
+TEST_F(font_index_tests, save_and_load)
+{
+    {
+        auto index = hi::font_index{index_path};
+        ASSERT_EQ(index.size(), 0);
+        ASSERT_EQ(index.find(font_path), nullptr);
+
+        index.insert(font_path, make_entry());
+        ASSERT_TRUE(index.modified());
+        index.save();
+        ASSERT_FALSE(index.modified());
+    }
+
+    auto index = hi::font_index{index_path};
+    ASSERT_EQ(index.size(), 1);
+
+    hilet entry = index.find(font_path);
+    ASSERT_NE(entry, nullptr);
+    ASSERT_EQ(entry->family_name, "Test Sans");
+    ASSERT_EQ(entry->sub_family_name, "Bold Italic");
+    ASSERT_EQ(entry->features, "kern,GPOS,");
+    ASSERT_FALSE(entry->serif);
+    ASSERT_TRUE(entry->monospace);
+    ASSERT_FALSE(entry->condensed);
+    ASSERT_EQ(entry->style, hi::font_style::italic);
+    ASSERT_EQ(entry->weight, hi::font_weight::bold);
+    ASSERT_EQ(entry->metrics.ascender, 0.75f);
+    ASSERT_EQ(entry->metrics.descender, 0.25f);
+    ASSERT_EQ(entry->metrics.x_height, 0.5f);
+    ASSERT_EQ(entry->em_scale, 1.0f / 2048.0f);
+    ASSERT_EQ(entry->num_horizontal_metrics, 42);
+    ASSERT_EQ(entry->num_glyphs, 300);
+    ASSERT_TRUE(entry->loca_is_offset32);
+
+    ASSERT_EQ(entry->char_map.count(), 26 + 10 + 1);
+    ASSERT_EQ(*entry->char_map.find(U'a'), 100);
+    ASSERT_EQ(*entry->char_map.find(U'z'), 125);
+    ASSERT_EQ(*entry->char_map.find(U'5'), 205);
+    ASSERT_EQ(*entry->char_map.find(U'é'), 250);
+    ASSERT_FALSE(entry->char_map.find(U'A'));
+}
+
+TEST_F(font_index_tests, modified_font_file)
+{
+    {
+        auto index = hi::font_index{index_path};
+        index.insert(font_path, make_entry());
+        index.save();
+    }
+
+    // The size of the font-file changes.
+    write_file(font_path, "not really a font, but longer");
+
+    auto index = hi::font_index{index_path};
+    ASSERT_EQ(index.find(font_path), nullptr);
+}
+
+TEST_F(font_index_tests, removed_font_file)
+{
+    {
+        auto index = hi::font_index{index_path};
+        index.insert(font_path, make_entry());
+        index.save();
+    }
+
+    std::filesystem::remove(font_path);
+
+    {
+        auto index = hi::font_index{index_path};
+        ASSERT_EQ(index.size(), 0);
+        // The index-file still contains the entry, it must be rewritten.
+        ASSERT_TRUE(index.modified());
+        index.save();
+    }
+
+    write_file(font_path, "not really a font");
+
+    // The entry was pruned from the index-file.
+    auto index = hi::font_index{index_path};
+    ASSERT_FALSE(index.modified());
+    ASSERT_EQ(index.size(), 0);
+}
+
+TEST_F(font_index_tests, invalid_index_file)
+{
+    // A valid header, followed by a truncated entry.
+    write_file(index_path, "HIFI\1\0\0\0\5\0\0\0garbage"sv);
+
+    auto index = hi::font_index{index_path};
+    ASSERT_EQ(index.size(), 0);
+    ASSERT_EQ(index.find(font_path), nullptr);
+}
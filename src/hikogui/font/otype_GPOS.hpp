@@ -0,0 +1,696 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "otype_utilities.hpp"
+#include "glyph_id.hpp"
+#include "../geometry/module.hpp"
+#include "../utility/utility.hpp"
+#include "../macros.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <format>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+hi_export_module(hikogui.font.otype_GPOS);
+
+hi_export namespace hi { inline namespace v1 {
+
+/** Get the bytes of a sub-table.
+ *
+ * @param bytes The bytes of the parent table.
+ * @param offset The offset of the sub-table from the start of the parent table.
+ * @return The bytes from the offset to the end of the parent table.
+ * @throws parse_error When the offset is beyond the end of the parent table.
+ */
+[[nodiscard]] inline std::span<std::byte const> otype_GPOS_subspan(std::span<std::byte const> bytes, size_t offset)
+{
+    hi_check(offset <= bytes.size(), "'GPOS' offset is beyond the end of the table.");
+    return bytes.subspan(offset);
+}
+
+/** Parse a coverage table.
+ *
+ * @param bytes The bytes of the coverage table.
+ * @return The covered glyphs in ascending order, the index in the list is the coverage index.
+ */
+[[nodiscard]] inline std::vector<uint16_t> otype_coverage_parse(std::span<std::byte const> bytes)
+{
+    struct range_type {
+        big_uint16_buf_t start_glyph_id;
+        big_uint16_buf_t end_glyph_id;
+        big_uint16_buf_t start_coverage_index;
+    };
+
+    auto offset = 0_uz;
+    hilet format = *implicit_cast<big_uint16_buf_t>(offset, bytes);
+    hilet count = *implicit_cast<big_uint16_buf_t>(offset, bytes);
+
+    auto r = std::vector<uint16_t>{};
+    if (format == 1) {
+        r.reserve(count);
+        for (hilet& glyph : implicit_cast<big_uint16_buf_t>(offset, bytes, count)) {
+            r.push_back(*glyph);
+        }
+
+    } else if (format == 2) {
+        for (hilet& range : implicit_cast<range_type>(offset, bytes, count)) {
+            hilet start_glyph_id = *range.start_glyph_id;
+            hilet end_glyph_id = *range.end_glyph_id;
+            hi_check(start_glyph_id <= end_glyph_id, "'GPOS' coverage range is invalid.");
+
+            auto coverage_index = wide_cast<size_t>(*range.start_coverage_index);
+            r.resize(std::max(r.size(), coverage_index + (end_glyph_id - start_glyph_id) + 1));
+            for (auto glyph = wide_cast<size_t>(start_glyph_id); glyph <= end_glyph_id; ++glyph) {
+                r[coverage_index++] = narrow_cast<uint16_t>(glyph);
+            }
+        }
+
+    } else {
+        throw parse_error(std::format("'GPOS' unknown coverage format {}.", format));
+    }
+
+    hi_check(std::is_sorted(r.begin(), r.end()), "'GPOS' coverage is not sorted.");
+    return r;
+}
+
+/** Find the coverage index of a glyph.
+ *
+ * @param coverage The coverage, as returned by `otype_coverage_parse()`.
+ * @param glyph_id The glyph to find.
+ * @return The coverage index, or empty if the glyph is not covered.
+ */
+[[nodiscard]] inline std::optional<size_t> otype_coverage_find(std::vector<uint16_t> const& coverage, glyph_id glyph_id) noexcept
+{
+    hilet it = std::lower_bound(coverage.begin(), coverage.end(), *glyph_id);
+    if (it != coverage.end() and *it == *glyph_id) {
+        return narrow_cast<size_t>(std::distance(coverage.begin(), it));
+    } else {
+        return std::nullopt;
+    }
+}
+
+/** A class definition table, expanded into a table indexed by glyph.
+ */
+struct otype_class_def_type {
+    uint16_t first_glyph_id = 0;
+    std::vector<uint16_t> classes;
+
+    /** Get the class of a glyph.
+     *
+     * @param glyph_id The glyph to get the class of.
+     * @param default_class The class of glyphs that are not in the table.
+     * @return The class of the glyph.
+     */
+    [[nodiscard]] uint16_t get(glyph_id glyph_id, uint16_t default_class) const noexcept
+    {
+        // Glyphs below first_glyph_id wrap around and are out of range.
+        hilet index = wide_cast<size_t>(*glyph_id) - wide_cast<size_t>(first_glyph_id);
+        return index < classes.size() ? classes[index] : default_class;
+    }
+
+    /** Get the class of a glyph.
+     *
+     * @return The class of the glyph, glyphs that are not in the table are in class 0.
+     */
+    [[nodiscard]] uint16_t operator[](glyph_id glyph_id) const noexcept
+    {
+        return get(glyph_id, 0);
+    }
+};
+
+/** Parse a class definition table.
+ *
+ * @param bytes The bytes of the class definition table.
+ * @return The class definition.
+ */
+[[nodiscard]] inline otype_class_def_type otype_class_def_parse(std::span<std::byte const> bytes)
+{
+    struct range_type {
+        big_uint16_buf_t start_glyph_id;
+        big_uint16_buf_t end_glyph_id;
+        big_uint16_buf_t class_value;
+    };
+
+    auto offset = 0_uz;
+    hilet format = *implicit_cast<big_uint16_buf_t>(offset, bytes);
+
+    auto r = otype_class_def_type{};
+    if (format == 1) {
+        r.first_glyph_id = *implicit_cast<big_uint16_buf_t>(offset, bytes);
+        hilet count = *implicit_cast<big_uint16_buf_t>(offset, bytes);
+        r.classes.reserve(count);
+        for (hilet& class_value : implicit_cast<big_uint16_buf_t>(offset, bytes, count)) {
+            r.classes.push_back(*class_value);
+        }
+
+    } else if (format == 2) {
+        hilet count = *implicit_cast<big_uint16_buf_t>(offset, bytes);
+        hilet ranges = implicit_cast<range_type>(offset, bytes, count);
+        if (ranges.empty()) {
+            return r;
+        }
+
+        auto first_glyph_id = uint16_t{0xffff};
+        auto last_glyph_id = uint16_t{0};
+        for (hilet& range : ranges) {
+            hi_check(*range.start_glyph_id <= *range.end_glyph_id, "'GPOS' class range is invalid.");
+            inplace_min(first_glyph_id, *range.start_glyph_id);
+            inplace_max(last_glyph_id, *range.end_glyph_id);
+        }
+
+        r.first_glyph_id = first_glyph_id;
+        r.classes.resize(wide_cast<size_t>(last_glyph_id) - first_glyph_id + 1, uint16_t{0});
+        for (hilet& range : ranges) {
+            std::fill(
+                r.classes.begin() + (*range.start_glyph_id - first_glyph_id),
+                r.classes.begin() + (*range.end_glyph_id - first_glyph_id + 1),
+                *range.class_value);
+        }
+
+    } else {
+        throw parse_error(std::format("'GPOS' unknown class definition format {}.", format));
+    }
+
+    return r;
+}
+
+/** Get the size of a value-record.
+ *
+ * @param value_format The format of the value-record.
+ * @return The size of the value-record in bytes.
+ */
+[[nodiscard]] constexpr size_t otype_GPOS_value_record_size(uint16_t value_format) noexcept
+{
+    return std::popcount(wide_cast<unsigned int>(value_format & 0xff)) * sizeof(big_int16_buf_t);
+}
+
+/** Get the horizontal advance adjustment from a value-record.
+ *
+ * @param bytes The bytes of the value-record.
+ * @param value_format The format of the value-record.
+ * @param em_scale The scale to convert font-units to EM.
+ * @return The adjustment of the horizontal advance.
+ */
+[[nodiscard]] inline float
+otype_GPOS_value_record_x_advance(std::span<std::byte const> bytes, uint16_t value_format, float em_scale)
+{
+    if ((value_format & 0x0004) == 0) {
+        return 0.0f;
+    }
+
+    // The X-advance follows the X-placement and Y-placement when they are present.
+    auto offset = std::popcount(wide_cast<unsigned int>(value_format & 0x0003)) * sizeof(big_int16_buf_t);
+    return implicit_cast<otype_fword_buf_t>(offset, bytes) * em_scale;
+}
+
+/** Pair adjustment positioning format 1, pairs of individual glyphs.
+ */
+struct otype_GPOS_pair_glyphs_type {
+    /** The pairs sorted by `(first_glyph_id << 16) | second_glyph_id`.
+     */
+    std::vector<uint32_t> keys;
+
+    /** The adjustment of the advance of the first glyph, one for each key.
+     */
+    std::vector<float> x_advances;
+
+    [[nodiscard]] std::optional<float> find(glyph_id first_glyph_id, glyph_id second_glyph_id) const noexcept
+    {
+        hilet key = (wide_cast<uint32_t>(*first_glyph_id) << 16) | wide_cast<uint32_t>(*second_glyph_id);
+        hilet it = std::lower_bound(keys.begin(), keys.end(), key);
+        if (it != keys.end() and *it == key) {
+            return x_advances[std::distance(keys.begin(), it)];
+        } else {
+            return std::nullopt;
+        }
+    }
+};
+
+/** Pair adjustment positioning format 2, pairs of glyph classes.
+ */
+struct otype_GPOS_pair_classes_type {
+    /** The class of each covered first glyph, indexed by glyph.
+     *
+     * Glyphs that are not covered by the sub-table have the class `not_covered`.
+     */
+    otype_class_def_type first_classes;
+    otype_class_def_type second_classes;
+
+    size_t second_class_count = 0;
+
+    /** The adjustment of the advance of the first glyph, indexed by `first_class * second_class_count + second_class`.
+     */
+    std::vector<float> x_advances;
+
+    constexpr static uint16_t not_covered = 0xffff;
+
+    [[nodiscard]] std::optional<float> find(glyph_id first_glyph_id, glyph_id second_glyph_id) const noexcept
+    {
+        hilet first_class = first_classes.get(first_glyph_id, not_covered);
+        if (first_class == not_covered) {
+            return std::nullopt;
+        }
+
+        hilet second_class = second_classes[second_glyph_id];
+        if (second_class >= second_class_count) {
+            return std::nullopt;
+        }
+
+        return x_advances[first_class * second_class_count + second_class];
+    }
+};
+
+/** Pair adjustment positioning, the sub-tables of a lookup.
+ */
+struct otype_GPOS_pair_lookup_type {
+    std::vector<std::variant<otype_GPOS_pair_glyphs_type, otype_GPOS_pair_classes_type>> sub_tables;
+
+    [[nodiscard]] std::optional<float> find(glyph_id first_glyph_id, glyph_id second_glyph_id) const noexcept
+    {
+        // The first sub-table that matches the pair is used.
+        for (hilet& sub_table : sub_tables) {
+            hilet r = std::visit(
+                [&](hilet& x) {
+                    return x.find(first_glyph_id, second_glyph_id);
+                },
+                sub_table);
+            if (r) {
+                return r;
+            }
+        }
+        return std::nullopt;
+    }
+};
+
+/** Mark-to-base and mark-to-mark attachment positioning.
+ *
+ * For mark-to-mark attachment the base is the previous mark.
+ */
+struct otype_GPOS_mark_attachment_type {
+    struct mark_type {
+        uint16_t mark_class;
+        vector2 anchor;
+    };
+
+    std::vector<uint16_t> mark_coverage;
+    std::vector<mark_type> marks;
+
+    std::vector<uint16_t> base_coverage;
+
+    /** The anchor on the base for each mark class, indexed by `base_coverage_index * mark_class_count + mark_class`.
+     */
+    std::vector<std::optional<vector2>> base_anchors;
+    size_t mark_class_count = 0;
+
+    /** Find the position of the mark.
+     *
+     * @param base_glyph_id The glyph to attach the mark to.
+     * @param mark_glyph_id The mark to attach.
+     * @return The position of the mark relative to the base, or empty if the mark can not be attached.
+     */
+    [[nodiscard]] std::optional<vector2> find(glyph_id base_glyph_id, glyph_id mark_glyph_id) const noexcept
+    {
+        hilet mark_index = otype_coverage_find(mark_coverage, mark_glyph_id);
+        if (not mark_index or *mark_index >= marks.size()) {
+            return std::nullopt;
+        }
+
+        hilet base_index = otype_coverage_find(base_coverage, base_glyph_id);
+        if (not base_index) {
+            return std::nullopt;
+        }
+
+        hilet& mark = marks[*mark_index];
+        hilet anchor_index = *base_index * mark_class_count + mark.mark_class;
+        if (anchor_index >= base_anchors.size() or not base_anchors[anchor_index]) {
+            return std::nullopt;
+        }
+
+        return *base_anchors[anchor_index] - mark.anchor;
+    }
+};
+
+/** The 'GPOS' glyph positioning table, compiled for fast lookups.
+ *
+ * Only the lookups used by the 'kern', 'mark' and 'mkmk' features are compiled,
+ * from all scripts and languages.
+ */
+struct otype_GPOS_type {
+    /** Pair adjustment lookups, in lookup order.
+     */
+    std::vector<otype_GPOS_pair_lookup_type> pair_lookups;
+
+    /** Mark-to-base attachment sub-tables, in lookup order.
+     */
+    std::vector<otype_GPOS_mark_attachment_type> mark_to_base;
+
+    /** Mark-to-mark attachment sub-tables, in lookup order.
+     */
+    std::vector<otype_GPOS_mark_attachment_type> mark_to_mark;
+
+    /** Get the kerning between two glyphs.
+     *
+     * @return The adjustment of the advance of the first glyph.
+     */
+    [[nodiscard]] float get_kerning(glyph_id first_glyph_id, glyph_id second_glyph_id) const noexcept
+    {
+        // The adjustments of each lookup are accumulated.
+        auto r = 0.0f;
+        for (hilet& lookup : pair_lookups) {
+            if (hilet x_advance = lookup.find(first_glyph_id, second_glyph_id)) {
+                r += *x_advance;
+            }
+        }
+        return r;
+    }
+
+    /** Get the position of a mark attached to a base glyph.
+     *
+     * @return The position of the mark relative to the base glyph, or empty if the mark can not be attached.
+     */
+    [[nodiscard]] std::optional<vector2> get_mark_to_base(glyph_id base_glyph_id, glyph_id mark_glyph_id) const noexcept
+    {
+        for (hilet& sub_table : mark_to_base) {
+            if (hilet r = sub_table.find(base_glyph_id, mark_glyph_id)) {
+                return r;
+            }
+        }
+        return std::nullopt;
+    }
+
+    /** Get the position of a mark attached to a previous mark.
+     *
+     * @return The position of the mark relative to the previous mark, or empty if the mark can not be attached.
+     */
+    [[nodiscard]] std::optional<vector2> get_mark_to_mark(glyph_id base_mark_glyph_id, glyph_id mark_glyph_id) const noexcept
+    {
+        for (hilet& sub_table : mark_to_mark) {
+            if (hilet r = sub_table.find(base_mark_glyph_id, mark_glyph_id)) {
+                return r;
+            }
+        }
+        return std::nullopt;
+    }
+};
+
+[[nodiscard]] inline vector2 otype_GPOS_anchor_parse(std::span<std::byte const> bytes, float em_scale)
+{
+    // The anchor formats 2 and 3 extend format 1 with contour-points and device-tables.
+    struct anchor_type {
+        big_uint16_buf_t format;
+        otype_fword_buf_t x;
+        otype_fword_buf_t y;
+    };
+
+    hilet& anchor = implicit_cast<anchor_type>(bytes);
+    hi_check(*anchor.format >= 1 and *anchor.format <= 3, "'GPOS' unknown anchor format.");
+    return vector2{anchor.x * em_scale, anchor.y * em_scale};
+}
+
+[[nodiscard]] inline otype_GPOS_pair_glyphs_type otype_GPOS_pair_glyphs_parse(std::span<std::byte const> bytes, float em_scale)
+{
+    struct header_type {
+        big_uint16_buf_t format;
+        big_uint16_buf_t coverage_offset;
+        big_uint16_buf_t value_format1;
+        big_uint16_buf_t value_format2;
+        big_uint16_buf_t pair_set_count;
+    };
+
+    auto offset = 0_uz;
+    hilet& header = implicit_cast<header_type>(offset, bytes);
+    hilet pair_set_offsets = implicit_cast<big_uint16_buf_t>(offset, bytes, *header.pair_set_count);
+    hilet coverage = otype_coverage_parse(otype_GPOS_subspan(bytes, *header.coverage_offset));
+    hi_check(coverage.size() >= pair_set_offsets.size(), "'GPOS' pair-set count is larger than the coverage.");
+
+    hilet value_format1 = *header.value_format1;
+    hilet record_size = sizeof(big_uint16_buf_t) + otype_GPOS_value_record_size(value_format1) +
+        otype_GPOS_value_record_size(*header.value_format2);
+
+    auto r = otype_GPOS_pair_glyphs_type{};
+    for (auto i = 0_uz; i != pair_set_offsets.size(); ++i) {
+        hilet first_glyph_id = wide_cast<uint32_t>(coverage[i]);
+        hilet pair_set_bytes = otype_GPOS_subspan(bytes, *pair_set_offsets[i]);
+
+        auto pair_set_offset = 0_uz;
+        hilet pair_count = *implicit_cast<big_uint16_buf_t>(pair_set_offset, pair_set_bytes);
+        for (auto j = 0_uz; j != pair_count; ++j) {
+            auto record_offset = pair_set_offset + j * record_size;
+            hilet second_glyph_id = *implicit_cast<big_uint16_buf_t>(record_offset, pair_set_bytes);
+
+            r.keys.push_back((first_glyph_id << 16) | second_glyph_id);
+            r.x_advances.push_back(
+                otype_GPOS_value_record_x_advance(otype_GPOS_subspan(pair_set_bytes, record_offset), value_format1, em_scale));
+        }
+    }
+
+    // The coverage and the pair-sets are sorted, but sort anyway to handle fonts that do not follow the specification.
+    if (not std::is_sorted(r.keys.begin(), r.keys.end())) {
+        auto indices = std::vector<size_t>(r.keys.size());
+        std::iota(indices.begin(), indices.end(), 0_uz);
+        std::stable_sort(indices.begin(), indices.end(), [&](hilet a, hilet b) {
+            return r.keys[a] < r.keys[b];
+        });
+
+        auto sorted = otype_GPOS_pair_glyphs_type{};
+        for (hilet index : indices) {
+            sorted.keys.push_back(r.keys[index]);
+            sorted.x_advances.push_back(r.x_advances[index]);
+        }
+        r = std::move(sorted);
+    }
+
+    return r;
+}
+
+[[nodiscard]] inline otype_GPOS_pair_classes_type otype_GPOS_pair_classes_parse(std::span<std::byte const> bytes, float em_scale)
+{
+    struct header_type {
+        big_uint16_buf_t format;
+        big_uint16_buf_t coverage_offset;
+        big_uint16_buf_t value_format1;
+        big_uint16_buf_t value_format2;
+        big_uint16_buf_t class_def1_offset;
+        big_uint16_buf_t class_def2_offset;
+        big_uint16_buf_t class1_count;
+        big_uint16_buf_t class2_count;
+    };
+
+    auto offset = 0_uz;
+    hilet& header = implicit_cast<header_type>(offset, bytes);
+    hilet class1_count = wide_cast<size_t>(*header.class1_count);
+    hilet class2_count = wide_cast<size_t>(*header.class2_count);
+    hilet value_format1 = *header.value_format1;
+    hilet record_size = otype_GPOS_value_record_size(value_format1) + otype_GPOS_value_record_size(*header.value_format2);
+
+    auto r = otype_GPOS_pair_classes_type{};
+    r.second_class_count = class2_count;
+    r.second_classes = otype_class_def_parse(otype_GPOS_subspan(bytes, *header.class_def2_offset));
+
+    // Only glyphs in the coverage are part of the sub-table, also the glyphs in class 0.
+    hilet coverage = otype_coverage_parse(otype_GPOS_subspan(bytes, *header.coverage_offset));
+    hilet class_def1 = otype_class_def_parse(otype_GPOS_subspan(bytes, *header.class_def1_offset));
+    if (not coverage.empty()) {
+        r.first_classes.first_glyph_id = coverage.front();
+        r.first_classes.classes.resize(coverage.back() - coverage.front() + 1, otype_GPOS_pair_classes_type::not_covered);
+        for (hilet glyph : coverage) {
+            hilet first_class = class_def1[glyph_id{glyph}];
+            r.first_classes.classes[glyph - coverage.front()] =
+                first_class < class1_count ? first_class : otype_GPOS_pair_classes_type::not_covered;
+        }
+    }
+
+    r.x_advances.reserve(class1_count * class2_count);
+    for (auto i = 0_uz; i != class1_count * class2_count; ++i) {
+        r.x_advances.push_back(otype_GPOS_value_record_x_advance(otype_GPOS_subspan(bytes, offset), value_format1, em_scale));
+        offset += record_size;
+    }
+
+    return r;
+}
+
+[[nodiscard]] inline otype_GPOS_mark_attachment_type
+otype_GPOS_mark_attachment_parse(std::span<std::byte const> bytes, float em_scale)
+{
+    struct header_type {
+        big_uint16_buf_t format;
+        big_uint16_buf_t mark_coverage_offset;
+        big_uint16_buf_t base_coverage_offset;
+        big_uint16_buf_t mark_class_count;
+        big_uint16_buf_t mark_array_offset;
+        big_uint16_buf_t base_array_offset;
+    };
+
+    struct mark_record_type {
+        big_uint16_buf_t mark_class;
+        big_uint16_buf_t anchor_offset;
+    };
+
+    hilet& header = implicit_cast<header_type>(bytes);
+    hi_check(*header.format == 1, "'GPOS' unknown mark attachment format.");
+
+    auto r = otype_GPOS_mark_attachment_type{};
+    r.mark_coverage = otype_coverage_parse(otype_GPOS_subspan(bytes, *header.mark_coverage_offset));
+    r.base_coverage = otype_coverage_parse(otype_GPOS_subspan(bytes, *header.base_coverage_offset));
+    r.mark_class_count = *header.mark_class_count;
+
+    hilet mark_array_bytes = otype_GPOS_subspan(bytes, *header.mark_array_offset);
+    auto offset = 0_uz;
+    hilet mark_count = *implicit_cast<big_uint16_buf_t>(offset, mark_array_bytes);
+    for (hilet& mark_record : implicit_cast<mark_record_type>(offset, mark_array_bytes, mark_count)) {
+        hilet mark_class = *mark_record.mark_class;
+        hi_check(mark_class < r.mark_class_count, "'GPOS' mark class is out of range.");
+        hilet anchor_bytes = otype_GPOS_subspan(mark_array_bytes, *mark_record.anchor_offset);
+        r.marks.emplace_back(mark_class, otype_GPOS_anchor_parse(anchor_bytes, em_scale));
+    }
+
+    hilet base_array_bytes = otype_GPOS_subspan(bytes, *header.base_array_offset);
+    offset = 0_uz;
+    hilet base_count = *implicit_cast<big_uint16_buf_t>(offset, base_array_bytes);
+    hilet anchor_offsets = implicit_cast<big_uint16_buf_t>(offset, base_array_bytes, base_count * r.mark_class_count);
+    r.base_anchors.reserve(anchor_offsets.size());
+    for (hilet& anchor_offset : anchor_offsets) {
+        if (*anchor_offset == 0) {
+            // This base has no anchor for this mark class.
+            r.base_anchors.emplace_back(std::nullopt);
+        } else {
+            r.base_anchors.emplace_back(otype_GPOS_anchor_parse(otype_GPOS_subspan(base_array_bytes, *anchor_offset), em_scale));
+        }
+    }
+
+    return r;
+}
+
+/** Parse the 'GPOS' table.
+ *
+ * The pair adjustments of the 'kern' feature and the mark attachments of the
+ * 'mark' and 'mkmk' features are compiled into tables that are fast to search.
+ *
+ * @param bytes The bytes of the 'GPOS' table.
+ * @param em_scale The scale to convert font-units to EM.
+ * @return The compiled 'GPOS' table.
+ */
+[[nodiscard]] inline otype_GPOS_type otype_GPOS_parse(std::span<std::byte const> bytes, float em_scale)
+{
+    struct header_type {
+        big_uint16_buf_t major_version;
+        big_uint16_buf_t minor_version;
+        big_uint16_buf_t script_list_offset;
+        big_uint16_buf_t feature_list_offset;
+        big_uint16_buf_t lookup_list_offset;
+    };
+
+    struct feature_record_type {
+        std::array<char, 4> tag;
+        big_uint16_buf_t feature_offset;
+    };
+
+    struct feature_type {
+        big_uint16_buf_t feature_params_offset;
+        big_uint16_buf_t lookup_index_count;
+    };
+
+    struct lookup_type {
+        big_uint16_buf_t lookup_type;
+        big_uint16_buf_t lookup_flag;
+        big_uint16_buf_t sub_table_count;
+    };
+
+    struct extension_type {
+        big_uint16_buf_t format;
+        big_uint16_buf_t extension_lookup_type;
+        big_uint32_buf_t extension_offset;
+    };
+
+    enum class feature_kind : uint8_t { none, kern, mark, mkmk };
+
+    hilet& header = implicit_cast<header_type>(bytes);
+    hi_check(*header.major_version == 1, "'GPOS' unknown version.");
+
+    // Find the lookups used by the features we support.
+    hilet lookup_list_bytes = otype_GPOS_subspan(bytes, *header.lookup_list_offset);
+    auto offset = 0_uz;
+    hilet lookup_count = *implicit_cast<big_uint16_buf_t>(offset, lookup_list_bytes);
+    hilet lookup_offsets = implicit_cast<big_uint16_buf_t>(offset, lookup_list_bytes, lookup_count);
+
+    auto lookup_features = std::vector<feature_kind>(lookup_count, feature_kind::none);
+
+    hilet feature_list_bytes = otype_GPOS_subspan(bytes, *header.feature_list_offset);
+    offset = 0_uz;
+    hilet feature_count = *implicit_cast<big_uint16_buf_t>(offset, feature_list_bytes);
+    for (hilet& feature_record : implicit_cast<feature_record_type>(offset, feature_list_bytes, feature_count)) {
+        hilet tag = std::string_view{feature_record.tag.data(), feature_record.tag.size()};
+        hilet kind = tag == "kern" ? feature_kind::kern :
+            tag == "mark"          ? feature_kind::mark :
+            tag == "mkmk"          ? feature_kind::mkmk :
+                                     feature_kind::none;
+        if (kind == feature_kind::none) {
+            continue;
+        }
+
+        hilet feature_bytes = otype_GPOS_subspan(feature_list_bytes, *feature_record.feature_offset);
+        auto feature_offset = 0_uz;
+        hilet& feature = implicit_cast<feature_type>(feature_offset, feature_bytes);
+        for (hilet& lookup_index : implicit_cast<big_uint16_buf_t>(feature_offset, feature_bytes, *feature.lookup_index_count)) {
+            hi_check(*lookup_index < lookup_count, "'GPOS' feature lookup-index is out of range.");
+            lookup_features[*lookup_index] = kind;
+        }
+    }
+
+    // Compile the lookups in lookup order.
+    auto r = otype_GPOS_type{};
+    for (auto i = 0_uz; i != lookup_offsets.size(); ++i) {
+        hilet kind = lookup_features[i];
+        if (kind == feature_kind::none) {
+            continue;
+        }
+
+        hilet lookup_bytes = otype_GPOS_subspan(lookup_list_bytes, *lookup_offsets[i]);
+        auto lookup_offset = 0_uz;
+        hilet& lookup = implicit_cast<lookup_type>(lookup_offset, lookup_bytes);
+        hilet sub_table_offsets = implicit_cast<big_uint16_buf_t>(lookup_offset, lookup_bytes, *lookup.sub_table_count);
+
+        auto pair_lookup = otype_GPOS_pair_lookup_type{};
+        for (hilet& sub_table_offset : sub_table_offsets) {
+            auto sub_table_bytes = otype_GPOS_subspan(lookup_bytes, *sub_table_offset);
+            auto type = *lookup.lookup_type;
+
+            if (type == 9) {
+                // Extension positioning, the sub-table is located with a 32-bit offset.
+                hilet& extension = implicit_cast<extension_type>(sub_table_bytes);
+                hi_check(*extension.format == 1, "'GPOS' unknown extension format.");
+                type = *extension.extension_lookup_type;
+                sub_table_bytes = otype_GPOS_subspan(sub_table_bytes, *extension.extension_offset);
+            }
+
+            hilet format = *implicit_cast<big_uint16_buf_t>(sub_table_bytes);
+            if (kind == feature_kind::kern and type == 2 and format == 1) {
+                pair_lookup.sub_tables.push_back(otype_GPOS_pair_glyphs_parse(sub_table_bytes, em_scale));
+            } else if (kind == feature_kind::kern and type == 2 and format == 2) {
+                pair_lookup.sub_tables.push_back(otype_GPOS_pair_classes_parse(sub_table_bytes, em_scale));
+            } else if (kind == feature_kind::mark and type == 4) {
+                r.mark_to_base.push_back(otype_GPOS_mark_attachment_parse(sub_table_bytes, em_scale));
+            } else if (kind == feature_kind::mkmk and type == 6) {
+                r.mark_to_mark.push_back(otype_GPOS_mark_attachment_parse(sub_table_bytes, em_scale));
+            }
+        }
+
+        if (not pair_lookup.sub_tables.empty()) {
+            r.pair_lookups.push_back(std::move(pair_lookup));
+        }
+    }
+
+    return r;
+}
+
+}} // namespace hi::v1
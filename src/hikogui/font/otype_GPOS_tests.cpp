@@ -0,0 +1,311 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "otype_GPOS.hpp"
+#include "../macros.hpp"
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace {
+
+/** Build a big-endian open-type table.
+ */
+class table_builder {
+public:
+    [[nodiscard]] size_t here() const noexcept
+    {
+        return _bytes.size();
+    }
+
+    void u16(int value) noexcept
+    {
+        _bytes.push_back(static_cast<std::byte>((value >> 8) & 0xff));
+        _bytes.push_back(static_cast<std::byte>(value & 0xff));
+    }
+
+    void u32(uint32_t value) noexcept
+    {
+        u16(static_cast<int>(value >> 16));
+        u16(static_cast<int>(value & 0xffff));
+    }
+
+    void tag(char const *value) noexcept
+    {
+        for (auto i = 0; i != 4; ++i) {
+            _bytes.push_back(static_cast<std::byte>(value[i]));
+        }
+    }
+
+    /** Reserve a 16-bit offset to be filled in by `patch()`.
+     */
+    [[nodiscard]] size_t offset16() noexcept
+    {
+        hilet r = here();
+        u16(0);
+        return r;
+    }
+
+    /** Fill in a 16-bit offset to the current position, relative to @a base.
+     */
+    void patch(size_t offset, size_t base) noexcept
+    {
+        hilet value = here() - base;
+        _bytes[offset] = static_cast<std::byte>((value >> 8) & 0xff);
+        _bytes[offset + 1] = static_cast<std::byte>(value & 0xff);
+    }
+
+    [[nodiscard]] std::span<std::byte const> bytes() const noexcept
+    {
+        return _bytes;
+    }
+
+private:
+    std::vector<std::byte> _bytes;
+};
+
+/** A 'GPOS' table with:
+ *  - lookup 0: 'kern' pair adjustment format 1, glyph 10 followed by 11 or 12.
+ *  - lookup 1: 'kern' extension of pair adjustment format 2, glyph classes 20-22 followed by 30-31.
+ *  - lookup 2: 'mark' mark-to-base, marks 100 and 101 on base 50.
+ */
+[[nodiscard]] table_builder make_GPOS_table() noexcept
+{
+    auto t = table_builder{};
+
+    t.u16(1);
+    t.u16(0);
+    hilet script_list_offset = t.offset16();
+    hilet feature_list_offset = t.offset16();
+    hilet lookup_list_offset = t.offset16();
+
+    t.patch(script_list_offset, 0);
+    t.u16(0);
+
+    t.patch(feature_list_offset, 0);
+    hilet feature_list = t.here();
+    t.u16(2);
+    t.tag("kern");
+    hilet kern_feature_offset = t.offset16();
+    t.tag("mark");
+    hilet mark_feature_offset = t.offset16();
+
+    t.patch(kern_feature_offset, feature_list);
+    t.u16(0);
+    t.u16(2);
+    t.u16(0);
+    t.u16(1);
+
+    t.patch(mark_feature_offset, feature_list);
+    t.u16(0);
+    t.u16(1);
+    t.u16(2);
+
+    t.patch(lookup_list_offset, 0);
+    hilet lookup_list = t.here();
+    t.u16(3);
+    hilet lookup0_offset = t.offset16();
+    hilet lookup1_offset = t.offset16();
+    hilet lookup2_offset = t.offset16();
+
+    // Pair adjustment format 1.
+    t.patch(lookup0_offset, lookup_list);
+    hilet lookup0 = t.here();
+    t.u16(2);
+    t.u16(0);
+    t.u16(1);
+    hilet pair_glyphs_offset = t.offset16();
+
+    t.patch(pair_glyphs_offset, lookup0);
+    hilet pair_glyphs = t.here();
+    t.u16(1);
+    hilet pair_glyphs_coverage_offset = t.offset16();
+    t.u16(0x0004);
+    t.u16(0x0000);
+    t.u16(1);
+    hilet pair_set_offset = t.offset16();
+
+    t.patch(pair_glyphs_coverage_offset, pair_glyphs);
+    t.u16(1);
+    t.u16(1);
+    t.u16(10);
+
+    t.patch(pair_set_offset, pair_glyphs);
+    t.u16(2);
+    t.u16(11);
+    t.u16(-50);
+    t.u16(12);
+    t.u16(-30);
+
+    // Extension of pair adjustment format 2.
+    t.patch(lookup1_offset, lookup_list);
+    hilet lookup1 = t.here();
+    t.u16(9);
+    t.u16(0);
+    t.u16(1);
+    hilet extension_offset = t.offset16();
+
+    t.patch(extension_offset, lookup1);
+    t.u16(1);
+    t.u16(2);
+    // The pair adjustment directly follows the 8 byte extension header.
+    t.u32(8);
+
+    hilet pair_classes = t.here();
+    t.u16(2);
+    hilet pair_classes_coverage_offset = t.offset16();
+    t.u16(0x0005);
+    t.u16(0x0000);
+    hilet class_def1_offset = t.offset16();
+    hilet class_def2_offset = t.offset16();
+    t.u16(2);
+    t.u16(2);
+    // class1 = 0
+    t.u16(0);
+    t.u16(0);
+    t.u16(0);
+    t.u16(-5);
+    // class1 = 1
+    t.u16(0);
+    t.u16(0);
+    t.u16(99);
+    t.u16(-20);
+
+    t.patch(pair_classes_coverage_offset, pair_classes);
+    t.u16(2);
+    t.u16(1);
+    t.u16(20);
+    t.u16(22);
+    t.u16(0);
+
+    t.patch(class_def1_offset, pair_classes);
+    t.u16(1);
+    t.u16(20);
+    t.u16(3);
+    t.u16(0);
+    t.u16(1);
+    t.u16(1);
+
+    t.patch(class_def2_offset, pair_classes);
+    t.u16(2);
+    t.u16(1);
+    t.u16(30);
+    t.u16(31);
+    t.u16(1);
+
+    // Mark-to-base attachment.
+    t.patch(lookup2_offset, lookup_list);
+    hilet lookup2 = t.here();
+    t.u16(4);
+    t.u16(0);
+    t.u16(1);
+    hilet mark_base_offset = t.offset16();
+
+    t.patch(mark_base_offset, lookup2);
+    hilet mark_base = t.here();
+    t.u16(1);
+    hilet mark_coverage_offset = t.offset16();
+    hilet base_coverage_offset = t.offset16();
+    t.u16(2);
+    hilet mark_array_offset = t.offset16();
+    hilet base_array_offset = t.offset16();
+
+    t.patch(mark_coverage_offset, mark_base);
+    t.u16(1);
+    t.u16(2);
+    t.u16(100);
+    t.u16(101);
+
+    t.patch(base_coverage_offset, mark_base);
+    t.u16(1);
+    t.u16(1);
+    t.u16(50);
+
+    t.patch(mark_array_offset, mark_base);
+    hilet mark_array = t.here();
+    t.u16(2);
+    t.u16(0);
+    hilet mark0_anchor_offset = t.offset16();
+    t.u16(1);
+    hilet mark1_anchor_offset = t.offset16();
+
+    t.patch(mark0_anchor_offset, mark_array);
+    t.u16(1);
+    t.u16(10);
+    t.u16(20);
+
+    t.patch(mark1_anchor_offset, mark_array);
+    t.u16(1);
+    t.u16(5);
+    t.u16(-5);
+
+    t.patch(base_array_offset, mark_base);
+    hilet base_array = t.here();
+    t.u16(1);
+    hilet base_class0_anchor_offset = t.offset16();
+    // No anchor for mark class 1.
+    t.u16(0);
+
+    t.patch(base_class0_anchor_offset, base_array);
+    t.u16(1);
+    t.u16(300);
+    t.u16(700);
+
+    return t;
+}
+
+} // namespace
+
+TEST(otype_GPOS, pair_glyphs)
+{
+    hilet table = make_GPOS_table();
+    hilet gpos = hi::otype_GPOS_parse(table.bytes(), 1.0f);
+
+    ASSERT_EQ(gpos.get_kerning(hi::glyph_id{10}, hi::glyph_id{11}), -50.0f);
+    ASSERT_EQ(gpos.get_kerning(hi::glyph_id{10}, hi::glyph_id{12}), -30.0f);
+    ASSERT_EQ(gpos.get_kerning(hi::glyph_id{10}, hi::glyph_id{13}), 0.0f);
+    ASSERT_EQ(gpos.get_kerning(hi::glyph_id{11}, hi::glyph_id{10}), 0.0f);
+}
+
+TEST(otype_GPOS, pair_classes)
+{
+    hilet table = make_GPOS_table();
+    hilet gpos = hi::otype_GPOS_parse(table.bytes(), 0.5f);
+
+    ASSERT_EQ(gpos.get_kerning(hi::glyph_id{20}, hi::glyph_id{31}), -2.5f);
+    ASSERT_EQ(gpos.get_kerning(hi::glyph_id{21}, hi::glyph_id{31}), -10.0f);
+    ASSERT_EQ(gpos.get_kerning(hi::glyph_id{22}, hi::glyph_id{30}), -10.0f);
+    ASSERT_EQ(gpos.get_kerning(hi::glyph_id{22}, hi::glyph_id{32}), 0.0f);
+    // Not in the coverage.
+    ASSERT_EQ(gpos.get_kerning(hi::glyph_id{19}, hi::glyph_id{31}), 0.0f);
+    ASSERT_EQ(gpos.get_kerning(hi::glyph_id{23}, hi::glyph_id{31}), 0.0f);
+}
+
+TEST(otype_GPOS, mark_to_base)
+{
+    hilet table = make_GPOS_table();
+    hilet gpos = hi::otype_GPOS_parse(table.bytes(), 1.0f);
+
+    hilet position = gpos.get_mark_to_base(hi::glyph_id{50}, hi::glyph_id{100});
+    ASSERT_TRUE(position);
+    ASSERT_EQ(position->x(), 290.0f);
+    ASSERT_EQ(position->y(), 680.0f);
+
+    // The base has no anchor for the class of this mark.
+    ASSERT_FALSE(gpos.get_mark_to_base(hi::glyph_id{50}, hi::glyph_id{101}));
+    ASSERT_FALSE(gpos.get_mark_to_base(hi::glyph_id{51}, hi::glyph_id{100}));
+    ASSERT_FALSE(gpos.get_mark_to_mark(hi::glyph_id{100}, hi::glyph_id{101}));
+}
+
+TEST(otype_GPOS, truncated)
+{
+    hilet table = make_GPOS_table();
+    hilet bytes = table.bytes();
+
+    for (auto size = size_t{0}; size != bytes.size(); ++size) {
+        ASSERT_ANY_THROW(std::ignore = hi::otype_GPOS_parse(bytes.first(size), 1.0f));
+    }
+}
@@ -0,0 +1,128 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "font_font.hpp"
+#include "../unicode/unicode.hpp"
+#include "../i18n/i18n.hpp"
+#include "../container/module.hpp"
+#include "../utility/utility.hpp"
+#include "../macros.hpp"
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+
+hi_export_module(hikogui.font.shape_run_cache);
+
+namespace hi::inline v1 {
+
+/** The number of shaped runs to keep in the `shape_run_cache`.
+ *
+ * Large enough for the runs of a table of 10'000 labels that is laid out over
+ * and over again. A least-recently-used cache that is smaller than such a
+ * cyclic working set never hits.
+ */
+constexpr std::size_t shape_run_cache_capacity = 32768;
+
+namespace detail {
+
+/** The key for a shaped run in the `shape_run_cache`.
+ */
+struct shape_run_key {
+    /** A unique id of the font that shaped the run.
+     *
+     * A unique id is used instead of the address of the font, so that a new
+     * font allocated at the address of a destroyed font does not get its results.
+     */
+    uint32_t font_id;
+    iso_639 language;
+    iso_15924 script;
+
+    /** The hash of the run.
+     *
+     * Stored before `run` so that most mismatches compare only the hash.
+     */
+    std::size_t run_hash;
+    gstring run;
+
+    shape_run_key(uint32_t font_id, iso_639 language, iso_15924 script, gstring run) noexcept :
+        font_id(font_id), language(language), script(script), run_hash(std::hash<gstring>{}(run)), run(std::move(run))
+    {
+    }
+
+    [[nodiscard]] friend bool operator==(shape_run_key const&, shape_run_key const&) noexcept = default;
+
+    [[nodiscard]] std::size_t hash() const noexcept
+    {
+        return hash_mix_two(hash_mix(font_id, language, script), run_hash);
+    }
+};
+
+struct shape_run_key_hash {
+    [[nodiscard]] std::size_t operator()(shape_run_key const& rhs) const noexcept
+    {
+        return rhs.hash();
+    }
+};
+
+/** A cache of shaped runs, split into shards that are locked separately.
+ *
+ * Threads that shape text at the same time rarely wait on each other, since
+ * they rarely need the same shard.
+ */
+class shape_run_cache_type {
+public:
+    using cache_type = lru_cache<shape_run_key, font::shape_run_result_type, shape_run_key_hash>;
+
+    /** The number of shards, must be a power of two.
+     */
+    constexpr static std::size_t nr_shards = 16;
+
+    explicit shape_run_cache_type(std::size_t capacity) noexcept
+    {
+        for (auto& shard : _shards) {
+            shard = std::make_unique<cache_type>(capacity / nr_shards);
+        }
+    }
+
+    [[nodiscard]] std::optional<font::shape_run_result_type> get(shape_run_key const& key) noexcept
+    {
+        return shard(key).get(key);
+    }
+
+    void insert(shape_run_key key, font::shape_run_result_type value) noexcept
+    {
+        auto& cache = shard(key);
+        cache.insert(std::move(key), std::move(value));
+    }
+
+private:
+    std::array<std::unique_ptr<cache_type>, nr_shards> _shards;
+
+    /** Select the shard of a key.
+     *
+     * The high bits of the hash are used, the low bits select the bucket within a shard.
+     */
+    [[nodiscard]] cache_type& shard(shape_run_key const& key) noexcept
+    {
+        constexpr auto shift = std::numeric_limits<std::size_t>::digits - std::countr_zero(nr_shards);
+        return *_shards[key.hash() >> shift];
+    }
+};
+
+} // namespace detail
+
+/** Cache of shaped runs for all fonts.
+ *
+ * Shaping a run is done each time text is laid out, while the text of labels
+ * rarely changes between layouts.
+ */
+inline auto shape_run_cache = detail::shape_run_cache_type{shape_run_cache_capacity};
+
+} // namespace hi::inline v1
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "font.hpp"
+#include "shape_run_cache.hpp"
 #include "otype_utilities.hpp"
 #include "otype_sfnt.hpp"
 #include "otype_cmap.hpp"
@@ -12,18 +13,22 @@
 #include "otype_head.hpp"
 #include "otype_hhea.hpp"
 #include "otype_hmtx.hpp"
+#include "otype_GPOS.hpp"
 #include "otype_kern.hpp"
 #include "otype_loca.hpp"
 #include "otype_maxp.hpp"
 #include "otype_name.hpp"
 #include "otype_os2.hpp"
 #include "font_char_map.hpp"
+#include "font_index.hpp"
 #include "../file/file_view.hpp"
 #include "../graphic_path/graphic_path.hpp"
 #include "../telemetry/telemetry.hpp"
 #include "../utility/utility.hpp"
 #include <memory>
 #include <filesystem>
+#include <atomic>
+#include <mutex>
 
 hi_export_module(hikogui.font.true_type_font);
 
@@ -48,6 +53,33 @@ public:
         }
     }
 
+    /** Create a font from the metadata in the font index.
+     *
+     * The font-file is not opened until the glyphs of the font are needed.
+     *
+     * @param path The location of the font-file.
+     * @param entry The metadata of the font-file.
+     */
+    true_type_font(std::filesystem::path const& path, font_index_entry const& entry) : _path(path)
+    {
+        family_name = entry.family_name;
+        sub_family_name = entry.sub_family_name;
+        features = entry.features;
+        monospace = entry.monospace;
+        serif = entry.serif;
+        style = entry.style;
+        condensed = entry.condensed;
+        weight = entry.weight;
+        optical_size = entry.optical_size;
+        metrics = entry.metrics;
+        char_map = entry.char_map;
+
+        _em_scale = entry.em_scale;
+        _num_horizontal_metrics = entry.num_horizontal_metrics;
+        num_glyphs = entry.num_glyphs;
+        _loca_is_offset32 = entry.loca_is_offset32;
+    }
+
     true_type_font() = delete;
     true_type_font(true_type_font const& other) = delete;
     true_type_font& operator=(true_type_font const& other) = delete;
@@ -55,6 +87,30 @@ public:
     true_type_font& operator=(true_type_font&& other) = delete;
     ~true_type_font() = default;
 
+    /** Get the metadata of the font to store in the font index.
+     */
+    [[nodiscard]] font_index_entry make_index_entry() const noexcept
+    {
+        auto r = font_index_entry{};
+        r.family_name = family_name;
+        r.sub_family_name = sub_family_name;
+        r.features = features;
+        r.monospace = monospace;
+        r.serif = serif;
+        r.style = style;
+        r.condensed = condensed;
+        r.weight = weight;
+        r.optical_size = optical_size;
+        r.metrics = metrics;
+        r.char_map = char_map;
+
+        r.em_scale = _em_scale;
+        r.num_horizontal_metrics = _num_horizontal_metrics;
+        r.num_glyphs = narrow_cast<uint16_t>(num_glyphs);
+        r.loca_is_offset32 = _loca_is_offset32;
+        return r;
+    }
+
     [[nodiscard]] bool loaded() const noexcept override
     {
         return to_bool(_view);
@@ -129,13 +185,28 @@ public:
 
     [[nodiscard]] shape_run_result_type shape_run(iso_639 language, iso_15924 script, gstring run) const override
     {
-        auto r = shape_run_basic(run);
+        auto key = detail::shape_run_key{_id, language, script, run};
+        if (auto cached = shape_run_cache.get(key)) {
+            ++global_counter<"shape_run_cache:hit">;
+            return *std::move(cached);
+        }
+        ++global_counter<"shape_run_cache:miss">;
+
+        auto r = shape_run_basic(std::move(run));
 
         // Glyphs should be morphed only once.
         // auto morphed = false;
         // Glyphs should be positioned only once.
         auto positioned = false;
 
+        if (not positioned) {
+            if (hilet GPOS = get_GPOS()) {
+                shape_run_GPOS(r, *GPOS);
+                // A 'GPOS' table with only mark attachment still needs kerning from the 'kern' table.
+                positioned = not GPOS->pair_lookups.empty();
+            }
+        }
+
         if (not positioned and not _kern_table_bytes.empty()) {
             try {
                 shape_run_kern(r);
@@ -146,10 +217,17 @@ public:
             }
         }
 
+        shape_run_cache.insert(std::move(key), r);
         return r;
     }
 
 private:
+    inline static std::atomic<uint32_t> _last_id = 0;
+
+    /** A unique id for this font, used as a key in the `shape_run_cache`.
+     */
+    uint32_t _id = ++_last_id;
+
     /** The url to retrieve the view.
      */
     std::filesystem::path _path;
@@ -174,8 +252,16 @@ private:
     mutable std::span<std::byte const> _hmtx_table_bytes;
     mutable std::span<std::byte const> _kern_table_bytes;
     mutable std::span<std::byte const> _GSUB_table_bytes;
+    mutable std::span<std::byte const> _GPOS_table_bytes;
     bool _loca_is_offset32;
 
+    /** The 'GPOS' table compiled for fast lookups.
+     *
+     * The table is compiled on first use and outlives the view of the font-file.
+     */
+    mutable std::unique_ptr<otype_GPOS_type> _GPOS;
+    mutable std::once_flag _GPOS_flag;
+
     void cache_tables(std::span<std::byte const> bytes) const
     {
         _loca_table_bytes = otype_sfnt_search<"loca">(bytes);
@@ -185,6 +271,28 @@ private:
         // Optional tables.
         _kern_table_bytes = otype_sfnt_search<"kern">(bytes);
         _GSUB_table_bytes = otype_sfnt_search<"GSUB">(bytes);
+        _GPOS_table_bytes = otype_sfnt_search<"GPOS">(bytes);
+    }
+
+    /** Get the compiled 'GPOS' table.
+     *
+     * @return The compiled 'GPOS' table, or nullptr if the font has no valid 'GPOS' table.
+     */
+    [[nodiscard]] otype_GPOS_type const *get_GPOS() const noexcept
+    {
+        std::call_once(_GPOS_flag, [this] {
+            load_view();
+            if (_GPOS_table_bytes.empty()) {
+                return;
+            }
+
+            try {
+                _GPOS = std::make_unique<otype_GPOS_type>(otype_GPOS_parse(_GPOS_table_bytes, _em_scale));
+            } catch (std::exception const& e) {
+                hi_log_error("Turning off invalid 'GPOS' table in font '{} {}': {}", family_name, sub_family_name, e.what());
+            }
+        });
+        return _GPOS.get();
     }
 
     void load_view() const noexcept
@@ -316,6 +424,9 @@ private:
         if (not _GSUB_table_bytes.empty()) {
             features += "GSUB,";
         }
+        if (not _GPOS_table_bytes.empty()) {
+            features += "GPOS,";
+        }
 
         if (OS2_x_height > 0.0f) {
             metrics.x_height = OS2_x_height;
@@ -401,9 +512,55 @@ private:
                 shape_result.advances[grapheme_index - 1] += kerning.x();
             }
 
+            prev_base_glyph_id = base_glyph_id;
             glyph_index += shape_result.glyph_count[grapheme_index];
         }
     }
+
+    /** Position the glyphs using the 'GPOS' table.
+     *
+     * Base-glyphs of consecutive graphemes are kerned, and marks are attached to the
+     * base-glyph or to the previous mark of the same grapheme.
+     */
+    static void shape_run_GPOS(font::shape_run_result_type& shape_result, otype_GPOS_type const& GPOS) noexcept
+    {
+        hilet num_graphemes = shape_result.advances.size();
+
+        auto prev_base_glyph_id = hi::glyph_id{};
+        auto glyph_index = 0_uz;
+        for (auto grapheme_index = 0_uz; grapheme_index != num_graphemes; ++grapheme_index) {
+            hilet base_glyph_index = glyph_index;
+            hilet base_glyph_id = shape_result.glyphs[base_glyph_index];
+
+            if (prev_base_glyph_id) {
+                hi_axiom(grapheme_index != 0);
+                shape_result.advances[grapheme_index - 1] += GPOS.get_kerning(prev_base_glyph_id, base_glyph_id);
+            }
+
+            hilet glyph_count = shape_result.glyph_count[grapheme_index];
+            for (auto i = 1_uz; i < glyph_count; ++i) {
+                hilet mark_glyph_index = base_glyph_index + i;
+                hilet mark_glyph_id = shape_result.glyphs[mark_glyph_index];
+
+                if (i > 1) {
+                    hilet prev_mark_glyph_index = mark_glyph_index - 1;
+                    hilet prev_mark_glyph_id = shape_result.glyphs[prev_mark_glyph_index];
+                    if (hilet offset = GPOS.get_mark_to_mark(prev_mark_glyph_id, mark_glyph_id)) {
+                        shape_result.glyph_positions[mark_glyph_index] =
+                            shape_result.glyph_positions[prev_mark_glyph_index] + *offset;
+                        continue;
+                    }
+                }
+
+                if (hilet offset = GPOS.get_mark_to_base(base_glyph_id, mark_glyph_id)) {
+                    shape_result.glyph_positions[mark_glyph_index] = shape_result.glyph_positions[base_glyph_index] + *offset;
+                }
+            }
+
+            prev_base_glyph_id = base_glyph_id;
+            glyph_index += glyph_count;
+        }
+    }
 };
 
 } // namespace hi::inline v1
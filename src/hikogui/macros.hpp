@@ -8,6 +8,7 @@
 #define HI_OS_WINDOWS 'W'
 #define HI_OS_MACOS 'A'
 #define HI_OS_MOBILE 'M'
+#define HI_OS_LINUX 'L'
 #define HI_OS_OTHER 'O'
 
 #if defined(_WIN32)
@@ -16,6 +17,8 @@
 #define HI_OPERATING_SYSTEM HI_OS_MACOS
 #elif defined(TARGET_OS_IPHONE) or defined(__ANDROID__)
 #define HI_OPERATING_SYSTEM HI_OS_MOBILE
+#elif defined(__linux__)
+#define HI_OPERATING_SYSTEM HI_OS_LINUX
 #else
 #define HI_OPERATING_SYSTEM HI_OS_OTHER
 #endif
@@ -109,6 +112,12 @@
 #define HI_HAS_SSE2 1
 #endif
 
+// The SHA extensions are not part of a micro-architecture level, they are enabled
+// by the compiler's target options (-msha) on top of x86-64-v2.
+#if defined(HI_X86_64_LEVEL) and HI_X86_64_LEVEL >= 2 and defined(__SHA__)
+#define HI_HAS_SHA 1
+#endif
+
 #if HI_COMPILER == HI_CC_CLANG
 #define hi_assume(condition) __builtin_assume(to_bool(condition))
 #define hi_force_inline inline __attribute__((always_inline))
@@ -585,14 +594,14 @@
 
 #define hi_log_info_once(name, fmt, ...) \
     do { \
-        if (++::hi::global_counter<name> == 1) { \
+        if (::hi::global_counter<name>.increment_is_first()) { \
             hi_log(::hi::global_state_type::log_info, fmt __VA_OPT__(, ) __VA_ARGS__); \
         } \
     } while (false)
 
 #define hi_log_error_once(name, fmt, ...) \
     do { \
-        if (++::hi::global_counter<name> == 1) { \
+        if (::hi::global_counter<name>.increment_is_first()) { \
             hi_log(::hi::global_state_type::log_error, fmt __VA_OPT__(, ) __VA_ARGS__); \
         } \
     } while (false)
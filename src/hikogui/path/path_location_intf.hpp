@@ -82,6 +82,10 @@ hi_export [[nodiscard]] std::filesystem::path log_dir() noexcept;
  */
 hi_export [[nodiscard]] std::filesystem::path preferences_file() noexcept;
 
+/** Get the full path to the index of the metadata of the font-files.
+ */
+hi_export [[nodiscard]] std::filesystem::path font_index_file() noexcept;
+
 /** The directories to search for resource files.
  */
 hi_export [[nodiscard]] inline generator<std::filesystem::path> resource_dirs() noexcept;
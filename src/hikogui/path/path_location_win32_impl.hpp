@@ -83,6 +83,12 @@ hi_export [[nodiscard]] inline std::filesystem::path preferences_file() noexcept
     return data_dir() / "preferences.json";
 }
 
+hi_export [[nodiscard]] inline std::filesystem::path font_index_file() noexcept
+{
+    // "%LOCALAPPDATA%\<Application Vendor>\<Application Name>\font_index.bin"
+    return data_dir() / "font_index.bin";
+}
+
 hi_export [[nodiscard]] inline generator<std::filesystem::path> resource_dirs() noexcept
 {
     if (auto source_path = source_dir()) {
@@ -0,0 +1,225 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+/** @file binary_log.hpp Write log messages in a compact binary format.
+ */
+
+#pragma once
+
+#include "../time/module.hpp"
+#include "../utility/utility.hpp"
+#include "../concurrency/concurrency.hpp"
+#include "../macros.hpp"
+#include <array>
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace hi::inline v1 {
+
+/** Information about a log message that is the same for each message logged from a source line.
+ */
+struct log_message_info {
+    global_state_type level;
+    std::string_view level_name;
+    std::string_view source_path;
+    int source_line;
+    std::string_view fmt;
+};
+
+/** A binary log file.
+ *
+ * Instead of formatting each message, the logger thread writes the arguments
+ * of the message as raw values. The format string and source location are
+ * written once per source line, and each message refers to them by an id.
+ * Messages are decoded and formatted offline with `tools/decode_binary_log.py`.
+ *
+ * The file starts with the 8 byte `magic` followed by records. All integers are
+ * little-endian, strings are a 32-bit length followed by UTF-8 code-units.
+ *
+ * - message_info: u8 type, u32 id, str level-name, str source-path, u32 source-line, str format.
+ * - thread_name: u8 type, u32 thread-id, str name.
+ * - message: u8 type, u32 id, i64 nanoseconds since the unix epoch, u32 thread-id, u16 cpu-id,
+ *   u8 number-of-arguments, followed by the arguments. The cpu-id is 0xffff when unknown.
+ *
+ * Each argument is a u8 `argument_type` followed by: a u8 for bool and char, an i64/u64
+ * for integers, a f64 for floating point, and a str for strings. Values of other
+ * types are formatted with `std::format("{}")` and written as a string.
+ */
+class binary_log {
+public:
+    enum class record_type : uint8_t { message_info = 1, thread_name = 2, message = 3 };
+    enum class argument_type : uint8_t {
+        boolean = 1,
+        character = 2,
+        signed_integer = 3,
+        unsigned_integer = 4,
+        floating_point = 5,
+        string = 6
+    };
+
+    constexpr static std::array<char, 8> magic = {'H', 'I', 'B', 'L', 'O', 'G', '0', '1'};
+
+    /** Number of bytes to buffer before writing to the file.
+     */
+    constexpr static std::size_t buffer_size = 65536;
+
+    /** The cpu-id written when the cpu on which the message was logged is unknown.
+     */
+    constexpr static uint16_t unknown_cpu_id = 0xffff;
+
+    static_assert(std::endian::native == std::endian::little, "The binary log format is little-endian.");
+
+    binary_log(binary_log const&) = delete;
+    binary_log(binary_log&&) = delete;
+    binary_log& operator=(binary_log const&) = delete;
+    binary_log& operator=(binary_log&&) = delete;
+
+    /** Create a binary log file.
+     *
+     * @param path The path to the log file, an existing file is overwritten.
+     * @throws io_error When the file could not be created.
+     */
+    explicit binary_log(std::filesystem::path const& path) : _file(path, std::ios::binary | std::ios::trunc)
+    {
+        if (not _file.is_open()) {
+            throw io_error(std::format("Could not create binary log file {}.", path.string()));
+        }
+        _buffer.reserve(buffer_size);
+        _buffer.append(magic.data(), magic.size());
+    }
+
+    ~binary_log()
+    {
+        flush();
+    }
+
+    /** Write the buffered records to the file.
+     */
+    void flush() noexcept
+    {
+        _file.write(_buffer.data(), _buffer.size());
+        _file.flush();
+        _buffer.clear();
+    }
+
+    /** Write a log message.
+     *
+     * @param info The information about the message that does not change between calls.
+     * @param time_stamp The time stamp of the message, including the thread-id and cpu-id.
+     * @param values The arguments of the message.
+     */
+    template<typename... Values>
+    void write(log_message_info const& info, time_stamp_count const& time_stamp, std::tuple<Values...> const& values) noexcept
+    {
+        static_assert(sizeof...(Values) <= 255);
+
+        hilet id = message_id(info);
+        hilet thread_id = time_stamp.thread_id();
+        if (_thread_ids.insert(thread_id).second) {
+            put(record_type::thread_name);
+            put(uint32_t{thread_id});
+            put(std::string_view{get_thread_name(thread_id)});
+        }
+
+        put(record_type::message);
+        put(id);
+        hilet sys_time_point = std::chrono::clock_cast<std::chrono::system_clock>(time_stamp_utc::make(time_stamp));
+        hilet sys_time_since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(sys_time_point.time_since_epoch());
+        put(narrow_cast<int64_t>(sys_time_since_epoch.count()));
+        put(uint32_t{thread_id});
+        hilet cpu_id = time_stamp.cpu_id();
+        put(cpu_id >= 0 ? narrow_cast<uint16_t>(cpu_id) : unknown_cpu_id);
+        put(narrow_cast<uint8_t>(sizeof...(Values)));
+        std::apply(
+            [this](auto const&...args) {
+                (put_argument(args), ...);
+            },
+            values);
+
+        if (_buffer.size() >= buffer_size) {
+            flush();
+        }
+    }
+
+private:
+    std::ofstream _file;
+    std::string _buffer;
+
+    /** The id of each message_info that was written to the file.
+     */
+    std::unordered_map<log_message_info const *, uint32_t> _message_ids;
+
+    /** The threads that have their name written to the file.
+     */
+    std::unordered_set<uint32_t> _thread_ids;
+
+    [[nodiscard]] uint32_t message_id(log_message_info const& info) noexcept
+    {
+        hilet [it, inserted] = _message_ids.try_emplace(&info, narrow_cast<uint32_t>(_message_ids.size()));
+        if (inserted) {
+            put(record_type::message_info);
+            put(it->second);
+            put(info.level_name);
+            put(info.source_path);
+            put(narrow_cast<uint32_t>(info.source_line));
+            put(info.fmt);
+        }
+        return it->second;
+    }
+
+    template<typename T>
+    void put(T const& value) noexcept
+        requires(std::is_trivially_copyable_v<T>)
+    {
+        hilet offset = _buffer.size();
+        _buffer.resize(offset + sizeof(T));
+        std::memcpy(_buffer.data() + offset, &value, sizeof(T));
+    }
+
+    void put(std::string_view str) noexcept
+    {
+        put(narrow_cast<uint32_t>(str.size()));
+        _buffer.append(str);
+    }
+
+    template<typename T>
+    void put_argument(T const& value) noexcept
+    {
+        if constexpr (std::is_same_v<T, bool>) {
+            put(argument_type::boolean);
+            put(uint8_t{value});
+        } else if constexpr (std::is_same_v<T, char>) {
+            put(argument_type::character);
+            put(value);
+        } else if constexpr (std::signed_integral<T>) {
+            put(argument_type::signed_integer);
+            put(int64_t{value});
+        } else if constexpr (std::unsigned_integral<T>) {
+            put(argument_type::unsigned_integer);
+            put(uint64_t{value});
+        } else if constexpr (std::floating_point<T>) {
+            put(argument_type::floating_point);
+            put(static_cast<double>(value));
+        } else if constexpr (std::is_convertible_v<T const&, std::string_view>) {
+            put(argument_type::string);
+            put(std::string_view{value});
+        } else {
+            put(argument_type::string);
+            put(std::string_view{std::format("{}", value)});
+        }
+    }
+};
+
+} // namespace hi::inline v1
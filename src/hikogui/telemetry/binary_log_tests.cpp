@@ -0,0 +1,92 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "binary_log.hpp"
+#include "../macros.hpp"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <tuple>
+
+using namespace hi;
+
+namespace {
+
+constexpr auto test_info = log_message_info{global_state_type::log_info, "info", "foo/bar.cpp", 42, "hello {} {} {}"};
+
+[[nodiscard]] std::string read_file(std::filesystem::path const& path)
+{
+    auto stream = std::ifstream{path, std::ios::binary};
+    auto r = std::stringstream{};
+    r << stream.rdbuf();
+    return r.str();
+}
+
+template<typename T>
+[[nodiscard]] T get(std::string const& data, std::size_t& offset)
+{
+    T r;
+    std::memcpy(&r, data.data() + offset, sizeof(T));
+    offset += sizeof(T);
+    return r;
+}
+
+[[nodiscard]] std::string get_string(std::string const& data, std::size_t& offset)
+{
+    hilet size = get<uint32_t>(data, offset);
+    auto r = data.substr(offset, size);
+    offset += size;
+    return r;
+}
+
+} // namespace
+
+TEST(binary_log, write)
+{
+    hilet path = std::filesystem::temp_directory_path() / "hikogui_binary_log_tests.bin";
+    {
+        auto log = binary_log{path};
+        log.write(test_info, time_stamp_count{1000, 0}, std::tuple{std::string{"world"}, 5, true});
+        log.write(test_info, time_stamp_count{2000, 0}, std::tuple{std::string{"again"}, -1, false});
+    }
+
+    hilet data = read_file(path);
+    std::filesystem::remove(path);
+
+    ASSERT_EQ(data.substr(0, 8), "HIBLOG01");
+    auto offset = 8_uz;
+
+    // The message information is written once, before the first message.
+    ASSERT_EQ(get<binary_log::record_type>(data, offset), binary_log::record_type::message_info);
+    ASSERT_EQ(get<uint32_t>(data, offset), 0);
+    ASSERT_EQ(get_string(data, offset), "info");
+    ASSERT_EQ(get_string(data, offset), "foo/bar.cpp");
+    ASSERT_EQ(get<uint32_t>(data, offset), 42);
+    ASSERT_EQ(get_string(data, offset), "hello {} {} {}");
+
+    ASSERT_EQ(get<binary_log::record_type>(data, offset), binary_log::record_type::thread_name);
+    ASSERT_EQ(get<uint32_t>(data, offset), 0);
+    std::ignore = get_string(data, offset);
+
+    for (auto i = 0; i != 2; ++i) {
+        ASSERT_EQ(get<binary_log::record_type>(data, offset), binary_log::record_type::message);
+        ASSERT_EQ(get<uint32_t>(data, offset), 0);
+        std::ignore = get<int64_t>(data, offset);
+        ASSERT_EQ(get<uint32_t>(data, offset), 0);
+        std::ignore = get<uint16_t>(data, offset);
+        ASSERT_EQ(get<uint8_t>(data, offset), 3);
+
+        ASSERT_EQ(get<binary_log::argument_type>(data, offset), binary_log::argument_type::string);
+        ASSERT_EQ(get_string(data, offset), i == 0 ? "world" : "again");
+        ASSERT_EQ(get<binary_log::argument_type>(data, offset), binary_log::argument_type::signed_integer);
+        ASSERT_EQ(get<int64_t>(data, offset), i == 0 ? 5 : -1);
+        ASSERT_EQ(get<binary_log::argument_type>(data, offset), binary_log::argument_type::boolean);
+        ASSERT_EQ(get<uint8_t>(data, offset), i == 0 ? 1 : 0);
+    }
+
+    ASSERT_EQ(offset, data.size());
+}
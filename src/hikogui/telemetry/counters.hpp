@@ -12,6 +12,11 @@
 #include "../concurrency/concurrency.hpp"
 #include "../time/module.hpp"
 #include "../macros.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <limits>
 #include <span>
 #include <typeinfo>
 #include <typeindex>
@@ -20,14 +25,111 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <utility>
 
 
 
 namespace hi::inline v1 {
 namespace detail {
 
+/** A log-linear histogram of durations.
+ *
+ * Each power-of-two range of durations is divided into `nr_sub_buckets`
+ * linear buckets, like an HDR-histogram. This gives a constant relative
+ * error of at most 1 / nr_sub_buckets over the full 64-bit range.
+ */
+class counter_histogram {
+public:
+    constexpr static std::size_t sub_bucket_bits = 3;
+    constexpr static std::size_t nr_sub_buckets = 1_uz << sub_bucket_bits;
+    constexpr static std::size_t nr_buckets = (64 - sub_bucket_bits + 1) * nr_sub_buckets;
+
+    using snapshot_type = std::array<uint64_t, nr_buckets>;
+
+    /** Get the index of the bucket for a value.
+     */
+    [[nodiscard]] constexpr static std::size_t bucket_index(uint64_t value) noexcept
+    {
+        if (value < nr_sub_buckets) {
+            return narrow_cast<std::size_t>(value);
+        }
+
+        hilet shift = std::bit_width(value) - 1 - sub_bucket_bits;
+        hilet sub_bucket = narrow_cast<std::size_t>(value >> shift) & (nr_sub_buckets - 1);
+        return (shift + 1) * nr_sub_buckets + sub_bucket;
+    }
+
+    /** Get the highest value that is counted in a bucket.
+     */
+    [[nodiscard]] constexpr static uint64_t bucket_upper_bound(std::size_t index) noexcept
+    {
+        hi_axiom(index < nr_buckets);
+        if (index < nr_sub_buckets) {
+            return index;
+        }
+
+        hilet shift = index / nr_sub_buckets - 1;
+        hilet sub_bucket = uint64_t{index % nr_sub_buckets} + nr_sub_buckets;
+        return ((sub_bucket + 1) << shift) - 1;
+    }
+
+    /** Get a percentile from the bucket counts of a histogram.
+     *
+     * @param buckets The number of values in each bucket.
+     * @param fraction The fraction of values that are less or equal to the result, between 0.0 and 1.0.
+     * @return The upper bound of the bucket which contains the percentile, or zero when the histogram is empty.
+     */
+    [[nodiscard]] static uint64_t percentile(snapshot_type const& buckets, double fraction) noexcept
+    {
+        auto total = uint64_t{0};
+        for (hilet count : buckets) {
+            total += count;
+        }
+        if (total == 0) {
+            return 0;
+        }
+
+        hilet threshold = std::max(uint64_t{1}, static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(total))));
+        auto running_total = uint64_t{0};
+        for (auto i = 0_uz; i != nr_buckets; ++i) {
+            running_total += buckets[i];
+            if (running_total >= threshold) {
+                return bucket_upper_bound(i);
+            }
+        }
+        return bucket_upper_bound(nr_buckets - 1);
+    }
+
+    void add(uint64_t value) noexcept
+    {
+        _buckets[bucket_index(value)].fetch_add(1, std::memory_order::relaxed);
+    }
+
+    /** Add the counts of this histogram to a snapshot.
+     */
+    void accumulate(snapshot_type& snapshot) const noexcept
+    {
+        for (auto i = 0_uz; i != nr_buckets; ++i) {
+            snapshot[i] += _buckets[i].load(std::memory_order::relaxed);
+        }
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, nr_buckets> _buckets = {};
+};
+
+/** A named statistics counter.
+ *
+ * The counter is sharded; each thread updates its own cache-line, and the
+ * shards are only combined when the counter is read. This makes it cheap to
+ * count events and durations from many threads at the same time.
+ */
 class counter {
 public:
+    /** The number of shards, threads share a shard when there are more threads.
+     */
+    constexpr static std::size_t nr_shards = 16;
+
     /** Get the named counter.
      *
      * @pre main() must have been started.
@@ -54,9 +156,22 @@ public:
 
     constexpr counter() noexcept {}
 
+    ~counter()
+    {
+        for (auto& shard : _shards) {
+            delete shard.histogram.load(std::memory_order::acquire);
+        }
+    }
+
+    /** The total count, combined from all the shards.
+     */
     operator uint64_t() const noexcept
     {
-        return _total_count.load(std::memory_order::relaxed);
+        auto r = uint64_t{0};
+        for (hilet& shard : _shards) {
+            r += shard.count.load(std::memory_order::relaxed);
+        }
+        return r;
     }
 
     static void log() noexcept
@@ -72,78 +187,150 @@ public:
     static void log_header() noexcept
     {
         hi_log_statistics("");
-        hi_log_statistics("{:>18} {:>9} {:>10} {:>10} {:>10}", "total", "delta", "min", "max", "mean");
-        hi_log_statistics("------------------ --------- ---------- ---------- ----------");
+        hi_log_statistics(
+            "{:>18} {:>9} {:>10} {:>10} {:>10} {:>10} {:>10} {:>10}", "total", "delta", "min", "max", "mean", "p50", "p99", "p999");
+        hi_log_statistics("------------------ --------- ---------- ---------- ---------- ---------- ---------- ----------");
     }
 
     /** Log the counter.
-     */
-    /** Log the counter.
+     *
+     * The delta, duration statistics and percentiles are over the period since
+     * the previous time the counter was logged.
+     *
+     * @note Must be called with `_mutex` locked.
      */
     void log(std::string const& tag) noexcept
     {
-        hilet total_count = _total_count.load(std::memory_order::relaxed);
-        hilet prev_count = _prev_count.exchange(_total_count, std::memory_order::relaxed);
-        hilet delta_count = total_count - prev_count;
-        if (delta_count != 0) {
-            hilet duration_max = time_stamp_count::duration_from_count(_duration_max.exchange(0, std::memory_order::relaxed));
-            hilet duration_min = time_stamp_count::duration_from_count(
-                _duration_min.exchange(std::numeric_limits<uint64_t>::max(), std::memory_order::relaxed));
-
-            hilet duration_avg = _duration_avg.exchange(0, std::memory_order::relaxed);
-            if (duration_avg == 0) {
-                hi_log_statistics("{:>18} {:>+9} {:10} {:10} {:10} {}", total_count, delta_count, "", "", "", tag);
-
-            } else {
-                hilet avg_count = duration_avg & 0xffff;
-                hilet avg_sum = duration_avg >> 16;
-                hilet average = time_stamp_count::duration_from_count(avg_sum / avg_count);
-
-                hi_log_statistics(
-                    "{:18d} {:+9d} {:>10} {:>10} {:>10} {}",
-                    total_count,
-                    delta_count,
-                    format_engineering(duration_min),
-                    format_engineering(duration_max),
-                    format_engineering(average),
-                    tag);
+        auto total_count = uint64_t{0};
+        auto duration_max = uint64_t{0};
+        auto duration_min = std::numeric_limits<uint64_t>::max();
+        auto duration_sum = uint64_t{0};
+        auto duration_count = uint64_t{0};
+        auto histogram = counter_histogram::snapshot_type{};
+        auto has_histogram = false;
+        for (auto& shard : _shards) {
+            total_count += shard.count.load(std::memory_order::relaxed);
+            duration_max = std::max(duration_max, shard.duration_max.exchange(0, std::memory_order::relaxed));
+            duration_min = std::min(
+                duration_min, shard.duration_min.exchange(std::numeric_limits<uint64_t>::max(), std::memory_order::relaxed));
+            duration_sum += shard.duration_sum.load(std::memory_order::relaxed);
+            duration_count += shard.duration_count.load(std::memory_order::relaxed);
+            if (hilet shard_histogram = shard.histogram.load(std::memory_order::acquire)) {
+                shard_histogram->accumulate(histogram);
+                has_histogram = true;
+            }
+        }
+
+        hilet delta_count = total_count - std::exchange(_prev_count, total_count);
+        hilet delta_duration_sum = duration_sum - std::exchange(_prev_duration_sum, duration_sum);
+        hilet delta_duration_count = duration_count - std::exchange(_prev_duration_count, duration_count);
+        if (has_histogram) {
+            if (not _prev_histogram) {
+                _prev_histogram = std::make_unique<counter_histogram::snapshot_type>();
+            }
+            for (auto i = 0_uz; i != histogram.size(); ++i) {
+                histogram[i] -= std::exchange((*_prev_histogram)[i], histogram[i]);
             }
         }
+
+        if (delta_count == 0) {
+            return;
+
+        } else if (delta_duration_count == 0) {
+            hi_log_statistics(
+                "{:>18} {:>+9} {:10} {:10} {:10} {:10} {:10} {:10} {}", total_count, delta_count, "", "", "", "", "", "", tag);
+
+        } else {
+            hilet to_string = [](uint64_t count) {
+                return format_engineering(time_stamp_count::duration_from_count(count));
+            };
+
+            // The percentiles are the upper bound of a bucket, which may be above the measured maximum.
+            hilet p50 = std::min(counter_histogram::percentile(histogram, 0.5), duration_max);
+            hilet p99 = std::min(counter_histogram::percentile(histogram, 0.99), duration_max);
+            hilet p999 = std::min(counter_histogram::percentile(histogram, 0.999), duration_max);
+
+            hi_log_statistics(
+                "{:18d} {:+9d} {:>10} {:>10} {:>10} {:>10} {:>10} {:>10} {}",
+                total_count,
+                delta_count,
+                to_string(duration_min),
+                to_string(duration_max),
+                to_string(delta_duration_sum / delta_duration_count),
+                to_string(p50),
+                to_string(p99),
+                to_string(p999),
+                tag);
+        }
     }
 
-    uint64_t operator++() noexcept
+    void operator++() noexcept
     {
-        return _total_count.fetch_add(1, std::memory_order::relaxed) + 1;
+        current_shard().count.fetch_add(1, std::memory_order::relaxed);
     }
 
-    uint64_t operator++(int) noexcept
+    void operator++(int) noexcept
     {
-        return _total_count.fetch_add(1, std::memory_order::relaxed);
+        current_shard().count.fetch_add(1, std::memory_order::relaxed);
     }
 
-    uint64_t operator--() noexcept
+    void operator--() noexcept
     {
-        return _total_count.fetch_sub(1, std::memory_order::relaxed) + 1;
+        current_shard().count.fetch_sub(1, std::memory_order::relaxed);
     }
 
-    uint64_t operator--(int) noexcept
+    void operator--(int) noexcept
     {
-        return _total_count.fetch_sub(1, std::memory_order::relaxed);
+        current_shard().count.fetch_sub(1, std::memory_order::relaxed);
+    }
+
+    /** Increment the counter, and check if this was the first increment.
+     *
+     * This updates an atomic shared by all threads, only use it for rare
+     * events such as in `hi_log_error_once()`.
+     *
+     * @return True on the first call for this counter.
+     */
+    [[nodiscard]] bool increment_is_first() noexcept
+    {
+        ++*this;
+        return _nr_first_increments.fetch_add(1, std::memory_order::relaxed) == 0;
     }
 
     /** Add a duration.
+     *
+     * @param duration The duration in time-stamp-counts.
      */
     void add_duration(uint64_t duration) noexcept
     {
-        _total_count.fetch_add(1, std::memory_order::relaxed);
-        fetch_max(_duration_max, duration, std::memory_order::relaxed);
-        fetch_min(_duration_min, duration, std::memory_order::relaxed);
+        auto& shard = current_shard();
+        shard.count.fetch_add(1, std::memory_order::relaxed);
+        shard.duration_sum.fetch_add(duration, std::memory_order::relaxed);
+        shard.duration_count.fetch_add(1, std::memory_order::relaxed);
+        fetch_max(shard.duration_max, duration, std::memory_order::relaxed);
+        fetch_min(shard.duration_min, duration, std::memory_order::relaxed);
+
+        auto histogram = shard.histogram.load(std::memory_order::acquire);
+        if (histogram == nullptr) [[unlikely]] {
+            histogram = make_histogram(shard);
+        }
+        histogram->add(duration);
+    }
 
-        // Combine duration with count in a single atomic.
-        hi_axiom(duration <= (std::numeric_limits<uint64_t>::max() >> 10));
-        duration <<= 16;
-        ++duration;
-        _duration_avg.fetch_add(duration, std::memory_order::relaxed);
+    /** Get a percentile of all the durations that where added.
+     *
+     * @param fraction The fraction of durations that are less or equal to the result, between 0.0 and 1.0.
+     * @return The percentile in time-stamp-counts, with the relative precision of the histogram buckets.
+     */
+    [[nodiscard]] uint64_t duration_percentile(double fraction) const noexcept
+    {
+        auto histogram = counter_histogram::snapshot_type{};
+        for (hilet& shard : _shards) {
+            if (hilet shard_histogram = shard.histogram.load(std::memory_order::acquire)) {
+                shard_histogram->accumulate(histogram);
+            }
+        }
+        return counter_histogram::percentile(histogram, fraction);
     }
 
 protected:
@@ -155,17 +342,54 @@ protected:
     constinit static inline unfair_mutex_impl<false> _mutex;
     constinit static inline atomic_unique_ptr<map_type> _map;
 
-    std::atomic<uint64_t> _total_count = 0;
-    std::atomic<uint64_t> _prev_count = 0;
-    std::atomic<uint64_t> _duration_max = 0;
-    std::atomic<uint64_t> _duration_min = std::numeric_limits<uint64_t>::max();
+private:
+    struct alignas(hardware_destructive_interference_size) shard_type {
+        std::atomic<uint64_t> count = 0;
+        std::atomic<uint64_t> duration_sum = 0;
+        std::atomic<uint64_t> duration_count = 0;
+        std::atomic<uint64_t> duration_max = 0;
+        std::atomic<uint64_t> duration_min = std::numeric_limits<uint64_t>::max();
 
-    /** Average duration.
-     *
-     * - [9:0] Count.
-     * - [63:10] Sum.
+        /** The histogram is allocated on the first duration added to the shard.
+         */
+        std::atomic<counter_histogram *> histogram = nullptr;
+    };
+
+    /** Used to give each thread its own shard.
+     */
+    inline static std::atomic<std::size_t> _nr_threads = 0;
+    inline static thread_local std::size_t _shard_index = _nr_threads.fetch_add(1, std::memory_order::relaxed) % nr_shards;
+
+    std::array<shard_type, nr_shards> _shards = {};
+
+    /** The number of calls to `increment_is_first()`.
+     */
+    std::atomic<uint64_t> _nr_first_increments = 0;
+
+    /** The values at the previous log(), protected by `_mutex`.
      */
-    std::atomic<uint64_t> _duration_avg = 0;
+    uint64_t _prev_count = 0;
+    uint64_t _prev_duration_sum = 0;
+    uint64_t _prev_duration_count = 0;
+    std::unique_ptr<counter_histogram::snapshot_type> _prev_histogram;
+
+    [[nodiscard]] hi_force_inline shard_type& current_shard() noexcept
+    {
+        return _shards[_shard_index];
+    }
+
+    hi_no_inline static counter_histogram *make_histogram(shard_type& shard) noexcept
+    {
+        auto new_histogram = new counter_histogram();
+        auto expected = static_cast<counter_histogram *>(nullptr);
+        if (shard.histogram.compare_exchange_strong(expected, new_histogram, std::memory_order::acq_rel)) {
+            return new_histogram;
+        } else {
+            // Another thread sharing this shard was first.
+            delete new_histogram;
+            return expected;
+        }
+    }
 };
 
 template<fixed_string Tag>
@@ -176,6 +400,17 @@ public:
         hilet lock = std::scoped_lock(_mutex);
         _map.get_or_make()[std::string{Tag}] = this;
     }
+
+    /** Unregister the counter, so that `counter::log()` does not read a destroyed counter.
+     */
+    ~tagged_counter()
+    {
+        hilet lock = std::scoped_lock(_mutex);
+        auto& map_ = _map.get_or_make();
+        if (hilet it = map_.find(std::string{Tag}); it != map_.end() and it->second == this) {
+            map_.erase(it);
+        }
+    }
 };
 
 } // namespace detail
@@ -8,6 +8,8 @@
 #include <gtest/gtest.h>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <vector>
 
 
 
@@ -35,3 +37,66 @@ TEST(Counters, RunTimeRead)
     ASSERT_EQ(*get_global_counter_if("foo_b"), 1);
     ASSERT_EQ(*get_global_counter_if("bar_b"), 2);
 }
+
+TEST(Counters, Threads)
+{
+    auto threads = std::vector<std::jthread>{};
+    for (auto i = 0; i != 20; ++i) {
+        threads.emplace_back([] {
+            for (auto j = 0; j != 1000; ++j) {
+                ++global_counter<"foo_c">;
+            }
+        });
+    }
+    threads.clear();
+
+    ASSERT_EQ(global_counter<"foo_c">, 20'000);
+}
+
+TEST(Counters, HistogramBuckets)
+{
+    using histogram = hi::detail::counter_histogram;
+
+    for (auto i = 0_uz; i != histogram::nr_buckets; ++i) {
+        hilet upper_bound = histogram::bucket_upper_bound(i);
+        ASSERT_EQ(histogram::bucket_index(upper_bound), i);
+        if (i + 1 != histogram::nr_buckets) {
+            ASSERT_EQ(histogram::bucket_index(upper_bound + 1), i + 1);
+        }
+    }
+
+    ASSERT_EQ(histogram::bucket_index(0), 0);
+    ASSERT_EQ(histogram::bucket_index(std::numeric_limits<uint64_t>::max()), histogram::nr_buckets - 1);
+}
+
+TEST(Counters, DurationPercentile)
+{
+    auto& counter = global_counter<"foo_d">;
+    ASSERT_EQ(counter.duration_percentile(0.5), 0);
+
+    for (auto i = 1; i <= 1000; ++i) {
+        counter.add_duration(i * 1000);
+    }
+    ASSERT_EQ(counter, 1000);
+
+    // The buckets have a relative error of at most 1/8.
+    hilet p50 = counter.duration_percentile(0.5);
+    ASSERT_GE(p50, 500'000);
+    ASSERT_LE(p50, 500'000 + 500'000 / 8);
+
+    hilet p99 = counter.duration_percentile(0.99);
+    ASSERT_GE(p99, 990'000);
+    ASSERT_LE(p99, 990'000 + 990'000 / 8);
+
+    hilet p100 = counter.duration_percentile(1.0);
+    ASSERT_GE(p100, 1'000'000);
+    ASSERT_LE(p100, 1'000'000 + 1'000'000 / 8);
+}
+
+TEST(Counters, IncrementIsFirst)
+{
+    ASSERT_TRUE(global_counter<"foo_e">.increment_is_first());
+    ASSERT_FALSE(global_counter<"foo_e">.increment_is_first());
+    ASSERT_TRUE(global_counter<"bar_e">.increment_is_first());
+    ASSERT_EQ(global_counter<"foo_e">, 2);
+}
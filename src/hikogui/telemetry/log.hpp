@@ -5,6 +5,7 @@
 #pragma once
 
 #include "delayed_format.hpp"
+#include "binary_log.hpp"
 #include "format_check.hpp"
 #include "../container/module.hpp"
 #include "../time/module.hpp"
@@ -33,8 +34,13 @@ public:
     hi_force_inline log_message_base() noexcept = default;
     virtual ~log_message_base() = default;
 
+    [[nodiscard]] virtual log_message_info const& info() const noexcept = 0;
     [[nodiscard]] virtual std::string format() const noexcept = 0;
     [[nodiscard]] virtual std::unique_ptr<log_message_base> make_unique_copy() const noexcept = 0;
+
+    /** Write the message to a binary log without formatting it.
+     */
+    virtual void write(binary_log& sink) const noexcept = 0;
 };
 
 template<global_state_type Level, fixed_string SourcePath, int SourceLine, fixed_string Fmt, typename... Values>
@@ -55,6 +61,13 @@ public:
         "<unknown log level>";
     // clang-format on
 
+    constexpr static log_message_info static_info = {
+        Level,
+        log_level_name,
+        static_cast<std::string_view>(SourcePath),
+        SourceLine,
+        static_cast<std::string_view>(Fmt)};
+
     log_message(log_message const&) noexcept = default;
     log_message& operator=(log_message const&) noexcept = default;
 
@@ -64,6 +77,11 @@ public:
     {
     }
 
+    [[nodiscard]] log_message_info const& info() const noexcept override
+    {
+        return static_info;
+    }
+
     std::string format() const noexcept override
     {
         hilet utc_time_point = time_stamp_utc::make(_time_stamp);
@@ -95,6 +113,11 @@ public:
         return std::make_unique<log_message>(*this);
     }
 
+    void write(binary_log& sink) const noexcept override
+    {
+        sink.write(static_info, _time_stamp, _what.values());
+    }
+
 private:
     time_stamp_count _time_stamp;
     delayed_format<Fmt, Values...> _what;
@@ -141,6 +164,9 @@ public:
     /** Flush all messages from the log_queue directly from this thread.
      * Flushing includes writing the message to a log file or displaying
      * them on the console.
+     *
+     * When a binary log is open, messages are written to the binary log
+     * without being formatted. Fatal messages are also displayed on the console.
      */
     hi_no_inline void flush() noexcept
     {
@@ -151,16 +177,49 @@ public:
             {
                 hilet lock = std::scoped_lock(_mutex);
 
-                wrote_message = _fifo.take_one([&copy_of_message](auto& message) {
+                wrote_message = _fifo.take_one([this, &copy_of_message](auto& message) {
+                    if (_binary_log) {
+                        message.write(*_binary_log);
+                        if (not to_bool(message.info().level & global_state_type::log_fatal)) {
+                            return;
+                        }
+                    }
                     copy_of_message = message.make_unique_copy();
                 });
             }
 
-            if (wrote_message) {
-                hi_assert_not_null(copy_of_message);
+            if (copy_of_message) {
                 write(copy_of_message->format());
             }
         } while (wrote_message);
+
+        hilet lock = std::scoped_lock(_mutex);
+        if (_binary_log) {
+            _binary_log->flush();
+        }
+    }
+
+    /** Write log messages to a binary log file, instead of formatting them.
+     *
+     * The binary log file can be decoded with `tools/decode_binary_log.py`.
+     *
+     * @param path The path to the binary log file.
+     * @throws io_error When the file could not be created.
+     */
+    void open_binary_log(std::filesystem::path const& path)
+    {
+        auto binary_log_ = std::make_unique<binary_log>(path);
+
+        hilet lock = std::scoped_lock(_mutex);
+        _binary_log = std::move(binary_log_);
+    }
+
+    /** Close the binary log file, and format log messages again.
+     */
+    void close_binary_log() noexcept
+    {
+        hilet lock = std::scoped_lock(_mutex);
+        _binary_log = nullptr;
     }
 
     /** Start the logger system.
@@ -190,6 +249,10 @@ private:
     wfree_fifo<detail::log_message_base, 64> _fifo;
     mutable unfair_mutex _mutex;
 
+    /** The binary log file, or nullptr when messages are formatted as text.
+     */
+    std::unique_ptr<binary_log> _binary_log;
+
     /** Write to a log file and console.
      * This will write to the console if one is open.
      * It will also create a log file in the application-data directory.
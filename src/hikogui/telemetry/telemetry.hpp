@@ -1,8 +1,10 @@
 
 #pragma once
 
+#include "binary_log.hpp" // export
 #include "counters.hpp" // export
 #include "log.hpp" // export
 #include "trace.hpp" // export
+#include "trace_recorder.hpp" // export
 
 hi_export_module(hikogui.telemetry);
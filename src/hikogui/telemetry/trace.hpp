@@ -7,6 +7,7 @@
 #include "../utility/utility.hpp"
 #include "../time/module.hpp"
 #include "counters.hpp"
+#include "trace_recorder.hpp"
 #include "../macros.hpp"
 #include <array>
 #include <tuple>
@@ -49,8 +50,16 @@ public:
             log();
         }
 
-        hilet current_time_stamp = time_stamp_count{time_stamp_count::inplace{}};
-        global_counter<Tag>.add_duration(current_time_stamp.count() - _time_stamp.count());
+        if (trace_recorder::global().enabled()) [[unlikely]] {
+            // The recorder needs the CPU id to convert the time-stamp to UTC.
+            hilet current_time_stamp = time_stamp_count{time_stamp_count::inplace_with_cpu_id{}};
+            global_counter<Tag>.add_duration(current_time_stamp.count() - _time_stamp.count());
+            trace_recorder::global().add(Tag, _time_stamp.count(), current_time_stamp);
+
+        } else {
+            hilet current_time_stamp = time_stamp_count{time_stamp_count::inplace{}};
+            global_counter<Tag>.add_duration(current_time_stamp.count() - _time_stamp.count());
+        }
     }
 
     void log() const noexcept override
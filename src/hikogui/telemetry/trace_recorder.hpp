@@ -0,0 +1,294 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+/** @file trace_recorder.hpp Record trace spans to a timeline file.
+ */
+
+#pragma once
+
+#include "counters.hpp"
+#include "../container/module.hpp"
+#include "../time/module.hpp"
+#include "../utility/utility.hpp"
+#include "../concurrency/concurrency.hpp"
+#include "../macros.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace hi::inline v1 {
+
+/** Records trace spans into a Chrome trace event file.
+ *
+ * While recording, each `trace<Tag>` span is added as a complete event to a
+ * ring-buffer owned by the thread that created the span. No locks are taken
+ * and nothing is shared between threads while adding an event.
+ *
+ * A background thread drains the ring-buffers, converts the time-stamp-counts
+ * to UTC using the calibration from `time_stamp_utc` and writes the events to
+ * a file in the Chrome JSON trace event format. The file can be opened with
+ * `chrome://tracing` or the Perfetto UI.
+ *
+ * Events are dropped and counted in the "trace_recorder:dropped" counter when
+ * a thread's ring-buffer is full.
+ *
+ * There is a single recorder, `trace_recorder::global()`, since the per-thread
+ * ring-buffers are registered with it.
+ */
+class trace_recorder {
+public:
+    /** The number of events that can be buffered per thread.
+     */
+    constexpr static std::size_t thread_capacity = 8192;
+
+    trace_recorder(trace_recorder const&) = delete;
+    trace_recorder(trace_recorder&&) = delete;
+    trace_recorder& operator=(trace_recorder const&) = delete;
+    trace_recorder& operator=(trace_recorder&&) = delete;
+
+    ~trace_recorder()
+    {
+        stop();
+    }
+
+    /** The trace recorder used by `hi::trace`.
+     */
+    [[nodiscard]] hi_force_inline static trace_recorder& global() noexcept
+    {
+        return _global;
+    }
+
+    /** Check if spans are being recorded.
+     */
+    [[nodiscard]] hi_force_inline bool enabled() const noexcept
+    {
+        return _enabled.load(std::memory_order::relaxed);
+    }
+
+    /** Start recording spans to a file.
+     *
+     * When the recorder is already running, the current recording is stopped first.
+     *
+     * @param path The path of the Chrome JSON trace event file to write.
+     * @throws io_error When the file could not be created.
+     */
+    void start(std::filesystem::path const& path)
+    {
+        stop();
+
+        hilet lock = std::scoped_lock(_mutex);
+        _file.open(path, std::ios::binary | std::ios::trunc);
+        if (not _file.is_open()) {
+            throw io_error(std::format("Could not create trace file {}.", path.string()));
+        }
+        _file << "[";
+        _nr_events = 0;
+
+        for (auto& buffer : _buffers) {
+            buffer->named = false;
+        }
+
+        _start_utc = time_stamp_utc::make(time_stamp_count::now());
+        _start_count = time_stamp_count::now().count();
+        _enabled.store(true, std::memory_order::relaxed);
+        _thread = std::jthread{[this](std::stop_token stop_token) {
+            thread_main(stop_token);
+        }};
+    }
+
+    /** Stop recording, and complete the file.
+     */
+    void stop() noexcept
+    {
+        if (not _thread.joinable()) {
+            return;
+        }
+
+        _enabled.store(false, std::memory_order::relaxed);
+        _thread.request_stop();
+        _thread.join();
+
+        hilet lock = std::scoped_lock(_mutex);
+        drain();
+        _file << "\n]\n";
+        _file.close();
+    }
+
+    /** Add a span to the current thread's buffer.
+     *
+     * @param name The name of the span, must point to a string with static lifetime.
+     * @param begin_count The time-stamp-count when the span began.
+     * @param end The time-stamp when the span ended, including the CPU id.
+     */
+    hi_force_inline void add(std::string_view name, uint64_t begin_count, time_stamp_count end) noexcept
+    {
+        if (_thread_buffer == nullptr) [[unlikely]] {
+            register_thread();
+        }
+
+        if (not _thread_buffer->fifo.try_emplace(name, begin_count, end)) [[unlikely]] {
+            ++global_counter<"trace_recorder:dropped">;
+        }
+    }
+
+    /** Write all buffered events to the file.
+     */
+    void flush() noexcept
+    {
+        hilet lock = std::scoped_lock(_mutex);
+        drain();
+    }
+
+private:
+    struct event_type {
+        std::string_view name;
+        uint64_t begin_count;
+        time_stamp_count end;
+    };
+
+    struct buffer_type {
+        thread_id id = current_thread_id();
+
+        /** The thread name was written to the file.
+         */
+        bool named = false;
+
+        spsc_fifo<event_type, thread_capacity> fifo;
+    };
+
+    static trace_recorder _global;
+
+    inline static thread_local std::shared_ptr<buffer_type> _thread_buffer;
+
+    std::atomic<bool> _enabled = false;
+
+    /** Protects the members below.
+     */
+    mutable unfair_mutex _mutex;
+    std::vector<std::shared_ptr<buffer_type>> _buffers;
+    std::ofstream _file;
+    std::size_t _nr_events = 0;
+    utc_nanoseconds _start_utc = {};
+    uint64_t _start_count = 0;
+
+    std::jthread _thread;
+
+    trace_recorder() = default;
+
+    hi_no_inline void register_thread() noexcept
+    {
+        _thread_buffer = std::make_shared<buffer_type>();
+
+        hilet lock = std::scoped_lock(_mutex);
+        _buffers.push_back(_thread_buffer);
+    }
+
+    void thread_main(std::stop_token stop_token) noexcept
+    {
+        using namespace std::chrono_literals;
+
+        set_thread_name("trace_recorder");
+        while (not stop_token.stop_requested()) {
+            flush();
+            std::this_thread::sleep_for(50ms);
+        }
+    }
+
+    /** Escape a string for use inside a JSON string.
+     */
+    [[nodiscard]] static std::string escape(std::string_view str) noexcept
+    {
+        auto r = std::string{};
+        r.reserve(str.size());
+        for (hilet c : str) {
+            if (c == '"' or c == '\\') {
+                r += '\\';
+                r += c;
+            } else if (hilet u = static_cast<unsigned char>(c); u < 0x20) {
+                r += "\\u00";
+                r += "0123456789abcdef"[u >> 4];
+                r += "0123456789abcdef"[u & 0xf];
+            } else {
+                r += c;
+            }
+        }
+        return r;
+    }
+
+    /** Write an event to the file.
+     *
+     * @param event_json The JSON object of the event.
+     */
+    void write_event(std::string const& event_json) noexcept
+    {
+        _file << (_nr_events++ == 0 ? "\n" : ",\n") << event_json;
+    }
+
+    /** Drain the buffers of all threads into the file.
+     *
+     * @note Must be called with `_mutex` locked.
+     */
+    void drain() noexcept
+    {
+        using namespace std::chrono_literals;
+
+        for (auto& buffer : _buffers) {
+            if (not _file.is_open()) {
+                // Not recording, discard the events.
+                buffer->fifo.take_all([](event_type const&) {});
+                continue;
+            }
+
+            if (not buffer->named and not buffer->fifo.empty()) {
+                write_event(std::format(
+                    R"({{"name":"thread_name","ph":"M","pid":1,"tid":{},"args":{{"name":"{}"}}}})",
+                    buffer->id,
+                    escape(get_thread_name(buffer->id))));
+                buffer->named = true;
+            }
+
+            buffer->fifo.take_all([this, &buffer](event_type const& event) {
+                if (event.begin_count < _start_count) {
+                    // The event was added to the buffer during a previous recording.
+                    return;
+                }
+
+                hilet end_utc = time_stamp_utc::make(event.end);
+                hilet duration = time_stamp_count::duration_from_count(event.end.count() - event.begin_count);
+                hilet begin = std::max<int64_t>(0, (end_utc - duration - _start_utc) / 1ns);
+
+                write_event(std::format(
+                    R"({{"name":"{}","ph":"X","pid":1,"tid":{},"ts":{}.{:03},"dur":{}.{:03}}})",
+                    escape(event.name),
+                    buffer->id,
+                    begin / 1000,
+                    begin % 1000,
+                    duration / 1us,
+                    (duration / 1ns) % 1000));
+            });
+        }
+
+        // Forget about buffers of threads that have exited.
+        std::erase_if(_buffers, [](hilet& buffer) {
+            return buffer.use_count() == 1 and buffer->fifo.empty();
+        });
+
+        if (_file.is_open()) {
+            _file.flush();
+        }
+    }
+};
+
+inline trace_recorder trace_recorder::_global;
+
+} // namespace hi::inline v1
@@ -0,0 +1,101 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "trace_recorder.hpp"
+#include "trace.hpp"
+#include "../macros.hpp"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace hi;
+
+namespace {
+
+[[nodiscard]] std::string read_file(std::filesystem::path const& path)
+{
+    auto stream = std::ifstream{path, std::ios::binary};
+    auto r = std::stringstream{};
+    r << stream.rdbuf();
+    return r.str();
+}
+
+[[nodiscard]] std::size_t count(std::string const& haystack, std::string const& needle)
+{
+    auto r = 0_uz;
+    for (auto i = haystack.find(needle); i != std::string::npos; i = haystack.find(needle, i + 1)) {
+        ++r;
+    }
+    return r;
+}
+
+} // namespace
+
+TEST(trace_recorder, spans)
+{
+    hilet path = std::filesystem::temp_directory_path() / "hikogui_trace_recorder_tests.json";
+
+    {
+        // Spans before recording are not written.
+        hilet t = trace<"trace_recorder_test:before">{};
+    }
+
+    trace_recorder::global().start(path);
+    {
+        hilet t1 = trace<"trace_recorder_test:outer">{};
+        hilet t2 = trace<"trace_recorder_test:inner">{};
+    }
+
+    auto threads = std::vector<std::jthread>{};
+    for (auto i = 0; i != 4; ++i) {
+        threads.emplace_back([] {
+            for (auto j = 0; j != 100; ++j) {
+                hilet t = trace<"trace_recorder_test:thread">{};
+            }
+        });
+    }
+    threads.clear();
+    trace_recorder::global().stop();
+
+    {
+        // Spans after recording are not written.
+        hilet t = trace<"trace_recorder_test:after">{};
+    }
+    trace_recorder::global().flush();
+
+    hilet json = read_file(path);
+    std::filesystem::remove(path);
+
+    ASSERT_TRUE(json.starts_with("["));
+    ASSERT_TRUE(json.ends_with("]\n"));
+    ASSERT_EQ(count(json, "\"trace_recorder_test:before\""), 0);
+    ASSERT_EQ(count(json, "\"trace_recorder_test:outer\""), 1);
+    ASSERT_EQ(count(json, "\"trace_recorder_test:inner\""), 1);
+    ASSERT_EQ(count(json, "\"trace_recorder_test:thread\""), 400);
+    ASSERT_EQ(count(json, "\"trace_recorder_test:after\""), 0);
+    ASSERT_EQ(count(json, "\"ph\":\"M\""), 5);
+}
+
+TEST(trace_recorder, escape_thread_name)
+{
+    hilet path = std::filesystem::temp_directory_path() / "hikogui_trace_recorder_escape_tests.json";
+
+    trace_recorder::global().start(path);
+    std::jthread{[] {
+        set_thread_name("trace\t\"recorder\"");
+        hilet t = trace<"trace_recorder_test:escape">{};
+    }}.join();
+    trace_recorder::global().stop();
+
+    hilet json = read_file(path);
+    std::filesystem::remove(path);
+
+    // Control characters must be escaped for the file to be valid JSON.
+    ASSERT_EQ(count(json, R"("name":"trace\u0009\"recorder\"")"), 1);
+    ASSERT_EQ(count(json, "\t"), 0);
+}
@@ -15,6 +15,9 @@
 #include "../macros.hpp"
 #include <vector>
 #include <tuple>
+#include <algorithm>
+#include <ranges>
+#include <limits>
 
 namespace hi::inline v1 {
 
@@ -86,35 +89,21 @@ public:
         _bidi_context(left_to_right ? unicode_bidi_class::L : unicode_bidi_class::R),
         _dpi_scale(dpi_scale),
         _alignment(alignment),
-        _script(script)
+        _script(script),
+        _style(style),
+        _font(std::addressof(find_font(style->family_id, style->variant)))
     {
-        hilet& font = find_font(style->family_id, style->variant);
-        _initial_line_metrics = (style->size * dpi_scale) * font.metrics;
+        _initial_line_metrics = (style->size * dpi_scale) * _font->metrics;
 
-        _text.reserve(text.size());
-        for (hilet& c : text) {
-            hilet clean_c = c == '\n' ? grapheme{unicode_PS} : c;
+        _text = make_chars(text);
 
-            auto& tmp = _text.emplace_back(clean_c, style, dpi_scale);
-            tmp.initialize_glyph(font);
-        }
-
-        _text_direction = unicode_bidi_direction(
-            _text.begin(),
-            _text.end(),
-            [](text_shaper::char_const_reference it) {
-                return it.grapheme.starter();
-            },
-            _bidi_context);
+        _text_direction = get_text_direction();
 
         _line_break_opportunities = unicode_line_break(_text.begin(), _text.end(), [](hilet& c) -> decltype(auto) {
             return c.grapheme.starter();
         });
 
-        _line_break_widths.reserve(text.size());
-        for (hilet& c : _text) {
-            _line_break_widths.push_back(is_visible(c.general_category) ? c.width : -c.width);
-        }
+        _line_break_widths = make_line_break_widths(_text.begin(), _text.end());
 
         _word_break_opportunities = unicode_word_break(_text.begin(), _text.end(), [](hilet& c) -> decltype(auto) {
             return c.grapheme.starter();
@@ -124,7 +113,7 @@ public:
             return c.grapheme.starter();
         });
 
-        resolve_script();
+        resolve_script(0, _text.size());
     }
 
     [[nodiscard]] text_shaper(
@@ -138,6 +127,108 @@ public:
     {
     }
 
+    /** Replace a range of the text.
+     *
+     * This is the incremental version of constructing a new text_shaper with
+     * the edited text, using the same style, alignment and text direction.
+     *
+     * The line, word and sentence break algorithms restart after a paragraph
+     * separator, so only the paragraphs that overlap with the replacement are
+     * analysed again. The analysis of the other paragraphs is moved into place.
+     * The next `layout()` with the same width only runs the bidi algorithm over
+     * these paragraphs.
+     *
+     * @note The lines are invalid after the replacement; the text must be laid out again using `layout()`.
+     * @param first The index of the first character to replace.
+     * @param last The index one beyond the last character to replace.
+     * @param replacement The text to replace the characters with.
+     *                    Use U+2029 as paragraph separator, and if needed U+2028 as line separator.
+     */
+    void replace(size_t first, size_t last, gstring_view replacement) noexcept
+    {
+        hi_assert(first <= last);
+        hi_assert(last <= _text.size());
+        hi_assert_not_null(_font);
+
+        _lines.clear();
+
+        auto chars = make_chars(replacement);
+        auto widths = make_line_break_widths(chars.begin(), chars.end());
+        _text.erase(_text.begin() + first, _text.begin() + last);
+        _text.insert(_text.begin() + first, std::make_move_iterator(chars.begin()), std::make_move_iterator(chars.end()));
+        _line_break_widths.erase(_line_break_widths.begin() + first, _line_break_widths.begin() + last);
+        _line_break_widths.insert(_line_break_widths.begin() + first, widths.begin(), widths.end());
+
+        // Find the paragraphs that overlap with the replacement.
+        hilet paragraph_first = [&] {
+            auto i = first;
+            while (i != 0 and _text[i - 1].general_category != unicode_general_category::Zp) {
+                --i;
+            }
+            return i;
+        }();
+
+        // The paragraph of the first character after the replacement is included, as its
+        // preceding text has changed; even when the replacement ends in a paragraph separator.
+        hilet paragraph_last = [&] {
+            auto i = first + replacement.size();
+            while (i < _text.size() and _text[i].general_category != unicode_general_category::Zp) {
+                ++i;
+            }
+            return std::min(i + 1, _text.size());
+        }();
+
+        // The end of the same paragraphs before the replacement.
+        hilet old_paragraph_last = paragraph_last + (last - first) - replacement.size();
+
+        hilet paragraph_begin = _text.begin() + paragraph_first;
+        hilet paragraph_end = _text.begin() + paragraph_last;
+        hilet get_code_point = [](hilet& c) -> decltype(auto) {
+            return c.grapheme.starter();
+        };
+
+        replace_break_opportunities(
+            _line_break_opportunities,
+            unicode_line_break(paragraph_begin, paragraph_end, get_code_point),
+            paragraph_first,
+            old_paragraph_last);
+        replace_break_opportunities(
+            _word_break_opportunities,
+            unicode_word_break(paragraph_begin, paragraph_end, get_code_point),
+            paragraph_first,
+            old_paragraph_last);
+        replace_break_opportunities(
+            _sentence_break_opportunities,
+            unicode_sentence_break(paragraph_begin, paragraph_end, get_code_point),
+            paragraph_first,
+            old_paragraph_last);
+
+        // The direction of the text is determined by the first paragraph.
+        if (paragraph_first == 0) {
+            _text_direction = get_text_direction();
+        }
+
+        resolve_script(paragraph_first, paragraph_last);
+
+        // Move the paragraphs edited since the last layout to their new position.
+        hilet move_index = [&](size_t i) {
+            if (i <= first) {
+                return i;
+            } else if (i >= last) {
+                return i + replacement.size() - (last - first);
+            } else {
+                return first + replacement.size();
+            }
+        };
+        if (_bidi_dirty_first < _bidi_dirty_last) {
+            _bidi_dirty_first = std::min(move_index(_bidi_dirty_first), paragraph_first);
+            _bidi_dirty_last = std::max(move_index(_bidi_dirty_last), paragraph_last);
+        } else {
+            _bidi_dirty_first = paragraph_first;
+            _bidi_dirty_last = paragraph_last;
+        }
+    }
+
     [[nodiscard]] bool empty() const noexcept
     {
         return _text.empty();
@@ -183,6 +274,27 @@ public:
         return _lines;
     }
 
+    /** The line break opportunities, one more than the number of characters.
+     */
+    [[nodiscard]] unicode_break_vector const& line_break_opportunities() const noexcept
+    {
+        return _line_break_opportunities;
+    }
+
+    /** The word break opportunities, one more than the number of characters.
+     */
+    [[nodiscard]] unicode_break_vector const& word_break_opportunities() const noexcept
+    {
+        return _word_break_opportunities;
+    }
+
+    /** The sentence break opportunities, one more than the number of characters.
+     */
+    [[nodiscard]] unicode_break_vector const& sentence_break_opportunities() const noexcept
+    {
+        return _sentence_break_opportunities;
+    }
+
     /** Get bounding rectangle.
      *
      * It will estimate the width and height based on the glyphs before glyph-morphing and kerning
@@ -881,6 +993,92 @@ private:
      */
     aarectangle _rectangle;
 
+    /** The style of the text, used for text added by `replace()`.
+     */
+    text_style _style;
+
+    /** The font of the text, used for text added by `replace()`.
+     */
+    font const *_font = nullptr;
+
+    /** The width of the rectangle during the last `layout()`.
+     */
+    float _bidi_width = std::numeric_limits<float>::quiet_NaN();
+
+    /** The index of the first character of the paragraphs edited since the last `layout()`.
+     */
+    size_t _bidi_dirty_first = std::numeric_limits<size_t>::max();
+
+    /** The index one beyond the last character of the paragraphs edited since the last `layout()`.
+     */
+    size_t _bidi_dirty_last = 0;
+
+    /** Make characters from graphemes, with the initial glyph loaded.
+     *
+     * @param text The text to convert, line-feeds are replaced by paragraph separators.
+     * @return The characters.
+     */
+    [[nodiscard]] char_vector make_chars(gstring_view text) const noexcept
+    {
+        auto r = char_vector{};
+        r.reserve(text.size());
+        for (hilet& c : text) {
+            hilet clean_c = c == '\n' ? grapheme{unicode_PS} : c;
+
+            auto& tmp = r.emplace_back(clean_c, _style, _dpi_scale);
+            tmp.initialize_glyph(*_font);
+        }
+        return r;
+    }
+
+    /** Get the widths of the characters used for folding lines.
+     *
+     * The width of invisible characters is negative.
+     */
+    [[nodiscard]] static std::vector<float> make_line_break_widths(char_const_iterator first, char_const_iterator last) noexcept
+    {
+        auto r = std::vector<float>{};
+        r.reserve(std::distance(first, last));
+        for (auto it = first; it != last; ++it) {
+            r.push_back(is_visible(it->general_category) ? it->width : -it->width);
+        }
+        return r;
+    }
+
+    /** Get the direction of the text as a whole, based on the first paragraph.
+     */
+    [[nodiscard]] unicode_bidi_class get_text_direction() const noexcept
+    {
+        return unicode_bidi_direction(
+            _text.begin(),
+            _text.end(),
+            [](text_shaper::char_const_reference it) {
+                return it.grapheme.starter();
+            },
+            _bidi_context);
+    }
+
+    /** Replace the break opportunities of a range of paragraphs.
+     *
+     * The opportunity at the start of a paragraph is the same as the opportunity
+     * at the end of the previous paragraph, and is therefore not replaced.
+     *
+     * @param[in,out] opportunities The break opportunities of the text.
+     * @param paragraph_opportunities The new break opportunities of the paragraphs.
+     * @param first The index of the first character of the paragraphs.
+     * @param old_last The index one beyond the last character of the paragraphs, before the replacement.
+     */
+    static void replace_break_opportunities(
+        unicode_break_vector& opportunities,
+        unicode_break_vector const& paragraph_opportunities,
+        size_t first,
+        size_t old_last) noexcept
+    {
+        hilet skip = first == 0 ? 0_uz : 1_uz;
+        hilet it = opportunities.erase(opportunities.begin() + first + skip, opportunities.begin() + old_last + 1);
+        opportunities.insert(it, paragraph_opportunities.begin() + skip, paragraph_opportunities.end());
+    }
+
     static void
     layout_lines_vertical_spacing(text_shaper::line_vector& lines, float line_spacing, float paragraph_spacing) noexcept
     {
@@ -946,22 +1144,29 @@ private:
         }
     }
 
-    /** Run the bidi-algorithm over the text and replace the columns of each line.
+    /** Run the bidi-algorithm over a paragraph and replace the columns of each line.
      *
-     * @param[in,out] lines The lines to be modified
+     * @param first The first line of the paragraph.
+     * @param last One beyond the last line of the paragraph.
      * @param[in,out] text The input text. non-const because modifications on the text is required.
      * @param writing_direction The initial writing direction.
      */
-    static void
-    bidi_algorithm(text_shaper::line_vector& lines, text_shaper::char_vector& text, unicode_bidi_context bidi_context) noexcept
+    static void bidi_algorithm(
+        text_shaper::line_iterator first,
+        text_shaper::line_iterator last,
+        text_shaper::char_vector& text,
+        unicode_bidi_context bidi_context) noexcept
     {
-        hi_assert(not lines.empty());
+        hi_assert(first != last);
+
+        hilet text_first = first->first;
+        hilet text_last = (last - 1)->last;
 
         // Create a list of all character indices.
         auto char_its = std::vector<text_shaper::char_iterator>{};
         // Make room for implicit line-separators.
-        char_its.reserve(text.size() + lines.size());
-        for (hilet& line : lines) {
+        char_its.reserve(narrow_cast<size_t>(std::distance(text_first, text_last) + std::distance(first, last)));
+        for (hilet& line : std::ranges::subrange(first, last)) {
             // Add all the characters of a line.
             for (auto it = line.first; it != line.last; ++it) {
                 char_its.push_back(it);
@@ -998,7 +1203,7 @@ private:
 
         // Add the paragraph direction for each line.
         auto par_it = paragraph_directions.cbegin();
-        for (auto& line : lines) {
+        for (auto& line : std::ranges::subrange(first, last)) {
             hi_axiom(par_it != paragraph_directions.cend());
             line.paragraph_direction = *par_it;
             if (line.last_category == unicode_general_category::Zp) {
@@ -1008,7 +1213,7 @@ private:
         hi_assert(par_it <= paragraph_directions.cend());
 
         // Add the character indices for each line in display order.
-        auto line_it = lines.begin();
+        auto line_it = first;
         line_it->columns.clear();
         auto column_nr = 0_uz;
         for (hilet char_it : char_its) {
@@ -1022,7 +1227,7 @@ private:
                 line_it->columns.clear();
                 column_nr = 0_uz;
             }
-            hi_axiom(line_it != lines.end());
+            hi_axiom(line_it != last);
             hi_axiom(char_it >= line_it->first);
             hi_axiom(char_it < line_it->last);
             line_it->columns.push_back(char_it);
@@ -1032,12 +1237,49 @@ private:
             char_it->column_nr = column_nr++;
         }
 
-        // All of the characters in the text must be positioned.
-        for (auto& c : text) {
+        // All of the characters in the paragraph must be positioned.
+        for (hilet& c : std::ranges::subrange(text_first, text_last)) {
             hi_axiom(c.line_nr != std::numeric_limits<size_t>::max() and c.column_nr != std::numeric_limits<size_t>::max());
         }
     }
 
+    /** Restore the columns of each line of a paragraph from a previous run of the bidi-algorithm.
+     *
+     * The bidi-algorithm leaves the column number and the direction in each character,
+     * and mirrors the brackets. These stay valid as long as the text of the paragraph
+     * and the way its lines are folded do not change.
+     *
+     * @param first The first line of the paragraph.
+     * @param last One beyond the last line of the paragraph.
+     */
+    void restore_bidi_algorithm(text_shaper::line_iterator first, text_shaper::line_iterator last) const noexcept
+    {
+        hi_assert(first != last);
+
+        hilet paragraph_direction = unicode_bidi_direction(
+            first->first,
+            (last - 1)->last,
+            [](text_shaper::char_const_reference it) {
+                return it.grapheme.starter();
+            },
+            _bidi_context);
+
+        for (auto& line : std::ranges::subrange(first, last)) {
+            line.paragraph_direction = paragraph_direction;
+
+            hilet num_columns = narrow_cast<size_t>(std::count_if(line.first, line.last, [](hilet& c) {
+                return c.column_nr != std::numeric_limits<size_t>::max();
+            }));
+            line.columns.assign(num_columns, line.last);
+            for (auto it = line.first; it != line.last; ++it) {
+                if (it->column_nr < line.columns.size()) {
+                    line.columns[it->column_nr] = it;
+                    it->line_nr = line.line_nr;
+                }
+            }
+        }
+    }
+
     [[nodiscard]] static generator<std::pair<std::vector<size_t>, float>>
     get_widths(unicode_break_vector const& opportunities, std::vector<float> const& widths, float dpi_scale) noexcept
     {
@@ -1172,22 +1414,72 @@ private:
     {
         hi_assert(not _lines.empty());
 
-        // The bidi algorithm will reorder the characters on each line, and mirror the brackets in the text when needed.
-        bidi_algorithm(_lines, _text, _bidi_context);
+        // When the width did not change, a paragraph that was not edited is folded into the same lines
+        // as during the previous layout, so the result of its bidi algorithm can be reused.
+        hilet same_width = rectangle.width() == _bidi_width;
+
+        auto paragraph_first = _lines.begin();
+        while (paragraph_first != _lines.end()) {
+            auto paragraph_last = std::find_if(paragraph_first, _lines.end(), [](hilet& line) {
+                return line.last_category == unicode_general_category::Zp;
+            });
+            if (paragraph_last != _lines.end()) {
+                ++paragraph_last;
+            }
+
+            hilet first = narrow_cast<size_t>(std::distance(_text.begin(), paragraph_first->first));
+            hilet last = narrow_cast<size_t>(std::distance(_text.begin(), (paragraph_last - 1)->last));
+            if (same_width and first != last and (last <= _bidi_dirty_first or first >= _bidi_dirty_last)) {
+                restore_bidi_algorithm(paragraph_first, paragraph_last);
+            } else {
+                // The bidi algorithm will reorder the characters on each line, and mirror the brackets in the text when needed.
+                bidi_algorithm(paragraph_first, paragraph_last, _text, _bidi_context);
+            }
+
+            paragraph_first = paragraph_last;
+        }
+
+        _bidi_width = rectangle.width();
+        _bidi_dirty_first = std::numeric_limits<size_t>::max();
+        _bidi_dirty_last = 0;
+
         for (auto& line : _lines) {
             // Position the glyphs on each line. Possibly morph glyphs to handle ligatures and calculate the bounding rectangles.
             line.layout(_alignment.horizontal(), rectangle.left(), rectangle.right(), sub_pixel_size.width());
         }
     }
 
-    /** Resolve the script of each character in text.
+    /** Resolve the script of each character in a range of paragraphs.
+     *
+     * @param first The index of the first character of the first paragraph.
+     * @param last The index one beyond the last character of the last paragraph.
+     */
+    void resolve_script(size_t first, size_t last) noexcept
+    {
+        while (first != last) {
+            auto paragraph_last = first;
+            while (paragraph_last != last) {
+                if (_text[paragraph_last++].general_category == unicode_general_category::Zp) {
+                    break;
+                }
+            }
+
+            resolve_paragraph_script(first, paragraph_last);
+            first = paragraph_last;
+        }
+    }
+
+    /** Resolve the script of each character in a paragraph.
+     *
+     * @param first The index of the first character of the paragraph.
+     * @param last The index one beyond the last character of the paragraph.
      */
-    void resolve_script() noexcept
+    void resolve_paragraph_script(size_t first, size_t last) noexcept
     {
-        // Find the first script in the text if no script is found use the text_shaper's default script.
+        // Find the first script in the paragraph if no script is found use the text_shaper's default script.
         auto first_script = _script;
-        for (auto& c : _text) {
-            hilet script = ucd_get_script(c.grapheme.starter());
+        for (auto i = first; i != last; ++i) {
+            hilet script = ucd_get_script(_text[i].grapheme.starter());
             if (script != iso_15924::wildcard() or script == iso_15924::uncoded() or script == iso_15924::common() or
                 script == iso_15924::inherited()) {
                 first_script = script;
@@ -1200,7 +1492,7 @@ private:
         // Close brackets will not be fixed, those will be fixed in the last forward pass.
         auto word_script = iso_15924::common();
         auto previous_script = first_script;
-        for (auto i = std::ssize(_text) - 1; i >= 0; --i) {
+        for (auto i = last; i-- != first;) {
             auto& c = _text[i];
 
             if (_word_break_opportunities[i + 1] != unicode_break_opportunity::no) {
@@ -1224,7 +1516,7 @@ private:
 
         // Forward pass: fix all common and inherited with previous or first script.
         previous_script = first_script;
-        for (auto i = 0_uz; i != _text.size(); ++i) {
+        for (auto i = first; i != last; ++i) {
             auto& c = _text[i];
 
             if (c.script == iso_15924::common() or c.script == iso_15924::inherited()) {
@@ -0,0 +1,131 @@
+// Copyright Take Vos 2024.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "text_shaper.hpp"
+#include "../path/path_location.hpp"
+#include "../macros.hpp"
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+using namespace hi;
+
+class text_shaper_tests : public ::testing::Test {
+protected:
+    inline static text_style style;
+
+    /** A narrow rectangle, so that the paragraphs are folded into multiple lines.
+     */
+    inline static auto const rectangle = aarectangle{0.0f, 0.0f, 120.0f, 1000.0f};
+
+    static void SetUpTestSuite()
+    {
+        // Text shaping requires fonts.
+        register_font_directories(font_dirs());
+
+        auto sub_styles = std::vector<text_sub_style>{};
+        sub_styles.emplace_back(
+            phrasing_mask::all,
+            iso_639{},
+            iso_15924{},
+            find_font_family("Arial"),
+            font_variant{},
+            14.0f,
+            color::black(),
+            text_decoration{});
+        style = text_style{sub_styles};
+    }
+
+    [[nodiscard]] static text_shaper make_shaper(gstring const& text) noexcept
+    {
+        auto r = text_shaper{text, style, 1.0f, alignment::top_flush(), true};
+        r.layout(rectangle, 0.0f, extent2{1.0f, 1.0f});
+        return r;
+    }
+
+    /** Check that `replace()` results in the same text_shaper as constructing one with the edited text.
+     *
+     * @param text The text before the edit.
+     * @param edits A list of replacements: first index, last index and replacement text.
+     */
+    static void check_replace(std::u32string_view text, std::vector<std::tuple<size_t, size_t, std::u32string_view>> const& edits)
+    {
+        auto edited_text = to_gstring(text);
+
+        // Laid out before the edits, so that the layout after the edits reuses the unedited paragraphs.
+        auto edited = make_shaper(edited_text);
+        for (hilet & [ first, last, replacement ] : edits) {
+            hilet replacement_text = to_gstring(replacement);
+            edited_text.replace(first, last - first, replacement_text);
+            edited.replace(first, last, replacement_text);
+        }
+        edited.layout(rectangle, 0.0f, extent2{1.0f, 1.0f});
+
+        auto expected = make_shaper(edited_text);
+
+        ASSERT_EQ(edited.size(), expected.size());
+        ASSERT_EQ(edited.text_direction(), expected.text_direction());
+        ASSERT_EQ(edited.line_break_opportunities(), expected.line_break_opportunities());
+        ASSERT_EQ(edited.word_break_opportunities(), expected.word_break_opportunities());
+        ASSERT_EQ(edited.sentence_break_opportunities(), expected.sentence_break_opportunities());
+
+        for (auto i = 0_uz; i != expected.size(); ++i) {
+            hilet& edited_char = edited.begin()[i];
+            hilet& expected_char = expected.begin()[i];
+            ASSERT_EQ(edited_char.grapheme, expected_char.grapheme) << "index " << i;
+            ASSERT_EQ(edited_char.script, expected_char.script) << "index " << i;
+            ASSERT_EQ(edited_char.direction, expected_char.direction) << "index " << i;
+            ASSERT_EQ(edited_char.line_nr, expected_char.line_nr) << "index " << i;
+            ASSERT_EQ(edited_char.column_nr, expected_char.column_nr) << "index " << i;
+        }
+
+        ASSERT_EQ(edited.lines().size(), expected.lines().size());
+        for (auto i = 0_uz; i != expected.lines().size(); ++i) {
+            ASSERT_EQ(edited.lines()[i].paragraph_direction, expected.lines()[i].paragraph_direction) << "line " << i;
+            ASSERT_EQ(edited.lines()[i].size(), expected.lines()[i].size()) << "line " << i;
+        }
+    }
+};
+
+namespace {
+
+// Paragraphs starting at index 0, 24, 60 and 79, with left-to-right and right-to-left text.
+constexpr auto test_text =
+    std::u32string_view{U"Hello (world) \u05e9\u05dc\u05d5\u05dd [x].\u2029"
+                        U"Second paragraph, 12.5 words. Done?\u2029"
+                        U"\u05e9\u05dc\u05d5\u05dd (abc) \u05e2\u05d5\u05dc\u05dd 3.\u2029"
+                        U"Last."};
+
+} // namespace
+
+TEST_F(text_shaper_tests, replace_insert)
+{
+    check_replace(test_text, {{31, 31, U"long "}});
+}
+
+TEST_F(text_shaper_tests, replace_delete_paragraph_separator)
+{
+    // Delete the paragraph separator at the end of the first paragraph, merging it with the second paragraph.
+    check_replace(test_text, {{23, 24, U""}});
+}
+
+TEST_F(text_shaper_tests, replace_insert_paragraph_separator)
+{
+    // Split the second paragraph.
+    check_replace(test_text, {{47, 47, U"and\u2029\u05e9\u05dc\u05d5\u05dd "}});
+}
+
+TEST_F(text_shaper_tests, replace_text_direction)
+{
+    // The first paragraph determines the direction of the text.
+    check_replace(test_text, {{0, 14, U""}});
+}
+
+TEST_F(text_shaper_tests, replace_multiple)
+{
+    // Several edits before the text is laid out again.
+    check_replace(test_text, {{70, 70, U"x\u2029"}, {5, 5, U" there"}, {20, 40, U"-"}});
+}
@@ -8,6 +8,7 @@
 #include "../i18n/i18n.hpp"
 #include "../telemetry/telemetry.hpp"
 #include "../concurrency/concurrency.hpp"
+#include "../container/wfree_unordered_map.hpp"
 #include "unicode_normalization.hpp"
 #include "ucd_general_categories.hpp"
 #include "ucd_canonical_combining_classes.hpp"
@@ -101,11 +102,16 @@ public:
         hi_axiom(code_points.size() >= 2);
         hi_axiom(unicode_is_NFC_grapheme(code_points.cbegin(), code_points.cend()));
 
+        // See if this grapheme already exists and return its index, without taking the lock.
+        if (hilet index = _indices.get(code_points)) {
+            return *index;
+        }
+
         hilet lock = std::scoped_lock(_mutex);
 
-        // See if this grapheme already exists and return its index.
-        if (hilet it = _indices.find(code_points); it != _indices.end()) {
-            return it->second;
+        // Another thread may have added the grapheme while we were waiting for the lock.
+        if (hilet index = _indices.get(code_points)) {
+            return *index;
         }
 
         // Check if there is enough room in the table to add the code-points.
@@ -120,8 +126,9 @@ public:
         std::copy(code_points.cbegin(), code_points.cend(), _table.begin() + insert_index);
         _table[insert_index] |= char_cast<char32_t>(code_points.size() << 21);
 
-        // Add the grapheme to the quickly searchable index table.
-        _indices.emplace(std::forward<CodePoints>(code_points), insert_index);
+        // Add the grapheme to the quickly searchable index table, this publishes
+        // the code-points in the table to threads that find the index.
+        _indices.insert(std::forward<CodePoints>(code_points), insert_index);
 
         return insert_index;
     }
@@ -137,7 +144,12 @@ private:
      */
     std::array<char32_t, 0x0f'0000> _table = {};
 
-    std::unordered_map<std::u32string, uint32_t> _indices = {};
+    /** Index of the graphemes in the table.
+     *
+     * Lookups are lock-free, so that encoding a grapheme that was seen before
+     * does not contend on `_mutex`.
+     */
+    wfree_unordered_map<std::u32string, uint32_t> _indices;
 };
 
 inline long_grapheme_table long_graphemes = {};
@@ -19,6 +19,7 @@
 #include <span>
 #include <format>
 #include <ranges>
+#include <algorithm>
 
 
 
@@ -131,3 +132,43 @@ TEST(unicode_break, line_break)
         ASSERT_EQ(test.expected, result) << test.comment;
     }
 }
+
+TEST(unicode_break, paragraph_local)
+{
+    // The text_shaper only reanalyses the edited paragraphs, which relies on
+    // the break opportunities of each paragraph being independent of the other paragraphs.
+    hilet text = std::u32string{U"He said \"Hi.\" (ok)\u2029 Second  paragraph, word's.\u2029\u2029(Third?) 12.5 end"};
+    hilet get_code_point = [](hilet code_point) -> decltype(auto) {
+        return code_point;
+    };
+
+    hilet check = [&](auto break_algorithm) {
+        hilet expected = break_algorithm(text.begin(), text.end(), get_code_point);
+
+        auto result = std::vector<hi::unicode_break_opportunity>{};
+        auto first = text.begin();
+        while (first != text.end()) {
+            auto last = std::find(first, text.end(), U'\u2029');
+            if (last != text.end()) {
+                ++last;
+            }
+
+            hilet paragraph = break_algorithm(first, last, get_code_point);
+            // The opportunity at the start of a paragraph is the end of the previous paragraph.
+            result.insert(result.end(), paragraph.begin() + (result.empty() ? 0 : 1), paragraph.end());
+            first = last;
+        }
+
+        ASSERT_EQ(expected, result);
+    };
+
+    check([](auto first, auto last, auto get_code_point) {
+        return hi::unicode_line_break(first, last, get_code_point);
+    });
+    check([](auto first, auto last, auto get_code_point) {
+        return hi::unicode_word_break(first, last, get_code_point);
+    });
+    check([](auto first, auto last, auto get_code_point) {
+        return hi::unicode_sentence_break(first, last, get_code_point);
+    });
+}
@@ -21,6 +21,7 @@
 #include <memory>
 #include <string>
 #include <array>
+#include <algorithm>
 #include <optional>
 #include <future>
 #include <limits>
@@ -164,17 +165,37 @@ public:
 
         // Read the latest text from the delegate.
         hi_assert_not_null(delegate);
-        _text_cache = delegate->read(*this);
+        auto text = delegate->read(*this);
 
         // Make sure that the current selection fits the new text.
-        _selection.resize(_text_cache.size());
+        _selection.resize(text.size());
 
         hilet actual_text_style = theme().text_style(*text_style);
-
-        // Create a new text_shaper with the new text.
         auto alignment_ = os_settings::left_to_right() ? *alignment : mirror(*alignment);
 
-        _shaped_text = text_shaper{_text_cache, actual_text_style, theme().scale, alignment_, os_settings::left_to_right()};
+        hilet shaped_text_arguments =
+            shaped_text_arguments_type{actual_text_style, theme().scale, alignment_, os_settings::left_to_right()};
+        if (_shaped_text_arguments != shaped_text_arguments) {
+            // Create a new text_shaper with the new text.
+            _shaped_text_arguments = shaped_text_arguments;
+            _shaped_text = text_shaper{text, actual_text_style, theme().scale, alignment_, os_settings::left_to_right()};
+
+        } else if (
+            _text_edit and text.size() == _text_cache.size() and
+            std::equal(
+                text.cbegin() + _text_edit->first,
+                text.cbegin() + _text_edit->first + _text_edit->size,
+                _text_cache.cbegin() + _text_edit->first)) {
+            // The delegate stored the text as edited by this widget, only shape the edited paragraphs again.
+            _shaped_text.replace(
+                _text_edit->first, _text_edit->last, gstring_view{_text_cache}.substr(_text_edit->first, _text_edit->size));
+
+        } else if (_text_edit or _text_cache != text) {
+            // The text was changed by something other than this widget.
+            _shaped_text = text_shaper{text, actual_text_style, theme().scale, alignment_, os_settings::left_to_right()};
+        }
+        _text_edit = std::nullopt;
+        _text_cache = std::move(text);
 
         hilet shaped_text_rectangle = ceil(_shaped_text.bounding_rectangle(std::numeric_limits<float>::infinity()));
         hilet shaped_text_size = shaped_text_rectangle.size();
@@ -767,8 +788,37 @@ private:
 
     enum class cursor_state_type { off, on, busy, none };
 
+    /** An edit of `_text_cache` by this widget that is not yet applied to `_shaped_text`.
+     */
+    struct text_edit_type {
+        /** The index of the first replaced grapheme.
+         */
+        size_t first;
+
+        /** The index one beyond the last replaced grapheme, before the edit.
+         */
+        size_t last;
+
+        /** The number of graphemes that replaced them.
+         */
+        size_t size;
+    };
+
+    /** The arguments, other than the text, used to construct `_shaped_text`.
+     */
+    struct shaped_text_arguments_type {
+        hi::text_style style;
+        float dpi_scale;
+        hi::alignment alignment;
+        bool left_to_right;
+
+        [[nodiscard]] friend bool operator==(shaped_text_arguments_type const&, shaped_text_arguments_type const&) noexcept = default;
+    };
+
     gstring _text_cache;
+    std::optional<text_edit_type> _text_edit;
     text_shaper _shaped_text;
+    std::optional<shaped_text_arguments_type> _shaped_text_arguments;
 
     mutable box_constraints _constraints_cache;
 
@@ -904,6 +954,9 @@ private:
         if (_undo_stack.can_undo()) {
             hilet & [ text, selection ] = _undo_stack.undo(_text_cache, _selection);
 
+            // Shape the whole text again.
+            _text_edit = std::nullopt;
+            _shaped_text_arguments = std::nullopt;
             delegate->write(*this, text);
             _selection = selection;
         }
@@ -914,6 +967,9 @@ private:
         if (_undo_stack.can_redo()) {
             hilet & [ text, selection ] = _undo_stack.redo();
 
+            // Shape the whole text again.
+            _text_edit = std::nullopt;
+            _shaped_text_arguments = std::nullopt;
             delegate->write(*this, text);
             _selection = selection;
         }
@@ -962,6 +1018,36 @@ private:
     }
 
 
+    /** Replace a range of the text and write the text to the delegate.
+     *
+     * The range is remembered, so that only the edited paragraphs are shaped again
+     * when the delegate reports the change.
+     *
+     * @param first The index of the first grapheme to replace.
+     * @param last The index one beyond the last grapheme to replace.
+     * @param replacement The graphemes to replace the range with.
+     */
+    void replace_text(size_t first, size_t last, gstring_view replacement) noexcept
+    {
+        hi_assert(first <= last);
+        hi_assert(last <= _text_cache.size());
+
+        if (_text_edit) {
+            // Merge with the previous edit, in the positions of the text between both edits.
+            hilet edit_first = std::min(_text_edit->first, first);
+            hilet edit_last = std::max(_text_edit->first + _text_edit->size, last);
+            _text_edit = text_edit_type{
+                edit_first,
+                edit_last - _text_edit->size + (_text_edit->last - _text_edit->first),
+                edit_last - edit_first - (last - first) + replacement.size()};
+        } else {
+            _text_edit = text_edit_type{first, last, replacement.size()};
+        }
+
+        _text_cache.replace(first, last - first, replacement);
+        delegate->write(*this, _text_cache);
+    }
+
     /** This function replaces the current selection with replacement text.
      */
     void replace_selection(gstring const& replacement) noexcept
@@ -969,10 +1055,7 @@ private:
         undo_push();
 
         hilet[first, last] = _selection.selection_indices();
-
-        auto text = _text_cache;
-        text.replace(first, last - first, replacement);
-        delegate->write(*this, text);
+        replace_text(first, last, replacement);
 
         _selection = text_cursor{first + replacement.size() - 1, true};
         fix_cursor_position();
@@ -1012,14 +1095,12 @@ private:
             hi_assert(_selection.cursor().before());
             hi_assert_bounds(_selection.cursor().index(), _text_cache);
 
+            hilet index = _selection.cursor().index();
             if (_has_dead_character != U'\uffff') {
-                auto text = _text_cache;
-                text[_selection.cursor().index()] = *_has_dead_character;
-                delegate->write(*this, text);
+                hilet original_grapheme = *_has_dead_character;
+                replace_text(index, index + 1, gstring_view{&original_grapheme, 1});
             } else {
-                auto text = _text_cache;
-                text.erase(_selection.cursor().index(), 1);
-                delegate->write(*this, text);
+                replace_text(index, index + 1, gstring_view{});
             }
         }
         _has_dead_character = std::nullopt;
@@ -0,0 +1,280 @@
+#!/usr/bin/env python3
+#
+# Decode a binary log file written by hi::binary_log into text.
+#
+# usage: decode_binary_log.py <binary log file>
+#
+# The format strings are std::format strings; the arguments are formatted here
+# following the std::format rules for bool, char, integer, floating point and
+# string arguments. The cpu-id of a message is 0xffff when it is unknown, it is
+# printed as "?".
+
+import datetime
+import decimal
+import json
+import math
+import os
+import re
+import struct
+import sys
+
+MAGIC = b"HIBLOG01"
+
+RECORD_MESSAGE_INFO = 1
+RECORD_THREAD_NAME = 2
+RECORD_MESSAGE = 3
+
+ARGUMENT_BOOLEAN = 1
+ARGUMENT_CHARACTER = 2
+ARGUMENT_SIGNED_INTEGER = 3
+ARGUMENT_UNSIGNED_INTEGER = 4
+ARGUMENT_FLOATING_POINT = 5
+ARGUMENT_STRING = 6
+
+UNKNOWN_CPU_ID = 0xffff
+
+# [[fill]align][sign][#][0][width][.precision][L][type]
+# Nested replacement fields for width and precision are substituted by str.format()
+# before the specification is passed to __format__().
+SPEC_RE = re.compile(
+    r"^(?P<fill_align>(?:.?[<>^])?)(?P<sign>[-+ ]?)(?P<alternate>#?)(?P<zero>0?)"
+    r"(?P<width>[0-9]*)(?P<precision>(?:\.[0-9]*)?)L?(?P<type>[a-zA-Z?]?)$",
+    re.DOTALL)
+
+
+def parse_spec(spec):
+    m = SPEC_RE.match(spec)
+    if m is None:
+        raise ValueError("Invalid format specification '{}'".format(spec))
+    return m.groupdict()
+
+
+def python_spec(s, type):
+    """Make a python format specification, without the locale flag."""
+    return s["fill_align"] + s["sign"] + s["alternate"] + s["zero"] + s["width"] + s["precision"] + type
+
+
+def pad_number(text, s):
+    """Apply the sign, zero-padding, fill and alignment to a formatted number."""
+    sign = ""
+    if text.startswith("-"):
+        sign, text = "-", text[1:]
+    elif s["sign"] in ("+", " "):
+        sign = s["sign"]
+
+    if s["fill_align"] == "" and s["zero"] != "":
+        return sign + text.rjust(int(s["width"] or 0) - len(sign), "0")
+    return format(sign + text, (s["fill_align"] or ">") + s["width"])
+
+
+def format_integer(value, s):
+    if s["type"] == "B":
+        # Python has no 'B' type, std::format uses a "0B" prefix for the alternate form.
+        return format(value, python_spec(s, "b")).replace("0b", "0B")
+    return format(value, python_spec(s, s["type"]))
+
+
+def shortest_float(value):
+    """Format like std::to_chars(value), the shortest of fixed and scientific notation."""
+    if math.isinf(value) or math.isnan(value):
+        return repr(value)
+
+    sign = "-" if math.copysign(1.0, value) < 0.0 else ""
+    _, digits, exponent = decimal.Decimal(repr(abs(value))).normalize().as_tuple()
+    digits = "".join(str(x) for x in digits)
+
+    point = len(digits) + exponent
+    if exponent >= 0:
+        fixed = digits + "0" * exponent
+    elif point > 0:
+        fixed = digits[:point] + "." + digits[point:]
+    else:
+        fixed = "0." + "0" * -point + digits
+
+    mantissa = digits[0] + ("." + digits[1:] if len(digits) > 1 else "")
+    scientific = "{}e{}{:02d}".format(mantissa, "-" if point - 1 < 0 else "+", abs(point - 1))
+
+    return sign + (fixed if len(fixed) <= len(scientific) else scientific)
+
+
+def hex_float(value, upper):
+    """Format like std::to_chars(value, std::chars_format::hex)."""
+    if math.isinf(value) or math.isnan(value):
+        text = repr(value)
+    else:
+        sign = "-" if math.copysign(1.0, value) < 0.0 else ""
+        mantissa, exponent = float.hex(abs(value))[2:].split("p")
+        mantissa = mantissa.rstrip("0").rstrip(".")
+        text = "{}{}p{}".format(sign, mantissa, exponent)
+    return text.upper() if upper else text
+
+
+class CppBool:
+    """A bool which formats like std::format."""
+    def __init__(self, value):
+        self.value = value
+
+    def __format__(self, spec):
+        s = parse_spec(spec)
+        if s["type"] in ("", "s"):
+            return format("true" if self.value else "false", python_spec(s, ""))
+        return format_integer(int(self.value), s)
+
+
+class CppChar:
+    """A char which formats like std::format."""
+    def __init__(self, value):
+        self.value = value
+
+    def __format__(self, spec):
+        s = parse_spec(spec)
+        if s["type"] in ("", "c"):
+            return format(self.value, python_spec(s, ""))
+        elif s["type"] == "?":
+            return format(repr(self.value), python_spec(s, ""))
+        return format_integer(ord(self.value), s)
+
+
+class CppInteger:
+    """An integer which formats like std::format."""
+    def __init__(self, value):
+        self.value = value
+
+    def __format__(self, spec):
+        return format_integer(self.value, parse_spec(spec))
+
+
+class CppFloat:
+    """A floating point number which formats like std::format."""
+    def __init__(self, value):
+        self.value = value
+
+    def __format__(self, spec):
+        s = parse_spec(spec)
+        if s["type"] in ("a", "A"):
+            return pad_number(hex_float(self.value, s["type"] == "A"), s)
+        elif s["type"] == "" and s["precision"] == "":
+            return pad_number(shortest_float(self.value), s)
+        elif s["type"] == "":
+            return format(self.value, python_spec(s, "g"))
+        return format(self.value, python_spec(s, s["type"]))
+
+
+class CppString:
+    """A string which formats like std::format."""
+    def __init__(self, value):
+        self.value = value
+
+    def __format__(self, spec):
+        s = parse_spec(spec)
+        if s["type"] == "?":
+            return format(json.dumps(self.value, ensure_ascii=False), python_spec(s, ""))
+        return format(self.value, python_spec(s, ""))
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.offset = 0
+
+    def at_end(self):
+        return self.offset >= len(self.data)
+
+    def unpack(self, fmt):
+        values = struct.unpack_from("<" + fmt, self.data, self.offset)
+        self.offset += struct.calcsize("<" + fmt)
+        return values[0] if len(values) == 1 else values
+
+    def string(self):
+        size = self.unpack("I")
+        value = self.data[self.offset:self.offset + size].decode("utf-8", errors="replace")
+        self.offset += size
+        return value
+
+    def argument(self):
+        argument_type = self.unpack("B")
+        if argument_type == ARGUMENT_BOOLEAN:
+            return CppBool(self.unpack("B") != 0)
+        elif argument_type == ARGUMENT_CHARACTER:
+            return CppChar(chr(self.unpack("B")))
+        elif argument_type == ARGUMENT_SIGNED_INTEGER:
+            return CppInteger(self.unpack("q"))
+        elif argument_type == ARGUMENT_UNSIGNED_INTEGER:
+            return CppInteger(self.unpack("Q"))
+        elif argument_type == ARGUMENT_FLOATING_POINT:
+            return CppFloat(self.unpack("d"))
+        elif argument_type == ARGUMENT_STRING:
+            return CppString(self.string())
+        else:
+            raise ValueError("Unknown argument type {} at offset {}".format(argument_type, self.offset - 1))
+
+
+def format_message(fmt, arguments):
+    # The replacement fields of std::format and str.format() have the same syntax,
+    # the format specifications are translated by the argument types.
+    try:
+        return fmt.format(*arguments)
+    except (ValueError, IndexError, KeyError) as e:
+        return "{} {} <{}>".format(fmt, [format(x) for x in arguments], e)
+
+
+def decode(data, out):
+    if data[:len(MAGIC)] != MAGIC:
+        raise ValueError("Not a binary log file")
+
+    reader = Reader(data)
+    reader.offset = len(MAGIC)
+
+    message_infos = {}
+    thread_names = {}
+    while not reader.at_end():
+        record_type = reader.unpack("B")
+
+        if record_type == RECORD_MESSAGE_INFO:
+            id = reader.unpack("I")
+            level_name = reader.string()
+            source_path = reader.string()
+            source_line = reader.unpack("I")
+            fmt = reader.string()
+            message_infos[id] = (level_name, source_path, source_line, fmt)
+
+        elif record_type == RECORD_THREAD_NAME:
+            thread_id = reader.unpack("I")
+            thread_names[thread_id] = reader.string()
+
+        elif record_type == RECORD_MESSAGE:
+            id, nanoseconds, thread_id, cpu_id, nr_arguments = reader.unpack("IqIHB")
+            arguments = [reader.argument() for _ in range(nr_arguments)]
+
+            level_name, source_path, source_line, fmt = message_infos[id]
+            time_point = datetime.datetime.fromtimestamp(nanoseconds // 1_000_000_000, datetime.timezone.utc)
+            text = "{}.{:09d} {}({}) {:5} {}".format(
+                time_point.strftime("%Y-%m-%d %H:%M:%S"),
+                nanoseconds % 1_000_000_000,
+                thread_names.get(thread_id, thread_id),
+                "?" if cpu_id == UNKNOWN_CPU_ID else cpu_id,
+                level_name,
+                format_message(fmt, arguments))
+
+            if level_name != "stats":
+                text += " ({}:{})".format(os.path.basename(source_path.replace("\\", "/")), source_line)
+
+            print(text, file=out)
+
+        else:
+            raise ValueError("Unknown record type {} at offset {}".format(record_type, reader.offset - 1))
+
+
+def main():
+    if len(sys.argv) != 2:
+        print("usage: {} <binary log file>".format(sys.argv[0]), file=sys.stderr)
+        sys.exit(2)
+
+    with open(sys.argv[1], "rb") as f:
+        data = f.read()
+
+    decode(data, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()